@@ -15,6 +15,10 @@
 #include <QCloseEvent>
 #include <QString>
 #include <QDir>
+#include <QTimer>
+#include <QThread>
+#include <QProgressBar>
+#include <QSignalBlocker>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -31,6 +35,12 @@ namespace fs = std::filesystem;
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), stageManager(std::make_unique<StageManager>())
 {
+    // Stage edits are queued by the session's change listener and applied here
+    visibilityTimer = new QTimer(this);
+    visibilityTimer->setInterval(250);
+    connect(visibilityTimer, &QTimer::timeout, this, &MainWindow::updateLiveVisibility);
+    connect(this, &MainWindow::liveVisibilityAnalyzed, this, &MainWindow::finishLiveVisibility, Qt::QueuedConnection);
+
     createMenus();
     createToolBar();
     createStatusBar();
@@ -56,7 +66,14 @@ MainWindow::MainWindow(QWidget *parent)
             primPropertiesWidget, &PrimPropertiesWidget::setPrim);
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow()
+{
+    // The analysis thread reads the stage and the session, so it has to finish before they go away
+    if (visibilityThread)
+    {
+        visibilityThread->wait();
+    }
+}
 
 void MainWindow::createMenus()
 {
@@ -78,6 +95,12 @@ void MainWindow::createMenus()
     connect(exitAct, &QAction::triggered, this, &MainWindow::quitApp);
     fileMenu->addAction(exitAct);
 
+    toolsMenu = menuBar()->addMenu(tr("&Tools"));
+    liveVisibilityAct = new QAction(tr("Live Hidden Mesh Analysis"), this);
+    liveVisibilityAct->setCheckable(true);
+    connect(liveVisibilityAct, &QAction::toggled, this, &MainWindow::toggleLiveVisibility);
+    toolsMenu->addAction(liveVisibilityAct);
+
     helpMenu = menuBar()->addMenu(tr("&Help"));
     helpAct = new QAction(tr("Help"), this);
     connect(helpAct, &QAction::triggered, this, &MainWindow::showHelp);
@@ -97,6 +120,13 @@ void MainWindow::createStatusBar()
     statusLabel = new QLabel(this);
     statusBar()->addWidget(statusLabel);
     statusLabel->setText("Ready");
+
+    // The analysis reports no progress, so the bar only shows that it is running
+    visibilityProgress = new QProgressBar(this);
+    visibilityProgress->setRange(0, 0);
+    visibilityProgress->setMaximumWidth(150);
+    visibilityProgress->hide();
+    statusBar()->addPermanentWidget(visibilityProgress);
 }
 
 void MainWindow::createLogWindow()
@@ -121,6 +151,7 @@ void MainWindow::openUsdFile()
     if (fileName.isEmpty())
         return;
     lastOpenedFile = fileName;
+    stopLiveVisibility();
     if (stageManager->LoadStage(fileName.toStdString()))
     {
         logMessage(tr("Loaded USD stage: %1").arg(fileName));
@@ -137,6 +168,7 @@ void MainWindow::closeStage()
 {
     if (stageManager->HasStage())
     {
+        stopLiveVisibility();
         stageManager->ClearStage();
         sceneTreeWidget->clear();
         logMessage(tr("Closed current USD stage."));
@@ -179,6 +211,88 @@ void MainWindow::convertFile()
     }
 }
 
+void MainWindow::toggleLiveVisibility(bool enabled)
+{
+    if (!enabled)
+    {
+        visibilityTimer->stop();
+        visibilitySession.reset();
+        sceneTreeWidget->setHiddenMeshes({});
+        logMessage(tr("Live hidden mesh analysis stopped."));
+        return;
+    }
+    if (!stageManager->HasStage())
+    {
+        logMessage(tr("No USD stage to analyze."));
+        QSignalBlocker blocker(liveVisibilityAct);
+        liveVisibilityAct->setChecked(false);
+        return;
+    }
+
+    visibilitySession = std::make_unique<workbench::optimizer::VisibilitySession>(
+        stageManager->GetStage(), workbench::optimizer::HiddenMeshRemover::RemovalOptions());
+
+    // A full analysis can take minutes, so run it on a worker and keep the window responsive
+    setLiveVisibilityBusy(true);
+    logMessage(tr("Analyzing hidden meshes..."));
+    workbench::optimizer::VisibilitySession *session = visibilitySession.get();
+    visibilityThread = QThread::create([this, session]()
+                                       { Q_EMIT liveVisibilityAnalyzed(session->analyze()); });
+    connect(visibilityThread, &QThread::finished, visibilityThread, &QObject::deleteLater);
+    visibilityThread->start();
+}
+
+void MainWindow::finishLiveVisibility(bool foundViewpoints)
+{
+    setLiveVisibilityBusy(false);
+    if (!visibilitySession)
+    {
+        return;
+    }
+    if (!foundViewpoints)
+    {
+        logMessage(tr("Hidden mesh analysis found no viewpoints."));
+    }
+    showLiveVisibility(visibilitySession->getStats().totalMeshes);
+    visibilityTimer->start();
+}
+
+void MainWindow::setLiveVisibilityBusy(bool busy)
+{
+    // The stage and the session must stay alive until the analysis thread is done with them
+    openAct->setEnabled(!busy);
+    closeStageAct->setEnabled(!busy);
+    liveVisibilityAct->setEnabled(!busy);
+    visibilityProgress->setVisible(busy);
+}
+
+void MainWindow::updateLiveVisibility()
+{
+    if (visibilitySession && visibilitySession->hasPendingChanges())
+    {
+        showLiveVisibility(visibilitySession->update());
+    }
+}
+
+void MainWindow::stopLiveVisibility()
+{
+    // Unchecking the action tears down the session through toggleLiveVisibility()
+    if (liveVisibilityAct->isChecked())
+    {
+        liveVisibilityAct->setChecked(false);
+    }
+}
+
+void MainWindow::showLiveVisibility(size_t retestedMeshes)
+{
+    const auto &stats = visibilitySession->getStats();
+    sceneTreeWidget->setHiddenMeshes(visibilitySession->getHiddenMeshes());
+    logMessage(tr("Hidden meshes: %1 of %2 (%3 analyzed)")
+                   .arg(stats.hiddenMeshes)
+                   .arg(stats.totalMeshes)
+                   .arg(retestedMeshes));
+}
+
 void MainWindow::showHelp()
 {
     QMessageBox::information(this, tr("Help"), tr("Use File > Open to load a USD file.\nUse File > Convert to convert between USD/FBX formats."));
@@ -1,11 +1,13 @@
 #pragma once
 #include <QMainWindow>
 #include <memory>
+#include <QPointer>
 #include <QSplitter>
 #include "StageManager.h"
 #include "SceneViewWidget.h"
 #include "SceneTreeWidget.h"
 #include "PrimPropertiesWidget.h"
+#include "VisibilitySession.h"
 
 QT_BEGIN_NAMESPACE
 class QAction;
@@ -13,6 +15,9 @@ class QMenu;
 class QToolBar;
 class QLabel;
 class QTextEdit;
+class QTimer;
+class QThread;
+class QProgressBar;
 QT_END_NAMESPACE
 
 class MainWindow : public QMainWindow
@@ -22,6 +27,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+signals:
+    // Emitted from the analysis thread; connected queued so the results are applied on the UI thread
+    void liveVisibilityAnalyzed(bool foundViewpoints);
+
 private slots:
     void openUsdFile();
     void closeStage();
@@ -29,6 +38,9 @@ private slots:
     void showHelp();
     void showAbout();
     void quitApp();
+    void toggleLiveVisibility(bool enabled);
+    void updateLiveVisibility();
+    void finishLiveVisibility(bool foundViewpoints);
 
 private:
     void createMenus();
@@ -36,14 +48,19 @@ private:
     void createStatusBar();
     void createLogWindow();
     void logMessage(const QString &msg);
+    void stopLiveVisibility();
+    void showLiveVisibility(size_t retestedMeshes);
+    void setLiveVisibilityBusy(bool busy);
 
     QMenu *fileMenu;
+    QMenu *toolsMenu;
     QMenu *helpMenu;
     QToolBar *mainToolBar;
     QAction *openAct;
     QAction *closeStageAct;
     QAction *convertAct;
     QAction *exitAct;
+    QAction *liveVisibilityAct;
     QAction *helpAct;
     QAction *aboutAct;
     QLabel *statusLabel;
@@ -52,6 +69,12 @@ private:
     std::unique_ptr<StageManager> stageManager;
     QString lastOpenedFile;
 
+    // Hidden mesh analysis kept current while the stage is edited
+    std::unique_ptr<workbench::optimizer::VisibilitySession> visibilitySession;
+    QTimer *visibilityTimer;
+    QPointer<QThread> visibilityThread; // First analysis, run off the UI thread
+    QProgressBar *visibilityProgress;
+
     // Splitter-based UI components
     QSplitter *mainSplitter;
     QSplitter *rightSplitter;
@@ -5,6 +5,7 @@
 #include <pxr/usd/usd/prim.h>
 
 #include <QLabel>
+#include <QSet>
 
 SceneTreeWidget::SceneTreeWidget(QWidget *parent)
     : QWidget(parent)
@@ -42,6 +43,32 @@ void SceneTreeWidget::clear()
     treeWidget->clear();
 }
 
+void SceneTreeWidget::setHiddenMeshes(const std::vector<pxr::SdfPath> &paths)
+{
+    QSet<QString> hiddenPaths;
+    for (const auto &path : paths)
+    {
+        hiddenPaths.insert(QString::fromStdString(path.GetString()));
+    }
+
+    const QBrush hiddenBrush = palette().brush(QPalette::Disabled, QPalette::Text);
+    QTreeWidgetItemIterator it(treeWidget);
+    while (*it)
+    {
+        if (hiddenPaths.contains((*it)->data(0, Qt::UserRole).toString()))
+        {
+            (*it)->setForeground(0, hiddenBrush);
+            (*it)->setToolTip(0, tr("Hidden from every viewpoint"));
+        }
+        else
+        {
+            (*it)->setData(0, Qt::ForegroundRole, QVariant());
+            (*it)->setToolTip(0, QString());
+        }
+        ++it;
+    }
+}
+
 void SceneTreeWidget::populateTree(const pxr::UsdPrim &prim, QTreeWidgetItem *parentItem)
 {
     if (!prim)
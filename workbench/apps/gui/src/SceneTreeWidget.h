@@ -2,6 +2,8 @@
 #include <QWidget>
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/prim.h>
+#include <pxr/usd/sdf/path.h>
+#include <vector>
 
 class QTreeWidget;
 class QTreeWidgetItem;
@@ -14,6 +16,8 @@ public:
     explicit SceneTreeWidget(QWidget *parent = nullptr);
     void setStage(const pxr::UsdStageRefPtr &stage);
     void clear();
+    // Greys out the given meshes; an empty list clears the marking
+    void setHiddenMeshes(const std::vector<pxr::SdfPath> &paths);
 
 signals:
     void primSelected(const pxr::UsdPrim &prim);
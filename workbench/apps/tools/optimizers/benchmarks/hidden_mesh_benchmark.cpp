@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/base/tf/stringUtils.h>
+#include "HiddenMeshRemover.h"
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+void printUsage(const char *programName)
+{
+    std::cout << "Usage: " << programName << " [options]\n\n";
+    std::cout << "Measure how hidden mesh analysis scales with the number of meshes.\n";
+    std::cout << "Builds in-memory stages containing an N x N x N grid of cubes, where every\n";
+    std::cout << "cube that is not on the outer shell is hidden, and times a dry-run analysis.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -h, --help              Show this help message\n";
+    std::cout << "  --max-meshes N          Largest scene to benchmark (default: 8000)\n";
+    std::cout << "  --viewpoint-density N   Number of viewpoints per axis (default: 8)\n";
+    std::cout << "  --repeat N              Runs per scene size, the fastest is reported (default: 1)\n";
+    std::cout << "  --engine NAME           Visibility engine: ray (default), raster or voxel\n";
+    std::cout << "  --raster-resolution N   Framebuffer size for the raster engine (default: 512)\n";
+    std::cout << "  --voxel-resolution N    Voxels along the longest scene axis for the voxel engine (default: 512)\n";
+    std::cout << "  --threads LIST          Comma separated thread counts; times the largest scene\n";
+    std::cout << "                          with each count and reports the speedup over the first\n";
+    std::cout << "  --packet-sizes LIST     Comma separated ray packet sizes (1, 4, 8, 16); times the\n";
+    std::cout << "                          largest scene with each size against the first\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << programName << "\n";
+    std::cout << "  " << programName << " --max-meshes 40000 --viewpoint-density 4\n";
+    std::cout << "  " << programName << " --max-meshes 27000 --threads 1,2,4,8,16,32,64\n";
+    std::cout << "  " << programName << " --engine raster --raster-resolution 256\n";
+    std::cout << "  " << programName << " --max-meshes 27000 --packet-sizes 1,4,8,16\n";
+}
+
+/**
+ * @brief Create a stage with a gridSize^3 lattice of unit cubes
+ */
+UsdStageRefPtr createCubeGridStage(int gridSize)
+{
+    UsdStageRefPtr stage = UsdStage::CreateInMemory();
+
+    const float halfSize = 0.4f; // Leaves a gap between neighbouring cubes
+    const VtIntArray faceVertexCounts(6, 4);
+    const VtIntArray faceVertexIndices = {
+        0, 1, 3, 2, // -Z
+        4, 6, 7, 5, // +Z
+        0, 4, 5, 1, // -Y
+        2, 3, 7, 6, // +Y
+        0, 2, 6, 4, // -X
+        1, 5, 7, 3  // +X
+    };
+
+    int cubeIndex = 0;
+    for (int x = 0; x < gridSize; ++x)
+    {
+        for (int y = 0; y < gridSize; ++y)
+        {
+            for (int z = 0; z < gridSize; ++z)
+            {
+                GfVec3f center(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+
+                VtArray<GfVec3f> points;
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    GfVec3f offset((corner & 1) ? halfSize : -halfSize,
+                                   (corner & 2) ? halfSize : -halfSize,
+                                   (corner & 4) ? halfSize : -halfSize);
+                    points.push_back(center + offset);
+                }
+
+                VtArray<GfVec3f> extent = {center - GfVec3f(halfSize), center + GfVec3f(halfSize)};
+
+                SdfPath path(TfStringPrintf("/World/Cube_%d", cubeIndex++));
+                UsdGeomMesh mesh = UsdGeomMesh::Define(stage, path);
+                mesh.GetPointsAttr().Set(points);
+                mesh.GetFaceVertexCountsAttr().Set(faceVertexCounts);
+                mesh.GetFaceVertexIndicesAttr().Set(faceVertexIndices);
+                mesh.GetExtentAttr().Set(extent);
+            }
+        }
+    }
+
+    return stage;
+}
+
+/**
+ * @brief Run a dry-run analysis several times and return the fastest wall time
+ */
+double timeAnalysis(workbench::optimizer::HiddenMeshRemover &remover, const UsdStageRefPtr &stage,
+                    int repeat, std::vector<SdfPath> &hiddenMeshes)
+{
+    double bestSeconds = 0.0;
+    for (int run = 0; run < repeat; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        hiddenMeshes = remover.analyzeHiddenMeshes(stage);
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (run == 0 || seconds < bestSeconds)
+        {
+            bestSeconds = seconds;
+        }
+    }
+    return bestSeconds;
+}
+
+/**
+ * @brief Time one scene with each value of an option and check the results agree
+ * @param title Heading of the results table
+ * @param column Name of the varied option
+ * @param values Option values; the first one is the baseline for the speedup
+ * @param applyValue Stores a value in the removal options
+ * @return Process exit code
+ */
+template <typename ApplyFn>
+int runComparison(workbench::optimizer::HiddenMeshRemover::RemovalOptions options, size_t maxMeshes, int repeat,
+                  const std::string &title, const std::string &column, const std::vector<int> &values,
+                  ApplyFn &&applyValue)
+{
+    int gridSize = 1;
+    while (static_cast<size_t>(gridSize + 1) * (gridSize + 1) * (gridSize + 1) <= maxMeshes)
+    {
+        ++gridSize;
+    }
+    const size_t meshCount = static_cast<size_t>(gridSize) * gridSize * gridSize;
+    UsdStageRefPtr stage = createCubeGridStage(gridSize);
+
+    const std::string heading = title + " (" + std::to_string(meshCount) + " meshes)";
+    std::cout << heading << "\n";
+    std::cout << std::string(heading.size(), '=') << "\n";
+    std::cout << std::left << std::setw(14) << column
+              << std::setw(10) << "Hidden"
+              << std::setw(14) << "Time (s)"
+              << "Speedup\n";
+
+    double baselineSeconds = 0.0;
+    std::vector<SdfPath> baselineHidden;
+    bool consistent = true;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        applyValue(options, values[i]);
+        workbench::optimizer::HiddenMeshRemover remover(options);
+
+        std::vector<SdfPath> hiddenMeshes;
+        double seconds = timeAnalysis(remover, stage, repeat, hiddenMeshes);
+        if (i == 0)
+        {
+            baselineSeconds = seconds;
+            baselineHidden = hiddenMeshes;
+        }
+        else if (hiddenMeshes != baselineHidden)
+        {
+            consistent = false;
+        }
+
+        std::cout << std::left << std::setw(14) << values[i]
+                  << std::setw(10) << hiddenMeshes.size()
+                  << std::setw(14) << std::fixed << std::setprecision(3) << seconds
+                  << std::setprecision(2) << (baselineSeconds / seconds) << "x\n";
+    }
+
+    if (!consistent)
+    {
+        std::cerr << "Error: Hidden mesh results differ between " << column << " values\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxMeshes = 8000;
+    int repeat = 1;
+    std::vector<int> threadCounts;
+    std::vector<int> packetSizes;
+
+    workbench::optimizer::HiddenMeshRemover::RemovalOptions options;
+    options.useExistingCameras = false;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        try
+        {
+            if (arg == "-h" || arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg == "--max-meshes" && i + 1 < argc)
+            {
+                maxMeshes = std::stoul(argv[++i]);
+            }
+            else if (arg == "--viewpoint-density" && i + 1 < argc)
+            {
+                options.viewpointDensity = std::stof(argv[++i]);
+            }
+            else if (arg == "--repeat" && i + 1 < argc)
+            {
+                repeat = std::max(1, std::stoi(argv[++i]));
+            }
+            else if (arg == "--engine" && i + 1 < argc)
+            {
+                std::string engine = argv[++i];
+                if (engine == "ray")
+                {
+                    options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::RayCast;
+                }
+                else if (engine == "raster")
+                {
+                    options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Raster;
+                }
+                else if (engine == "voxel")
+                {
+                    options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Voxel;
+                }
+                else
+                {
+                    throw std::invalid_argument(engine);
+                }
+            }
+            else if (arg == "--raster-resolution" && i + 1 < argc)
+            {
+                options.rasterResolution = std::max(8, std::stoi(argv[++i]));
+            }
+            else if (arg == "--voxel-resolution" && i + 1 < argc)
+            {
+                options.voxelResolution = std::max(8, std::stoi(argv[++i]));
+            }
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                for (const std::string &count : TfStringSplit(argv[++i], ","))
+                {
+                    threadCounts.push_back(std::max(1, std::stoi(count)));
+                }
+            }
+            else if (arg == "--packet-sizes" && i + 1 < argc)
+            {
+                for (const std::string &size : TfStringSplit(argv[++i], ","))
+                {
+                    packetSizes.push_back(std::clamp(std::stoi(size), 1, 16));
+                }
+            }
+            else
+            {
+                std::cerr << "Error: Unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: Invalid value for " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (!threadCounts.empty())
+    {
+        return runComparison(options, maxMeshes, repeat, "Hidden Mesh Analysis Thread Scaling", "Threads", threadCounts,
+                             [](auto &removalOptions, int count)
+                             { removalOptions.numThreads = count; });
+    }
+    if (!packetSizes.empty())
+    {
+        return runComparison(options, maxMeshes, repeat, "Hidden Mesh Analysis Ray Packets", "Packet size", packetSizes,
+                             [](auto &removalOptions, int size)
+                             { removalOptions.rayPacketSize = size; });
+    }
+
+    std::cout << "Hidden Mesh Analysis Benchmark\n";
+    std::cout << "==============================\n";
+    std::cout << std::left << std::setw(10) << "Meshes"
+              << std::setw(12) << "Viewpoints"
+              << std::setw(10) << "Hidden"
+              << std::setw(12) << "Rays"
+              << std::setw(14) << "Time (s)"
+              << "Time/mesh (us)\n";
+
+    // Grow the mesh count by roughly 2x per step
+    const std::vector<int> gridSizes = {4, 5, 6, 8, 10, 13, 16, 20, 25, 32, 40, 50};
+    for (int gridSize : gridSizes)
+    {
+        size_t meshCount = static_cast<size_t>(gridSize) * gridSize * gridSize;
+        if (meshCount > maxMeshes)
+        {
+            break;
+        }
+
+        UsdStageRefPtr stage = createCubeGridStage(gridSize);
+        workbench::optimizer::HiddenMeshRemover remover(options);
+
+        std::vector<SdfPath> hiddenMeshes;
+        double bestSeconds = timeAnalysis(remover, stage, repeat, hiddenMeshes);
+        size_t hiddenCount = hiddenMeshes.size();
+
+        std::cout << std::left << std::setw(10) << meshCount
+                  << std::setw(12) << remover.getStats().viewpointsUsed
+                  << std::setw(10) << hiddenCount
+                  << std::setw(12) << remover.getStats().raysTraced
+                  << std::setw(14) << std::fixed << std::setprecision(3) << bestSeconds
+                  << std::setprecision(1) << (bestSeconds * 1e6 / meshCount) << "\n";
+    }
+
+    return 0;
+}
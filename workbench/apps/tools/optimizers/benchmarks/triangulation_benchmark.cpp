@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include "MeshTriangulator.h"
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+void printUsage(const char *programName)
+{
+    std::cout << "Usage: " << programName << " [options]\n\n";
+    std::cout << "Measure the throughput of the fan triangulation kernels in faces per second.\n";
+    std::cout << "Triangulates synthetic all-triangle, all-quad and mixed topologies with\n";
+    std::cout << "MeshTriangulator::triangulateTopology and with a reference loop that appends\n";
+    std::cout << "one index at a time, and checks that both produce the same arrays.\n";
+    std::cout << "All-triangle input is returned as the same array instead of being filled, so\n";
+    std::cout << "its row is labelled Passthrough and does not time a kernel.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -h, --help              Show this help message\n";
+    std::cout << "  --faces N               Faces per topology (default: 1000000)\n";
+    std::cout << "  --repeat N              Runs per topology, the fastest is reported (default: 5)\n\n";
+    std::cout << "Examples:\n";
+    std::cout << "  " << programName << "\n";
+    std::cout << "  " << programName << " --faces 10000000 --repeat 3\n";
+}
+
+/**
+ * @brief Build a topology whose face sizes come from sizeOf(face), over a shared pool of points
+ */
+template <typename SizeFn>
+void createTopology(size_t faceCount, SizeFn &&sizeOf, VtIntArray &faceVertexCounts, VtIntArray &faceVertexIndices)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> point(0, 1 << 20);
+    faceVertexCounts.clear();
+    faceVertexIndices.clear();
+    faceVertexCounts.reserve(faceCount);
+    for (size_t face = 0; face < faceCount; ++face)
+    {
+        const int count = sizeOf(random);
+        faceVertexCounts.push_back(count);
+        for (int i = 0; i < count; ++i)
+        {
+            faceVertexIndices.push_back(point(random));
+        }
+    }
+}
+
+/**
+ * @brief The triangulation loop the kernels replaced, appending one index at a time
+ */
+void triangulateReference(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices,
+                          VtIntArray &triangulatedCounts, VtIntArray &triangulatedIndices)
+{
+    triangulatedCounts.clear();
+    triangulatedIndices.clear();
+    int indexOffset = 0;
+    for (int faceVertexCount : faceVertexCounts)
+    {
+        for (int i = 1; i < faceVertexCount - 1; ++i)
+        {
+            triangulatedCounts.push_back(3);
+            triangulatedIndices.push_back(faceVertexIndices[indexOffset]);
+            triangulatedIndices.push_back(faceVertexIndices[indexOffset + i]);
+            triangulatedIndices.push_back(faceVertexIndices[indexOffset + i + 1]);
+        }
+        indexOffset += faceVertexCount;
+    }
+}
+
+/**
+ * @brief Run a triangulation several times and return the fastest wall time
+ */
+template <typename TriangulateFn>
+double timeTriangulation(int repeat, TriangulateFn &&triangulate)
+{
+    double bestSeconds = 0.0;
+    for (int run = 0; run < repeat; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        triangulate();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (run == 0 || seconds < bestSeconds)
+        {
+            bestSeconds = seconds;
+        }
+    }
+    return bestSeconds;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t faceCount = 1000000;
+    int repeat = 5;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        try
+        {
+            if (arg == "-h" || arg == "--help")
+            {
+                printUsage(argv[0]);
+                return 0;
+            }
+            else if (arg == "--faces" && i + 1 < argc)
+            {
+                faceCount = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else if (arg == "--repeat" && i + 1 < argc)
+            {
+                repeat = std::max(1, std::stoi(argv[++i]));
+            }
+            else
+            {
+                std::cerr << "Error: Unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: Invalid value for " << arg << "\n";
+            return 1;
+        }
+    }
+
+    struct Topology
+    {
+        std::string name;
+        VtIntArray faceVertexCounts;
+        VtIntArray faceVertexIndices;
+    };
+    std::vector<Topology> topologies(3);
+    // triangulateTopology shares all-triangle indices rather than copying them, so this row measures no kernel
+    topologies[0].name = "Passthrough";
+    createTopology(faceCount, [](std::mt19937 &)
+                   { return 3; }, topologies[0].faceVertexCounts, topologies[0].faceVertexIndices);
+    topologies[1].name = "Quads";
+    createTopology(faceCount, [](std::mt19937 &)
+                   { return 4; }, topologies[1].faceVertexCounts, topologies[1].faceVertexIndices);
+    topologies[2].name = "Mixed 3-8";
+    createTopology(faceCount, [](std::mt19937 &random)
+                   { return std::uniform_int_distribution<int>(3, 8)(random); },
+                   topologies[2].faceVertexCounts, topologies[2].faceVertexIndices);
+
+    const std::string heading = std::string("Triangulation Kernels (") + workbench::optimizer::MeshTriangulator::getKernelName() +
+                                ", " + std::to_string(faceCount) + " faces)";
+    std::cout << heading << "\n";
+    std::cout << std::string(heading.size(), '=') << "\n";
+    std::cout << std::left << std::setw(14) << "Topology"
+              << std::setw(14) << "Triangles"
+              << std::setw(18) << "Reference (Mf/s)"
+              << std::setw(16) << "Kernel (Mf/s)"
+              << "Speedup\n";
+
+    bool consistent = true;
+    for (const Topology &topology : topologies)
+    {
+        VtIntArray referenceCounts;
+        VtIntArray referenceIndices;
+        const double referenceSeconds = timeTriangulation(repeat, [&]()
+                                                          { triangulateReference(topology.faceVertexCounts, topology.faceVertexIndices,
+                                                                                 referenceCounts, referenceIndices); });
+
+        VtIntArray triangulatedCounts;
+        VtIntArray triangulatedIndices;
+        const double kernelSeconds = timeTriangulation(repeat, [&]()
+                                                       { workbench::optimizer::MeshTriangulator::triangulateTopology(
+                                                             topology.faceVertexCounts, topology.faceVertexIndices,
+                                                             triangulatedCounts, triangulatedIndices); });
+
+        if (triangulatedCounts != referenceCounts || triangulatedIndices != referenceIndices)
+        {
+            std::cerr << "Error: Kernel and reference results differ for " << topology.name << "\n";
+            consistent = false;
+        }
+
+        std::cout << std::left << std::setw(14) << topology.name
+                  << std::setw(14) << triangulatedCounts.size()
+                  << std::setw(18) << std::fixed << std::setprecision(1) << (faceCount / referenceSeconds * 1e-6)
+                  << std::setw(16) << (faceCount / kernelSeconds * 1e-6)
+                  << std::setprecision(2) << (referenceSeconds / kernelSeconds) << "x\n";
+    }
+
+    return consistent ? 0 : 1;
+}
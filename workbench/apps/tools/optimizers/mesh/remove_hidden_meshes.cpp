@@ -1,12 +1,39 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <filesystem>
 #include <pxr/usd/usd/stage.h>
+#include <pxr/usd/sdf/layer.h>
 #include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/work/threadLimits.h>
 #include "HiddenMeshRemover.h"
+#include "PotentiallyVisibleSet.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+void printPhaseTimes(const workbench::optimizer::HiddenMeshRemover::RemovalStats &stats)
+{
+    std::cout << "Time: " << std::fixed << std::setprecision(2)
+              << "traversal " << stats.traversalSeconds << "s, bounds " << stats.boundsSeconds
+              << "s, BVH build " << stats.bvhBuildSeconds << "s, viewpoints " << stats.viewpointSeconds
+              << "s, visibility " << stats.visibilitySeconds << "s, authoring " << stats.authoringSeconds << "s\n";
+}
+
+void printLoadSavings(const workbench::optimizer::HiddenMeshRemover::LoadMetrics &before,
+                      const workbench::optimizer::HiddenMeshRemover::LoadMetrics &after)
+{
+    auto percentSmaller = [](double from, double to)
+    { return from > 0.0 ? 100.0 * (from - to) / from : 0.0; };
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Output size: " << before.fileBytes / (1024.0 * 1024.0) << " MiB -> " << after.fileBytes / (1024.0 * 1024.0)
+              << " MiB (" << std::setprecision(1) << percentSmaller(double(before.fileBytes), double(after.fileBytes))
+              << "% smaller, " << before.layerCount << " -> " << after.layerCount << " layers)\n";
+    std::cout << std::setprecision(3) << "Load time: " << before.openSeconds << "s -> " << after.openSeconds << "s ("
+              << std::setprecision(1) << percentSmaller(before.openSeconds, after.openSeconds) << "% faster, "
+              << before.primCount << " -> " << after.primCount << " prims)\n";
+}
+
 void printUsage(const char *programName)
 {
     std::cout << "Usage: " << programName << " [options] input_file [output_file]\n\n";
@@ -23,14 +50,57 @@ void printUsage(const char *programName)
     std::cout << "  --no-cameras            Don't use existing camera viewpoints\n";
     std::cout << "  --no-generate           Don't generate additional viewpoints\n";
     std::cout << "  --viewpoint-density N   Number of viewpoints per axis (default: 8)\n";
+    std::cout << "  --viewpoints NAME       Sphere layout: fibonacci (default) or latlong\n";
+    std::cout << "  --refine N              Passes adding views where neighbours disagree (default: 2, 0 = off)\n";
+    std::cout << "  --interior-probes N     Probe grid cells per axis inside the scene (default: 0 = off)\n";
     std::cout << "  --occlusion-threshold T Occlusion threshold 0.0-1.0 (default: 0.95)\n";
     std::cout << "  --aggressive            Use aggressive hiding (less conservative)\n";
-    std::cout << "  --preserve-instanced    Don't hide instanced meshes (default: true)\n\n";
+    std::cout << "  --preserve-instanced    Don't hide instanced meshes (default: true)\n";
+    std::cout << "  --threads N             Worker threads for the analysis (default: 0 = current Work limit)\n";
+    std::cout << "  --engine NAME           Visibility engine: ray (default), raster or voxel\n";
+    std::cout << "  --raster-resolution N   Framebuffer size for the raster engine (default: 512)\n";
+    std::cout << "  --voxel-resolution N    Voxels along the longest scene axis for the voxel engine (default: 512)\n";
+    std::cout << "  --min-pixels N          Pixels a mesh must cover to be visible (raster engine, default: 1)\n";
+    std::cout << "  --packet-size N         Rays traced together: 1, 4, 8 or 16 (ray engine, default: 16)\n";
+    std::cout << "  --min-samples N         Fewest surface samples per mesh and view (ray engine, default: 4)\n";
+    std::cout << "  --max-samples N         Samples for a mesh that fills the view (ray engine, default: 64)\n";
+    std::cout << "  --hierarchical          Test whole prim subtrees by their bounds before their meshes (ray engine)\n";
+    std::cout << "  --min-group-meshes N    Fewest untested meshes a subtree needs to be tested as a whole (default: 4)\n";
+    std::cout << "  --cache FILE            Reuse verdicts of unchanged meshes from FILE and update it\n";
+    std::cout << "  --frames                Analyse every frame of the stage's time range\n";
+    std::cout << "  --frame-range S E       Analyse frames S to E instead of the stage's range\n";
+    std::cout << "  --frame-step N          Distance between analysed frames (default: 1)\n";
+    std::cout << "  --frame-output NAME     ever (default): hide meshes hidden in every frame,\n";
+    std::cout << "                          sampled: also author per-frame visibility samples\n";
+    std::cout << "  --pvs FILE              Write a potentially visible set to FILE instead of hiding meshes\n";
+    std::cout << "  --pvs-resolution N      Cells per axis of the potentially visible set (default: 8)\n";
+    std::cout << "  --report FILE           Write per-mesh results and phase timings to FILE (.json or .csv)\n";
+    std::cout << "  --stream-payloads       Open with payloads unloaded and load them one at a time; the output\n";
+    std::cout << "                          keeps the payload arcs instead of being flattened\n";
+    std::cout << "  --memory-budget MB      Stop instead of exceeding MB of occlusion data while streaming\n";
+    std::cout << "  --prune MODE            deactivate: author active=false on hidden meshes, delete: remove them\n";
+    std::cout << "                          from the flattened output; both report size and load-time savings\n";
+    std::cout << "  --keep-unused           When pruning, keep materials and prototypes only hidden meshes used\n";
+    std::cout << "  --override FILE         Write only the edits to FILE, a layer over the input (ignores output_file)\n";
+    std::cout << "  --hidden-triangles      Also remove faces of visible meshes that no viewpoint sees\n";
+    std::cout << "  --triangle-samples N    Sample points per triangle for --hidden-triangles, 1 to 7 (default: 4)\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << programName << " scene.usd\n";
     std::cout << "  " << programName << " -v --dry-run scene.usd\n";
     std::cout << "  " << programName << " --aggressive scene.usd optimized_scene.usd\n";
     std::cout << "  " << programName << " --viewpoint-density 12 --in-place scene.usd\n";
+    std::cout << "  " << programName << " --threads 16 scene.usd\n";
+    std::cout << "  " << programName << " --engine raster --raster-resolution 1024 scene.usd\n";
+    std::cout << "  " << programName << " --engine voxel --voxel-resolution 1024 engine_assembly.usd\n";
+    std::cout << "  " << programName << " --cache scene.usd.viscache --in-place scene.usd\n";
+    std::cout << "  " << programName << " --frame-range 1001 1500 --frame-output sampled shot.usd\n";
+    std::cout << "  " << programName << " --pvs level.pvs --pvs-resolution 16 level.usd\n";
+    std::cout << "  " << programName << " --dry-run --report scene_visibility.csv scene.usd\n";
+    std::cout << "  " << programName << " --hierarchical --dry-run plant.usd\n";
+    std::cout << "  " << programName << " --stream-payloads --memory-budget 4096 --in-place assembly.usd\n";
+    std::cout << "  " << programName << " --prune delete scene.usd scene_pruned.usdc\n";
+    std::cout << "  " << programName << " --prune deactivate --override scene_pruned.usda scene.usd\n";
+    std::cout << "  " << programName << " --hidden-triangles --triangle-samples 7 building.usd building_shell.usd\n";
 }
 
 int main(int argc, char *argv[])
@@ -39,6 +109,8 @@ int main(int argc, char *argv[])
     std::string outputFile;
     bool dryRun = false;
     bool inPlace = false;
+    std::string pvsFile;
+    std::string overrideFile;
 
     // Initialize options with defaults
     workbench::optimizer::HiddenMeshRemover::RemovalOptions options;
@@ -99,6 +171,57 @@ int main(int argc, char *argv[])
                 return 1;
             }
         }
+        else if (arg == "--viewpoints" && i + 1 < argc)
+        {
+            std::string distribution = argv[++i];
+            if (distribution == "fibonacci")
+            {
+                options.viewpointDistribution = workbench::optimizer::HiddenMeshRemover::ViewpointDistribution::Fibonacci;
+            }
+            else if (distribution == "latlong")
+            {
+                options.viewpointDistribution = workbench::optimizer::HiddenMeshRemover::ViewpointDistribution::LatLong;
+            }
+            else
+            {
+                std::cerr << "Error: viewpoints must be 'fibonacci' or 'latlong'\n";
+                return 1;
+            }
+        }
+        else if (arg == "--refine" && i + 1 < argc)
+        {
+            try
+            {
+                options.refinementPasses = std::stoi(argv[++i]);
+                if (options.refinementPasses < 0 || options.refinementPasses > 8)
+                {
+                    std::cerr << "Error: refine must be between 0 and 8\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid refine value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--interior-probes" && i + 1 < argc)
+        {
+            try
+            {
+                options.interiorProbeResolution = std::stoi(argv[++i]);
+                if (options.interiorProbeResolution < 0 || options.interiorProbeResolution > 64)
+                {
+                    std::cerr << "Error: interior-probes must be between 0 and 64\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid interior-probes value\n";
+                return 1;
+            }
+        }
         else if (arg == "--occlusion-threshold" && i + 1 < argc)
         {
             try
@@ -116,6 +239,323 @@ int main(int argc, char *argv[])
                 return 1;
             }
         }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            try
+            {
+                options.numThreads = std::stoi(argv[++i]);
+                if (options.numThreads < 0)
+                {
+                    std::cerr << "Error: threads must be 0 (current Work limit) or a positive number\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid threads value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--engine" && i + 1 < argc)
+        {
+            std::string engine = argv[++i];
+            if (engine == "ray")
+            {
+                options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::RayCast;
+            }
+            else if (engine == "raster")
+            {
+                options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Raster;
+            }
+            else if (engine == "voxel")
+            {
+                options.engine = workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Voxel;
+            }
+            else
+            {
+                std::cerr << "Error: engine must be 'ray', 'raster' or 'voxel'\n";
+                return 1;
+            }
+        }
+        else if (arg == "--raster-resolution" && i + 1 < argc)
+        {
+            try
+            {
+                options.rasterResolution = std::stoi(argv[++i]);
+                if (options.rasterResolution < 8 || options.rasterResolution > 8192)
+                {
+                    std::cerr << "Error: raster-resolution must be between 8 and 8192\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid raster-resolution value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--voxel-resolution" && i + 1 < argc)
+        {
+            try
+            {
+                options.voxelResolution = std::stoi(argv[++i]);
+                if (options.voxelResolution < 8 || options.voxelResolution > 4096)
+                {
+                    std::cerr << "Error: voxel-resolution must be between 8 and 4096\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Error: Invalid voxel-resolution value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--min-pixels" && i + 1 < argc)
+        {
+            try
+            {
+                options.minVisiblePixels = std::stoi(argv[++i]);
+                if (options.minVisiblePixels < 1)
+                {
+                    std::cerr << "Error: min-pixels must be at least 1\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid min-pixels value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--packet-size" && i + 1 < argc)
+        {
+            try
+            {
+                options.rayPacketSize = std::stoi(argv[++i]);
+                if (options.rayPacketSize != 1 && options.rayPacketSize != 4 &&
+                    options.rayPacketSize != 8 && options.rayPacketSize != 16)
+                {
+                    std::cerr << "Error: packet-size must be 1, 4, 8 or 16\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid packet-size value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--min-samples" && i + 1 < argc)
+        {
+            try
+            {
+                options.minSurfaceSamples = std::stoi(argv[++i]);
+                if (options.minSurfaceSamples < 1)
+                {
+                    std::cerr << "Error: min-samples must be at least 1\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid min-samples value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--max-samples" && i + 1 < argc)
+        {
+            try
+            {
+                options.maxSurfaceSamples = std::stoi(argv[++i]);
+                if (options.maxSurfaceSamples < 1 || options.maxSurfaceSamples > 4096)
+                {
+                    std::cerr << "Error: max-samples must be between 1 and 4096\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid max-samples value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--hierarchical")
+        {
+            options.hierarchicalCulling = true;
+        }
+        else if (arg == "--min-group-meshes" && i + 1 < argc)
+        {
+            try
+            {
+                options.minGroupMeshes = std::stoi(argv[++i]);
+                if (options.minGroupMeshes < 2)
+                {
+                    std::cerr << "Error: min-group-meshes must be at least 2\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid min-group-meshes value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            options.visibilityCachePath = argv[++i];
+        }
+        else if (arg == "--report" && i + 1 < argc)
+        {
+            options.reportPath = argv[++i];
+        }
+        else if (arg == "--stream-payloads")
+        {
+            options.streamPayloads = true;
+        }
+        else if (arg == "--memory-budget" && i + 1 < argc)
+        {
+            try
+            {
+                const long long budget = std::stoll(argv[++i]);
+                if (budget < 0)
+                {
+                    std::cerr << "Error: memory-budget must not be negative\n";
+                    return 1;
+                }
+                options.memoryBudgetMB = static_cast<size_t>(budget);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Error: Invalid memory-budget value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--prune" && i + 1 < argc)
+        {
+            std::string action = argv[++i];
+            if (action == "deactivate")
+            {
+                options.removalAction = workbench::optimizer::HiddenMeshRemover::RemovalAction::Deactivate;
+            }
+            else if (action == "delete")
+            {
+                options.removalAction = workbench::optimizer::HiddenMeshRemover::RemovalAction::Delete;
+            }
+            else
+            {
+                std::cerr << "Error: prune must be 'deactivate' or 'delete'\n";
+                return 1;
+            }
+        }
+        else if (arg == "--keep-unused")
+        {
+            options.collectGarbage = false;
+        }
+        else if (arg == "--override" && i + 1 < argc)
+        {
+            overrideFile = argv[++i];
+        }
+        else if (arg == "--hidden-triangles")
+        {
+            options.removeHiddenTriangles = true;
+        }
+        else if (arg == "--triangle-samples" && i + 1 < argc)
+        {
+            try
+            {
+                options.triangleSamples = std::stoi(argv[++i]);
+                if (options.triangleSamples < 1 || options.triangleSamples > 7)
+                {
+                    std::cerr << "Error: triangle-samples must be between 1 and 7\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Error: Invalid triangle-samples value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--frames")
+        {
+            options.analyzeFrameRange = true;
+        }
+        else if (arg == "--frame-range" && i + 2 < argc)
+        {
+            try
+            {
+                options.startFrame = std::stod(argv[++i]);
+                options.endFrame = std::stod(argv[++i]);
+                options.analyzeFrameRange = true;
+                options.useStageFrameRange = false;
+                if (options.endFrame < options.startFrame)
+                {
+                    std::cerr << "Error: frame-range end must not be before its start\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid frame-range values\n";
+                return 1;
+            }
+        }
+        else if (arg == "--frame-step" && i + 1 < argc)
+        {
+            try
+            {
+                options.frameStep = std::stod(argv[++i]);
+                if (options.frameStep <= 0.0)
+                {
+                    std::cerr << "Error: frame-step must be greater than 0\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid frame-step value\n";
+                return 1;
+            }
+        }
+        else if (arg == "--frame-output" && i + 1 < argc)
+        {
+            std::string frameOutput = argv[++i];
+            if (frameOutput == "ever")
+            {
+                options.frameOutput = workbench::optimizer::HiddenMeshRemover::FrameOutput::EverVisible;
+            }
+            else if (frameOutput == "sampled")
+            {
+                options.frameOutput = workbench::optimizer::HiddenMeshRemover::FrameOutput::TimeSampled;
+            }
+            else
+            {
+                std::cerr << "Error: frame-output must be 'ever' or 'sampled'\n";
+                return 1;
+            }
+        }
+        else if (arg == "--pvs" && i + 1 < argc)
+        {
+            pvsFile = argv[++i];
+        }
+        else if (arg == "--pvs-resolution" && i + 1 < argc)
+        {
+            try
+            {
+                options.pvsResolution = std::stoi(argv[++i]);
+                if (options.pvsResolution < 1 || options.pvsResolution > 256)
+                {
+                    std::cerr << "Error: pvs-resolution must be between 1 and 256\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid pvs-resolution value\n";
+                return 1;
+            }
+        }
         else if (arg[0] != '-')
         {
             if (inputFile.empty())
@@ -156,6 +596,12 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (!overrideFile.empty() && inPlace)
+    {
+        std::cerr << "Error: --override and --in-place cannot be combined\n";
+        return 1;
+    }
+
     // Generate output filename if not provided and not in-place
     if (!inPlace && outputFile.empty())
     {
@@ -177,7 +623,11 @@ int main(int argc, char *argv[])
         std::cout << "Input file: " << inputFile << "\n";
         if (!dryRun)
         {
-            if (inPlace)
+            if (!overrideFile.empty())
+            {
+                std::cout << "Override layer: " << overrideFile << "\n";
+            }
+            else if (inPlace)
             {
                 std::cout << "Mode: In-place modification\n";
             }
@@ -193,24 +643,154 @@ int main(int argc, char *argv[])
         std::cout << "Options:\n";
         std::cout << "  Use existing cameras: " << (options.useExistingCameras ? "Yes" : "No") << "\n";
         std::cout << "  Generate viewpoints: " << (options.generateViewpoints ? "Yes" : "No") << "\n";
-        std::cout << "  Viewpoint density: " << options.viewpointDensity << "\n";
+        std::cout << "  Viewpoint density: " << options.viewpointDensity << " ("
+                  << (options.viewpointDistribution == workbench::optimizer::HiddenMeshRemover::ViewpointDistribution::LatLong
+                          ? "lat-long grid"
+                          : "Fibonacci sphere")
+                  << ", " << options.refinementPasses << " refinement passes)\n";
+        if (options.interiorProbeResolution > 0)
+        {
+            std::cout << "  Interior probes: " << options.interiorProbeResolution << " cells per axis\n";
+        }
         std::cout << "  Occlusion threshold: " << options.occlusionThreshold << "\n";
         std::cout << "  Conservative mode: " << (options.conservativeRemoval ? "Yes" : "No") << "\n";
         std::cout << "  Preserve instanced: " << (options.preserveInstancedMeshes ? "Yes" : "No") << "\n";
+        if (options.engine == workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Raster)
+        {
+            std::cout << "  Engine: raster (" << options.rasterResolution << "x" << options.rasterResolution
+                      << ", min " << options.minVisiblePixels << " pixels)\n";
+        }
+        else if (options.engine == workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Voxel)
+        {
+            std::cout << "  Engine: voxel flood fill (" << options.voxelResolution << " voxels along the longest axis)\n";
+        }
+        else
+        {
+            std::cout << "  Engine: ray casting (packets of " << options.rayPacketSize << ", "
+                      << options.minSurfaceSamples << "-" << options.maxSurfaceSamples << " samples per mesh)\n";
+            if (options.hierarchicalCulling)
+            {
+                std::cout << "  Hierarchical culling: Yes (groups of " << options.minGroupMeshes << "+ meshes)\n";
+            }
+        }
+        if (!options.visibilityCachePath.empty())
+        {
+            std::cout << "  Visibility cache: " << options.visibilityCachePath << "\n";
+        }
+        if (options.analyzeFrameRange)
+        {
+            std::cout << "  Frames: ";
+            if (options.useStageFrameRange)
+            {
+                std::cout << "stage range";
+            }
+            else
+            {
+                std::cout << options.startFrame << "-" << options.endFrame;
+            }
+            std::cout << ", step " << options.frameStep << " ("
+                      << (options.frameOutput == workbench::optimizer::HiddenMeshRemover::FrameOutput::TimeSampled
+                              ? "time-sampled visibility"
+                              : "hidden in every frame")
+                      << ")\n";
+        }
+        if (options.streamPayloads)
+        {
+            std::cout << "  Payload streaming: Yes (budget "
+                      << (options.memoryBudgetMB > 0 ? std::to_string(options.memoryBudgetMB) + " MiB" : "unlimited") << ")\n";
+        }
+        if (options.removalAction != workbench::optimizer::HiddenMeshRemover::RemovalAction::Hide)
+        {
+            std::cout << "  Prune: "
+                      << (options.removalAction == workbench::optimizer::HiddenMeshRemover::RemovalAction::Delete ? "delete"
+                                                                                                                  : "deactivate")
+                      << (options.collectGarbage ? " (collecting unused materials and prototypes)" : "") << "\n";
+        }
+        std::cout << "  Threads: " << (options.numThreads > 0 ? std::to_string(options.numThreads)
+                                                            : std::to_string(WorkGetConcurrencyLimit()) + " (current Work limit)") << "\n";
         std::cout << "\n";
     }
 
+    const bool writing = !dryRun && pvsFile.empty();
+    const bool pruning = writing && options.removalAction != workbench::optimizer::HiddenMeshRemover::RemovalAction::Hide;
+
+    // Measured before anything else opens the input, so its layers are read from disk
+    workbench::optimizer::HiddenMeshRemover::LoadMetrics inputLoad;
+    if (pruning)
+    {
+        inputLoad = workbench::optimizer::HiddenMeshRemover::measureStageLoad(inputFile);
+    }
+
     // Open USD stage
-    auto stage = UsdStage::Open(inputFile);
+    // Streaming loads each payload itself, one at a time
+    const UsdStage::InitialLoadSet loadSet = options.streamPayloads ? UsdStage::LoadNone : UsdStage::LoadAll;
+    SdfLayerRefPtr outputLayer;
+    UsdStageRefPtr stage;
+    if (writing && !overrideFile.empty())
+    {
+        // Edits go to a new layer that sublayers the input, which stays untouched
+        outputLayer = SdfLayer::CreateNew(overrideFile);
+        if (!outputLayer)
+        {
+            std::cerr << "Error: Could not create override layer: " << overrideFile << "\n";
+            return 1;
+        }
+        const std::filesystem::path overrideDir = std::filesystem::absolute(overrideFile).parent_path();
+        outputLayer->InsertSubLayerPath(std::filesystem::absolute(inputFile).lexically_relative(overrideDir).generic_string());
+        stage = UsdStage::Open(outputLayer, loadSet);
+    }
+    else
+    {
+        stage = UsdStage::Open(inputFile, loadSet);
+    }
     if (!stage)
     {
         std::cerr << "Error: Could not open USD file: " << inputFile << "\n";
         return 1;
     }
 
+    // Pruning edits the flattened output itself, where deleted prims take their data with them
+    if (pruning && !outputLayer && !options.streamPayloads)
+    {
+        outputLayer = stage->Flatten();
+        stage = UsdStage::Open(outputLayer, loadSet);
+        if (!stage)
+        {
+            std::cerr << "Error: Could not flatten USD file: " << inputFile << "\n";
+            return 1;
+        }
+    }
+
     // Create hidden mesh remover
     workbench::optimizer::HiddenMeshRemover remover(options);
 
+    if (!pvsFile.empty())
+    {
+        // The stage is only read; nothing is saved besides the set
+        workbench::optimizer::PotentiallyVisibleSet pvs;
+        if (!remover.computePotentiallyVisibleSet(stage, pvs))
+        {
+            std::cerr << "Error: Could not compute a potentially visible set for " << inputFile << "\n";
+            return 1;
+        }
+        if (!pvs.save(pvsFile))
+        {
+            std::cerr << "Error: Failed to write potentially visible set: " << pvsFile << "\n";
+            return 1;
+        }
+
+        const auto &stats = remover.getStats();
+        std::cout << "Potentially Visible Set Written\n";
+        std::cout << "===============================\n";
+        std::cout << "File: " << pvsFile << "\n";
+        std::cout << "Meshes: " << stats.totalMeshes << "\n";
+        std::cout << "Cells: " << stats.pvsCells << " (" << stats.pvsNavigableCells << " navigable)\n";
+        std::cout << "Distinct bitsets: " << stats.pvsUniqueMasks << "\n";
+        std::cout << "Table size: " << std::fixed << std::setprecision(2) << pvs.getMemoryUsage() / 1024.0 << " KiB\n";
+        std::cout << "Rays traced: " << stats.raysTraced << "\n";
+        return 0;
+    }
+
     bool success = false;
     if (dryRun)
     {
@@ -219,7 +799,40 @@ int main(int argc, char *argv[])
 
         std::cout << "Analysis Results:\n";
         std::cout << "=================\n";
-        std::cout << "Hidden meshes found: " << hiddenMeshes.size() << "\n";
+        std::cout << "Hidden meshes found: " << hiddenMeshes.size() << " (" << remover.getStats().hiddenTriangles << " of "
+                  << remover.getStats().totalTriangles << " triangles)\n";
+        std::cout << "Viewpoints used: " << remover.getStats().viewpointsUsed << "\n";
+        std::cout << "Geometry cache: " << std::fixed << std::setprecision(2)
+                  << remover.getStats().geometryCacheBytes / (1024.0 * 1024.0) << " MiB\n";
+        if (options.streamPayloads)
+        {
+            std::cout << "Payloads streamed: " << remover.getStats().payloadsStreamed << "\n";
+        }
+        std::cout << "Frustum candidates: " << remover.getStats().frustumCandidates << "\n";
+        std::cout << "Rays traced: " << remover.getStats().raysTraced << "\n";
+        if (options.hierarchicalCulling)
+        {
+            const auto &stats = remover.getStats();
+            std::cout << "Enclosed groups: " << stats.enclosedGroups << " (" << stats.provenHiddenGroups << " proven hidden, "
+                      << stats.groupProvenMeshes << " mesh tests skipped)\n";
+            std::cout << "Group tests: " << stats.groupTests << " (" << stats.hiddenGroups << " looked hidden, "
+                      << stats.groupCulledMeshes - stats.groupRetestedMeshes << " mesh tests skipped, "
+                      << stats.groupRetestedMeshes << " rerun, " << stats.groupTestsSkipped << " left out)\n";
+        }
+        if (!options.visibilityCachePath.empty())
+        {
+            std::cout << "Cached verdicts reused: " << remover.getStats().cachedMeshes << "\n";
+        }
+        if (options.analyzeFrameRange)
+        {
+            std::cout << "Frames tested: " << remover.getStats().framesAnalyzed << " (" << remover.getStats().framesReused
+                      << " reused, " << remover.getStats().animatedMeshes << " animated meshes)\n";
+        }
+        printPhaseTimes(remover.getStats());
+        if (!options.reportPath.empty())
+        {
+            std::cout << "Report: " << options.reportPath << "\n";
+        }
 
         if (options.verbose && !hiddenMeshes.empty())
         {
@@ -240,34 +853,134 @@ int main(int argc, char *argv[])
         if (success)
         {
             // Save the result - use Export like triangulate_meshes does
-            std::string saveFile = inPlace ? inputFile : outputFile;
+            std::string saveFile = !overrideFile.empty() ? overrideFile : inPlace ? inputFile : outputFile;
 
             if (options.verbose)
             {
                 std::cout << "Saving to: " << saveFile << "\n";
             }
 
-            if (!stage->Export(saveFile))
+            // Flattening would pull every payload into the output, so streamed stages keep their arcs
+            bool saved = false;
+            if (!overrideFile.empty())
+            {
+                saved = outputLayer->Save();
+            }
+            else if (outputLayer)
+            {
+                saved = outputLayer->Export(saveFile);
+            }
+            else
+            {
+                saved = options.streamPayloads ? stage->GetRootLayer()->Export(saveFile) : stage->Export(saveFile);
+            }
+            if (!saved)
             {
                 std::cerr << "Error: Failed to save USD file: " << saveFile << "\n";
                 return 1;
             }
 
+            // Release the edited layers so the output is read back from disk like a fresh load
+            workbench::optimizer::HiddenMeshRemover::LoadMetrics outputLoad;
+            if (pruning)
+            {
+                stage.Reset();
+                outputLayer.Reset();
+                outputLoad = workbench::optimizer::HiddenMeshRemover::measureStageLoad(saveFile);
+            }
+
             // Print statistics
             const auto &stats = remover.getStats();
             std::cout << "Hidden Mesh Optimization Completed\n";
             std::cout << "===================================\n";
             std::cout << "Total meshes: " << stats.totalMeshes << "\n";
-            std::cout << "Hidden meshes detected: " << stats.hiddenMeshes << "\n";
-            std::cout << "Meshes made invisible: " << stats.removedMeshes << "\n";
+            std::cout << "Hidden meshes detected: " << stats.hiddenMeshes << " (" << stats.hiddenTriangles << " of "
+                      << stats.totalTriangles << " triangles)\n";
+            std::cout << (pruning ? "Meshes pruned: " : "Meshes made invisible: ") << stats.removedMeshes << "\n";
             std::cout << "Meshes preserved: " << stats.preservedMeshes << "\n";
             std::cout << "Viewpoints used: " << stats.viewpointsUsed << "\n";
             if (stats.viewpointsGenerated > 0)
             {
-                std::cout << "Viewpoints generated: " << stats.viewpointsGenerated << "\n";
+                std::cout << "Viewpoints generated: " << stats.viewpointsGenerated << " (" << stats.interiorProbes
+                          << " interior, " << stats.viewpointsRefined << " refined)\n";
+            }
+            if (stats.duplicateViewpoints > 0)
+            {
+                std::cout << "Duplicate viewpoints dropped: " << stats.duplicateViewpoints << "\n";
+            }
+            if (options.streamPayloads)
+            {
+                std::cout << "Payloads streamed: " << stats.payloadsStreamed << "\n";
+            }
+            if (stats.occluderInstances > 0)
+            {
+                std::cout << "Instanced occluders: " << stats.occluderInstances << " (" << stats.prototypeMeshes
+                          << " prototype meshes)\n";
+            }
+            std::cout << "Geometry cache: " << std::fixed << std::setprecision(2)
+                      << stats.geometryCacheBytes / (1024.0 * 1024.0) << " MiB\n";
+            std::cout << "Frustum candidates: " << stats.frustumCandidates << "\n";
+            std::cout << "Rays traced: " << stats.raysTraced << "\n";
+            if (options.engine == workbench::optimizer::HiddenMeshRemover::VisibilityEngine::Voxel)
+            {
+                std::cout << "Occupied voxel bricks: " << stats.voxelBricks << "\n";
+            }
+            if (options.hierarchicalCulling)
+            {
+                std::cout << "Enclosed groups: " << stats.enclosedGroups << " (" << stats.provenHiddenGroups << " proven hidden, "
+                          << stats.groupProvenMeshes << " mesh tests skipped)\n";
+                std::cout << "Group tests: " << stats.groupTests << " (" << stats.hiddenGroups << " looked hidden, "
+                          << stats.groupCulledMeshes - stats.groupRetestedMeshes << " mesh tests skipped, "
+                          << stats.groupRetestedMeshes << " rerun, " << stats.groupTestsSkipped << " left out)\n";
+            }
+            if (!options.visibilityCachePath.empty())
+            {
+                std::cout << "Cached verdicts reused: " << stats.cachedMeshes << "\n";
+            }
+            if (options.analyzeFrameRange)
+            {
+                std::cout << "Frames tested: " << stats.framesAnalyzed << " (" << stats.framesReused << " reused, "
+                          << stats.animatedMeshes << " animated meshes)\n";
+                if (options.frameOutput == workbench::optimizer::HiddenMeshRemover::FrameOutput::TimeSampled)
+                {
+                    std::cout << "Meshes with time-sampled visibility: " << stats.timeSampledMeshes << "\n";
+                }
+            }
+            printPhaseTimes(stats);
+            if (!options.reportPath.empty())
+            {
+                std::cout << "Report: " << options.reportPath << "\n";
             }
             std::cout << "Visibility reduction: " << std::fixed << std::setprecision(1)
-                      << stats.spaceSavedPercent << "%\n";
+                      << stats.spaceSavedPercent << "% of meshes\n";
+            if (options.removeHiddenTriangles)
+            {
+                std::cout << "Hidden triangles in visible meshes: " << stats.hiddenSurfaceTriangles << "\n";
+                std::cout << "Faces removed: " << stats.removedFaces << " from " << stats.compactedMeshes << " meshes ("
+                          << stats.removedPoints << " points)\n";
+            }
+            if (pruning)
+            {
+                std::cout << "Prims pruned: " << stats.deactivatedPrims << " deactivated, " << stats.deletedPrims << " deleted\n";
+                if (options.collectGarbage)
+                {
+                    std::cout << "Garbage collected: " << stats.collectedMaterials << " materials, "
+                              << stats.collectedPrototypes << " prototypes\n";
+                }
+                if (stats.orphanedTextures > 0)
+                {
+                    std::cout << "Textures no longer used: " << stats.orphanedTextures << " (" << std::setprecision(2)
+                              << stats.orphanedTextureBytes / (1024.0 * 1024.0) << " MiB on disk, not deleted)\n";
+                    if (options.verbose)
+                    {
+                        for (const std::string &texture : remover.getOrphanedTextures())
+                        {
+                            std::cout << "  " << texture << "\n";
+                        }
+                    }
+                }
+                printLoadSavings(inputLoad, outputLoad);
+            }
         }
     }
 
@@ -17,11 +17,16 @@ void printUsage(const char *programName)
     std::cout << "  -h, --help              Show this help message\n";
     std::cout << "  -v, --verbose           Enable verbose output\n";
     std::cout << "  --in-place              Modify the input file directly (ignores output_file)\n";
-    std::cout << "  --no-primvars           Don't preserve primvar data during triangulation\n\n";
+    std::cout << "  --no-primvars           Don't preserve primvar data during triangulation\n";
+    std::cout << "  --threads N             Worker threads for triangulation (default: 0 = current Work limit)\n";
+    std::cout << "  --no-share-topology     Triangulate every mesh separately instead of once per distinct topology\n";
+    std::cout << "  --all-time-samples      Also triangulate every time sample of time-sampled topology\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << programName << " scene.usd\n";
     std::cout << "  " << programName << " -v scene.usd triangulated_scene.usd\n";
     std::cout << "  " << programName << " --in-place scene.usd\n";
+    std::cout << "  " << programName << " --threads 8 scene.usd\n";
+    std::cout << "  " << programName << " --all-time-samples fluid_cache.usd\n";
 }
 
 int main(int argc, char *argv[])
@@ -31,6 +36,9 @@ int main(int argc, char *argv[])
     bool verbose = false;
     bool inPlace = false;
     bool preservePrimvars = true;
+    int numThreads = 0;
+    bool shareTopology = true;
+    bool allTimeSamples = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i)
@@ -54,6 +62,31 @@ int main(int argc, char *argv[])
         {
             preservePrimvars = false;
         }
+        else if (arg == "--all-time-samples")
+        {
+            allTimeSamples = true;
+        }
+        else if (arg == "--no-share-topology")
+        {
+            shareTopology = false;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            try
+            {
+                numThreads = std::stoi(argv[++i]);
+                if (numThreads < 0)
+                {
+                    std::cerr << "Error: threads must be 0 (current Work limit) or a positive number\n";
+                    return 1;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Error: Invalid threads value\n";
+                return 1;
+            }
+        }
         else if (inputFile.empty())
         {
             inputFile = arg;
@@ -103,6 +136,7 @@ int main(int argc, char *argv[])
             std::cout << "Output file: " << outputFile << std::endl;
         }
         std::cout << "Preserve primvars: " << (preservePrimvars ? "Yes" : "No") << std::endl;
+        std::cout << "Time samples: " << (allTimeSamples ? "All" : "Default only") << std::endl;
     }
 
     // Open the USD stage
@@ -118,6 +152,9 @@ int main(int argc, char *argv[])
     options.verbose = verbose;
     options.inPlace = inPlace;
     options.preserveOriginalPrimvars = preservePrimvars;
+    options.numThreads = numThreads;
+    options.shareTopology = shareTopology;
+    options.allTimeSamples = allTimeSamples;
 
     // Create triangulator and process the stage
     workbench::optimizer::MeshTriangulator triangulator(options);
@@ -156,6 +193,7 @@ int main(int argc, char *argv[])
     std::cout << "Faces triangulated: " << stats.facesTriangulated << std::endl;
     std::cout << "Original face count: " << stats.originalFaceCount << std::endl;
     std::cout << "Final face count: " << stats.finalFaceCount << std::endl;
+    std::cout << "Shared topologies: " << stats.sharedTopologies << std::endl;
 
     return 0;
 }
\ No newline at end of file
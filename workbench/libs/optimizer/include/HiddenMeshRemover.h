@@ -1,10 +1,13 @@
 #pragma once
 
+#include "VisibilityReport.h"
 #include <pxr/pxr.h>
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/primRange.h>
+#include <pxr/usd/usd/timeCode.h>
 #include <pxr/usd/usdGeom/mesh.h>
 #include <pxr/usd/usdGeom/camera.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
 #include <pxr/usd/usdGeom/boundable.h>
 #include <pxr/base/vt/array.h>
 #include <pxr/base/gf/vec3f.h>
@@ -13,6 +16,8 @@
 #include <pxr/base/gf/bbox3d.h>
 #include <pxr/base/gf/ray.h>
 #include <pxr/base/gf/range3d.h>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <unordered_set>
 
@@ -23,6 +28,10 @@ namespace workbench
     namespace optimizer
     {
 
+        class WorldSpaceCache;
+        class PotentiallyVisibleSet;
+        class VisibilitySession;
+
         /**
          * @brief A utility class for removing hidden meshes from USD stages
          *
@@ -33,6 +42,44 @@ namespace workbench
         class HiddenMeshRemover
         {
         public:
+            /**
+             * @brief Algorithm used to decide whether a mesh is visible from a viewpoint
+             */
+            enum class VisibilityEngine
+            {
+                RayCast, ///< Cast rays at surface samples of each mesh
+                Raster,  ///< Rasterize the whole scene into a CPU ID buffer and count pixels per mesh
+                Voxel    ///< Flood the free space of a voxelized scene from the viewpoints; meshes it never reaches are hidden
+            };
+
+            /**
+             * @brief How generated viewpoints are spread over the sphere around the scene
+             */
+            enum class ViewpointDistribution
+            {
+                Fibonacci, ///< Evenly spaced points of a Fibonacci lattice
+                LatLong    ///< Latitude/longitude grid, dense at the poles (previous behaviour)
+            };
+
+            /**
+             * @brief How verdicts of a frame range are written to the stage
+             */
+            enum class FrameOutput
+            {
+                EverVisible, ///< Hide only meshes that are hidden in every frame
+                TimeSampled  ///< Author visibility per frame for meshes that are hidden in some frames
+            };
+
+            /**
+             * @brief What removeHiddenMeshes() does to the meshes it found hidden
+             */
+            enum class RemovalAction
+            {
+                Hide,       ///< Author visibility=invisible; every prim and its data stay in the output
+                Deactivate, ///< Author active=false, so the prims are no longer composed or loaded
+                Delete      ///< Remove the prims' specs from the edit target, deactivating prims other layers define
+            };
+
             /**
              * @brief Options for controlling hidden mesh removal behavior
              */
@@ -41,11 +88,39 @@ namespace workbench
                 bool useExistingCameras = true;      ///< Use cameras defined in the scene
                 bool generateViewpoints = true;      ///< Generate additional viewpoints around the scene
                 float viewpointDensity = 8.0f;       ///< Number of viewpoints per axis when generating
+                ViewpointDistribution viewpointDistribution = ViewpointDistribution::Fibonacci; ///< Placement of sphere viewpoints
+                int interiorProbeResolution = 0;     ///< Grid cells per axis for cube-map probes inside the scene (0 = none)
+                int refinementPasses = 2;            ///< Passes adding viewpoints where neighbouring views disagree (0 = none)
                 bool conservativeRemoval = true;     ///< Be conservative - only remove obviously hidden meshes
                 bool considerTransparency = true;    ///< Consider transparent materials when determining visibility
                 bool preserveInstancedMeshes = true; ///< Don't remove meshes that are instanced multiple times
                 bool verbose = false;                ///< Enable verbose logging
                 float occlusionThreshold = 0.95f;    ///< Fraction of mesh that must be occluded to consider it hidden
+                int numThreads = 0;                  ///< Worker threads for the whole analysis (0 = keep the current Work limit, negative = all cores but N)
+                VisibilityEngine engine = VisibilityEngine::RayCast; ///< Visibility algorithm
+                int rasterResolution = 512;          ///< Framebuffer width and height for the raster engine
+                int voxelResolution = 512;           ///< Voxels along the longest scene axis (voxel engine)
+                int minVisiblePixels = 1;            ///< Pixels a mesh must cover in one view to be visible (raster engine)
+                int rayPacketSize = 16;              ///< Rays traced together, 1 to 16 (ray engine; 1 = single rays)
+                int minSurfaceSamples = 4;           ///< Fewest surface samples per mesh and viewpoint (ray engine)
+                int maxSurfaceSamples = 64;          ///< Samples for a mesh that spans the view (ray engine)
+                bool hierarchicalCulling = false;    ///< Skip or postpone mesh tests in prim subtrees hidden as a whole (ray engine)
+                int minGroupMeshes = 4;              ///< Fewest untested meshes a subtree needs to be tested as a whole
+                std::string visibilityCachePath;     ///< Sidecar file reusing verdicts of unchanged meshes between runs (empty = no cache)
+                bool analyzeFrameRange = false;      ///< Analyse every frame of a range instead of the default time
+                bool useStageFrameRange = true;      ///< Take the range from the stage's start and end time codes
+                double startFrame = 0.0;             ///< First frame when not using the stage range
+                double endFrame = 0.0;               ///< Last frame, inclusive, when not using the stage range
+                double frameStep = 1.0;              ///< Distance between analysed frames
+                FrameOutput frameOutput = FrameOutput::EverVisible; ///< How the verdicts of a frame range are authored
+                int pvsResolution = 8;               ///< Cells per axis of a potentially visible set
+                std::string reportPath;              ///< Per-mesh report written after each analysis, CSV for ".csv" and JSON otherwise (empty = none)
+                bool streamPayloads = false;         ///< Load unloaded payloads one at a time instead of requiring a fully loaded stage
+                size_t memoryBudgetMB = 0;           ///< Limit for the occlusion data kept while streaming, in MiB (0 = none)
+                RemovalAction removalAction = RemovalAction::Hide; ///< Hide hidden meshes or prune them from the stage
+                bool collectGarbage = true;          ///< When pruning, also prune materials and prototypes only hidden meshes used
+                bool removeHiddenTriangles = false;  ///< Also remove the faces of visible meshes that no viewpoint sees
+                int triangleSamples = 4;             ///< Sample points per triangle for hidden face removal, 1 to 7
 
                 RemovalOptions() = default;
             };
@@ -61,7 +136,52 @@ namespace workbench
                 size_t preservedMeshes = 0;
                 size_t viewpointsGenerated = 0;
                 size_t viewpointsUsed = 0;
-                float spaceSavedPercent = 0.0f;
+                size_t interiorProbes = 0;       ///< Generated viewpoints placed inside the scene bounds
+                size_t viewpointsRefined = 0;    ///< Generated viewpoints added by adaptive refinement
+                size_t duplicateViewpoints = 0;  ///< Viewpoints dropped because they repeat another one
+                size_t geometryCacheBytes = 0; ///< Memory held by the flat geometry snapshot
+                size_t frustumCandidates = 0;  ///< Mesh/viewpoint pairs that passed frustum culling
+                size_t raysTraced = 0;         ///< Occlusion rays cast by the ray engine
+                size_t cachedMeshes = 0;       ///< Meshes whose verdict was reused from the visibility cache
+                size_t occluderInstances = 0;  ///< Instance proxy meshes and point-instancer entries used as occluders
+                size_t prototypeMeshes = 0;    ///< Distinct meshes those instances share
+                size_t framesAnalyzed = 0;     ///< Frames whose visibility was tested
+                size_t framesReused = 0;       ///< Frames that took the previous verdicts because nothing could have moved
+                size_t animatedMeshes = 0;     ///< Meshes re-read and refitted between frames
+                size_t timeSampledMeshes = 0;  ///< Meshes given per-frame visibility samples
+                size_t pvsCells = 0;           ///< Cells of the potentially visible set grid
+                size_t pvsNavigableCells = 0;  ///< Cells with free space and a visibility table
+                size_t pvsUniqueMasks = 0;     ///< Distinct visible-mesh bitsets among those cells
+                size_t payloadsStreamed = 0;   ///< Payloads loaded, snapshotted and unloaded again
+                size_t hierarchyGroups = 0;    ///< Prims with two or more meshes below them
+                size_t enclosedGroups = 0;     ///< Of those, groups inside a closed mesh that does not belong to them
+                size_t provenHiddenGroups = 0; ///< Group/viewpoint pairs with the viewpoint outside the group's enclosing mesh
+                size_t groupProvenMeshes = 0;  ///< Mesh/viewpoint tests skipped because their group was proven hidden
+                size_t groupTestsSkipped = 0;  ///< Group tests left out because every candidate below was already deferred
+                size_t groupTests = 0;         ///< Group/viewpoint pairs tested as a whole
+                size_t hiddenGroups = 0;       ///< Of those, groups that looked hidden
+                size_t groupCulledMeshes = 0;  ///< Mesh/viewpoint tests deferred because their group looked hidden
+                size_t groupRetestedMeshes = 0; ///< Deferred tests run anyway because no other viewpoint saw the mesh
+                size_t voxelBricks = 0;        ///< Bricks of 8x8x8 voxels that triangles occupy (voxel engine)
+                size_t totalTriangles = 0;     ///< Triangles of the analysed meshes
+                size_t hiddenTriangles = 0;    ///< Triangles of the meshes found hidden
+                size_t deactivatedPrims = 0;   ///< Pruned prims given active=false, garbage included
+                size_t deletedPrims = 0;       ///< Pruned prims whose specs were removed, garbage included
+                size_t collectedMaterials = 0; ///< Materials pruned because only pruned prims used them
+                size_t collectedPrototypes = 0; ///< Class and over prims pruned because only pruned prims referenced them
+                size_t orphanedTextures = 0;   ///< Texture files only collected materials used; see getOrphanedTextures()
+                uintmax_t orphanedTextureBytes = 0; ///< Size of those texture files on disk
+                size_t hiddenSurfaceTriangles = 0; ///< Triangles of visible meshes that no viewpoint sees
+                size_t compactedMeshes = 0;    ///< Visible meshes that lost hidden faces
+                size_t removedFaces = 0;       ///< Faces removed from those meshes
+                size_t removedPoints = 0;      ///< Points only the removed faces used
+                double traversalSeconds = 0.0; ///< Collecting meshes, cameras and instances from the stage
+                double boundsSeconds = 0.0;    ///< Computing world-space scene bounds
+                double bvhBuildSeconds = 0.0;  ///< Snapshotting geometry and building or refitting the BVHs
+                double viewpointSeconds = 0.0; ///< Reading cameras, generating and deduplicating viewpoints
+                double visibilitySeconds = 0.0; ///< Visibility tests, including the visibility cache
+                double authoringSeconds = 0.0; ///< Writing visibility opinions to the stage
+                float spaceSavedPercent = 0.0f; ///< Percentage of meshes set invisible; see hiddenTriangles for the geometry saved
 
                 void reset()
                 {
@@ -71,6 +191,51 @@ namespace workbench
                     preservedMeshes = 0;
                     viewpointsGenerated = 0;
                     viewpointsUsed = 0;
+                    interiorProbes = 0;
+                    viewpointsRefined = 0;
+                    duplicateViewpoints = 0;
+                    geometryCacheBytes = 0;
+                    frustumCandidates = 0;
+                    raysTraced = 0;
+                    cachedMeshes = 0;
+                    occluderInstances = 0;
+                    prototypeMeshes = 0;
+                    framesAnalyzed = 0;
+                    framesReused = 0;
+                    animatedMeshes = 0;
+                    timeSampledMeshes = 0;
+                    pvsCells = 0;
+                    pvsNavigableCells = 0;
+                    pvsUniqueMasks = 0;
+                    payloadsStreamed = 0;
+                    hierarchyGroups = 0;
+                    enclosedGroups = 0;
+                    provenHiddenGroups = 0;
+                    groupProvenMeshes = 0;
+                    groupTestsSkipped = 0;
+                    groupTests = 0;
+                    hiddenGroups = 0;
+                    groupCulledMeshes = 0;
+                    groupRetestedMeshes = 0;
+                    voxelBricks = 0;
+                    totalTriangles = 0;
+                    hiddenTriangles = 0;
+                    deactivatedPrims = 0;
+                    deletedPrims = 0;
+                    collectedMaterials = 0;
+                    collectedPrototypes = 0;
+                    orphanedTextures = 0;
+                    orphanedTextureBytes = 0;
+                    hiddenSurfaceTriangles = 0;
+                    compactedMeshes = 0;
+                    removedFaces = 0;
+                    removedPoints = 0;
+                    traversalSeconds = 0.0;
+                    boundsSeconds = 0.0;
+                    bvhBuildSeconds = 0.0;
+                    viewpointSeconds = 0.0;
+                    visibilitySeconds = 0.0;
+                    authoringSeconds = 0.0;
                     spaceSavedPercent = 0.0f;
                 }
             };
@@ -88,6 +253,17 @@ namespace workbench
                     : position(pos), direction(dir), fov(fieldOfView) {}
             };
 
+            /**
+             * @brief Size and load cost of a USD file together with every layer it composes
+             */
+            struct LoadMetrics
+            {
+                size_t layerCount = 0;   ///< Layers the stage used, sublayers, references and payloads included
+                uintmax_t fileBytes = 0; ///< Combined size of those layers on disk
+                size_t primCount = 0;    ///< Active, loaded and defined prims a default traversal visits
+                double openSeconds = 0.0; ///< Opening the stage with every payload loaded and traversing it once
+            };
+
             /**
              * @brief Default constructor
              */
@@ -113,12 +289,53 @@ namespace workbench
              */
             std::vector<SdfPath> analyzeHiddenMeshes(UsdStagePtr stage);
 
+            /**
+             * @brief Compute which meshes may be seen from each cell of a grid over the scene
+             *
+             * The scene bounds are split into pvsResolution cells per axis. A
+             * cell is navigable if its center or one of eight points near its
+             * corners lies in free space, as for interior probes. From each
+             * free point six slightly overlapping views are tested with the
+             * selected engine; a mesh is visible from the cell if any view
+             * sees it, if its bounds touch the cell, or if it is preserved.
+             * The stage is not modified.
+             *
+             * @param stage The USD stage to analyze
+             * @param pvs Receives the grid and one visible-mesh bitset per navigable cell
+             * @return False if the stage is invalid or has no mesh geometry
+             */
+            bool computePotentiallyVisibleSet(UsdStagePtr stage, PotentiallyVisibleSet &pvs);
+
+            /**
+             * @brief Open a USD file with every payload loaded and measure what that costs
+             *
+             * Layers that are already open elsewhere in the process are not
+             * read again, so release every stage on the file first to measure
+             * a cold load.
+             *
+             * @param path USD file to open
+             * @return Zero metrics if the file could not be opened
+             */
+            static LoadMetrics measureStageLoad(const std::string &path);
+
             /**
              * @brief Get removal statistics
              * @return Reference to the current statistics
              */
             const RemovalStats &getStats() const { return m_stats; }
 
+            /**
+             * @brief Per-mesh results and phase timings of the last removeHiddenMeshes() or analyzeHiddenMeshes() call
+             */
+            const VisibilityReport &getReport() const { return m_report; }
+
+            /**
+             * @brief Texture files that only the materials collected by the last removeHiddenMeshes() call used
+             *
+             * The files are reported, never deleted: other stages may still use them.
+             */
+            const std::vector<std::string> &getOrphanedTextures() const { return m_orphanedTextures; }
+
             /**
              * @brief Reset removal statistics
              */
@@ -137,74 +354,397 @@ namespace workbench
             const RemovalOptions &getOptions() const { return m_options; }
 
         private:
+            /// Keeps the occlusion scene of a full analysis alive and re-tests parts of it
+            friend class VisibilitySession;
+
             /**
-             * @brief Generate viewpoints around the scene bounding box
+             * @brief Per-run occlusion data: meshes, their geometry snapshot and, for ray casting, BVHs over them
+             */
+            struct OcclusionScene;
+
+            /**
+             * @brief Generate viewpoints around and, with interior probes, inside the scene bounding box
              * @param sceneBounds The bounding box of the entire scene
+             * @param scene Occlusion scene; its ray caster is used for probes and refinement
              * @return Vector of generated viewpoints
              */
-            std::vector<Viewpoint> generateViewpoints(const GfBBox3d &sceneBounds);
+            std::vector<Viewpoint> generateViewpoints(const GfBBox3d &sceneBounds, const OcclusionScene &scene);
+
+            /**
+             * @brief Whether this run needs the occlusion BVHs: for the ray engine, viewpoint generation or hidden face removal
+             */
+            bool usesRayCaster() const;
+
+            /**
+             * @brief Collect every loaded mesh, camera and instance below a prim in a single traversal
+             * @param root Prim to traverse, e.g. the stage's pseudo-root
+             * @param meshes Receives the meshes to analyse, in traversal order
+             * @param cameras Receives the cameras, in traversal order
+             * @param instanceProxies Receives the meshes inside native instances
+             * @param instancers Receives the point instancers; their prototype meshes are left out of meshes
+             */
+            void collectScenePrims(const UsdPrim &root, std::vector<UsdGeomMesh> &meshes, std::vector<UsdGeomCamera> &cameras,
+                                   std::vector<UsdGeomMesh> &instanceProxies, std::vector<UsdGeomPointInstancer> &instancers);
+
+            /**
+             * @brief Create viewpoints from scene cameras
+             * @param cameras The cameras found in the stage
+             * @param worldCache Provides the cameras' world transforms
+             * @return Vector of camera viewpoints in world space
+             */
+            std::vector<Viewpoint> extractCameraViewpoints(const std::vector<UsdGeomCamera> &cameras,
+                                                           const WorldSpaceCache &worldCache);
+
+            /**
+             * @brief Extract mesh geometry once and build the occlusion hierarchy if the engine needs it
+             *
+             * After this call no visibility query reads from the USD stage.
+             *
+             * Instanced geometry is stored once per prototype and only acts
+             * as an occluder.
+             *
+             * @param meshes All meshes to analyse
+             * @param instanceProxies Meshes inside native instances
+             * @param instancers Point instancers of the scene
+             * @param worldCache Provides the meshes' world transforms
+             * @return The occlusion scene used by all visibility queries of this run
+             */
+            OcclusionScene buildOcclusionScene(const std::vector<UsdGeomMesh> &meshes,
+                                               const std::vector<UsdGeomMesh> &instanceProxies,
+                                               const std::vector<UsdGeomPointInstancer> &instancers,
+                                               const WorldSpaceCache &worldCache);
 
             /**
-             * @brief Extract camera viewpoints from the stage
-             * @param stage The USD stage to search for cameras
-             * @return Vector of camera viewpoints
+             * @brief Build the occlusion scene of a stage whose payloads are unloaded, one payload at a time
+             *
+             * Everything outside unloaded payloads is snapshotted first, with
+             * bounds that use the extentsHint of unloaded models. Each unloaded
+             * payload is then loaded, its meshes, instances and cameras are
+             * snapshotted, its exact bounds are added and it is unloaded again,
+             * so at most one payload is loaded at any time. The snapshot holds
+             * the same geometry as for a fully loaded stage, so verdicts match.
+             *
+             * @param stage The USD stage, typically opened with UsdStage::LoadNone
+             * @param scene Receives the occlusion scene, BVHs included
+             * @param cameraViewpoints Receives the viewpoints of every camera, read while its payload was loaded
+             * @param sceneBounds Receives the bounds of the whole stage
+             * @return False if the occlusion data would exceed memoryBudgetMB
              */
-            std::vector<Viewpoint> extractCameraViewpoints(UsdStagePtr stage);
+            bool streamOcclusionScene(UsdStagePtr stage, OcclusionScene &scene, std::vector<Viewpoint> &cameraViewpoints,
+                                      GfBBox3d &sceneBounds);
 
             /**
-             * @brief Test if a mesh is visible from any viewpoint
-             * @param mesh The mesh to test
+             * @brief Compute the scene bounds and build the BVHs and samplers over a complete snapshot
+             */
+            void finishOcclusionScene(OcclusionScene &scene);
+
+            /**
+             * @brief Outcome of the visibility analysis for a single mesh
+             */
+            enum class MeshVisibility : uint8_t
+            {
+                Visible,
+                Hidden,
+                Preserved ///< Skipped because it is instanced
+            };
+
+            /**
+             * @brief Work spent on one mesh by the visibility tests, for the report
+             */
+            struct MeshCost
+            {
+                size_t raysTraced = 0;
+                double seconds = 0.0;   ///< Share of each viewpoint's time, see VisibilityReport
+                float bestScore = 0.0f;
+                bool hasBestViewpoint = false;
+                GfVec3d bestPosition = GfVec3d(0.0);
+                GfVec3d bestDirection = GfVec3d(0.0);
+                bool cached = false;
+
+                void recordScore(float score, const Viewpoint &viewpoint)
+                {
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        hasBestViewpoint = true;
+                        bestPosition = viewpoint.position;
+                        bestDirection = viewpoint.direction;
+                    }
+                }
+            };
+
+            /**
+             * @brief Re-read moved or deformed meshes into the occlusion scene and refit over them
+             *
+             * Meshes are re-read in parallel; the instances must already hold
+             * their current placements.
+             *
+             * @param scene Occlusion scene built by buildOcclusionScene()
+             * @param changedMeshes Indices into scene.meshes, sorted and unique
+             * @param worldCache Provides the transforms and the time to read at
+             * @return False if a mesh changed its point or triangle count; the scene must then be rebuilt
+             */
+            bool refitOcclusionScene(OcclusionScene &scene, const std::vector<uint32_t> &changedMeshes,
+                                     const WorldSpaceCache &worldCache);
+
+            /**
+             * @brief Time codes of the configured frame range, first to last
+             */
+            std::vector<UsdTimeCode> computeFrames(UsdStagePtr stage) const;
+
+            /**
+             * @brief Classify every mesh at each frame of a range
+             *
+             * The occlusion scene is built once, at the first frame. Later
+             * frames re-read only meshes and instances that may be animated
+             * and refit the BVHs over them; a frame in which neither geometry
+             * nor cameras can have moved takes the previous verdicts. Generated
+             * viewpoints are placed around the first frame and only re-tested
+             * after the geometry moved; camera viewpoints follow the cameras.
+             * With FrameOutput::EverVisible, meshes seen in an earlier frame
+             * are not tested again and count as visible in later frames.
+             *
+             * @param stage The USD stage to analyze
+             * @param frames Time codes to analyze, in increasing order
+             * @param scene Receives the occlusion scene of the last frame
+             * @param viewpoints Receives the viewpoints of the last frame
+             * @param frameVisibility Receives one verdict list per frame, each indexed like scene.meshes
+             * @return Per-mesh verdicts over the whole range, hidden only if hidden in every frame;
+             *         empty if there are no viewpoints
+             */
+            std::vector<MeshVisibility> analyzeFrames(UsdStagePtr stage, const std::vector<UsdTimeCode> &frames,
+                                                      OcclusionScene &scene, std::vector<Viewpoint> &viewpoints,
+                                                      std::vector<std::vector<MeshVisibility>> &frameVisibility);
+
+            /**
+             * @brief Author visibility time samples for meshes hidden in some but not all frames
+             * @return Number of meshes given time samples
+             */
+            size_t authorFrameVisibility(UsdStagePtr stage, const OcclusionScene &scene, const std::vector<UsdTimeCode> &frames,
+                                         const std::vector<std::vector<MeshVisibility>> &frameVisibility);
+
+            /**
+             * @brief Deactivate or delete one prim as removalAction asks
+             *
+             * Delete removes the prim's spec from the edit target layer if no
+             * other layer has opinions about the prim; otherwise, and for
+             * Deactivate, the prim is given active=false. Prims inside unloaded
+             * payloads get an inactive over when streaming payloads.
+             *
+             * @return False for instance proxies and prims that could not be edited
+             */
+            bool prunePrim(UsdStagePtr stage, const SdfPath &path);
+
+            /**
+             * @brief Prune materials and prototypes that were used before pruning and are not anymore
+             *
+             * Prototypes are class or over prims that active prims of the edit
+             * target layer referenced, inherited or specialized; collecting
+             * one can leave others unused, so they are collected until nothing
+             * changes. Materials are collected last, since collected
+             * prototypes may have bound them. Texture files of collected
+             * materials that no remaining material uses are recorded in
+             * m_orphanedTextures.
+             *
+             * @param stage The USD stage, after the hidden meshes were pruned
+             * @param materialsBefore Materials in use before pruning
+             * @param prototypesBefore Prototypes in use before pruning
+             */
+            void collectGarbage(UsdStagePtr stage, const SdfPathSet &materialsBefore, const SdfPathSet &prototypesBefore);
+
+            /**
+             * @brief Collect, snapshot and classify every mesh of a stage
+             *
+             * Shared by removeHiddenMeshes(), analyzeHiddenMeshes() and
+             * VisibilitySession; updates every statistic except the per-verdict
+             * counts, which callers accumulate from the result.
+             *
+             * @param stage The USD stage to analyze
+             * @param scene Receives the occlusion scene the verdicts were computed on
+             * @param viewpoints Receives the viewpoints used, after duplicates are removed
+             * @return One entry per mesh, indexed like scene.meshes; empty if there are no viewpoints
+             */
+            std::vector<MeshVisibility> analyzeStage(UsdStagePtr stage, OcclusionScene &scene,
+                                                     std::vector<Viewpoint> &viewpoints);
+
+            /**
+             * @brief Classify every mesh of the occlusion scene in parallel
+             *
+             * Each viewpoint first culls the cached mesh bounds against its view
+             * frustum; only the resulting candidates reach the occlusion tests.
+             * Visibility tests only read the occlusion scene, so candidates are
+             * distributed over m_options.numThreads workers. Each worker writes
+             * its own result slot, which keeps the output independent of the
+             * thread count; callers update statistics and author USD serially.
+             * With a visibility cache, unchanged meshes keep their earlier
+             * verdict and are not tested.
+             *
+             * @param scene The occlusion scene containing all meshes
+             * @param viewpoints The viewpoints to test from
+             * @param viewpointKey Visibility cache key of the viewpoints and analysis options
+             * @param stage The stage the meshes belong to
+             * @return One entry per mesh, indexed like scene.meshes
+             */
+            std::vector<MeshVisibility> classifyMeshes(const OcclusionScene &scene,
+                                                       const std::vector<Viewpoint> &viewpoints,
+                                                       uint64_t viewpointKey,
+                                                       UsdStagePtr stage);
+
+            /**
+             * @brief Run the selected visibility engine on every unresolved mesh
+             *
+             * @param scene The occlusion scene containing all meshes
              * @param viewpoints The viewpoints to test from
-             * @param allMeshes All meshes in the scene (for occlusion testing)
-             * @return True if the mesh is visible from at least one viewpoint
+             * @param resolved Meshes whose result is already known; they are not tested but still occlude
+             * @param visibility Per-mesh results; unresolved entries must start Visible and become Hidden if never seen
+             * @param scores Receives the highest visibility score of each tested mesh
+             *
+             * Rays, time and best viewpoints are added to m_meshCosts.
              */
-            bool isMeshVisible(const UsdGeomMesh &mesh,
-                               const std::vector<Viewpoint> &viewpoints,
-                               const std::vector<UsdGeomMesh> &allMeshes);
+            void testVisibility(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                std::vector<uint8_t> &resolved, std::vector<MeshVisibility> &visibility,
+                                std::vector<float> &scores);
 
             /**
-             * @brief Test if a mesh is visible from a specific viewpoint
-             * @param mesh The mesh to test
+             * @brief Mark meshes that cover at least minVisiblePixels in some rasterized view
+             *
+             * Each worker renders whole viewpoints into its own framebuffer, so
+             * every mesh acts as an occluder for every other.
+             *
+             * @param scene The occlusion scene containing all meshes
+             * @param viewpoints The viewpoints to render
+             * @param resolved Meshes whose result is already known; they still occlude others. Seen meshes are added
+             * @param visibility Per-mesh results; unresolved entries become Visible or Hidden
+             * @param scores Receives the most pixels each unresolved mesh covered in one view
+             * @param costs Per-mesh costs, one per mesh; render time and best views are added
+             * @return Number of mesh/viewpoint pairs that passed frustum culling
+             */
+            size_t rasterizeVisibility(const OcclusionScene &scene,
+                                       const std::vector<Viewpoint> &viewpoints,
+                                       std::vector<uint8_t> &resolved,
+                                       std::vector<MeshVisibility> &visibility,
+                                       std::vector<float> &scores,
+                                       std::vector<MeshCost> &costs) const;
+
+            /**
+             * @brief Mark meshes that the free space around some viewpoint reaches
+             *
+             * Free space is flooded through the scene's voxel grid from every
+             * viewpoint; viewpoints outside the scene bounds flood it from the
+             * whole border. A mesh is visible if any voxel it overlaps borders
+             * on flooded space. View directions and fields of view are
+             * ignored, which can only keep more meshes visible.
+             *
+             * @param scene The occlusion scene; its voxel grid must have been built
+             * @param viewpoints The viewpoints to flood from
+             * @param resolved Meshes whose result is already known; they still occlude. Reached meshes are added
+             * @param visibility Per-mesh results; unresolved entries become Visible or Hidden
+             * @param scores Receives 1 for each reached mesh and 0 otherwise
+             * @param costs Per-mesh costs, one per mesh; the fill's time is shared by triangle count
+             */
+            void floodFillVisibility(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                     std::vector<uint8_t> &resolved, std::vector<MeshVisibility> &visibility,
+                                     std::vector<float> &scores, std::vector<MeshCost> &costs) const;
+
+            /**
+             * @brief Drop or defer candidates whose whole prim subtree is hidden from one viewpoint
+             *
+             * Walks the scene's mesh hierarchy from the root. Subtrees without
+             * candidates, e.g. outside the frustum or already seen, are skipped
+             * at once. A subtree with at least minGroupMeshes candidates is
+             * hidden for certain if its bounds lie inside a closed mesh and the
+             * viewpoint lies outside that mesh; its candidates are dropped
+             * without tracing a ray. Otherwise it looks hidden if every ray to
+             * samples on the sides of its bounds that face the viewpoint is
+             * blocked. Only subtrees that are not hidden are descended into.
+             *
+             * The samples can miss gaps, so looking hidden is not a proof:
+             * deferred meshes are not hidden from the viewpoint, only tested
+             * after all viewpoints, and only if no other viewpoint saw them.
+             * Subtrees whose candidates were all deferred from an earlier
+             * viewpoint are not sampled again, since their meshes are
+             * retested anyway. There is no fully-visible group test; visible
+             * meshes are always found by their own test.
+             *
+             * @param scene The occlusion scene; its hierarchy must have been built
              * @param viewpoint The viewpoint to test from
-             * @param occludingMeshes Other meshes that might occlude this one
-             * @return Fraction of mesh that is visible (0.0 = completely hidden, 1.0 = fully visible)
+             * @param candidates Unresolved meshes inside the view frustum; dropped and deferred ones are removed
+             * @param everDeferred Per mesh, 1 if an earlier viewpoint deferred it
+             * @param deferred Receives the deferred candidates
              */
-            float testMeshVisibilityFromViewpoint(const UsdGeomMesh &mesh,
-                                                  const Viewpoint &viewpoint,
-                                                  const std::vector<UsdGeomMesh> &occludingMeshes);
+            void cullHiddenGroups(const OcclusionScene &scene, const Viewpoint &viewpoint, std::vector<uint32_t> &candidates,
+                                  const std::vector<uint8_t> &everDeferred, std::vector<uint32_t> &deferred);
 
             /**
-             * @brief Check if a mesh is within the camera frustum
-             * @param meshBounds The bounding box of the mesh
+             * @brief Decide which candidate meshes are visible from one viewpoint
+             *
+             * Each candidate gets a budget of area-weighted surface samples
+             * between minSurfaceSamples and maxSurfaceSamples, scaled by its
+             * projected size. Samples are traced in rounds of doubling size;
+             * rays of a round are sorted by the screen tile they pass through
+             * and traced in packets of m_options.rayPacketSize rays. A
+             * candidate drops out as soon as enough samples are visible, or
+             * too many occluded, to settle the occlusionThreshold test.
+             *
+             * @param scene The occlusion scene; every other mesh is a potential occluder
              * @param viewpoint The viewpoint to test from
-             * @return True if the mesh is within the frustum
+             * @param cameraToWorld Camera basis of the viewpoint, used to find screen tiles
+             * @param candidates Meshes inside the view frustum
+             * @param visibleFractions Receives the fraction of traced samples that reached the camera, per candidate
+             * @param tracedRays Receives the number of rays traced, per candidate
+             * @return One flag per candidate, non-zero if the mesh is visible
              */
-            bool isMeshInFrustum(const GfBBox3d &meshBounds, const Viewpoint &viewpoint);
+            std::vector<uint8_t> findVisibleCandidates(const OcclusionScene &scene,
+                                                       const Viewpoint &viewpoint,
+                                                       const GfMatrix4d &cameraToWorld,
+                                                       const std::vector<uint32_t> &candidates,
+                                                       std::vector<float> &visibleFractions,
+                                                       std::vector<uint32_t> &tracedRays);
 
             /**
-             * @brief Perform ray-mesh intersection test
-             * @param ray The ray to test
-             * @param mesh The mesh to test against
-             * @return True if the ray intersects the mesh
+             * @brief Find the triangles of the tested meshes that some viewpoint sees
+             *
+             * Each triangle is sampled at triangleSamples fixed barycentric
+             * points and is visible once a ray from a viewpoint reaches one of
+             * them inside its field of view. Unlike the mesh tests, a
+             * triangle's own mesh occludes it as well, so faces behind other
+             * parts of the same mesh count as hidden. Faces are not culled by
+             * orientation, since meshes are often rendered double-sided.
+             *
+             * @param scene The occlusion scene; its ray caster must have been built
+             * @param viewpoints The viewpoints to test from
+             * @param testedMeshes Non-zero for the meshes whose triangles are tested, indexed like scene.meshes
+             * @return One flag per snapshot triangle, non-zero if visible; triangles of untested meshes stay zero
              */
-            bool rayMeshIntersection(const GfRay &ray, const UsdGeomMesh &mesh);
+            std::vector<uint8_t> findVisibleTriangles(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                                      const std::vector<uint8_t> &testedMeshes);
 
             /**
-             * @brief Get the bounding box of a mesh
-             * @param mesh The mesh to get bounds for
-             * @return The bounding box of the mesh
+             * @brief Remove the faces of visible meshes that no viewpoint sees, with the points only they used
+             *
+             * A face stays if any of its triangles is visible. Instanced
+             * meshes, meshes of unloaded payloads and meshes whose faces are
+             * all hidden are left unchanged; see MeshCompactor for the meshes
+             * it refuses to edit.
              */
-            GfBBox3d getMeshBounds(const UsdGeomMesh &mesh);
+            void removeHiddenFaces(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                   const std::vector<MeshVisibility> &visibility);
 
             /**
-             * @brief Calculate the scene bounding box
+             * @brief Fill m_report from the verdicts, m_meshCosts and the phase timings, and write it if reportPath is set
+             */
+            void buildReport(const OcclusionScene &scene, const std::vector<MeshVisibility> &visibility);
+
+            /**
+             * @brief Calculate the world-space scene bounding box
              * @param stage The USD stage
+             * @param worldCache Shared bounds cache, populated for the whole stage by this call
              * @return The bounding box containing all geometry
              */
-            GfBBox3d calculateSceneBounds(UsdStagePtr stage);
+            GfBBox3d calculateSceneBounds(UsdStagePtr stage, WorldSpaceCache &worldCache);
 
             /**
-             * @brief Check if a mesh is instanced (referenced multiple times)
+             * @brief Check if a mesh prim is itself an instance, so hiding it would affect its prototype
              * @param mesh The mesh to check
              * @param stage The USD stage
              * @return True if the mesh is instanced
@@ -217,17 +757,12 @@ namespace workbench
              */
             void logVerbose(const std::string &message) const;
 
-            /**
-             * @brief Sample points on the mesh surface for visibility testing
-             * @param mesh The mesh to sample
-             * @param numSamples Number of sample points to generate
-             * @return Vector of sample points on the mesh surface
-             */
-            std::vector<GfVec3d> sampleMeshSurface(const UsdGeomMesh &mesh, size_t numSamples = 16);
-
         private:
             RemovalOptions m_options;
             RemovalStats m_stats;
+            std::vector<MeshCost> m_meshCosts; ///< Indexed like the occlusion scene's meshes of the current run
+            VisibilityReport m_report;
+            std::vector<std::string> m_orphanedTextures;
         };
 
     } // namespace optimizer
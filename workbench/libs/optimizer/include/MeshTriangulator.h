@@ -4,8 +4,11 @@
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/primvar.h>
 #include <pxr/base/vt/array.h>
 #include <pxr/base/gf/vec3f.h>
+#include <string>
+#include <utility>
 #include <vector>
 
 PXR_NAMESPACE_USING_DIRECTIVE
@@ -15,6 +18,9 @@ namespace workbench
     namespace optimizer
     {
 
+        struct TriangulationLayout;
+        class TopologyCache;
+
         /**
          * @brief A utility class for triangulating meshes in USD stages
          *
@@ -33,6 +39,9 @@ namespace workbench
                 bool preserveOriginalPrimvars = true; ///< Whether to preserve original primvar data
                 bool inPlace = false;                 ///< Whether to modify meshes in-place or create new ones
                 bool verbose = false;                 ///< Enable verbose logging
+                int numThreads = 0;                   ///< Worker threads for triangulateStage (0 = keep the current Work limit, negative = all cores but N)
+                bool shareTopology = true;            ///< Triangulate each distinct topology once per triangulateStage and share the result arrays
+                bool allTimeSamples = false;          ///< Triangulate every time sample of the topology and face-varying primvar indices, not only the default value
 
                 TriangulationOptions() = default;
             };
@@ -46,6 +55,7 @@ namespace workbench
                 size_t facesTriangulated = 0;
                 size_t originalFaceCount = 0;
                 size_t finalFaceCount = 0;
+                size_t sharedTopologies = 0; ///< Triangulated meshes whose triangulation an earlier mesh in traversal order already received
 
                 void reset()
                 {
@@ -53,6 +63,7 @@ namespace workbench
                     facesTriangulated = 0;
                     originalFaceCount = 0;
                     finalFaceCount = 0;
+                    sharedTopologies = 0;
                 }
             };
 
@@ -69,6 +80,12 @@ namespace workbench
 
             /**
              * @brief Triangulate all meshes in a USD stage
+             *
+             * The triangulated topology of every mesh is computed in parallel
+             * from the unchanged stage, then authored on the calling thread in
+             * traversal order inside a single SdfChangeBlock. Results, messages
+             * and statistics are the same as triangulating the meshes one by one.
+             *
              * @param stage The USD stage containing meshes to triangulate
              * @return True if triangulation was successful, false otherwise
              */
@@ -76,6 +93,11 @@ namespace workbench
 
             /**
              * @brief Triangulate a specific mesh primitive
+             *
+             * With allTimeSamples, the default value and every time sample of
+             * the topology are triangulated; identical topologies among the
+             * samples are triangulated once.
+             *
              * @param mesh The USD mesh primitive to triangulate
              * @return True if triangulation was successful, false otherwise
              */
@@ -89,6 +111,28 @@ namespace workbench
              */
             bool triangulateMesh(UsdGeomMesh &mesh, UsdTimeCode timeCode);
 
+            /**
+             * @brief Fan-triangulate a topology without a mesh prim
+             *
+             * Sizes the output with one pass over the counts and fills it in a
+             * second, with kernels specialised for all-triangle, all-quad and
+             * mixed topologies. Faces with fewer than 3 vertices are dropped.
+             *
+             * @param faceVertexCounts Input face vertex counts
+             * @param faceVertexIndices Input face vertex indices
+             * @param triangulatedCounts Output triangulated face counts (all 3s)
+             * @param triangulatedIndices Output triangulated face indices
+             * @return False if a count is negative or the counts need more indices than given
+             */
+            static bool triangulateTopology(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices,
+                                            VtIntArray &triangulatedCounts, VtIntArray &triangulatedIndices);
+
+            /**
+             * @brief Name of the instruction set the triangulation kernels were compiled for
+             * @return "AVX2", "SSE" or "scalar"
+             */
+            static const char *getKernelName();
+
             /**
              * @brief Get triangulation statistics
              * @return Reference to the current statistics
@@ -114,32 +158,75 @@ namespace workbench
 
         private:
             /**
-             * @brief Triangulate face vertex counts and indices
+             * @brief Triangulated topology of one mesh, computed without touching the stage
+             */
+            struct MeshTriangulation
+            {
+                bool valid = false;              ///< Whether the topology could be read
+                bool needsTriangulation = false; ///< Whether any face has more than 3 vertices
+                size_t originalFaceCount = 0;
+                size_t facesTriangulated = 0;
+                VtIntArray triangulatedCounts;
+                VtIntArray triangulatedIndices;
+                std::vector<std::pair<UsdGeomPrimvar, VtIntArray>> primvarIndices; ///< New indices of face-varying primvars
+                bool primvarsFailed = false;
+                std::vector<std::string> errors; ///< Errors and warnings in the order the serial path printed them
+            };
+
+            /**
+             * @brief Read a mesh and build its triangulated topology and primvar indices
+             *
+             * Only reads the stage and touches no member state, so meshes can be
+             * computed concurrently.
+             *
+             * @param cache Shares results between meshes with identical topology; may be null
+             */
+            void computeTriangulation(const UsdGeomMesh &mesh, UsdTimeCode timeCode, TopologyCache *cache, MeshTriangulation &result) const;
+
+            /**
+             * @brief Times at which to triangulate a mesh
+             *
+             * Default only, unless allTimeSamples is set. Then the union of the
+             * time samples of faceVertexCounts, faceVertexIndices and, when
+             * primvars are preserved, face-varying primvar indices, preceded by
+             * the default time if both topology attributes have a default value.
+             * Authoring every time in the union keeps held values consistent
+             * between attributes sampled at different times.
+             */
+            std::vector<UsdTimeCode> getTopologyTimes(const UsdGeomMesh &mesh) const;
+
+            /**
+             * @brief Print the messages of a computed triangulation, update the statistics and author the result
+             * @param authorUnchanged Author a time sample that needed no triangulation as well, because
+             *        another sample of the mesh was triangulated and would otherwise be held over it
+             * @return True if the mesh was triangulated or did not need it
+             */
+            bool authorTriangulation(UsdGeomMesh &mesh, UsdTimeCode timeCode, const MeshTriangulation &result, bool authorUnchanged);
+
+            /**
+             * @brief Triangulate face vertex counts and indices into exactly sized arrays
              * @param faceVertexCounts Input face vertex counts
              * @param faceVertexIndices Input face vertex indices
-             * @param triangulatedCounts Output triangulated face counts (all 3s)
-             * @param triangulatedIndices Output triangulated face indices
-             * @return True if triangulation was successful
+             * @param layout Result of measureTriangulation for faceVertexCounts
+             * @param cache Source of shared results; if null the triangulated counts are created here as well
+             * @param result Receives the triangulated indices, whether they were shared, and a warning per degenerate face
+             * @return False if a count is negative or the counts need more indices than given
              */
-            bool triangulateFaces(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices, VtIntArray &triangulatedCounts, VtIntArray &triangulatedIndices);
+            static bool triangulateFaces(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices, const TriangulationLayout &layout,
+                                         TopologyCache *cache, MeshTriangulation &result);
 
             /**
              * @brief Triangulate primvar data to match new face topology
              * @param mesh The mesh being triangulated
              * @param originalFaceCounts Original face vertex counts
+             * @param layout Result of measureTriangulation for originalFaceCounts
              * @param timeCode Time code for the sample
+             * @param cache Shares primvar indices between meshes; may be null
+             * @param result Receives the new primvar indices and any warnings
              * @return True if primvar triangulation was successful
              */
-            bool triangulatePrimvars(UsdGeomMesh &mesh, const VtIntArray &originalFaceCounts, UsdTimeCode timeCode);
-
-            /**
-             * @brief Triangulate a single face using fan triangulation
-             * @param faceVertexCount Number of vertices in the face
-             * @param startIndex Starting index in the vertex index array
-             * @param faceVertexIndices Input face vertex indices
-             * @param triangulatedIndices Output triangulated indices (appended to)
-             */
-            void triangulateFace(int faceVertexCount, int startIndex, const VtIntArray &faceVertexIndices, VtIntArray &triangulatedIndices);
+            static bool triangulatePrimvars(const UsdGeomMesh &mesh, const VtIntArray &originalFaceCounts, const TriangulationLayout &layout, UsdTimeCode timeCode,
+                                            TopologyCache *cache, MeshTriangulation &result);
 
             /**
              * @brief Log a message if verbose mode is enabled
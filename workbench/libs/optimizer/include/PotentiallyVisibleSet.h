@@ -0,0 +1,168 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3i.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Cell-to-visible-mesh tables for culling at load time
+         *
+         * The scene bounds are split into a regular grid of cells. Each
+         * navigable cell references a bitset with one bit per mesh, set if the
+         * mesh may be seen from somewhere in the cell. Neighbouring cells
+         * usually see the same meshes, so identical bitsets are stored once
+         * and cells only hold an index into them.
+         *
+         * Every query is constant time: a position maps to its cell by
+         * arithmetic, a cell to its bitset by one lookup. Positions outside
+         * the grid and cells that are not navigable have no table; they
+         * report every mesh as visible, so a runtime never culls on missing
+         * data.
+         *
+         * HiddenMeshRemover::computePotentiallyVisibleSet() fills the set;
+         * save() and load() use a little-endian binary sidecar file on every
+         * host, so sets can be shared between platforms.
+         */
+        class PotentiallyVisibleSet
+        {
+        public:
+            static constexpr uint32_t kNoCell = std::numeric_limits<uint32_t>::max();
+            static constexpr uint32_t kNoMesh = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * @brief Start an empty set in which no cell is navigable
+             * @param bounds World-space region covered by the grid
+             * @param resolution Cells along each axis, at least 1
+             * @param meshPaths Path of each mesh; bit i of every bitset refers to meshPaths[i]
+             */
+            void reset(const GfRange3d &bounds, const GfVec3i &resolution, const std::vector<std::string> &meshPaths);
+
+            /**
+             * @brief Make a cell navigable with the given visible meshes
+             * @param cell Cell index from getCellIndex() or findCell()
+             * @param visibleMeshes One flag per mesh, non-zero if visible
+             */
+            void setVisibleMeshes(uint32_t cell, const std::vector<uint8_t> &visibleMeshes);
+
+            /**
+             * @brief Write the set, replacing the file atomically
+             * @return False if the file could not be written
+             */
+            bool save(const std::string &path) const;
+
+            /**
+             * @brief Replace the set with the contents of a file written by save()
+             * @return False, leaving the set empty, if the file is missing or not a valid set
+             */
+            bool load(const std::string &path);
+
+            /**
+             * @brief Cell containing a world-space position
+             * @return kNoCell if the position lies outside the grid
+             */
+            uint32_t findCell(const GfVec3d &position) const;
+
+            /**
+             * @brief Cell at integer grid coordinates, which must lie inside the grid
+             */
+            uint32_t getCellIndex(int x, int y, int z) const
+            {
+                return static_cast<uint32_t>((static_cast<size_t>(z) * m_resolution[1] + y) * m_resolution[0] + x);
+            }
+
+            /**
+             * @brief World-space bounds of one cell
+             */
+            GfRange3d getCellBounds(uint32_t cell) const;
+
+            /**
+             * @brief Whether a cell has a visibility table
+             */
+            bool isNavigable(uint32_t cell) const
+            {
+                return cell < m_cellMasks.size() && m_cellMasks[cell] != kNoMask;
+            }
+
+            /**
+             * @brief Whether a mesh may be seen from a cell; true without a table for the cell or for unknown meshes
+             */
+            bool isVisible(uint32_t cell, uint32_t mesh) const
+            {
+                if (!isNavigable(cell) || mesh >= m_meshPaths.size())
+                {
+                    return true;
+                }
+                const uint64_t *bits = getMask(cell);
+                return (bits[mesh / 64] >> (mesh % 64)) & 1u;
+            }
+
+            /**
+             * @brief Whether a mesh may be seen from a world-space position
+             */
+            bool isVisible(const GfVec3d &position, uint32_t mesh) const { return isVisible(findCell(position), mesh); }
+
+            /**
+             * @brief Bitset of a navigable cell, getWordsPerCell() words with bit i for mesh i
+             */
+            const uint64_t *getMask(uint32_t cell) const { return &m_masks[static_cast<size_t>(m_cellMasks[cell]) * m_wordsPerMask]; }
+
+            /**
+             * @brief Indices of the meshes visible from a cell; every mesh without a table
+             */
+            std::vector<uint32_t> getVisibleMeshes(uint32_t cell) const;
+
+            /**
+             * @brief Index of a mesh by its path
+             * @return kNoMesh if the mesh is not part of the set
+             */
+            uint32_t findMesh(const std::string &meshPath) const;
+
+            const std::vector<std::string> &getMeshPaths() const { return m_meshPaths; }
+            size_t getMeshCount() const { return m_meshPaths.size(); }
+            size_t getCellCount() const { return m_cellMasks.size(); }
+            size_t getNavigableCellCount() const;
+            size_t getUniqueMaskCount() const { return m_wordsPerMask == 0 ? 0 : m_masks.size() / m_wordsPerMask; }
+            size_t getWordsPerCell() const { return m_wordsPerMask; }
+            const GfRange3d &getBounds() const { return m_bounds; }
+            const GfVec3i &getResolution() const { return m_resolution; }
+
+            /**
+             * @brief Bytes held by the bitsets and the cell table
+             */
+            size_t getMemoryUsage() const
+            {
+                return m_masks.capacity() * sizeof(uint64_t) + m_cellMasks.capacity() * sizeof(uint32_t);
+            }
+
+        private:
+            static constexpr uint32_t kNoMask = std::numeric_limits<uint32_t>::max();
+
+            void clear();
+
+            GfRange3d m_bounds;
+            GfVec3i m_resolution = GfVec3i(0);
+            GfVec3d m_cellSize = GfVec3d(0.0);
+            std::vector<std::string> m_meshPaths;
+            std::unordered_map<std::string, uint32_t> m_meshIndices;
+
+            size_t m_wordsPerMask = 0;
+            std::vector<uint64_t> m_masks;     ///< Distinct bitsets, m_wordsPerMask words each
+            std::vector<uint32_t> m_cellMasks; ///< Bitset of each cell, or kNoMask if it is not navigable
+            std::unordered_multimap<uint64_t, uint32_t> m_maskLookup; ///< Hash to bitset, only used while filling
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3d.h>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Per-mesh results and phase timings of one hidden mesh analysis
+         *
+         * Filled by HiddenMeshRemover after removeHiddenMeshes() or
+         * analyzeHiddenMeshes() and meant for tuning options on large assets:
+         * which meshes cost the most, which ones barely made it, and where
+         * the wall-clock time of a run went.
+         *
+         * Per-mesh seconds are an estimate. Viewpoints are timed as a whole;
+         * the ray engine splits each viewpoint's time over the meshes it
+         * tested in proportion to the rays traced for them, the raster
+         * engine over the rendered meshes in proportion to their triangles.
+         * The raster engine renders views on several threads at once, so
+         * its per-mesh seconds add up to CPU time rather than wall-clock time.
+         */
+        class VisibilityReport
+        {
+        public:
+            /**
+             * @brief Outcome and cost of one analysed mesh
+             */
+            struct MeshEntry
+            {
+                std::string path;
+                std::string verdict;                  ///< "visible", "hidden" or "preserved"
+                float score = 0.0f;                   ///< Highest visible sample fraction (ray engine), pixel count (raster engine) or 1 if the fill reached it (voxel engine)
+                bool hasBestViewpoint = false;        ///< False if no viewpoint saw any of the mesh, or the verdict was cached
+                GfVec3d bestPosition = GfVec3d(0.0);  ///< Position of the viewpoint that reached the score
+                GfVec3d bestDirection = GfVec3d(0.0); ///< View direction of that viewpoint
+                size_t raysTraced = 0;                ///< Occlusion rays cast for the mesh (ray engine)
+                size_t triangleCount = 0;
+                double seconds = 0.0;                 ///< Estimated share of the visibility-test time
+                bool cached = false;                  ///< Verdict reused from the visibility cache
+            };
+
+            /**
+             * @brief Wall-clock time of one analysis phase
+             */
+            struct Phase
+            {
+                std::string name;
+                double seconds = 0.0;
+            };
+
+            void clear();
+
+            void addMesh(MeshEntry entry) { m_meshes.push_back(std::move(entry)); }
+            void addPhase(const std::string &name, double seconds) { m_phases.push_back(Phase{name, seconds}); }
+
+            /**
+             * @brief Write the report, as CSV if the path ends in ".csv" and as JSON otherwise
+             *
+             * As CSV, the meshes go to the path and the phase timings to a
+             * second file next to it, "scene.phases.csv" for "scene.csv".
+             *
+             * @return False if a file could not be written
+             */
+            bool save(const std::string &path) const;
+
+            /**
+             * @brief Write one JSON object with a "phases" object and a "meshes" array
+             */
+            void writeJson(std::ostream &stream) const;
+
+            /**
+             * @brief Write one CSV row per mesh after a header row
+             */
+            void writeCsv(std::ostream &stream) const;
+
+            /**
+             * @brief Write one CSV row per phase after a "phase,seconds" header row
+             */
+            void writePhasesCsv(std::ostream &stream) const;
+
+            const std::vector<MeshEntry> &getMeshes() const { return m_meshes; }
+            const std::vector<Phase> &getPhases() const { return m_phases; }
+
+        private:
+            std::vector<MeshEntry> m_meshes;
+            std::vector<Phase> m_phases;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "HiddenMeshRemover.h"
+#include <pxr/pxr.h>
+#include <pxr/base/tf/notice.h>
+#include <pxr/base/tf/weakBase.h>
+#include <pxr/usd/usd/notice.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/sdf/path.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Hidden mesh analysis that stays up to date while a stage is edited
+         *
+         * The session keeps the geometry snapshot, acceleration structures and
+         * verdicts of a full analysis alive and listens for stage changes.
+         * Edits to mesh points or topology and to transforms are queued by the
+         * change notice; update() re-reads only those meshes, refits the BVHs
+         * over them and re-tests the meshes near the changed region. Adding,
+         * removing or resyncing prims, or a change of point or triangle count,
+         * falls back to a full analysis, as does any edit to an instance
+         * proxy, a point instancer or a prototype they share.
+         *
+         * Nearby means within one bounding-box diagonal of the old or new
+         * bounds of a changed mesh, the same neighbourhood the visibility
+         * cache uses. Viewpoints are those of the last full analysis. Meshes
+         * only revealed through a distant change keep their old verdict until
+         * analyze() is called again.
+         *
+         * The session never authors to the stage; use getHiddenMeshes() to
+         * act on the results.
+         */
+        class VisibilitySession : public TfWeakBase
+        {
+        public:
+            /**
+             * @brief Start listening to a stage; call analyze() for the first verdicts
+             * @param stage Stage to analyze; must outlive the session
+             * @param options Options for every analysis of this session
+             */
+            VisibilitySession(UsdStagePtr stage, const HiddenMeshRemover::RemovalOptions &options);
+            ~VisibilitySession();
+
+            VisibilitySession(const VisibilitySession &) = delete;
+            VisibilitySession &operator=(const VisibilitySession &) = delete;
+
+            /**
+             * @brief Analyze the whole stage and drop all queued changes
+             * @return False if the stage is invalid or there are no viewpoints
+             */
+            bool analyze();
+
+            /**
+             * @brief Whether edits were queued since the last analyze() or update()
+             *
+             * Safe to call from any thread.
+             */
+            bool hasPendingChanges() const;
+
+            /**
+             * @brief Apply the queued edits to the verdicts
+             * @return Number of meshes tested again; all meshes after a full analysis
+             */
+            size_t update();
+
+            /**
+             * @brief Whether the last verdict for a mesh is hidden
+             */
+            bool isHidden(const SdfPath &meshPath) const;
+
+            /**
+             * @brief Paths of all meshes currently considered hidden
+             */
+            std::vector<SdfPath> getHiddenMeshes() const;
+
+            /**
+             * @brief Statistics of the last analysis, with verdict counts kept current by update()
+             */
+            const HiddenMeshRemover::RemovalStats &getStats() const { return m_remover.getStats(); }
+
+        private:
+            using OcclusionScene = HiddenMeshRemover::OcclusionScene;
+            using MeshVisibility = HiddenMeshRemover::MeshVisibility;
+
+            void onObjectsChanged(const UsdNotice::ObjectsChanged &notice, const UsdStageWeakPtr &sender);
+
+            /**
+             * @brief Mesh indices touched by the queued edits, sorted and unique
+             */
+            std::vector<uint32_t> resolveChangedMeshes(const std::unordered_set<SdfPath, SdfPath::Hash> &meshPaths,
+                                                       const std::unordered_set<SdfPath, SdfPath::Hash> &xformPaths) const;
+
+            /**
+             * @brief Recount hidden and preserved meshes into the statistics
+             */
+            void countVerdicts();
+
+            UsdStagePtr m_stage;
+            HiddenMeshRemover m_remover;
+            std::unique_ptr<OcclusionScene> m_scene;
+            std::vector<HiddenMeshRemover::Viewpoint> m_viewpoints;
+            std::vector<MeshVisibility> m_visibility; ///< Indexed like m_scene->meshes
+            std::unordered_map<SdfPath, uint32_t, SdfPath::Hash> m_meshIndices;
+
+            TfNotice::Key m_noticeKey;
+            mutable std::mutex m_pendingMutex;
+            std::unordered_set<SdfPath, SdfPath::Hash> m_pendingMeshes; ///< Meshes or instancers whose geometry changed
+            std::unordered_set<SdfPath, SdfPath::Hash> m_pendingXforms; ///< Prims whose transform changed
+            bool m_pendingRebuild = false;                              ///< Prims were added, removed or resynced
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,284 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <numeric>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr int kBinCount = 16;
+
+            // Below this depth every split falls back to a median split, which
+            // keeps the traversal stack in intersectRay() bounded
+            constexpr uint32_t kMaxSahDepth = 48;
+
+            float surfaceArea(const GfVec3f &boundsMin, const GfVec3f &boundsMax)
+            {
+                GfVec3f extent = boundsMax - boundsMin;
+                if (extent[0] < 0.0f || extent[1] < 0.0f || extent[2] < 0.0f)
+                {
+                    return 0.0f;
+                }
+                return 2.0f * (extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0]);
+            }
+
+            struct Bin
+            {
+                GfVec3f boundsMin{std::numeric_limits<float>::max()};
+                GfVec3f boundsMax{-std::numeric_limits<float>::max()};
+                uint32_t count = 0;
+
+                void grow(const GfVec3f &minPoint, const GfVec3f &maxPoint)
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        boundsMin[i] = std::min(boundsMin[i], minPoint[i]);
+                        boundsMax[i] = std::max(boundsMax[i], maxPoint[i]);
+                    }
+                }
+            };
+        } // namespace
+
+        void Bvh::build(const std::vector<GfRange3f> &primitiveBounds, uint32_t maxLeafSize)
+        {
+            m_nodes.clear();
+            m_primitiveIndices.clear();
+            m_maxLeafSize = std::max(1u, maxLeafSize);
+
+            if (primitiveBounds.empty())
+            {
+                return;
+            }
+
+            m_buildPrimitives.resize(primitiveBounds.size());
+            for (size_t i = 0; i < primitiveBounds.size(); ++i)
+            {
+                BuildPrimitive &prim = m_buildPrimitives[i];
+                if (primitiveBounds[i].IsEmpty())
+                {
+                    // Keep empty primitives addressable but make them unhittable
+                    prim.boundsMin = GfVec3f(std::numeric_limits<float>::max());
+                    prim.boundsMax = GfVec3f(-std::numeric_limits<float>::max());
+                    prim.centroid = GfVec3f(0.0f);
+                    continue;
+                }
+                prim.boundsMin = primitiveBounds[i].GetMin();
+                prim.boundsMax = primitiveBounds[i].GetMax();
+                prim.centroid = (prim.boundsMin + prim.boundsMax) * 0.5f;
+            }
+
+            m_primitiveIndices.resize(primitiveBounds.size());
+            std::iota(m_primitiveIndices.begin(), m_primitiveIndices.end(), 0u);
+
+            // A binary tree with N leaves has at most 2N - 1 nodes
+            m_nodes.reserve(primitiveBounds.size() * 2);
+            m_nodes.emplace_back();
+            buildNode(0, 0, static_cast<uint32_t>(primitiveBounds.size()), 0);
+
+            m_nodes.shrink_to_fit();
+            m_buildPrimitives.clear();
+            m_buildPrimitives.shrink_to_fit();
+        }
+
+        void Bvh::updateNodeBounds(Node &node, uint32_t first, uint32_t count) const
+        {
+            node.boundsMin = GfVec3f(std::numeric_limits<float>::max());
+            node.boundsMax = GfVec3f(-std::numeric_limits<float>::max());
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const BuildPrimitive &prim = m_buildPrimitives[m_primitiveIndices[i]];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    node.boundsMin[axis] = std::min(node.boundsMin[axis], prim.boundsMin[axis]);
+                    node.boundsMax[axis] = std::max(node.boundsMax[axis], prim.boundsMax[axis]);
+                }
+            }
+        }
+
+        void Bvh::buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth)
+        {
+            updateNodeBounds(m_nodes[nodeIndex], first, count);
+
+            if (count <= m_maxLeafSize)
+            {
+                m_nodes[nodeIndex].firstOrChild = first;
+                m_nodes[nodeIndex].primitiveCount = count;
+                return;
+            }
+
+            // Centroid bounds decide the bin layout
+            GfVec3f centroidMin(std::numeric_limits<float>::max());
+            GfVec3f centroidMax(-std::numeric_limits<float>::max());
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                const GfVec3f &c = m_buildPrimitives[m_primitiveIndices[i]].centroid;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    centroidMin[axis] = std::min(centroidMin[axis], c[axis]);
+                    centroidMax[axis] = std::max(centroidMax[axis], c[axis]);
+                }
+            }
+
+            int bestAxis = -1;
+            int bestSplit = 0;
+            float bestCost = std::numeric_limits<float>::max();
+
+            if (depth < kMaxSahDepth)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float extent = centroidMax[axis] - centroidMin[axis];
+                    if (extent <= 0.0f)
+                    {
+                        continue;
+                    }
+
+                    Bin bins[kBinCount];
+                    float scale = kBinCount / extent;
+                    for (uint32_t i = first; i < first + count; ++i)
+                    {
+                        const BuildPrimitive &prim = m_buildPrimitives[m_primitiveIndices[i]];
+                        int binIndex = std::min(kBinCount - 1, static_cast<int>((prim.centroid[axis] - centroidMin[axis]) * scale));
+                        bins[binIndex].count++;
+                        bins[binIndex].grow(prim.boundsMin, prim.boundsMax);
+                    }
+
+                    // Sweep from both sides to evaluate every bin boundary
+                    float leftArea[kBinCount - 1], rightArea[kBinCount - 1];
+                    uint32_t leftCount[kBinCount - 1], rightCount[kBinCount - 1];
+                    Bin leftBox, rightBox;
+                    uint32_t leftSum = 0, rightSum = 0;
+                    for (int i = 0; i < kBinCount - 1; ++i)
+                    {
+                        leftSum += bins[i].count;
+                        leftCount[i] = leftSum;
+                        leftBox.grow(bins[i].boundsMin, bins[i].boundsMax);
+                        leftArea[i] = surfaceArea(leftBox.boundsMin, leftBox.boundsMax);
+
+                        rightSum += bins[kBinCount - 1 - i].count;
+                        rightCount[kBinCount - 2 - i] = rightSum;
+                        rightBox.grow(bins[kBinCount - 1 - i].boundsMin, bins[kBinCount - 1 - i].boundsMax);
+                        rightArea[kBinCount - 2 - i] = surfaceArea(rightBox.boundsMin, rightBox.boundsMax);
+                    }
+
+                    for (int i = 0; i < kBinCount - 1; ++i)
+                    {
+                        if (leftCount[i] == 0 || rightCount[i] == 0)
+                        {
+                            continue;
+                        }
+                        float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = i;
+                        }
+                    }
+                }
+            }
+
+            const Node &node = m_nodes[nodeIndex];
+            float leafCost = count * surfaceArea(node.boundsMin, node.boundsMax);
+
+            uint32_t middle = first;
+            if (bestAxis >= 0)
+            {
+                // Small nodes become leaves when splitting does not pay off
+                if (bestCost >= leafCost && count <= m_maxLeafSize * 4)
+                {
+                    m_nodes[nodeIndex].firstOrChild = first;
+                    m_nodes[nodeIndex].primitiveCount = count;
+                    return;
+                }
+
+                float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+                float scale = kBinCount / extent;
+                auto begin = m_primitiveIndices.begin() + first;
+                auto inLeftHalf = [&](uint32_t index)
+                {
+                    float c = m_buildPrimitives[index].centroid[bestAxis];
+                    int binIndex = std::min(kBinCount - 1, static_cast<int>((c - centroidMin[bestAxis]) * scale));
+                    return binIndex <= bestSplit;
+                };
+                auto split = std::partition(begin, begin + count, inLeftHalf);
+                middle = static_cast<uint32_t>(split - m_primitiveIndices.begin());
+            }
+
+            if (middle == first || middle == first + count)
+            {
+                // Coincident centroids or depth limit: split at the median of the widest axis
+                GfVec3f extent = centroidMax - centroidMin;
+                int axis = 0;
+                if (extent[1] > extent[axis])
+                    axis = 1;
+                if (extent[2] > extent[axis])
+                    axis = 2;
+
+                middle = first + count / 2;
+                auto begin = m_primitiveIndices.begin() + first;
+                std::nth_element(begin, m_primitiveIndices.begin() + middle, begin + count,
+                                 [&](uint32_t a, uint32_t b)
+                                 { return m_buildPrimitives[a].centroid[axis] < m_buildPrimitives[b].centroid[axis]; });
+            }
+
+            uint32_t leftChild = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+            m_nodes.emplace_back();
+            m_nodes[nodeIndex].firstOrChild = leftChild;
+            m_nodes[nodeIndex].primitiveCount = 0;
+
+            buildNode(leftChild, first, middle - first, depth + 1);
+            buildNode(leftChild + 1, middle, first + count - middle, depth + 1);
+        }
+
+        void Bvh::refit(const std::vector<GfRange3f> &primitiveBounds)
+        {
+            // Children are always stored after their parent, so a reverse sweep sees them first
+            for (size_t nodeIndex = m_nodes.size(); nodeIndex-- > 0;)
+            {
+                Node &node = m_nodes[nodeIndex];
+                node.boundsMin = GfVec3f(std::numeric_limits<float>::max());
+                node.boundsMax = GfVec3f(-std::numeric_limits<float>::max());
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t slot = node.firstOrChild; slot < node.firstOrChild + node.primitiveCount; ++slot)
+                    {
+                        const GfRange3f &bounds = primitiveBounds[m_primitiveIndices[slot]];
+                        if (bounds.IsEmpty())
+                        {
+                            continue;
+                        }
+                        for (int axis = 0; axis < 3; ++axis)
+                        {
+                            node.boundsMin[axis] = std::min(node.boundsMin[axis], bounds.GetMin()[axis]);
+                            node.boundsMax[axis] = std::max(node.boundsMax[axis], bounds.GetMax()[axis]);
+                        }
+                    }
+                    continue;
+                }
+
+                for (uint32_t child = node.firstOrChild; child < node.firstOrChild + 2; ++child)
+                {
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        node.boundsMin[axis] = std::min(node.boundsMin[axis], m_nodes[child].boundsMin[axis]);
+                        node.boundsMax[axis] = std::max(node.boundsMax[axis], m_nodes[child].boundsMax[axis]);
+                    }
+                }
+            }
+        }
+
+        size_t Bvh::getMemoryUsage() const
+        {
+            return m_nodes.capacity() * sizeof(Node) + m_primitiveIndices.capacity() * sizeof(uint32_t);
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "RayPacket.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/range3f.h>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Bounding volume hierarchy over axis-aligned primitive bounds
+         *
+         * The hierarchy is built once with a binned surface area heuristic and
+         * stored as a flat node array. Primitives are identified by their index
+         * in the bounds array passed to build(); each leaf references a
+         * contiguous run of getPrimitiveIndices().
+         */
+        class Bvh
+        {
+        public:
+            /**
+             * @brief A single node of the flattened hierarchy (32 bytes)
+             *
+             * Interior nodes store the index of their left child; the right
+             * child always follows it directly.
+             */
+            struct Node
+            {
+                GfVec3f boundsMin;
+                uint32_t firstOrChild = 0; ///< First primitive slot for leaves, left child for interior nodes
+                GfVec3f boundsMax;
+                uint32_t primitiveCount = 0; ///< Number of primitives, zero for interior nodes
+
+                bool isLeaf() const { return primitiveCount > 0; }
+            };
+
+            /**
+             * @brief Build the hierarchy over a set of primitive bounds
+             * @param primitiveBounds One bounding box per primitive
+             * @param maxLeafSize Largest number of primitives stored in a leaf
+             */
+            void build(const std::vector<GfRange3f> &primitiveBounds, uint32_t maxLeafSize = 4);
+
+            /**
+             * @brief Update node bounds for moved primitives, keeping the tree topology
+             *
+             * Much cheaper than build(), but the tree gets looser the further
+             * primitives move from where they were when it was built.
+             *
+             * @param primitiveBounds One bounding box per primitive, same count as for build()
+             */
+            void refit(const std::vector<GfRange3f> &primitiveBounds);
+
+            /**
+             * @brief Visit every leaf primitive whose node is hit by a ray
+             *
+             * Nodes are visited front to back. The callback has the signature
+             * `bool(uint32_t primitive, float &tMax)`; it may shorten tMax to
+             * prune farther nodes and returns true to stop the traversal.
+             *
+             * @param origin Ray origin
+             * @param direction Ray direction (need not be normalized)
+             * @param tMax Largest ray parameter of interest
+             * @param leafFn Callback invoked for each candidate primitive
+             * @return True if the callback requested termination
+             */
+            template <typename LeafFn>
+            bool intersectRay(const GfVec3f &origin, const GfVec3f &direction, float tMax, LeafFn &&leafFn) const;
+
+            /**
+             * @brief Visit every leaf node hit by a ray, front to back
+             *
+             * Like intersectRay(), but the callback receives whole leaves with
+             * the signature `bool(uint32_t nodeIndex, const Node &leaf, float &tMax)`.
+             * This lets callers store per-leaf data such as packed triangles.
+             */
+            template <typename LeafFn>
+            bool traverseRay(const GfVec3f &origin, const GfVec3f &direction, float tMax, LeafFn &&leafFn) const;
+
+            /**
+             * @brief Visit every leaf node hit by at least one ray of a packet
+             *
+             * The packet descends the tree together; each node is tested once
+             * for all active rays and children are visited nearest first. The
+             * callback has the signature
+             * `uint32_t(uint32_t nodeIndex, const Node &leaf, uint32_t rayMask)`,
+             * receives the rays that overlap the leaf and returns the rays that
+             * are finished. Finished rays drop out of the traversal, which ends
+             * once no ray is left.
+             *
+             * @param packet Finalized ray packet
+             * @param activeMask Rays taking part in the traversal
+             * @param leafFn Callback invoked for each leaf node
+             * @return Mask of the rays the callback reported as finished
+             */
+            template <typename LeafFn>
+            uint32_t traversePacket(const RayPacket &packet, uint32_t activeMask, LeafFn &&leafFn) const;
+
+            /**
+             * @brief Visit every primitive of the leaves that overlap a box
+             *
+             * The callback has the signature `void(uint32_t primitive)`.
+             * Leaves hold several primitives, so callers test the primitive's
+             * own bounds if they need an exact overlap. Primitives are visited
+             * in no particular order.
+             */
+            template <typename PrimitiveFn>
+            void queryBox(const GfVec3f &boundsMin, const GfVec3f &boundsMax, PrimitiveFn &&primitiveFn) const;
+
+            /**
+             * @brief Slab test of a ray against an axis-aligned box
+             * @return True if the ray overlaps the box within [0, tMax]; tEntry receives the entry distance
+             */
+            static bool intersectBox(const GfVec3f &boundsMin, const GfVec3f &boundsMax,
+                                     const GfVec3f &origin, const GfVec3f &invDirection,
+                                     float tMax, float &tEntry);
+
+            /**
+             * @brief Compute a safe reciprocal of a ray direction for slab tests
+             */
+            static GfVec3f computeInverseDirection(const GfVec3f &direction);
+
+            bool empty() const { return m_nodes.empty(); }
+            const std::vector<Node> &getNodes() const { return m_nodes; }
+            const std::vector<uint32_t> &getPrimitiveIndices() const { return m_primitiveIndices; }
+
+            /**
+             * @brief Bytes used by the node and primitive index arrays
+             */
+            size_t getMemoryUsage() const;
+
+        private:
+            struct BuildPrimitive
+            {
+                GfVec3f boundsMin;
+                GfVec3f boundsMax;
+                GfVec3f centroid;
+            };
+
+            void buildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth);
+            void updateNodeBounds(Node &node, uint32_t first, uint32_t count) const;
+
+            std::vector<Node> m_nodes;
+            std::vector<uint32_t> m_primitiveIndices;
+            std::vector<BuildPrimitive> m_buildPrimitives; ///< Scratch data, only valid during build()
+            uint32_t m_maxLeafSize = 4;
+        };
+
+        inline GfVec3f Bvh::computeInverseDirection(const GfVec3f &direction)
+        {
+            GfVec3f inverse;
+            for (int i = 0; i < 3; ++i)
+            {
+                // Avoid 0 * inf = NaN in the slab test for axis-parallel rays
+                inverse[i] = (std::abs(direction[i]) > 1e-12f) ? 1.0f / direction[i]
+                                                                : std::copysign(1e30f, direction[i]);
+            }
+            return inverse;
+        }
+
+        inline bool Bvh::intersectBox(const GfVec3f &boundsMin, const GfVec3f &boundsMax,
+                                      const GfVec3f &origin, const GfVec3f &invDirection,
+                                      float tMax, float &tEntry)
+        {
+            float tNear = 0.0f;
+            float tFar = tMax;
+            for (int i = 0; i < 3; ++i)
+            {
+                float t1 = (boundsMin[i] - origin[i]) * invDirection[i];
+                float t2 = (boundsMax[i] - origin[i]) * invDirection[i];
+                tNear = std::max(tNear, std::min(t1, t2));
+                tFar = std::min(tFar, std::max(t1, t2));
+            }
+            tEntry = tNear;
+            return tNear <= tFar;
+        }
+
+        template <typename LeafFn>
+        bool Bvh::intersectRay(const GfVec3f &origin, const GfVec3f &direction, float tMax, LeafFn &&leafFn) const
+        {
+            return traverseRay(origin, direction, tMax,
+                               [&](uint32_t, const Node &leaf, float &currentTMax)
+                               {
+                                   for (uint32_t i = 0; i < leaf.primitiveCount; ++i)
+                                   {
+                                       if (leafFn(m_primitiveIndices[leaf.firstOrChild + i], currentTMax))
+                                       {
+                                           return true;
+                                       }
+                                   }
+                                   return false;
+                               });
+        }
+
+        template <typename LeafFn>
+        bool Bvh::traverseRay(const GfVec3f &origin, const GfVec3f &direction, float tMax, LeafFn &&leafFn) const
+        {
+            if (m_nodes.empty())
+            {
+                return false;
+            }
+
+            const GfVec3f invDirection = computeInverseDirection(direction);
+
+            // The build limits tree depth, so a fixed stack is sufficient
+            uint32_t stack[128];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0)
+            {
+                const uint32_t nodeIndex = stack[--stackSize];
+                const Node &node = m_nodes[nodeIndex];
+
+                float tEntry;
+                if (!intersectBox(node.boundsMin, node.boundsMax, origin, invDirection, tMax, tEntry))
+                {
+                    continue;
+                }
+
+                if (node.isLeaf())
+                {
+                    if (leafFn(nodeIndex, node, tMax))
+                    {
+                        return true;
+                    }
+                    continue;
+                }
+
+                // Push the farther child first so the nearer one is visited next
+                uint32_t left = node.firstOrChild;
+                uint32_t right = left + 1;
+                float tLeft, tRight;
+                bool hitLeft = intersectBox(m_nodes[left].boundsMin, m_nodes[left].boundsMax, origin, invDirection, tMax, tLeft);
+                bool hitRight = intersectBox(m_nodes[right].boundsMin, m_nodes[right].boundsMax, origin, invDirection, tMax, tRight);
+
+                if (hitLeft && hitRight)
+                {
+                    if (tLeft <= tRight)
+                    {
+                        stack[stackSize++] = right;
+                        stack[stackSize++] = left;
+                    }
+                    else
+                    {
+                        stack[stackSize++] = left;
+                        stack[stackSize++] = right;
+                    }
+                }
+                else if (hitLeft)
+                {
+                    stack[stackSize++] = left;
+                }
+                else if (hitRight)
+                {
+                    stack[stackSize++] = right;
+                }
+            }
+
+            return false;
+        }
+
+        template <typename LeafFn>
+        uint32_t Bvh::traversePacket(const RayPacket &packet, uint32_t activeMask, LeafFn &&leafFn) const
+        {
+            uint32_t finished = 0;
+            if (m_nodes.empty())
+            {
+                return finished;
+            }
+
+            float tEntry;
+            activeMask = intersectBoxPacket(m_nodes[0].boundsMin, m_nodes[0].boundsMax, packet, activeMask, tEntry);
+
+            // Each entry remembers which rays overlapped the node when its parent was tested
+            uint32_t stack[128];
+            uint32_t stackMasks[128];
+            uint32_t stackSize = 0;
+            if (activeMask != 0)
+            {
+                stack[stackSize] = 0;
+                stackMasks[stackSize++] = activeMask;
+            }
+
+            while (stackSize > 0 && activeMask != 0)
+            {
+                --stackSize;
+                const Node &node = m_nodes[stack[stackSize]];
+
+                // Rays may have finished since the node was pushed
+                const uint32_t nodeMask = stackMasks[stackSize] & activeMask;
+                if (nodeMask == 0)
+                {
+                    continue;
+                }
+
+                if (node.isLeaf())
+                {
+                    const uint32_t done = leafFn(stack[stackSize], node, nodeMask) & activeMask;
+                    finished |= done;
+                    activeMask &= ~done;
+                    continue;
+                }
+
+                uint32_t left = node.firstOrChild;
+                uint32_t right = left + 1;
+                float tLeft, tRight;
+                uint32_t leftMask = intersectBoxPacket(m_nodes[left].boundsMin, m_nodes[left].boundsMax, packet, nodeMask, tLeft);
+                uint32_t rightMask = intersectBoxPacket(m_nodes[right].boundsMin, m_nodes[right].boundsMax, packet, nodeMask, tRight);
+
+                // Push the farther child first so the nearer one is visited next
+                if (leftMask != 0 && rightMask != 0 && tLeft > tRight)
+                {
+                    std::swap(left, right);
+                    std::swap(leftMask, rightMask);
+                }
+                if (rightMask != 0)
+                {
+                    stack[stackSize] = right;
+                    stackMasks[stackSize++] = rightMask;
+                }
+                if (leftMask != 0)
+                {
+                    stack[stackSize] = left;
+                    stackMasks[stackSize++] = leftMask;
+                }
+            }
+
+            return finished;
+        }
+
+        template <typename PrimitiveFn>
+        void Bvh::queryBox(const GfVec3f &boundsMin, const GfVec3f &boundsMax, PrimitiveFn &&primitiveFn) const
+        {
+            auto overlaps = [&](const GfVec3f &nodeMin, const GfVec3f &nodeMax)
+            {
+                return nodeMin[0] <= boundsMax[0] && nodeMax[0] >= boundsMin[0] &&
+                       nodeMin[1] <= boundsMax[1] && nodeMax[1] >= boundsMin[1] &&
+                       nodeMin[2] <= boundsMax[2] && nodeMax[2] >= boundsMin[2];
+            };
+
+            uint32_t stack[128];
+            uint32_t stackSize = 0;
+            if (!m_nodes.empty())
+            {
+                stack[stackSize++] = 0;
+            }
+
+            while (stackSize > 0)
+            {
+                const Node &node = m_nodes[stack[--stackSize]];
+                if (!overlaps(node.boundsMin, node.boundsMax))
+                {
+                    continue;
+                }
+
+                if (node.isLeaf())
+                {
+                    for (uint32_t slot = node.firstOrChild; slot < node.firstOrChild + node.primitiveCount; ++slot)
+                    {
+                        primitiveFn(m_primitiveIndices[slot]);
+                    }
+                    continue;
+                }
+
+                stack[stackSize++] = node.firstOrChild;
+                stack[stackSize++] = node.firstOrChild + 1;
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
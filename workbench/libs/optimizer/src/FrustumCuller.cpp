@@ -0,0 +1,208 @@
+#include "FrustumCuller.h"
+#include <pxr/base/gf/plane.h>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            // Corner order of GfFrustum::ComputeCorners(): left/right, bottom/top, near/far
+            constexpr int kLeftBottomNear = 0;
+            constexpr int kRightBottomNear = 1;
+            constexpr int kLeftTopNear = 2;
+            constexpr int kRightTopNear = 3;
+            constexpr int kLeftBottomFar = 4;
+            constexpr int kRightBottomFar = 5;
+            constexpr int kLeftTopFar = 6;
+
+            /**
+             * @brief Array holding the coordinate of the positive vertex along one axis
+             */
+            inline const float *selectBounds(float normal, const std::vector<float> &minValues, const std::vector<float> &maxValues)
+            {
+                return normal >= 0.0f ? maxValues.data() : minValues.data();
+            }
+        } // namespace
+
+        GfMatrix4d FrustumCuller::computeCameraToWorld(const GfVec3d &eye, const GfVec3d &direction)
+        {
+            GfVec3d forward = direction.GetNormalized();
+            GfVec3d up = (std::abs(forward[1]) < 0.99) ? GfVec3d(0, 1, 0) : GfVec3d(0, 0, 1);
+            GfVec3d right = GfCross(forward, up).GetNormalized();
+            up = GfCross(right, forward);
+
+            // Rows are the camera's X, Y and Z axes, then its position
+            GfMatrix4d cameraToWorld(1.0);
+            for (int i = 0; i < 3; ++i)
+            {
+                cameraToWorld[0][i] = right[i];
+                cameraToWorld[1][i] = up[i];
+                cameraToWorld[2][i] = -forward[i];
+                cameraToWorld[3][i] = eye[i];
+            }
+            return cameraToWorld;
+        }
+
+        GfFrustum FrustumCuller::computeViewFrustum(const GfMatrix4d &cameraToWorld, double fovDegrees,
+                                                    double nearDistance, double farDistance)
+        {
+            GfFrustum frustum;
+            frustum.SetPositionAndRotationFromMatrix(cameraToWorld);
+            frustum.SetPerspective(fovDegrees, 1.0, nearDistance, farDistance);
+            return frustum;
+        }
+
+        void FrustumCuller::setFrustum(const GfFrustum &frustum)
+        {
+            const std::vector<GfVec3d> corners = frustum.ComputeCorners();
+
+            GfVec3d center(0.0);
+            for (const GfVec3d &corner : corners)
+            {
+                center += corner;
+            }
+            center /= static_cast<double>(corners.size());
+
+            const int planeCorners[6][3] = {
+                {kLeftBottomNear, kRightBottomNear, kLeftTopNear}, // near
+                {kLeftBottomFar, kRightBottomFar, kLeftTopFar},    // far
+                {kLeftBottomNear, kLeftTopNear, kLeftBottomFar},   // left
+                {kRightBottomNear, kRightTopNear, kRightBottomFar}, // right
+                {kLeftBottomNear, kRightBottomNear, kLeftBottomFar}, // bottom
+                {kLeftTopNear, kRightTopNear, kLeftTopFar}         // top
+            };
+
+            for (int plane = 0; plane < 6; ++plane)
+            {
+                GfPlane gfPlane(corners[planeCorners[plane][0]], corners[planeCorners[plane][1]], corners[planeCorners[plane][2]]);
+
+                // Orient every plane so the frustum interior is on its positive side
+                gfPlane.Reorient(center);
+
+                const GfVec3d &normal = gfPlane.GetNormal();
+                m_planes[plane][0] = static_cast<float>(normal[0]);
+                m_planes[plane][1] = static_cast<float>(normal[1]);
+                m_planes[plane][2] = static_cast<float>(normal[2]);
+                m_planes[plane][3] = static_cast<float>(-gfPlane.GetDistanceFromOrigin());
+            }
+        }
+
+        bool FrustumCuller::intersects(const GfRange3f &bounds) const
+        {
+            if (bounds.IsEmpty())
+            {
+                return false;
+            }
+
+            for (const auto &plane : m_planes)
+            {
+                float distance = plane[3];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    distance += plane[axis] * (plane[axis] >= 0.0f ? bounds.GetMax()[axis] : bounds.GetMin()[axis]);
+                }
+                if (distance < 0.0f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void FrustumCuller::cullBounds(const SceneGeometry &geometry, std::vector<uint32_t> &candidates) const
+        {
+            cullBoundsArrays(geometry, geometry.getMeshCount(), candidates);
+        }
+
+        void FrustumCuller::cullBounds(const SceneInstances &instances, std::vector<uint32_t> &candidates) const
+        {
+            cullBoundsArrays(instances, instances.getInstanceCount(), candidates);
+        }
+
+        template <typename BoundsArrays>
+        void FrustumCuller::cullBoundsArrays(const BoundsArrays &geometry, size_t count, std::vector<uint32_t> &candidates) const
+        {
+            candidates.clear();
+
+            // Positive vertex arrays per plane, resolved once for the whole pass
+            const float *positiveX[6], *positiveY[6], *positiveZ[6];
+            for (int plane = 0; plane < 6; ++plane)
+            {
+                positiveX[plane] = selectBounds(m_planes[plane][0], geometry.boundsMinX, geometry.boundsMaxX);
+                positiveY[plane] = selectBounds(m_planes[plane][1], geometry.boundsMinY, geometry.boundsMaxY);
+                positiveZ[plane] = selectBounds(m_planes[plane][2], geometry.boundsMinZ, geometry.boundsMaxZ);
+            }
+
+            size_t mesh = 0;
+
+#if defined(__AVX2__)
+            for (; mesh + 8 <= count; mesh += 8)
+            {
+                // Meshes without points have inverted bounds and are never candidates
+                __m256 outside = _mm256_cmp_ps(_mm256_loadu_ps(&geometry.boundsMinX[mesh]),
+                                               _mm256_loadu_ps(&geometry.boundsMaxX[mesh]), _CMP_GT_OQ);
+
+                for (int plane = 0; plane < 6; ++plane)
+                {
+                    __m256 distance = _mm256_set1_ps(m_planes[plane][3]);
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[plane][0]), _mm256_loadu_ps(positiveX[plane] + mesh)));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[plane][1]), _mm256_loadu_ps(positiveY[plane] + mesh)));
+                    distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(m_planes[plane][2]), _mm256_loadu_ps(positiveZ[plane] + mesh)));
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+                }
+
+                const int inside = ~_mm256_movemask_ps(outside) & 0xFF;
+                for (int lane = 0; inside != 0 && lane < 8; ++lane)
+                {
+                    if (inside & (1 << lane))
+                    {
+                        candidates.push_back(static_cast<uint32_t>(mesh + lane));
+                    }
+                }
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            for (; mesh + 4 <= count; mesh += 4)
+            {
+                __m128 outside = _mm_cmpgt_ps(_mm_loadu_ps(&geometry.boundsMinX[mesh]), _mm_loadu_ps(&geometry.boundsMaxX[mesh]));
+
+                for (int plane = 0; plane < 6; ++plane)
+                {
+                    __m128 distance = _mm_set1_ps(m_planes[plane][3]);
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[plane][0]), _mm_loadu_ps(positiveX[plane] + mesh)));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[plane][1]), _mm_loadu_ps(positiveY[plane] + mesh)));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(m_planes[plane][2]), _mm_loadu_ps(positiveZ[plane] + mesh)));
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+                }
+
+                const int inside = ~_mm_movemask_ps(outside) & 0xF;
+                for (int lane = 0; inside != 0 && lane < 4; ++lane)
+                {
+                    if (inside & (1 << lane))
+                    {
+                        candidates.push_back(static_cast<uint32_t>(mesh + lane));
+                    }
+                }
+            }
+#endif
+
+            // Remainder (or everything on targets without SIMD)
+            for (; mesh < count; ++mesh)
+            {
+                if (intersects(geometry.getBounds(mesh)))
+                {
+                    candidates.push_back(static_cast<uint32_t>(mesh));
+                }
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
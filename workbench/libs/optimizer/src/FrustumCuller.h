@@ -0,0 +1,89 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/frustum.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/vec3d.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Six-plane view frustum test over the cached mesh bounds
+         *
+         * The planes are derived once per viewpoint from a GfFrustum. Bounds
+         * are then read straight from the SceneGeometry structure-of-arrays
+         * buffers and tested eight boxes at a time. Each plane picks the box
+         * corner farthest along its normal (the "positive vertex"). That choice
+         * is the same for every box, so the SIMD loop needs no per-lane
+         * selects. The test is conservative: boxes near a frustum edge may be
+         * reported although they lie just outside.
+         */
+        class FrustumCuller
+        {
+        public:
+            /**
+             * @brief Camera-to-world matrix looking along a direction
+             *
+             * Follows the USD camera convention: the camera looks down -Z with
+             * +Y up. The roll is chosen so that the world Y axis (or Z for views
+             * along Y) points up. Every per-viewpoint consumer uses this matrix,
+             * so culling, rasterization and sampling all agree on the view.
+             */
+            static GfMatrix4d computeCameraToWorld(const GfVec3d &eye, const GfVec3d &direction);
+
+            /**
+             * @brief Square perspective frustum for a viewpoint
+             * @param cameraToWorld Camera placement, e.g. from computeCameraToWorld()
+             * @param fovDegrees Full field of view in degrees
+             * @param nearDistance Distance to the near plane
+             * @param farDistance Distance to the far plane
+             */
+            static GfFrustum computeViewFrustum(const GfMatrix4d &cameraToWorld, double fovDegrees,
+                                               double nearDistance, double farDistance);
+
+            /**
+             * @brief Derive the six inward-facing planes of a frustum
+             */
+            void setFrustum(const GfFrustum &frustum);
+
+            /**
+             * @brief Collect every mesh whose bounds overlap the frustum
+             * @param geometry Scene snapshot providing the bounds arrays
+             * @param candidates Cleared, then filled with mesh indices in ascending order
+             */
+            void cullBounds(const SceneGeometry &geometry, std::vector<uint32_t> &candidates) const;
+
+            /**
+             * @brief Collect every instance whose world bounds overlap the frustum
+             * @param instances Instanced occluders providing the bounds arrays
+             * @param candidates Cleared, then filled with instance indices in ascending order
+             */
+            void cullBounds(const SceneInstances &instances, std::vector<uint32_t> &candidates) const;
+
+            /**
+             * @brief Scalar version of the same test for a single box
+             */
+            bool intersects(const GfRange3f &bounds) const;
+
+        private:
+            /**
+             * @brief Shared SIMD loop over the bounds arrays of SceneGeometry or SceneInstances
+             */
+            template <typename BoundsArrays>
+            void cullBoundsArrays(const BoundsArrays &geometry, size_t count, std::vector<uint32_t> &candidates) const;
+
+            float m_planes[6][4] = {}; ///< Normal xyz and offset; inside when dot(n, p) + offset >= 0
+        };
+
+    } // namespace optimizer
+} // namespace workbench
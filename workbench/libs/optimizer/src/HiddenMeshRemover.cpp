@@ -1,13 +1,44 @@
 #include "HiddenMeshRemover.h"
+#include "FrustumCuller.h"
+#include "MeshCompactor.h"
+#include "MeshHierarchy.h"
+#include "OcclusionScene.h"
+#include "PotentiallyVisibleSet.h"
+#include "RayPacket.h"
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include "SceneRayCaster.h"
+#include "ScopedConcurrencyLimit.h"
+#include "SoftwareRasterizer.h"
+#include "SurfaceSampler.h"
+#include "TriangleIntersector.h"
+#include "ViewpointGenerator.h"
+#include "VisibilityCache.h"
+#include "WorldSpaceCache.h"
+#include <pxr/usd/sdf/attributeSpec.h>
+#include <pxr/usd/sdf/assetPath.h>
+#include <pxr/usd/sdf/primSpec.h>
+#include <pxr/usd/sdf/reference.h>
+#include <pxr/usd/sdf/types.h>
+#include <pxr/usd/usd/editTarget.h>
 #include <pxr/usd/usdGeom/tokens.h>
 #include <pxr/usd/usdGeom/xformable.h>
 #include <pxr/usd/usdGeom/scope.h>
 #include <pxr/usd/usdGeom/imageable.h>
-#include <pxr/base/gf/frustum.h>
-#include <pxr/base/gf/plane.h>
+#include <pxr/usd/usdShade/material.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/base/work/threadLimits.h>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
@@ -16,6 +47,489 @@ namespace workbench
     namespace optimizer
     {
 
+        namespace
+        {
+            using Clock = std::chrono::steady_clock;
+
+            double secondsSince(Clock::time_point start)
+            {
+                return std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            /**
+             * @brief Create the edit target's spec for a prim that is not on the stage, e.g. inside an unloaded payload
+             * @return Null if the edit target cannot hold an opinion about the prim
+             */
+            SdfPrimSpecHandle createEditTargetSpec(const UsdStagePtr &stage, const SdfPath &path)
+            {
+                const UsdEditTarget &editTarget = stage->GetEditTarget();
+                const SdfPath specPath = editTarget.MapToSpecPath(path);
+                if (specPath.IsEmpty() || !editTarget.GetLayer())
+                {
+                    return SdfPrimSpecHandle();
+                }
+                return SdfCreatePrimInLayer(editTarget.GetLayer(), specPath);
+            }
+
+            /**
+             * @brief Author visibility=invisible over a prim that is not on the stage
+             * @return False if the edit target cannot hold the opinion
+             */
+            bool authorInvisibleSpec(const UsdStagePtr &stage, const SdfPath &path)
+            {
+                SdfPrimSpecHandle primSpec = createEditTargetSpec(stage, path);
+                if (!primSpec)
+                {
+                    return false;
+                }
+                SdfAttributeSpecHandle attributeSpec = primSpec->GetAttributes().get(UsdGeomTokens->visibility);
+                if (!attributeSpec)
+                {
+                    attributeSpec = SdfAttributeSpec::New(primSpec, UsdGeomTokens->visibility, SdfValueTypeNames->Token);
+                }
+                return attributeSpec && attributeSpec->SetDefaultValue(VtValue(UsdGeomTokens->invisible));
+            }
+
+            /**
+             * @brief Author active=false over a prim that is not on the stage
+             * @return False if the edit target cannot hold the opinion
+             */
+            bool authorInactiveSpec(const UsdStagePtr &stage, const SdfPath &path)
+            {
+                SdfPrimSpecHandle primSpec = createEditTargetSpec(stage, path);
+                if (!primSpec)
+                {
+                    return false;
+                }
+                primSpec->SetActive(false);
+                return true;
+            }
+
+            /**
+             * @brief Whether every opinion about a prim lives in one layer, so removing its specs there removes the prim
+             */
+            bool isDefinedOnlyIn(const UsdPrim &prim, const SdfLayerHandle &layer)
+            {
+                for (const SdfPrimSpecHandle &primSpec : prim.GetPrimStack())
+                {
+                    if (primSpec->GetLayer() != layer)
+                    {
+                        return false;
+                    }
+                }
+                return static_cast<bool>(layer);
+            }
+
+            /**
+             * @brief Path of the material a prim or property belongs to, or an empty path outside materials
+             */
+            SdfPath findEnclosingMaterial(const UsdStagePtr &stage, const SdfPath &path)
+            {
+                for (UsdPrim prim = stage->GetPrimAtPath(path.GetPrimPath()); prim && !prim.IsPseudoRoot(); prim = prim.GetParent())
+                {
+                    if (prim.IsA<UsdShadeMaterial>())
+                    {
+                        return prim.GetPath();
+                    }
+                }
+                return SdfPath();
+            }
+
+            /**
+             * @brief Materials that prims outside materials target, directly or through other materials' connections
+             *
+             * Bindings, collection bindings and any other relationship count,
+             * so a material is only left out if nothing could be using it.
+             * Inactive and unloaded prims are not traversed and use nothing.
+             */
+            SdfPathSet findUsedMaterials(const UsdStagePtr &stage)
+            {
+                SdfPathSet used;
+                std::vector<SdfPath> pending;
+                auto addTargets = [&](const SdfPathVector &targets)
+                {
+                    for (const SdfPath &target : targets)
+                    {
+                        const SdfPath material = findEnclosingMaterial(stage, target);
+                        if (!material.IsEmpty() && used.insert(material).second)
+                        {
+                            pending.push_back(material);
+                        }
+                    }
+                };
+
+                UsdPrimRange range = stage->Traverse(UsdTraverseInstanceProxies());
+                for (auto it = range.begin(); it != range.end(); ++it)
+                {
+                    if (it->IsA<UsdShadeMaterial>())
+                    {
+                        it.PruneChildren();
+                        continue;
+                    }
+                    for (const UsdRelationship &relationship : it->GetAuthoredRelationships())
+                    {
+                        SdfPathVector targets;
+                        relationship.GetTargets(&targets);
+                        addTargets(targets);
+                    }
+                }
+
+                // A used material keeps node graphs and materials its shaders connect to in use
+                while (!pending.empty())
+                {
+                    const UsdPrim material = stage->GetPrimAtPath(pending.back());
+                    pending.pop_back();
+                    for (const UsdPrim &prim : UsdPrimRange(material, UsdTraverseInstanceProxies()))
+                    {
+                        for (const UsdAttribute &attribute : prim.GetAuthoredAttributes())
+                        {
+                            SdfPathVector sources;
+                            if (attribute.HasAuthoredConnections() && attribute.GetConnections(&sources))
+                            {
+                                addTargets(sources);
+                            }
+                        }
+                        for (const UsdRelationship &relationship : prim.GetAuthoredRelationships())
+                        {
+                            SdfPathVector targets;
+                            relationship.GetTargets(&targets);
+                            addTargets(targets);
+                        }
+                    }
+                }
+                return used;
+            }
+
+            /**
+             * @brief Prims of the stage that active prims of the edit target layer reference, inherit or specialize
+             *
+             * Only arcs within the stage count: external references bring in
+             * their own layers, which pruning does not touch.
+             */
+            SdfPathSet findPrototypeTargets(const UsdStagePtr &stage)
+            {
+                SdfPathSet targets;
+                const SdfLayerHandle layer = stage->GetEditTarget().GetLayer();
+                if (!layer)
+                {
+                    return targets;
+                }
+
+                const TfToken defaultPrim = layer->GetDefaultPrim();
+                layer->Traverse(SdfPath::AbsoluteRootPath(),
+                                [&](const SdfPath &specPath)
+                                {
+                                    if (!specPath.IsPrimPath())
+                                    {
+                                        return;
+                                    }
+                                    // Arcs of pruned prims and of anything below them no longer compose
+                                    const UsdPrim prim = stage->GetPrimAtPath(specPath);
+                                    const SdfPrimSpecHandle primSpec = layer->GetPrimAtPath(specPath);
+                                    if (!prim || !prim.IsActive() || !primSpec)
+                                    {
+                                        return;
+                                    }
+
+                                    std::vector<SdfReference> references;
+                                    primSpec->GetReferenceList().ApplyEditsToList(&references);
+                                    for (const SdfReference &reference : references)
+                                    {
+                                        if (!reference.GetAssetPath().empty())
+                                        {
+                                            continue;
+                                        }
+                                        if (!reference.GetPrimPath().IsEmpty())
+                                        {
+                                            targets.insert(reference.GetPrimPath());
+                                        }
+                                        else if (!defaultPrim.IsEmpty())
+                                        {
+                                            targets.insert(SdfPath::AbsoluteRootPath().AppendChild(defaultPrim));
+                                        }
+                                    }
+
+                                    SdfPathVector classes;
+                                    primSpec->GetInheritPathList().ApplyEditsToList(&classes);
+                                    primSpec->GetSpecializesList().ApplyEditsToList(&classes);
+                                    targets.insert(classes.begin(), classes.end());
+                                });
+                return targets;
+            }
+
+            /**
+             * @brief Resolved paths of every asset-valued attribute below a prim, e.g. the textures of a material
+             */
+            void collectAssetPaths(const UsdPrim &root, std::set<std::string> &assetPaths)
+            {
+                for (const UsdPrim &prim : UsdPrimRange(root, UsdTraverseInstanceProxies()))
+                {
+                    for (const UsdAttribute &attribute : prim.GetAuthoredAttributes())
+                    {
+                        SdfAssetPath assetPath;
+                        if (attribute.GetTypeName() != SdfValueTypeNames->Asset || !attribute.Get(&assetPath))
+                        {
+                            continue;
+                        }
+                        const std::string &path = assetPath.GetResolvedPath().empty() ? assetPath.GetAssetPath()
+                                                                                     : assetPath.GetResolvedPath();
+                        if (!path.empty())
+                        {
+                            assetPaths.insert(path);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief Near plane distance for views of a scene, small relative to its size
+             */
+            double computeNearDistance(const GfRange3f &sceneBounds)
+            {
+                return sceneBounds.IsEmpty() ? 1e-3 : 1e-5 * sceneBounds.GetSize().GetLength();
+            }
+
+            /**
+             * @brief Far plane distance that keeps the whole scene inside a view frustum
+             */
+            double computeFarDistance(const GfVec3d &eye, const GfRange3f &sceneBounds)
+            {
+                if (sceneBounds.IsEmpty())
+                {
+                    return 1e3;
+                }
+                const double radius = 0.5 * sceneBounds.GetSize().GetLength();
+                return (GfVec3d(sceneBounds.GetMidpoint()) - eye).GetLength() + radius * 1.01 + 1e-3;
+            }
+
+            /**
+             * @brief Visibility ray from a viewpoint to one surface sample
+             */
+            struct SampleRay
+            {
+                GfVec3f direction;
+                float length = 0.0f;
+                uint32_t candidate = 0; ///< Index into the viewpoint's candidate list
+                uint32_t screenKey = 0; ///< Morton code of the screen tile the ray passes through
+            };
+
+            /**
+             * @brief Sampling state of one mesh seen from one viewpoint
+             *
+             * The mesh is visible if more than requiredVisible of its budget
+             * reaches the camera. The outcome is settled once that count is
+             * exceeded, or once the untraced samples can no longer exceed it.
+             */
+            struct SampleProgress
+            {
+                uint32_t budget = 0;
+                uint32_t traced = 0;
+                uint32_t visible = 0;
+                float requiredVisible = 0.0f;
+
+                bool isVisible() const { return static_cast<float>(visible) > requiredVisible; }
+                bool isSettled() const
+                {
+                    return isVisible() || static_cast<float>(visible + (budget - traced)) <= requiredVisible;
+                }
+            };
+
+            constexpr uint32_t kScreenTiles = 32;      ///< Screen tiles per axis used to group rays into packets
+            constexpr uint32_t kFirstRoundSamples = 4; ///< Samples per candidate in the first round; doubles each round
+            constexpr int kGroupSampleScale = 4;       ///< Group bounds get this many times the samples of a mesh of the same size
+            constexpr size_t kTriangleBatchSize = 1 << 16; ///< Triangles whose rays are built and traced together
+
+            /**
+             * @brief Barycentric sample points of a triangle for hidden face removal
+             *
+             * The centroid comes first, then the points halfway from it to each
+             * corner and to each edge midpoint. All lie strictly inside, so
+             * rays do not graze the faces that share an edge.
+             */
+            constexpr float kTriangleSampleWeights[][3] = {
+                {1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f},
+                {2.0f / 3.0f, 1.0f / 6.0f, 1.0f / 6.0f},
+                {1.0f / 6.0f, 2.0f / 3.0f, 1.0f / 6.0f},
+                {1.0f / 6.0f, 1.0f / 6.0f, 2.0f / 3.0f},
+                {1.0f / 6.0f, 5.0f / 12.0f, 5.0f / 12.0f},
+                {5.0f / 12.0f, 1.0f / 6.0f, 5.0f / 12.0f},
+                {5.0f / 12.0f, 5.0f / 12.0f, 1.0f / 6.0f},
+            };
+            constexpr int kMaxTriangleSamples = static_cast<int>(std::size(kTriangleSampleWeights));
+
+            /**
+             * @brief Number of surface samples for a mesh, growing with its size on screen
+             *
+             * Scales maxSamples by the projected radius of the mesh's bounding
+             * sphere, where 1 spans half the view. Meshes around the camera get
+             * the full budget.
+             */
+            uint32_t computeSampleBudget(const GfRange3f &bounds, const GfVec3d &eye, double tanHalfFov,
+                                         int minSamples, int maxSamples)
+            {
+                const double radius = 0.5 * bounds.GetSize().GetLength();
+                const double distance = (GfVec3d(bounds.GetMidpoint()) - eye).GetLength();
+                if (distance <= radius)
+                {
+                    return static_cast<uint32_t>(maxSamples);
+                }
+
+                const double projectedRadius = radius / (distance * tanHalfFov);
+                const double samples = std::ceil(maxSamples * projectedRadius);
+                return static_cast<uint32_t>(std::clamp(samples, static_cast<double>(minSamples), static_cast<double>(maxSamples)));
+            }
+
+            /**
+             * @brief Morton order key of the screen tile a camera-space direction falls into
+             *
+             * Directions behind the camera or outside the field of view are
+             * clamped to the border tiles; they only affect packet grouping.
+             */
+            uint32_t computeScreenKey(double x, double y, double depth, double tanHalfFov)
+            {
+                if (depth <= 1e-6)
+                {
+                    return kScreenTiles * kScreenTiles;
+                }
+
+                auto toTile = [&](double coordinate)
+                {
+                    double ndc = coordinate / (depth * tanHalfFov);
+                    double tile = std::floor((ndc * 0.5 + 0.5) * kScreenTiles);
+                    return static_cast<uint32_t>(std::clamp(tile, 0.0, static_cast<double>(kScreenTiles - 1)));
+                };
+
+                uint32_t tileX = toTile(x);
+                uint32_t tileY = toTile(y);
+                uint32_t key = 0;
+                for (uint32_t bit = 0; (kScreenTiles >> bit) > 1; ++bit)
+                {
+                    key |= ((tileX >> bit) & 1u) << (2 * bit);
+                    key |= ((tileY >> bit) & 1u) << (2 * bit + 1);
+                }
+                return key;
+            }
+
+            /**
+             * @brief Set up the culler for one viewpoint and collect the meshes it can see
+             */
+            void cullViewpoint(FrustumCuller &culler, const GfMatrix4d &cameraToWorld, float fov,
+                               const SceneGeometry &geometry, const GfRange3f &sceneBounds,
+                               std::vector<uint32_t> &candidates)
+            {
+                const GfVec3d eye = cameraToWorld.ExtractTranslation();
+                culler.setFrustum(FrustumCuller::computeViewFrustum(cameraToWorld, fov, computeNearDistance(sceneBounds),
+                                                                    computeFarDistance(eye, sceneBounds)));
+                culler.cullBounds(geometry, candidates);
+            }
+
+            /**
+             * @brief Distance below which two viewpoint positions count as the same
+             */
+            double getDuplicateTolerance(const GfBBox3d &sceneBounds)
+            {
+                return 1e-4 * sceneBounds.GetRange().GetSize().GetLength();
+            }
+
+            /**
+             * @brief Visibility cache key of the viewpoints that do not depend on mesh geometry
+             *
+             * Refined and interior probe views come last and move with the
+             * meshes around them; keying on them would let any edit invalidate
+             * every cached verdict.
+             */
+            uint64_t computeViewpointKey(const std::vector<HiddenMeshRemover::Viewpoint> &viewpoints, size_t derivedCount,
+                                         const HiddenMeshRemover::RemovalOptions &options, const SceneInstances &instances)
+            {
+                const std::vector<HiddenMeshRemover::Viewpoint> baseViewpoints(viewpoints.begin(), viewpoints.end() - derivedCount);
+                return VisibilityCache::computeAnalysisHash(baseViewpoints, options, instances);
+            }
+
+            /**
+             * @brief Whether the transform of a prim or of any of its ancestors may change over time
+             * @param known Answers for prims visited before, shared between calls
+             */
+            bool transformMightBeTimeVarying(const UsdPrim &prim, std::unordered_map<SdfPath, bool, SdfPath::Hash> &known)
+            {
+                if (!prim || prim.IsPseudoRoot())
+                {
+                    return false;
+                }
+                auto found = known.find(prim.GetPath());
+                if (found != known.end())
+                {
+                    return found->second;
+                }
+
+                UsdGeomXformable xformable(prim);
+                const bool varying = (xformable && xformable.TransformMightBeTimeVarying()) ||
+                                     transformMightBeTimeVarying(prim.GetParent(), known);
+                known.emplace(prim.GetPath(), varying);
+                return varying;
+            }
+
+            /**
+             * @brief Whether a mesh may move or deform between frames
+             */
+            bool meshMightBeTimeVarying(const UsdGeomMesh &mesh, std::unordered_map<SdfPath, bool, SdfPath::Hash> &known)
+            {
+                return mesh.GetPointsAttr().ValueMightBeTimeVarying() ||
+                       mesh.GetFaceVertexCountsAttr().ValueMightBeTimeVarying() ||
+                       mesh.GetFaceVertexIndicesAttr().ValueMightBeTimeVarying() ||
+                       transformMightBeTimeVarying(mesh.GetPrim(), known);
+            }
+
+            /**
+             * @brief Whether any instance may move, deform, appear or disappear between frames
+             */
+            bool instancesMightBeTimeVarying(UsdStagePtr stage, const std::vector<UsdGeomMesh> &instanceProxies,
+                                             const std::vector<UsdGeomPointInstancer> &instancers,
+                                             const SceneInstances &instances,
+                                             std::unordered_map<SdfPath, bool, SdfPath::Hash> &known)
+            {
+                for (const UsdGeomMesh &proxy : instanceProxies)
+                {
+                    if (transformMightBeTimeVarying(proxy.GetPrim(), known))
+                    {
+                        return true;
+                    }
+                }
+                for (const UsdGeomPointInstancer &instancer : instancers)
+                {
+                    if (instancer.GetPositionsAttr().ValueMightBeTimeVarying() ||
+                        instancer.GetOrientationsAttr().ValueMightBeTimeVarying() ||
+                        instancer.GetScalesAttr().ValueMightBeTimeVarying() ||
+                        instancer.GetProtoIndicesAttr().ValueMightBeTimeVarying() ||
+                        instancer.GetInvisibleIdsAttr().ValueMightBeTimeVarying() ||
+                        transformMightBeTimeVarying(instancer.GetPrim(), known))
+                    {
+                        return true;
+                    }
+                }
+
+                // Prototype meshes may deform or move inside their prototype
+                for (const SdfPath &path : instances.prototypes.paths)
+                {
+                    UsdGeomMesh prototype(stage->GetPrimAtPath(path));
+                    if (prototype && meshMightBeTimeVarying(prototype, known))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * @brief Whether a camera may move or change its field of view between frames
+             */
+            bool cameraMightBeTimeVarying(const UsdGeomCamera &camera, std::unordered_map<SdfPath, bool, SdfPath::Hash> &known)
+            {
+                return camera.GetFocalLengthAttr().ValueMightBeTimeVarying() ||
+                       camera.GetHorizontalApertureAttr().ValueMightBeTimeVarying() ||
+                       transformMightBeTimeVarying(camera.GetPrim(), known);
+            }
+        } // namespace
+
         HiddenMeshRemover::HiddenMeshRemover(const RemovalOptions &options)
             : m_options(options)
         {
@@ -30,78 +544,91 @@ namespace workbench
             }
 
             m_stats.reset();
+            m_report.clear();
+            m_orphanedTextures.clear();
+            ScopedConcurrencyLimit concurrencyLimit(m_options.numThreads);
             logVerbose("Starting hidden mesh removal analysis...");
 
-            // Calculate scene bounds
-            GfBBox3d sceneBounds = calculateSceneBounds(stage);
-            logVerbose("Scene bounds calculated: " +
-                       std::to_string(sceneBounds.GetRange().GetSize().GetLength()) + " units");
-
-            // Generate viewpoints
+            // Analyze each mesh for visibility; results come back in mesh order
+            OcclusionScene scene;
             std::vector<Viewpoint> viewpoints;
-
-            if (m_options.useExistingCameras)
+            std::vector<UsdTimeCode> frames;
+            std::vector<std::vector<MeshVisibility>> frameVisibility;
+            std::vector<MeshVisibility> visibility;
+            if (m_options.analyzeFrameRange)
             {
-                auto cameraViewpoints = extractCameraViewpoints(stage);
-                viewpoints.insert(viewpoints.end(), cameraViewpoints.begin(), cameraViewpoints.end());
-                logVerbose("Found " + std::to_string(cameraViewpoints.size()) + " camera viewpoints");
+                frames = computeFrames(stage);
+                visibility = analyzeFrames(stage, frames, scene, viewpoints, frameVisibility);
             }
-
-            if (m_options.generateViewpoints)
+            else
             {
-                auto generatedViewpoints = generateViewpoints(sceneBounds);
-                viewpoints.insert(viewpoints.end(), generatedViewpoints.begin(), generatedViewpoints.end());
-                m_stats.viewpointsGenerated = generatedViewpoints.size();
-                logVerbose("Generated " + std::to_string(generatedViewpoints.size()) + " additional viewpoints");
+                visibility = analyzeStage(stage, scene, viewpoints);
             }
-
-            m_stats.viewpointsUsed = viewpoints.size();
-
             if (viewpoints.empty())
             {
-                logVerbose("No viewpoints available for analysis");
                 return false;
             }
 
-            // Collect all meshes in the stage
-            std::vector<UsdGeomMesh> allMeshes;
-            auto range = stage->Traverse();
-            for (auto it = range.begin(); it != range.end(); ++it)
-            {
-                if (it->IsA<UsdGeomMesh>())
-                {
-                    UsdGeomMesh mesh(*it);
-                    allMeshes.push_back(mesh);
-                }
-            }
-
-            m_stats.totalMeshes = allMeshes.size();
-            logVerbose("Found " + std::to_string(allMeshes.size()) + " meshes to analyze");
-
-            // Analyze each mesh for visibility
             std::vector<SdfPath> meshesToRemove;
-            for (const auto &mesh : allMeshes)
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
             {
-                // Skip if this is an instanced mesh and we want to preserve them
-                if (m_options.preserveInstancedMeshes && isMeshInstanced(mesh, stage))
+                const UsdGeomMesh &mesh = scene.meshes[meshIndex];
+
+                if (visibility[meshIndex] == MeshVisibility::Preserved)
                 {
                     m_stats.preservedMeshes++;
                     logVerbose("Preserving instanced mesh: " + mesh.GetPath().GetString());
-                    continue;
                 }
-
-                // Test visibility
-                if (!isMeshVisible(mesh, viewpoints, allMeshes))
+                else if (visibility[meshIndex] == MeshVisibility::Hidden)
                 {
                     meshesToRemove.push_back(mesh.GetPath());
                     m_stats.hiddenMeshes++;
+                    m_stats.hiddenTriangles += scene.geometry.getTriangleCount(meshIndex);
                     logVerbose("Mesh marked for removal: " + mesh.GetPath().GetString());
                 }
             }
 
-            // Create visibility overrides for hidden meshes (non-destructive approach)
+            // Garbage is whatever only hidden meshes kept in use, so note what was in use before pruning
+            const bool pruning = m_options.removalAction != RemovalAction::Hide;
+            bool collecting = pruning && m_options.collectGarbage;
+            if (collecting && m_options.streamPayloads)
+            {
+                logVerbose("Skipping garbage collection: prims of unloaded payloads may use materials and prototypes too");
+                collecting = false;
+            }
+            const auto authoringStart = Clock::now();
+            SdfPathSet materialsBefore;
+            SdfPathSet prototypesBefore;
+            if (collecting)
+            {
+                materialsBefore = findUsedMaterials(stage);
+                prototypesBefore = findPrototypeTargets(stage);
+            }
+
+            // Create visibility overrides for hidden meshes (non-destructive approach), or prune them
+            SdfPath lastPruned;
             for (const auto &path : meshesToRemove)
             {
+                if (pruning)
+                {
+                    // Meshes come in traversal order, so meshes below a pruned one follow it and went with it
+                    if (!lastPruned.IsEmpty() && path.HasPrefix(lastPruned))
+                    {
+                        m_stats.removedMeshes++;
+                    }
+                    else if (prunePrim(stage, path))
+                    {
+                        lastPruned = path;
+                        m_stats.removedMeshes++;
+                        logVerbose("Pruned mesh: " + path.GetString());
+                    }
+                    else
+                    {
+                        logVerbose("Could not prune mesh: " + path.GetString());
+                    }
+                    continue;
+                }
+
                 auto prim = stage->GetPrimAtPath(path);
                 if (prim && prim.IsValid())
                 {
@@ -118,6 +645,35 @@ namespace workbench
                         logVerbose("Could not create imageable for mesh: " + path.GetString());
                     }
                 }
+                else if (m_options.streamPayloads && authorInvisibleSpec(stage, path))
+                {
+                    // Meshes of unloaded payloads have no prim, but an opinion can still be authored over them
+                    m_stats.removedMeshes++;
+                    logVerbose("Set visibility=invisible for unloaded mesh: " + path.GetString());
+                }
+            }
+
+            if (collecting)
+            {
+                collectGarbage(stage, materialsBefore, prototypesBefore);
+            }
+
+            if (m_options.analyzeFrameRange && m_options.frameOutput == FrameOutput::TimeSampled)
+            {
+                m_stats.timeSampledMeshes = authorFrameVisibility(stage, scene, frames, frameVisibility);
+            }
+            m_stats.authoringSeconds += secondsSince(authoringStart);
+
+            if (m_options.removeHiddenTriangles)
+            {
+                if (m_options.analyzeFrameRange)
+                {
+                    logVerbose("Skipping hidden face removal: faces hidden in one frame may be seen in another");
+                }
+                else
+                {
+                    removeHiddenFaces(scene, viewpoints, visibility);
+                }
             }
 
             // Calculate space saved percentage
@@ -126,400 +682,2110 @@ namespace workbench
                 m_stats.spaceSavedPercent = (float(m_stats.removedMeshes) / float(m_stats.totalMeshes)) * 100.0f;
             }
 
-            logVerbose("Hidden mesh removal completed. Set visibility=invisible for " +
-                       std::to_string(m_stats.removedMeshes) + " of " +
-                       std::to_string(m_stats.totalMeshes) + " meshes (" +
-                       std::to_string(m_stats.spaceSavedPercent) + "% visibility reduction)");
+            logVerbose(std::string("Hidden mesh removal completed. ") + (pruning ? "Pruned " : "Set visibility=invisible for ") +
+                       std::to_string(m_stats.removedMeshes) + " of " +
+                       std::to_string(m_stats.totalMeshes) + " meshes (" +
+                       std::to_string(m_stats.spaceSavedPercent) + "% visibility reduction)");
+
+            buildReport(scene, visibility);
+            return true;
+        }
+
+        bool HiddenMeshRemover::prunePrim(UsdStagePtr stage, const SdfPath &path)
+        {
+            const UsdPrim prim = stage->GetPrimAtPath(path);
+            if (!prim)
+            {
+                // Prims of unloaded payloads are not on the stage, but an opinion can still be authored over them
+                if (m_options.streamPayloads && authorInactiveSpec(stage, path))
+                {
+                    m_stats.deactivatedPrims++;
+                    return true;
+                }
+                return false;
+            }
+
+            // Edits inside an instance would change its prototype and with it every other instance
+            if (prim.IsInstanceProxy())
+            {
+                return false;
+            }
+
+            if (m_options.removalAction == RemovalAction::Delete && isDefinedOnlyIn(prim, stage->GetEditTarget().GetLayer()) &&
+                stage->RemovePrim(path))
+            {
+                m_stats.deletedPrims++;
+                return true;
+            }
+            if (prim.SetActive(false))
+            {
+                m_stats.deactivatedPrims++;
+                return true;
+            }
+            return false;
+        }
+
+        void HiddenMeshRemover::collectGarbage(UsdStagePtr stage, const SdfPathSet &materialsBefore,
+                                               const SdfPathSet &prototypesBefore)
+        {
+            // Defined, concrete prims are part of the scene themselves, even if something references them
+            SdfPathSet attempted;
+            for (bool collected = true; collected;)
+            {
+                collected = false;
+                const SdfPathSet prototypesAfter = findPrototypeTargets(stage);
+                for (const SdfPath &path : prototypesBefore)
+                {
+                    if (prototypesAfter.count(path) || !attempted.insert(path).second)
+                    {
+                        continue;
+                    }
+                    const UsdPrim prim = stage->GetPrimAtPath(path);
+                    if (!prim || prim.IsInstanceProxy() || (prim.IsDefined() && !prim.IsAbstract()))
+                    {
+                        continue;
+                    }
+                    if (prunePrim(stage, path))
+                    {
+                        m_stats.collectedPrototypes++;
+                        collected = true;
+                        logVerbose("Collected unreferenced prototype: " + path.GetString());
+                    }
+                }
+            }
+
+            const SdfPathSet materialsAfter = findUsedMaterials(stage);
+            std::set<std::string> keptTextures;
+            std::set<std::string> collectedTextures;
+            for (const SdfPath &path : materialsAfter)
+            {
+                collectAssetPaths(stage->GetPrimAtPath(path), keptTextures);
+            }
+            for (const SdfPath &path : materialsBefore)
+            {
+                const UsdPrim material = stage->GetPrimAtPath(path);
+                if (materialsAfter.count(path) || !material || material.IsInstanceProxy())
+                {
+                    continue;
+                }
+
+                // Read the textures first; a deleted material has no attributes left
+                std::set<std::string> textures;
+                collectAssetPaths(material, textures);
+                if (prunePrim(stage, path))
+                {
+                    m_stats.collectedMaterials++;
+                    collectedTextures.insert(textures.begin(), textures.end());
+                    logVerbose("Collected unused material: " + path.GetString());
+                }
+            }
+
+            for (const std::string &texture : collectedTextures)
+            {
+                if (keptTextures.count(texture))
+                {
+                    continue;
+                }
+                std::error_code error;
+                const uintmax_t bytes = std::filesystem::file_size(texture, error);
+                m_orphanedTextures.push_back(texture);
+                m_stats.orphanedTextures++;
+                m_stats.orphanedTextureBytes += error ? 0 : bytes;
+                logVerbose("Texture no longer used by the stage: " + texture);
+            }
+        }
+
+        HiddenMeshRemover::LoadMetrics HiddenMeshRemover::measureStageLoad(const std::string &path)
+        {
+            LoadMetrics metrics;
+            const auto openStart = Clock::now();
+            UsdStageRefPtr stage = UsdStage::Open(path, UsdStage::LoadAll);
+            if (!stage)
+            {
+                return metrics;
+            }
+            UsdPrimRange range = stage->Traverse();
+            for (auto it = range.begin(); it != range.end(); ++it)
+            {
+                ++metrics.primCount;
+            }
+            metrics.openSeconds = secondsSince(openStart);
+
+            // Anonymous layers, e.g. the session layer, have no file to measure
+            for (const SdfLayerHandle &layer : stage->GetUsedLayers())
+            {
+                ++metrics.layerCount;
+                std::error_code error;
+                const uintmax_t bytes = layer->GetRealPath().empty() ? 0 : std::filesystem::file_size(layer->GetRealPath(), error);
+                metrics.fileBytes += error ? 0 : bytes;
+            }
+            return metrics;
+        }
+
+        std::vector<SdfPath> HiddenMeshRemover::analyzeHiddenMeshes(UsdStagePtr stage)
+        {
+            std::vector<SdfPath> hiddenMeshes;
+
+            if (!stage)
+            {
+                return hiddenMeshes;
+            }
+
+            m_stats.reset();
+            m_report.clear();
+            ScopedConcurrencyLimit concurrencyLimit(m_options.numThreads);
+
+            OcclusionScene scene;
+            std::vector<Viewpoint> viewpoints;
+            std::vector<MeshVisibility> visibility;
+            if (m_options.analyzeFrameRange)
+            {
+                std::vector<std::vector<MeshVisibility>> frameVisibility;
+                visibility = analyzeFrames(stage, computeFrames(stage), scene, viewpoints, frameVisibility);
+            }
+            else
+            {
+                visibility = analyzeStage(stage, scene, viewpoints);
+            }
+            for (size_t meshIndex = 0; meshIndex < visibility.size(); ++meshIndex)
+            {
+                if (visibility[meshIndex] == MeshVisibility::Preserved)
+                {
+                    m_stats.preservedMeshes++;
+                }
+                else if (visibility[meshIndex] == MeshVisibility::Hidden)
+                {
+                    hiddenMeshes.push_back(scene.meshes[meshIndex].GetPath());
+                    m_stats.hiddenMeshes++;
+                    m_stats.hiddenTriangles += scene.geometry.getTriangleCount(meshIndex);
+                }
+            }
+
+            if (!visibility.empty())
+            {
+                buildReport(scene, visibility);
+            }
+            return hiddenMeshes;
+        }
+
+        bool HiddenMeshRemover::computePotentiallyVisibleSet(UsdStagePtr stage, PotentiallyVisibleSet &pvs)
+        {
+            if (!stage)
+            {
+                logVerbose("Invalid stage provided");
+                return false;
+            }
+
+            m_stats.reset();
+            ScopedConcurrencyLimit concurrencyLimit(m_options.numThreads);
+
+            OcclusionScene scene;
+            auto phaseStart = Clock::now();
+            if (m_options.streamPayloads)
+            {
+                std::vector<Viewpoint> cameraViewpoints;
+                GfBBox3d sceneBounds;
+                if (!streamOcclusionScene(stage, scene, cameraViewpoints, sceneBounds))
+                {
+                    return false;
+                }
+                m_stats.totalMeshes = scene.meshes.size();
+            }
+            else
+            {
+                std::vector<UsdGeomMesh> allMeshes;
+                std::vector<UsdGeomCamera> cameras;
+                std::vector<UsdGeomMesh> instanceProxies;
+                std::vector<UsdGeomPointInstancer> instancers;
+                collectScenePrims(stage->GetPseudoRoot(), allMeshes, cameras, instanceProxies, instancers);
+                m_stats.totalMeshes = allMeshes.size();
+                m_stats.traversalSeconds += secondsSince(phaseStart);
+
+                phaseStart = Clock::now();
+                WorldSpaceCache worldCache;
+                scene = buildOcclusionScene(allMeshes, instanceProxies, instancers, worldCache);
+                m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+            }
+            if (scene.bounds.IsEmpty())
+            {
+                logVerbose("No mesh geometry to build a potentially visible set for");
+                return false;
+            }
+
+            // Free space is found with rays, even when the raster engine tests visibility
+            if (!usesRayCaster())
+            {
+                phaseStart = Clock::now();
+                scene.rayCaster.build(scene.geometry, scene.instances);
+                m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+            }
+
+            const size_t meshCount = scene.meshes.size();
+            std::vector<std::string> meshPaths(meshCount);
+            std::vector<uint8_t> preserved(meshCount, 0);
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                meshPaths[meshIndex] = scene.meshes[meshIndex].GetPath().GetString();
+                preserved[meshIndex] = m_options.preserveInstancedMeshes && scene.instancedMeshes[meshIndex];
+            }
+
+            const int resolution = std::max(1, m_options.pvsResolution);
+            pvs.reset(GfRange3d(GfVec3d(scene.bounds.GetMin()), GfVec3d(scene.bounds.GetMax())), GfVec3i(resolution), meshPaths);
+            const size_t cellCount = pvs.getCellCount();
+
+            const GfVec3d cellSize = pvs.getCellBounds(0).GetSize();
+            double smallestCell = std::numeric_limits<double>::max();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (cellSize[axis] > 0.0)
+                {
+                    smallestCell = std::min(smallestCell, cellSize[axis]);
+                }
+            }
+            const float clearance = static_cast<float>(0.1 * smallestCell);
+            const float maxDistance = static_cast<float>(scene.bounds.GetSize().GetLength());
+
+            // The center and eight points an eighth of a cell inside its corners
+            phaseStart = Clock::now();
+            std::vector<std::vector<GfVec3d>> freePoints(cellCount);
+            WorkParallelForN(
+                cellCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t cell = begin; cell < end; ++cell)
+                    {
+                        const GfRange3d bounds = pvs.getCellBounds(static_cast<uint32_t>(cell));
+                        std::vector<GfVec3d> points{bounds.GetMidpoint()};
+                        for (int corner = 0; corner < 8; ++corner)
+                        {
+                            const GfVec3d fraction((corner & 1) ? 0.875 : 0.125, (corner & 2) ? 0.875 : 0.125, (corner & 4) ? 0.875 : 0.125);
+                            points.push_back(bounds.GetMin() + GfCompMult(fraction, bounds.GetSize()));
+                        }
+                        for (const GfVec3d &point : points)
+                        {
+                            if (ViewpointGenerator::isFreeSpace(GfVec3f(point), clearance, maxDistance, scene.rayCaster))
+                            {
+                                freePoints[cell].push_back(point);
+                            }
+                        }
+                    }
+                },
+                8);
+            m_stats.viewpointSeconds += secondsSince(phaseStart);
+
+            // Six views per point; 100 degrees lets neighbouring faces overlap so no direction falls between them
+            const GfVec3d axes[6] = {GfVec3d(1, 0, 0), GfVec3d(-1, 0, 0), GfVec3d(0, 1, 0),
+                                     GfVec3d(0, -1, 0), GfVec3d(0, 0, 1), GfVec3d(0, 0, -1)};
+            const std::vector<GfRange3f> meshBounds = scene.geometry.getAllBounds();
+            std::vector<MeshVisibility> visibility;
+            std::vector<float> scores(meshCount, 0.0f);
+            phaseStart = Clock::now();
+            for (size_t cell = 0; cell < cellCount; ++cell)
+            {
+                if (freePoints[cell].empty())
+                {
+                    continue;
+                }
+
+                std::vector<Viewpoint> views;
+                for (const GfVec3d &point : freePoints[cell])
+                {
+                    for (const GfVec3d &axis : axes)
+                    {
+                        views.emplace_back(point, axis, 100.0f);
+                    }
+                }
+
+                // Meshes reaching into the cell can be seen from inside it however they face
+                const GfRange3d cellBounds = pvs.getCellBounds(static_cast<uint32_t>(cell));
+                const GfRange3f cellRange(GfVec3f(cellBounds.GetMin()), GfVec3f(cellBounds.GetMax()));
+                std::vector<uint8_t> resolved = preserved;
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    if (!meshBounds[meshIndex].IsEmpty() && !GfRange3f::GetIntersection(meshBounds[meshIndex], cellRange).IsEmpty())
+                    {
+                        resolved[meshIndex] = 1;
+                    }
+                }
+
+                visibility.assign(meshCount, MeshVisibility::Visible);
+                testVisibility(scene, views, resolved, visibility, scores);
+
+                // Built from the verdicts rather than resolved, so the mask holds whatever any engine saw
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    resolved[meshIndex] = visibility[meshIndex] != MeshVisibility::Hidden;
+                }
+                pvs.setVisibleMeshes(static_cast<uint32_t>(cell), resolved);
+                m_stats.viewpointsUsed += views.size();
+            }
+            m_stats.visibilitySeconds += secondsSince(phaseStart);
+
+            m_stats.pvsCells = cellCount;
+            m_stats.pvsNavigableCells = pvs.getNavigableCellCount();
+            m_stats.pvsUniqueMasks = pvs.getUniqueMaskCount();
+            logVerbose("Potentially visible set: " + std::to_string(m_stats.pvsNavigableCells) + " of " +
+                       std::to_string(cellCount) + " cells navigable, " + std::to_string(m_stats.pvsUniqueMasks) +
+                       " distinct bitsets in " + std::to_string(pvs.getMemoryUsage()) + " bytes");
+            return true;
+        }
+
+        std::vector<HiddenMeshRemover::MeshVisibility> HiddenMeshRemover::analyzeStage(UsdStagePtr stage, OcclusionScene &scene,
+                                                                                       std::vector<Viewpoint> &viewpoints)
+        {
+            m_meshCosts.clear();
+            GfBBox3d sceneBounds;
+            std::vector<Viewpoint> cameraViewpoints;
+            if (m_options.streamPayloads)
+            {
+                // Cameras inside payloads are read while their payload is loaded
+                if (!streamOcclusionScene(stage, scene, cameraViewpoints, sceneBounds))
+                {
+                    viewpoints.clear();
+                    return {};
+                }
+                m_stats.totalMeshes = scene.meshes.size();
+                logVerbose("Found " + std::to_string(scene.meshes.size()) + " meshes to analyze");
+            }
+            else
+            {
+                // Collect all meshes and cameras in the stage
+                std::vector<UsdGeomMesh> allMeshes;
+                std::vector<UsdGeomCamera> cameras;
+                std::vector<UsdGeomMesh> instanceProxies;
+                std::vector<UsdGeomPointInstancer> instancers;
+                auto phaseStart = Clock::now();
+                collectScenePrims(stage->GetPseudoRoot(), allMeshes, cameras, instanceProxies, instancers);
+                m_stats.traversalSeconds += secondsSince(phaseStart);
+
+                // World transforms and bounds are computed once and shared by every step below
+                WorldSpaceCache worldCache;
+
+                // Calculate scene bounds
+                phaseStart = Clock::now();
+                sceneBounds = calculateSceneBounds(stage, worldCache);
+                m_stats.boundsSeconds += secondsSince(phaseStart);
+
+                m_stats.totalMeshes = allMeshes.size();
+                logVerbose("Found " + std::to_string(allMeshes.size()) + " meshes to analyze");
+
+                // Build the occlusion hierarchy once; viewpoint generation and every ray query below go through it
+                phaseStart = Clock::now();
+                scene = buildOcclusionScene(allMeshes, instanceProxies, instancers, worldCache);
+                m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+
+                if (m_options.useExistingCameras)
+                {
+                    phaseStart = Clock::now();
+                    cameraViewpoints = extractCameraViewpoints(cameras, worldCache);
+                    m_stats.viewpointSeconds += secondsSince(phaseStart);
+                }
+            }
+            logVerbose("Scene bounds calculated: " +
+                       std::to_string(sceneBounds.GetRange().GetSize().GetLength()) + " units");
+            logVerbose("Geometry cache holds " + std::to_string(scene.geometry.getTotalTriangleCount()) + " mesh and " +
+                       std::to_string(scene.instances.prototypes.getTotalTriangleCount()) + " prototype triangles in " +
+                       std::to_string(m_stats.geometryCacheBytes) + " bytes");
+            if (m_stats.occluderInstances > 0)
+            {
+                logVerbose("Using " + std::to_string(m_stats.occluderInstances) + " instances of " +
+                           std::to_string(m_stats.prototypeMeshes) + " prototype meshes as occluders");
+            }
+
+            // Generate viewpoints
+            auto phaseStart = Clock::now();
+            viewpoints.clear();
+
+            if (m_options.useExistingCameras)
+            {
+                viewpoints.insert(viewpoints.end(), cameraViewpoints.begin(), cameraViewpoints.end());
+                logVerbose("Found " + std::to_string(cameraViewpoints.size()) + " camera viewpoints");
+            }
+
+            if (m_options.generateViewpoints)
+            {
+                auto generatedViewpoints = generateViewpoints(sceneBounds, scene);
+                viewpoints.insert(viewpoints.end(), generatedViewpoints.begin(), generatedViewpoints.end());
+                m_stats.viewpointsGenerated = generatedViewpoints.size();
+                logVerbose("Generated " + std::to_string(generatedViewpoints.size()) + " additional viewpoints (" +
+                           std::to_string(m_stats.interiorProbes) + " interior, " +
+                           std::to_string(m_stats.viewpointsRefined) + " from refinement)");
+            }
+
+            const uint64_t viewpointKey = computeViewpointKey(viewpoints, m_stats.viewpointsRefined + m_stats.interiorProbes, m_options,
+                                                             scene.instances);
+            m_stats.duplicateViewpoints = ViewpointGenerator::removeDuplicates(viewpoints, getDuplicateTolerance(sceneBounds));
+            if (m_stats.duplicateViewpoints > 0)
+            {
+                logVerbose("Dropped " + std::to_string(m_stats.duplicateViewpoints) + " duplicate viewpoints");
+            }
+            m_stats.viewpointsUsed = viewpoints.size();
+            m_stats.viewpointSeconds += secondsSince(phaseStart);
+
+            if (viewpoints.empty())
+            {
+                logVerbose("No viewpoints available for analysis");
+                return {};
+            }
+
+            if (m_options.engine == VisibilityEngine::Raster)
+            {
+                logVerbose("Rasterizing " + std::to_string(viewpoints.size()) + " views at " +
+                           std::to_string(m_options.rasterResolution) + "x" + std::to_string(m_options.rasterResolution) +
+                           " (" + getTriangleKernelName() + " kernels)");
+            }
+            else if (m_options.engine == VisibilityEngine::Voxel)
+            {
+                logVerbose("Voxelized the scene into " + std::to_string(scene.voxels.getOccupiedBrickCount()) +
+                           " occupied bricks, " + std::to_string(scene.voxels.getMemoryUsage()) + " bytes");
+            }
+            else
+            {
+                logVerbose("Built occlusion BVHs in " + std::to_string(scene.rayCaster.getMemoryUsage()) +
+                           " bytes (" + getTriangleKernelName() + " triangle kernel)");
+            }
+
+            phaseStart = Clock::now();
+            std::vector<MeshVisibility> visibility = classifyMeshes(scene, viewpoints, viewpointKey, stage);
+            m_stats.visibilitySeconds += secondsSince(phaseStart);
+            return visibility;
+        }
+
+        std::vector<UsdTimeCode> HiddenMeshRemover::computeFrames(UsdStagePtr stage) const
+        {
+            double start = m_options.startFrame;
+            double end = m_options.endFrame;
+            if (m_options.useStageFrameRange)
+            {
+                start = stage->GetStartTimeCode();
+                end = stage->GetEndTimeCode();
+            }
+            const double step = m_options.frameStep > 0.0 ? m_options.frameStep : 1.0;
+
+            // Frames are counted from the start so that rounding never drifts over long ranges
+            std::vector<UsdTimeCode> frames;
+            for (size_t frame = 0; start + frame * step <= end + 1e-6 * step; ++frame)
+            {
+                frames.emplace_back(start + frame * step);
+            }
+            return frames;
+        }
+
+        std::vector<HiddenMeshRemover::MeshVisibility> HiddenMeshRemover::analyzeFrames(UsdStagePtr stage, const std::vector<UsdTimeCode> &frames,
+                                                                                        OcclusionScene &scene, std::vector<Viewpoint> &viewpoints,
+                                                                                        std::vector<std::vector<MeshVisibility>> &frameVisibility)
+        {
+            viewpoints.clear();
+            frameVisibility.clear();
+            if (frames.empty())
+            {
+                logVerbose("The frame range is empty");
+                return {};
+            }
+            if (m_options.streamPayloads)
+            {
+                // Animated meshes are re-read every frame, which needs their payloads loaded throughout
+                std::cerr << "Warning: Payload streaming does not support frame ranges; load the payloads instead" << std::endl;
+                return {};
+            }
+
+            std::vector<UsdGeomMesh> allMeshes;
+            std::vector<UsdGeomCamera> cameras;
+            std::vector<UsdGeomMesh> instanceProxies;
+            std::vector<UsdGeomPointInstancer> instancers;
+            m_meshCosts.clear();
+            auto phaseStart = Clock::now();
+            collectScenePrims(stage->GetPseudoRoot(), allMeshes, cameras, instanceProxies, instancers);
+            m_stats.traversalSeconds += secondsSince(phaseStart);
+            if (!m_options.useExistingCameras)
+            {
+                cameras.clear();
+            }
+
+            m_stats.totalMeshes = allMeshes.size();
+            logVerbose("Found " + std::to_string(allMeshes.size()) + " meshes to analyze over " + std::to_string(frames.size()) +
+                       " frames from " + std::to_string(frames.front().GetValue()) + " to " + std::to_string(frames.back().GetValue()));
+            if (!m_options.visibilityCachePath.empty())
+            {
+                logVerbose("The visibility cache is not used for frame ranges");
+            }
+
+            // The scene is set up once, at the first frame; generated views stay around it for the whole range
+            WorldSpaceCache firstFrameCache(frames.front());
+            phaseStart = Clock::now();
+            GfBBox3d sceneBounds = calculateSceneBounds(stage, firstFrameCache);
+            const double duplicateTolerance = getDuplicateTolerance(sceneBounds);
+            m_stats.boundsSeconds += secondsSince(phaseStart);
+
+            phaseStart = Clock::now();
+            scene = buildOcclusionScene(allMeshes, instanceProxies, instancers, firstFrameCache);
+            m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+
+            phaseStart = Clock::now();
+            std::vector<Viewpoint> generatedViewpoints;
+            if (m_options.generateViewpoints)
+            {
+                generatedViewpoints = generateViewpoints(sceneBounds, scene);
+                m_stats.viewpointsGenerated = generatedViewpoints.size();
+                m_stats.duplicateViewpoints = ViewpointGenerator::removeDuplicates(generatedViewpoints, duplicateTolerance);
+            }
+            m_stats.viewpointSeconds += secondsSince(phaseStart);
+            if (generatedViewpoints.empty() && cameras.empty())
+            {
+                logVerbose("No viewpoints available for analysis");
+                return {};
+            }
+
+            // Only prims that may change over time are read again after the first frame
+            std::unordered_map<SdfPath, bool, SdfPath::Hash> varyingTransforms;
+            std::vector<uint32_t> animatedMeshes;
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+            {
+                if (meshMightBeTimeVarying(scene.meshes[meshIndex], varyingTransforms))
+                {
+                    animatedMeshes.push_back(static_cast<uint32_t>(meshIndex));
+                }
+            }
+            const bool animatedInstances = instancesMightBeTimeVarying(stage, instanceProxies, instancers, scene.instances, varyingTransforms);
+            const bool animatedCameras = std::any_of(cameras.begin(), cameras.end(),
+                                                     [&](const UsdGeomCamera &camera)
+                                                     { return cameraMightBeTimeVarying(camera, varyingTransforms); });
+            m_stats.animatedMeshes = animatedMeshes.size();
+            logVerbose(std::to_string(animatedMeshes.size()) + " meshes are animated" +
+                       (animatedInstances ? ", instances are animated" : "") + (animatedCameras ? ", cameras are animated" : ""));
+
+            const size_t meshCount = scene.meshes.size();
+            std::vector<MeshVisibility> initialVisibility(meshCount, MeshVisibility::Visible);
+            if (m_options.preserveInstancedMeshes)
+            {
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    if (scene.instancedMeshes[meshIndex])
+                    {
+                        initialVisibility[meshIndex] = MeshVisibility::Preserved;
+                    }
+                }
+            }
+
+            const bool everVisible = m_options.frameOutput == FrameOutput::EverVisible;
+            std::vector<uint8_t> seenBefore(meshCount, 0);
+            std::vector<uint8_t> seenFromGenerated;
+            std::vector<Viewpoint> cameraViewpoints;
+            std::vector<MeshVisibility> scratchVisibility;
+            std::vector<float> scores(meshCount, 0.0f);
+            frameVisibility.reserve(frames.size());
+
+            for (size_t frame = 0; frame < frames.size(); ++frame)
+            {
+                const bool geometryMoved = frame > 0 && (!animatedMeshes.empty() || animatedInstances);
+                const bool camerasMoved = frame > 0 && animatedCameras;
+                if (frame > 0 && !geometryMoved && !camerasMoved)
+                {
+                    frameVisibility.push_back(frameVisibility.back());
+                    m_stats.framesReused++;
+                    continue;
+                }
+
+                WorldSpaceCache worldCache(frames[frame]);
+                phaseStart = Clock::now();
+                if (geometryMoved)
+                {
+                    // Refit in place; only changed counts force a rebuild
+                    const bool refitted = (!animatedInstances || scene.instances.updatePlacements(instanceProxies, instancers, worldCache)) &&
+                                          refitOcclusionScene(scene, animatedMeshes, worldCache);
+                    if (!refitted)
+                    {
+                        logVerbose("Point, triangle or instance counts changed at frame " + std::to_string(frames[frame].GetValue()) +
+                                   "; rebuilding the occlusion scene");
+                        scene = buildOcclusionScene(allMeshes, instanceProxies, instancers, worldCache);
+                    }
+                }
+                m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+
+                phaseStart = Clock::now();
+                if (frame == 0 || camerasMoved)
+                {
+                    cameraViewpoints = extractCameraViewpoints(cameras, worldCache);
+                    ViewpointGenerator::removeDuplicates(cameraViewpoints, duplicateTolerance);
+                }
+                m_stats.viewpointSeconds += secondsSince(phaseStart);
+
+                // Meshes seen before are still tested as occluders, just not again for themselves
+                phaseStart = Clock::now();
+                std::vector<uint8_t> resolved(meshCount, 0);
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    resolved[meshIndex] = initialVisibility[meshIndex] == MeshVisibility::Preserved || (everVisible && seenBefore[meshIndex]);
+                }
+
+                // Generated views are fixed, so what they see only changes when the geometry moves
+                if (frame == 0 || geometryMoved)
+                {
+                    seenFromGenerated = resolved;
+                    if (!generatedViewpoints.empty())
+                    {
+                        scratchVisibility = initialVisibility;
+                        testVisibility(scene, generatedViewpoints, seenFromGenerated, scratchVisibility, scores);
+                    }
+                }
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    resolved[meshIndex] |= seenFromGenerated[meshIndex];
+                }
+                if (!cameraViewpoints.empty())
+                {
+                    scratchVisibility = initialVisibility;
+                    testVisibility(scene, cameraViewpoints, resolved, scratchVisibility, scores);
+                }
+                m_stats.visibilitySeconds += secondsSince(phaseStart);
+
+                std::vector<MeshVisibility> visibility = initialVisibility;
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    if (visibility[meshIndex] != MeshVisibility::Preserved)
+                    {
+                        visibility[meshIndex] = resolved[meshIndex] ? MeshVisibility::Visible : MeshVisibility::Hidden;
+                        seenBefore[meshIndex] |= resolved[meshIndex];
+                    }
+                }
+                frameVisibility.push_back(std::move(visibility));
+                m_stats.framesAnalyzed++;
+
+                // Once every mesh has been seen, no later frame can hide one
+                if (everVisible && std::find(resolved.begin(), resolved.end(), 0) == resolved.end())
+                {
+                    logVerbose("Every mesh was seen by frame " + std::to_string(frames[frame].GetValue()) +
+                               "; skipping the remaining frames");
+                    m_stats.framesReused += frames.size() - frameVisibility.size();
+                    frameVisibility.resize(frames.size(), frameVisibility.back());
+                    break;
+                }
+            }
+
+            viewpoints = generatedViewpoints;
+            viewpoints.insert(viewpoints.end(), cameraViewpoints.begin(), cameraViewpoints.end());
+            m_stats.viewpointsUsed = viewpoints.size();
+            logVerbose("Tested " + std::to_string(m_stats.framesAnalyzed) + " frames, reused the verdicts of " +
+                       std::to_string(m_stats.framesReused));
+
+            std::vector<MeshVisibility> visibility = initialVisibility;
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                if (visibility[meshIndex] != MeshVisibility::Preserved && !seenBefore[meshIndex])
+                {
+                    visibility[meshIndex] = MeshVisibility::Hidden;
+                }
+            }
+            return visibility;
+        }
+
+        bool HiddenMeshRemover::refitOcclusionScene(OcclusionScene &scene, const std::vector<uint32_t> &changedMeshes,
+                                                    const WorldSpaceCache &worldCache)
+        {
+            std::vector<UsdGeomMesh> meshes;
+            meshes.reserve(changedMeshes.size());
+            for (uint32_t meshIndex : changedMeshes)
+            {
+                meshes.push_back(scene.meshes[meshIndex]);
+            }
+
+            // Each mesh owns its range of the snapshot, so meshes are re-read in parallel
+            const std::vector<GfMatrix4d> transforms = worldCache.computeLocalToWorld(meshes);
+            std::atomic<bool> countsKept(true);
+            WorkParallelForN(
+                changedMeshes.size(),
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end && countsKept; ++i)
+                    {
+                        if (!scene.geometry.updateMesh(changedMeshes[i], meshes[i], transforms[i], worldCache.getTime()))
+                        {
+                            countsKept = false;
+                        }
+                        else if (m_options.engine == VisibilityEngine::RayCast)
+                        {
+                            scene.sampler.updateMesh(scene.geometry, changedMeshes[i]);
+                        }
+                    }
+                });
+            if (!countsKept)
+            {
+                return false;
+            }
+
+            if (usesRayCaster())
+            {
+                scene.rayCaster.refit(scene.geometry, scene.instances, changedMeshes);
+            }
+            if (!scene.hierarchy.empty())
+            {
+                scene.hierarchy.refit(scene.geometry, changedMeshes);
+            }
+
+            scene.bounds = GfRange3f();
+            for (size_t meshIndex = 0; meshIndex < scene.geometry.getMeshCount(); ++meshIndex)
+            {
+                scene.bounds.UnionWith(scene.geometry.getBounds(meshIndex));
+            }
+            for (size_t instance = 0; instance < scene.instances.getInstanceCount(); ++instance)
+            {
+                scene.bounds.UnionWith(scene.instances.getBounds(instance));
+            }
+            if (m_options.engine == VisibilityEngine::Voxel)
+            {
+                // Voxels cannot be refitted; rebuilding costs about as much as a fill
+                scene.voxels.build(scene.geometry, scene.instances, scene.bounds, m_options.voxelResolution);
+            }
+            return true;
+        }
+
+        size_t HiddenMeshRemover::authorFrameVisibility(UsdStagePtr stage, const OcclusionScene &scene,
+                                                        const std::vector<UsdTimeCode> &frames,
+                                                        const std::vector<std::vector<MeshVisibility>> &frameVisibility)
+        {
+            size_t authored = 0;
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+            {
+                // Meshes hidden in every frame already got a plain invisible value
+                size_t hiddenFrames = 0;
+                for (const std::vector<MeshVisibility> &visibility : frameVisibility)
+                {
+                    hiddenFrames += visibility[meshIndex] == MeshVisibility::Hidden;
+                }
+                if (hiddenFrames == 0 || hiddenFrames == frameVisibility.size())
+                {
+                    continue;
+                }
+
+                const SdfPath &path = scene.meshes[meshIndex].GetPath();
+                UsdGeomImageable imageable(stage->GetPrimAtPath(path));
+                if (!imageable)
+                {
+                    logVerbose("Could not create imageable for mesh: " + path.GetString());
+                    continue;
+                }
+
+                // Token samples hold until the next one, so only changes are authored
+                UsdAttribute visibilityAttr = imageable.CreateVisibilityAttr();
+                TfToken previous;
+                for (size_t frame = 0; frame < frames.size(); ++frame)
+                {
+                    const TfToken &value = frameVisibility[frame][meshIndex] == MeshVisibility::Hidden ? UsdGeomTokens->invisible
+                                                                                                       : UsdGeomTokens->inherited;
+                    if (value != previous)
+                    {
+                        visibilityAttr.Set(value, frames[frame]);
+                        previous = value;
+                    }
+                }
+                ++authored;
+                logVerbose("Set time-sampled visibility for mesh: " + path.GetString() + " (hidden in " +
+                           std::to_string(hiddenFrames) + " of " + std::to_string(frames.size()) + " frames)");
+            }
+            return authored;
+        }
+
+        std::vector<HiddenMeshRemover::Viewpoint> HiddenMeshRemover::generateViewpoints(const GfBBox3d &sceneBounds,
+                                                                                        const OcclusionScene &scene)
+        {
+            ViewpointGenerator generator(sceneBounds.GetRange());
+            const int density = static_cast<int>(m_options.viewpointDensity);
+
+            std::vector<Viewpoint> viewpoints;
+            if (m_options.viewpointDistribution == ViewpointDistribution::LatLong)
+            {
+                viewpoints = generator.generateLatLongGrid(density);
+            }
+            else
+            {
+                // Same spacing as the density x density grid has at its equator, with about a third of the views
+                const double count = std::ceil(static_cast<double>(density) * density / M_PI);
+                viewpoints = generator.generateFibonacciSphere(static_cast<size_t>(std::max(1.0, count)));
+            }
+
+            // Refinement needs the ray caster, which buildOcclusionScene() only skips when nothing uses it
+            const bool canTrace = scene.geometry.getMeshCount() > 0 && usesRayCaster();
+            std::vector<Viewpoint> refined;
+            if (canTrace && m_options.refinementPasses > 0)
+            {
+                refined = generator.refineSphere(viewpoints, m_options.refinementPasses, scene.rayCaster);
+            }
+
+            // Add some additional viewpoints along the main axes
+            auto axisViews = generator.generateAxisViews();
+            viewpoints.insert(viewpoints.end(), axisViews.begin(), axisViews.end());
+
+            // Views that depend on the geometry come last; the visibility cache does not key on them
+            viewpoints.insert(viewpoints.end(), refined.begin(), refined.end());
+            m_stats.viewpointsRefined = refined.size();
+
+            if (canTrace && m_options.interiorProbeResolution > 0)
+            {
+                auto probes = generator.generateInteriorProbes(m_options.interiorProbeResolution, scene.rayCaster);
+                viewpoints.insert(viewpoints.end(), probes.begin(), probes.end());
+                m_stats.interiorProbes = probes.size();
+            }
+
+            return viewpoints;
+        }
+
+        bool HiddenMeshRemover::usesRayCaster() const
+        {
+            return m_options.engine == VisibilityEngine::RayCast || m_options.removeHiddenTriangles ||
+                   (m_options.generateViewpoints && (m_options.refinementPasses > 0 || m_options.interiorProbeResolution > 0));
+        }
+
+        void HiddenMeshRemover::collectScenePrims(const UsdPrim &root, std::vector<UsdGeomMesh> &meshes,
+                                                  std::vector<UsdGeomCamera> &cameras,
+                                                  std::vector<UsdGeomMesh> &instanceProxies,
+                                                  std::vector<UsdGeomPointInstancer> &instancers)
+        {
+            // Descend into native instances too; their meshes are occluders but not analysed
+            UsdPrimRange range(root, UsdTraverseInstanceProxies());
+            for (auto it = range.begin(); it != range.end(); ++it)
+            {
+                if (it->IsA<UsdGeomMesh>())
+                {
+                    if (it->IsInstanceProxy())
+                    {
+                        instanceProxies.emplace_back(*it);
+                    }
+                    else
+                    {
+                        meshes.emplace_back(*it);
+                    }
+                }
+                else if (it->IsA<UsdGeomCamera>())
+                {
+                    cameras.emplace_back(*it);
+                }
+                else if (it->IsA<UsdGeomPointInstancer>())
+                {
+                    instancers.emplace_back(*it);
+                }
+            }
+
+            // Prototype meshes of point instancers are placed by the instancer, not analysed in place
+            SdfPathVector prototypeRoots;
+            for (const UsdGeomPointInstancer &instancer : instancers)
+            {
+                SdfPathVector targets;
+                instancer.GetPrototypesRel().GetTargets(&targets);
+                prototypeRoots.insert(prototypeRoots.end(), targets.begin(), targets.end());
+            }
+            if (prototypeRoots.empty())
+            {
+                return;
+            }
 
-            return true;
+            auto isPrototypeMesh = [&](const UsdGeomMesh &mesh)
+            {
+                const SdfPath path = mesh.GetPath();
+                return std::any_of(prototypeRoots.begin(), prototypeRoots.end(),
+                                   [&](const SdfPath &root)
+                                   { return path.HasPrefix(root); });
+            };
+            meshes.erase(std::remove_if(meshes.begin(), meshes.end(), isPrototypeMesh), meshes.end());
+            instanceProxies.erase(std::remove_if(instanceProxies.begin(), instanceProxies.end(), isPrototypeMesh), instanceProxies.end());
         }
 
-        std::vector<SdfPath> HiddenMeshRemover::analyzeHiddenMeshes(UsdStagePtr stage)
+        std::vector<HiddenMeshRemover::Viewpoint> HiddenMeshRemover::extractCameraViewpoints(const std::vector<UsdGeomCamera> &cameras,
+                                                                                             const WorldSpaceCache &worldCache)
         {
-            std::vector<SdfPath> hiddenMeshes;
+            std::vector<Viewpoint> viewpoints;
 
-            if (!stage)
+            const std::vector<GfMatrix4d> transforms = worldCache.computeLocalToWorld(cameras);
+            for (size_t i = 0; i < cameras.size(); ++i)
             {
-                return hiddenMeshes;
-            }
+                const UsdGeomCamera &camera = cameras[i];
+                const GfMatrix4d &transform = transforms[i];
+
+                // Extract position and direction from the world transform
+                GfVec3d position = transform.ExtractTranslation();
+
+                // Camera looks down -Z axis in its local space
+                GfVec3d localDirection(0, 0, -1);
+                GfVec3d worldDirection = transform.TransformDir(localDirection).GetNormalized();
+
+                // Get field of view
+                float fov = 60.0f; // Default
+                float horizontalAperture, verticalAperture, focalLength;
+                if (camera.GetHorizontalApertureAttr().Get(&horizontalAperture, worldCache.getTime()) &&
+                    camera.GetVerticalApertureAttr().Get(&verticalAperture, worldCache.getTime()) &&
+                    camera.GetFocalLengthAttr().Get(&focalLength, worldCache.getTime()))
+                {
 
-            m_stats.reset();
+                    // Calculate FOV from aperture and focal length
+                    fov = 2.0f * atan(horizontalAperture / (2.0f * focalLength)) * 180.0f / M_PI;
+                }
 
-            // Calculate scene bounds and generate viewpoints
-            GfBBox3d sceneBounds = calculateSceneBounds(stage);
-            std::vector<Viewpoint> viewpoints;
+                viewpoints.emplace_back(position, worldDirection, fov);
+            }
 
-            if (m_options.useExistingCameras)
+            return viewpoints;
+        }
+
+        HiddenMeshRemover::OcclusionScene HiddenMeshRemover::buildOcclusionScene(const std::vector<UsdGeomMesh> &meshes,
+                                                                                 const std::vector<UsdGeomMesh> &instanceProxies,
+                                                                                 const std::vector<UsdGeomPointInstancer> &instancers,
+                                                                                 const WorldSpaceCache &worldCache)
+        {
+            OcclusionScene scene;
+            scene.meshes = meshes;
+            for (const UsdGeomMesh &mesh : meshes)
             {
-                auto cameraViewpoints = extractCameraViewpoints(stage);
-                viewpoints.insert(viewpoints.end(), cameraViewpoints.begin(), cameraViewpoints.end());
+                scene.instancedMeshes.push_back(isMeshInstanced(mesh, mesh.GetPrim().GetStage()));
             }
 
-            if (m_options.generateViewpoints)
+            // One pass over the stage; all later queries read the flat, world-space buffers
+            scene.geometry.extract(meshes, worldCache.computeLocalToWorld(meshes), worldCache.getTime());
+            scene.instances.extract(instanceProxies, instancers, worldCache);
+            finishOcclusionScene(scene);
+            return scene;
+        }
+
+        bool HiddenMeshRemover::streamOcclusionScene(UsdStagePtr stage, OcclusionScene &scene, std::vector<Viewpoint> &cameraViewpoints,
+                                                     GfBBox3d &sceneBounds)
+        {
+            scene = OcclusionScene();
+            cameraViewpoints.clear();
+            auto phaseStart = Clock::now();
+            const size_t budgetBytes = m_options.memoryBudgetMB * 1024 * 1024;
+            auto withinBudget = [&](size_t bytes)
             {
-                auto generatedViewpoints = generateViewpoints(sceneBounds);
-                viewpoints.insert(viewpoints.end(), generatedViewpoints.begin(), generatedViewpoints.end());
-            }
+                if (budgetBytes == 0 || bytes <= budgetBytes)
+                {
+                    return true;
+                }
+                // Dropping occluders would change verdicts, so the analysis stops instead
+                std::cerr << "Warning: Occlusion data of " << bytes / (1024 * 1024) << " MiB exceeds the memory budget of "
+                          << m_options.memoryBudgetMB << " MiB; no meshes were analysed" << std::endl;
+                return false;
+            };
 
-            if (viewpoints.empty())
+            // Unloaded payloads are pruned by the default predicate, so find them with a looser one
+            SdfPathVector payloads;
+            UsdPrimRange range(stage->GetPseudoRoot(), UsdPrimIsActive && UsdPrimIsDefined && !UsdPrimIsAbstract);
+            for (auto it = range.begin(); it != range.end(); ++it)
             {
-                return hiddenMeshes;
+                if (!it->IsLoaded() && it->HasAuthoredPayloads())
+                {
+                    payloads.push_back(it->GetPath());
+                    it.PruneChildren();
+                }
             }
 
-            // Collect all meshes
-            std::vector<UsdGeomMesh> allMeshes;
-            auto range = stage->Traverse();
-            for (auto it = range.begin(); it != range.end(); ++it)
+            // Snapshot the loaded prims below root; meshes are appended after those already taken
+            auto snapshot = [&](const UsdPrim &root, WorldSpaceCache &worldCache)
             {
-                if (it->IsA<UsdGeomMesh>())
+                std::vector<UsdGeomMesh> meshes;
+                std::vector<UsdGeomCamera> cameras;
+                std::vector<UsdGeomMesh> instanceProxies;
+                std::vector<UsdGeomPointInstancer> instancers;
+                collectScenePrims(root, meshes, cameras, instanceProxies, instancers);
+
+                // Instancing is a stage query, so it is answered while the prims are loaded
+                for (const UsdGeomMesh &mesh : meshes)
+                {
+                    scene.meshes.push_back(mesh);
+                    scene.instancedMeshes.push_back(isMeshInstanced(mesh, stage));
+                }
+                SceneGeometry geometry;
+                geometry.extract(meshes, worldCache.computeLocalToWorld(meshes), worldCache.getTime());
+                scene.geometry.append(geometry);
+                SceneInstances instances;
+                instances.extract(instanceProxies, instancers, worldCache);
+                scene.instances.append(instances);
+                if (m_options.useExistingCameras)
                 {
-                    UsdGeomMesh mesh(*it);
-                    allMeshes.push_back(mesh);
+                    const std::vector<Viewpoint> views = extractCameraViewpoints(cameras, worldCache);
+                    cameraViewpoints.insert(cameraViewpoints.end(), views.begin(), views.end());
                 }
+            };
+
+            // Everything that is already loaded, with unloaded models bounded by their extentsHint
+            GfRange3d bounds;
+            {
+                WorldSpaceCache worldCache;
+                bounds = calculateSceneBounds(stage, worldCache).GetRange();
+                snapshot(stage->GetPseudoRoot(), worldCache);
             }
+            logVerbose("Streaming " + std::to_string(payloads.size()) + " unloaded payloads around " +
+                       std::to_string(scene.meshes.size()) + " loaded meshes");
 
-            // Analyze visibility
-            for (const auto &mesh : allMeshes)
+            for (const SdfPath &payload : payloads)
             {
-                if (m_options.preserveInstancedMeshes && isMeshInstanced(mesh, stage))
+                stage->Load(payload);
+                const UsdPrim root = stage->GetPrimAtPath(payload);
+                if (root)
                 {
-                    continue;
+                    // A fresh cache per payload; the previous one holds prims that are gone
+                    WorldSpaceCache worldCache;
+                    bounds.UnionWith(worldCache.computeWorldBounds(root));
+                    snapshot(root, worldCache);
                 }
+                stage->Unload(payload);
+                m_stats.payloadsStreamed++;
 
-                if (!isMeshVisible(mesh, viewpoints, allMeshes))
+                if (!withinBudget(scene.geometry.getMemoryUsage() + scene.instances.getMemoryUsage()))
                 {
-                    hiddenMeshes.push_back(mesh.GetPath());
+                    m_stats.traversalSeconds += secondsSince(phaseStart);
+                    scene = OcclusionScene();
+                    return false;
                 }
             }
 
-            return hiddenMeshes;
+            sceneBounds = GfBBox3d(bounds.IsEmpty() ? GfRange3d(GfVec3d(-10), GfVec3d(10)) : bounds);
+            m_stats.traversalSeconds += secondsSince(phaseStart);
+
+            phaseStart = Clock::now();
+            finishOcclusionScene(scene);
+            m_stats.bvhBuildSeconds += secondsSince(phaseStart);
+            const size_t residentBytes = m_stats.geometryCacheBytes + scene.rayCaster.getMemoryUsage() + scene.sampler.getMemoryUsage();
+            if (!withinBudget(residentBytes))
+            {
+                scene = OcclusionScene();
+                return false;
+            }
+            logVerbose("Streamed " + std::to_string(m_stats.payloadsStreamed) + " payloads into " +
+                       std::to_string(residentBytes) + " bytes of occlusion data");
+            return true;
         }
 
-        std::vector<HiddenMeshRemover::Viewpoint> HiddenMeshRemover::generateViewpoints(const GfBBox3d &sceneBounds)
+        void HiddenMeshRemover::finishOcclusionScene(OcclusionScene &scene)
         {
-            std::vector<Viewpoint> viewpoints;
+            scene.bounds = GfRange3f();
+            for (size_t meshIndex = 0; meshIndex < scene.geometry.getMeshCount(); ++meshIndex)
+            {
+                scene.bounds.UnionWith(scene.geometry.getBounds(meshIndex));
+            }
+            for (size_t instance = 0; instance < scene.instances.getInstanceCount(); ++instance)
+            {
+                scene.bounds.UnionWith(scene.instances.getBounds(instance));
+            }
+            if (usesRayCaster())
+            {
+                scene.rayCaster.build(scene.geometry, scene.instances);
+            }
+            if (m_options.engine == VisibilityEngine::RayCast)
+            {
+                scene.sampler.build(scene.geometry);
+                if (m_options.hierarchicalCulling)
+                {
+                    scene.hierarchy.build(scene.meshes, scene.geometry);
+                }
+            }
+            else if (m_options.engine == VisibilityEngine::Voxel)
+            {
+                scene.voxels.build(scene.geometry, scene.instances, scene.bounds, m_options.voxelResolution);
+                m_stats.voxelBricks = scene.voxels.getOccupiedBrickCount();
+            }
 
-            GfVec3d center = sceneBounds.GetRange().GetMidpoint();
-            GfVec3d size = sceneBounds.GetRange().GetSize();
-            double maxDim = std::max({size[0], size[1], size[2]});
-            double radius = maxDim * 1.5; // Distance from center to place viewpoints
+            m_stats.hierarchyGroups = scene.hierarchy.getGroupCount();
+            m_stats.enclosedGroups = scene.hierarchy.getEnclosedGroupCount();
+            m_stats.geometryCacheBytes = scene.geometry.getMemoryUsage() + scene.instances.getMemoryUsage();
+            m_stats.totalTriangles = scene.geometry.getTotalTriangleCount();
+            m_stats.occluderInstances = scene.instances.getInstanceCount();
+            m_stats.prototypeMeshes = scene.instances.prototypes.getMeshCount();
+        }
 
-            int numViewpoints = static_cast<int>(m_options.viewpointDensity);
+        std::vector<HiddenMeshRemover::MeshVisibility> HiddenMeshRemover::classifyMeshes(const OcclusionScene &scene,
+                                                                                          const std::vector<Viewpoint> &viewpoints,
+                                                                                          uint64_t viewpointKey,
+                                                                                          UsdStagePtr stage)
+        {
+            const size_t meshCount = scene.meshes.size();
+            std::vector<MeshVisibility> visibility(meshCount, MeshVisibility::Visible);
 
-            // Generate viewpoints in a sphere around the scene
-            for (int i = 0; i < numViewpoints; ++i)
+            // Instancing is a stage query, so resolve it up front on this thread
+            if (m_options.preserveInstancedMeshes)
             {
-                for (int j = 0; j < numViewpoints; ++j)
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
                 {
-                    double theta = (2.0 * M_PI * i) / numViewpoints; // Azimuth
-                    double phi = (M_PI * j) / (numViewpoints - 1);   // Elevation
+                    if (scene.instancedMeshes[meshIndex])
+                    {
+                        visibility[meshIndex] = MeshVisibility::Preserved;
+                    }
+                }
+            }
 
-                    // Convert spherical to cartesian coordinates
-                    GfVec3d position(
-                        center[0] + radius * sin(phi) * cos(theta),
-                        center[1] + radius * sin(phi) * sin(theta),
-                        center[2] + radius * cos(phi));
+            // Meshes seen from an earlier viewpoint, preserved or cached are not tested again
+            std::vector<uint8_t> resolved(meshCount, 0);
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                resolved[meshIndex] = visibility[meshIndex] == MeshVisibility::Preserved;
+            }
 
-                    // Direction points towards scene center
-                    GfVec3d direction = (center - position).GetNormalized();
+            // Highest visible sample fraction (ray engine) or pixel count (raster engine) per mesh
+            std::vector<float> scores(meshCount, 0.0f);
 
-                    viewpoints.emplace_back(position, direction, 60.0f);
+            m_meshCosts.assign(meshCount, MeshCost());
+            const bool useCache = !m_options.visibilityCachePath.empty();
+            VisibilityCache cache;
+            if (useCache)
+            {
+                cache.computeKeys(scene.geometry, viewpointKey);
+                const size_t entryCount = cache.load(m_options.visibilityCachePath);
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    bool hidden = false;
+                    if (!resolved[meshIndex] && cache.find(static_cast<uint32_t>(meshIndex), hidden, scores[meshIndex]))
+                    {
+                        visibility[meshIndex] = hidden ? MeshVisibility::Hidden : MeshVisibility::Visible;
+                        resolved[meshIndex] = 1;
+                        m_meshCosts[meshIndex].cached = true;
+                        m_meshCosts[meshIndex].bestScore = scores[meshIndex];
+                        m_stats.cachedMeshes++;
+                    }
                 }
+                logVerbose("Reusing " + std::to_string(m_stats.cachedMeshes) + " of " + std::to_string(entryCount) +
+                           " cached verdicts from " + m_options.visibilityCachePath);
             }
 
-            // Add some additional viewpoints along the main axes
-            double axisDistance = radius * 0.8;
-            std::vector<GfVec3d> axisPositions = {
-                center + GfVec3d(axisDistance, 0, 0),  // +X
-                center + GfVec3d(-axisDistance, 0, 0), // -X
-                center + GfVec3d(0, axisDistance, 0),  // +Y
-                center + GfVec3d(0, -axisDistance, 0), // -Y
-                center + GfVec3d(0, 0, axisDistance),  // +Z
-                center + GfVec3d(0, 0, -axisDistance)  // -Z
-            };
+            testVisibility(scene, viewpoints, resolved, visibility, scores);
 
-            for (const auto &pos : axisPositions)
+            if (useCache)
             {
-                GfVec3d direction = (center - pos).GetNormalized();
-                viewpoints.emplace_back(pos, direction, 90.0f); // Wider FOV for axis views
+                // Preserved meshes depend on the stage, not on geometry, so they are never cached
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    if (visibility[meshIndex] != MeshVisibility::Preserved)
+                    {
+                        cache.store(static_cast<uint32_t>(meshIndex), visibility[meshIndex] == MeshVisibility::Hidden, scores[meshIndex]);
+                    }
+                }
+                if (!cache.save(m_options.visibilityCachePath))
+                {
+                    std::cerr << "Warning: Failed to write visibility cache: " << m_options.visibilityCachePath << std::endl;
+                }
             }
 
-            return viewpoints;
+            return visibility;
         }
 
-        std::vector<HiddenMeshRemover::Viewpoint> HiddenMeshRemover::extractCameraViewpoints(UsdStagePtr stage)
+        void HiddenMeshRemover::testVisibility(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                               std::vector<uint8_t> &resolved, std::vector<MeshVisibility> &visibility,
+                                               std::vector<float> &scores)
         {
-            std::vector<Viewpoint> viewpoints;
+            const size_t meshCount = scene.meshes.size();
+            if (m_meshCosts.size() != meshCount)
+            {
+                m_meshCosts.assign(meshCount, MeshCost());
+            }
 
-            auto range = stage->Traverse();
-            for (auto it = range.begin(); it != range.end(); ++it)
+            logVerbose("Testing visibility with " + std::to_string(WorkGetConcurrencyLimit()) + " threads");
+            if (std::find(resolved.begin(), resolved.end(), 0) == resolved.end())
             {
-                if (it->IsA<UsdGeomCamera>())
-                {
-                    UsdGeomCamera camera(*it);
+                logVerbose("Every mesh is already resolved; skipping visibility tests");
+            }
+            else if (m_options.engine == VisibilityEngine::Raster)
+            {
+                m_stats.frustumCandidates += rasterizeVisibility(scene, viewpoints, resolved, visibility, scores, m_meshCosts);
+            }
+            else if (m_options.engine == VisibilityEngine::Voxel)
+            {
+                floodFillVisibility(scene, viewpoints, resolved, visibility, scores, m_meshCosts);
+            }
+            else
+            {
+                logVerbose("Tracing rays in packets of " +
+                           std::to_string(std::clamp(m_options.rayPacketSize, 1, RayPacket::kMaxSize)));
 
-                    // Get camera transform
-                    UsdGeomXformable xformable(camera);
-                    GfMatrix4d transform;
-                    bool resetsXformStack;
-                    xformable.GetLocalTransformation(&transform, &resetsXformStack);
+                FrustumCuller culler;
+                std::vector<uint32_t> candidates;
+                std::vector<float> visibleFractions;
+                std::vector<uint32_t> tracedRays;
 
-                    // Extract position and direction from transform
-                    GfVec3d position = transform.ExtractTranslation();
+                // Test candidates from one viewpoint and record their verdicts, scores and costs
+                auto testCandidates = [&](const Viewpoint &viewpoint, const GfMatrix4d &cameraToWorld, Clock::time_point viewStart)
+                {
+                    const std::vector<uint8_t> visible = findVisibleCandidates(scene, viewpoint, cameraToWorld, candidates,
+                                                                               visibleFractions, tracedRays);
+                    for (size_t i = 0; i < candidates.size(); ++i)
+                    {
+                        resolved[candidates[i]] |= visible[i];
+                        scores[candidates[i]] = std::max(scores[candidates[i]], visibleFractions[i]);
+                    }
 
-                    // Camera looks down -Z axis in its local space
-                    GfVec3d localDirection(0, 0, -1);
-                    GfVec3d worldDirection = transform.TransformDir(localDirection);
+                    // The viewpoint's time is shared by its candidates in proportion to their rays
+                    const double viewSeconds = secondsSince(viewStart);
+                    size_t viewRays = 0;
+                    for (uint32_t rays : tracedRays)
+                    {
+                        viewRays += rays;
+                    }
+                    for (size_t i = 0; i < candidates.size(); ++i)
+                    {
+                        MeshCost &cost = m_meshCosts[candidates[i]];
+                        cost.raysTraced += tracedRays[i];
+                        if (viewRays > 0)
+                        {
+                            cost.seconds += viewSeconds * tracedRays[i] / static_cast<double>(viewRays);
+                        }
+                        cost.recordScore(visibleFractions[i], viewpoint);
+                    }
+                };
 
-                    // Get field of view
-                    float fov = 60.0f; // Default
-                    float horizontalAperture, verticalAperture, focalLength;
-                    if (camera.GetHorizontalApertureAttr().Get(&horizontalAperture) &&
-                        camera.GetVerticalApertureAttr().Get(&verticalAperture) &&
-                        camera.GetFocalLengthAttr().Get(&focalLength))
+                // Meshes whose group looked hidden from each viewpoint; tested later unless another viewpoint sees them
+                std::vector<std::vector<uint32_t>> deferred(scene.hierarchy.empty() ? 0 : viewpoints.size());
+                std::vector<uint8_t> everDeferred(scene.hierarchy.empty() ? 0 : meshCount, 0);
+                for (size_t viewIndex = 0; viewIndex < viewpoints.size(); ++viewIndex)
+                {
+                    const Viewpoint &viewpoint = viewpoints[viewIndex];
+                    const auto viewStart = Clock::now();
+                    const GfMatrix4d cameraToWorld = FrustumCuller::computeCameraToWorld(viewpoint.position, viewpoint.direction);
+                    cullViewpoint(culler, cameraToWorld, viewpoint.fov, scene.geometry, scene.bounds, candidates);
+                    m_stats.frustumCandidates += candidates.size();
+
+                    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                                    [&](uint32_t meshIndex)
+                                                    { return resolved[meshIndex] != 0; }),
+                                     candidates.end());
+                    if (!scene.hierarchy.empty())
                     {
+                        cullHiddenGroups(scene, viewpoint, candidates, everDeferred, deferred[viewIndex]);
+                        for (uint32_t meshIndex : deferred[viewIndex])
+                        {
+                            everDeferred[meshIndex] = 1;
+                        }
+                    }
 
-                        // Calculate FOV from aperture and focal length
-                        fov = 2.0f * atan(horizontalAperture / (2.0f * focalLength)) * 180.0f / M_PI;
+                    testCandidates(viewpoint, cameraToWorld, viewStart);
+                }
+
+                // A group verdict only postpones work: a mesh is hidden only after its own test from every such viewpoint
+                for (size_t viewIndex = 0; viewIndex < deferred.size(); ++viewIndex)
+                {
+                    candidates.clear();
+                    for (uint32_t meshIndex : deferred[viewIndex])
+                    {
+                        if (!resolved[meshIndex])
+                        {
+                            candidates.push_back(meshIndex);
+                        }
                     }
+                    std::vector<uint32_t>().swap(deferred[viewIndex]);
+                    if (candidates.empty())
+                    {
+                        continue;
+                    }
+
+                    const Viewpoint &viewpoint = viewpoints[viewIndex];
+                    const auto viewStart = Clock::now();
+                    m_stats.groupRetestedMeshes += candidates.size();
+                    testCandidates(viewpoint, FrustumCuller::computeCameraToWorld(viewpoint.position, viewpoint.direction), viewStart);
+                }
 
-                    viewpoints.emplace_back(position, worldDirection, fov);
+                for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                {
+                    if (!resolved[meshIndex])
+                    {
+                        visibility[meshIndex] = MeshVisibility::Hidden;
+                    }
+                }
+                logVerbose("Traced " + std::to_string(m_stats.raysTraced) + " occlusion rays");
+                if (!scene.hierarchy.empty())
+                {
+                    logVerbose(std::to_string(m_stats.provenHiddenGroups) + " groups were inside a closed mesh from the viewpoint's outside, skipping " +
+                               std::to_string(m_stats.groupProvenMeshes) + " mesh tests");
+                    logVerbose(std::to_string(m_stats.hiddenGroups) + " of " + std::to_string(m_stats.groupTests) +
+                               " group tests looked hidden, deferring " + std::to_string(m_stats.groupCulledMeshes) + " mesh tests, " +
+                               std::to_string(m_stats.groupRetestedMeshes) + " of which were run because no other viewpoint saw the mesh; " +
+                               std::to_string(m_stats.groupTestsSkipped) + " group tests were left out for already deferred meshes");
                 }
             }
 
-            return viewpoints;
         }
 
-        bool HiddenMeshRemover::isMeshVisible(const UsdGeomMesh &mesh, const std::vector<Viewpoint> &viewpoints, const std::vector<UsdGeomMesh> &allMeshes)
+        void HiddenMeshRemover::floodFillVisibility(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                                    std::vector<uint8_t> &resolved, std::vector<MeshVisibility> &visibility,
+                                                    std::vector<float> &scores, std::vector<MeshCost> &costs) const
         {
-            // Create a list of potential occluding meshes (all meshes except this one)
-            std::vector<UsdGeomMesh> occludingMeshes;
-            for (const auto &otherMesh : allMeshes)
+            const auto start = Clock::now();
+            const SceneGeometry &geometry = scene.geometry;
+            const size_t meshCount = geometry.getMeshCount();
+
+            std::vector<GfVec3d> seeds;
+            seeds.reserve(viewpoints.size());
+            for (const Viewpoint &viewpoint : viewpoints)
             {
-                if (otherMesh.GetPath() != mesh.GetPath())
-                {
-                    occludingMeshes.push_back(otherMesh);
-                }
+                seeds.push_back(viewpoint.position);
             }
+            const VoxelGrid::Fill fill = scene.voxels.floodFill(seeds);
 
-            // Test visibility from each viewpoint
-            for (const auto &viewpoint : viewpoints)
-            {
-                float visibilityFraction = testMeshVisibilityFromViewpoint(mesh, viewpoint, occludingMeshes);
+            // The fill is only read from here on, so meshes are looked up in parallel
+            std::vector<uint8_t> reached(meshCount, 0);
+            WorkParallelForN(
+                meshCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t meshIndex = begin; meshIndex < end; ++meshIndex)
+                    {
+                        if (!resolved[meshIndex])
+                        {
+                            reached[meshIndex] = scene.voxels.isMeshReached(fill, geometry, static_cast<uint32_t>(meshIndex));
+                        }
+                    }
+                },
+                16);
 
-                // If the mesh is sufficiently visible from this viewpoint, consider it visible
-                if (visibilityFraction > (1.0f - m_options.occlusionThreshold))
+            // The time is shared by the tested meshes in proportion to their triangles
+            const double seconds = secondsSince(start);
+            size_t testedTriangles = 0;
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                testedTriangles += resolved[meshIndex] ? 0 : geometry.getTriangleCount(meshIndex);
+            }
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                if (resolved[meshIndex])
                 {
-                    return true;
+                    continue;
+                }
+                visibility[meshIndex] = reached[meshIndex] ? MeshVisibility::Visible : MeshVisibility::Hidden;
+                scores[meshIndex] = reached[meshIndex] ? 1.0f : 0.0f;
+                resolved[meshIndex] = reached[meshIndex];
+                if (testedTriangles > 0)
+                {
+                    costs[meshIndex].seconds += seconds * geometry.getTriangleCount(meshIndex) / static_cast<double>(testedTriangles);
                 }
             }
-
-            return false; // Not visible from any viewpoint
         }
 
-        float HiddenMeshRemover::testMeshVisibilityFromViewpoint(const UsdGeomMesh &mesh, const Viewpoint &viewpoint, const std::vector<UsdGeomMesh> &occludingMeshes)
+        void HiddenMeshRemover::cullHiddenGroups(const OcclusionScene &scene, const Viewpoint &viewpoint, std::vector<uint32_t> &candidates,
+                                                 const std::vector<uint8_t> &everDeferred, std::vector<uint32_t> &deferred)
         {
-            // Get mesh bounds
-            GfBBox3d meshBounds = getMeshBounds(mesh);
-
-            // First check if mesh is within camera frustum
-            if (!isMeshInFrustum(meshBounds, viewpoint))
+            const MeshHierarchy &hierarchy = scene.hierarchy;
+            const std::vector<uint32_t> &meshOrder = hierarchy.getMeshOrder();
+            const std::vector<uint32_t> &directMeshes = hierarchy.getDirectMeshes();
+
+            // Candidates start pending; groups move them to deferred or proven hidden
+            constexpr uint8_t kPending = 1;
+            constexpr uint8_t kDeferred = 2;
+            constexpr uint8_t kProven = 3;
+            std::vector<uint8_t> state(scene.geometry.getMeshCount(), 0);
+            for (uint32_t meshIndex : candidates)
             {
-                return 0.0f; // Not in view
+                state[meshIndex] = kPending;
             }
 
-            // Sample points on the mesh surface
-            std::vector<GfVec3d> samplePoints = sampleMeshSurface(mesh, 16);
+            // Candidates below each group, and how many of them an earlier viewpoint deferred already;
+            // children come after their parent, so count backwards
+            std::vector<uint32_t> pendingCounts(hierarchy.getGroupCount(), 0);
+            std::vector<uint32_t> deferredCounts(hierarchy.getGroupCount(), 0);
+            for (size_t index = hierarchy.getGroupCount(); index-- > 0;)
+            {
+                const MeshHierarchy::Group &group = hierarchy.getGroup(static_cast<uint32_t>(index));
+                uint32_t count = 0;
+                uint32_t deferredCount = 0;
+                for (uint32_t i = group.firstDirect; i < group.firstDirect + group.directCount; ++i)
+                {
+                    const uint32_t meshIndex = directMeshes[i];
+                    count += state[meshIndex] == kPending;
+                    deferredCount += state[meshIndex] == kPending && everDeferred[meshIndex];
+                }
+                for (uint32_t child = group.firstChild; child < group.firstChild + group.childCount; ++child)
+                {
+                    count += pendingCounts[child];
+                    deferredCount += deferredCounts[child];
+                }
+                pendingCounts[index] = count;
+                deferredCounts[index] = deferredCount;
+            }
 
-            int visibleSamples = 0;
-            for (const auto &point : samplePoints)
+            const uint32_t minMeshes = static_cast<uint32_t>(std::max(2, m_options.minGroupMeshes));
+            const int minSamples = std::max(1, m_options.minSurfaceSamples);
+            const int maxSamples = std::max(minSamples, m_options.maxSurfaceSamples) * kGroupSampleScale;
+            const double tanHalfFov = std::tan(viewpoint.fov * M_PI / 360.0);
+            const GfVec3f origin(viewpoint.position);
+
+            // Whether the viewpoint lies outside each enclosing mesh met so far
+            std::unordered_map<uint32_t, uint8_t> outsideEnclosure;
+            std::vector<uint32_t> newEnclosures;
+
+            // One level at a time, so the groups of a level are tested in parallel
+            std::vector<uint32_t> level(1, 0);
+            std::vector<uint32_t> nextLevel;
+            std::vector<uint32_t> tested;
+            std::vector<uint8_t> verdicts;
+            std::vector<uint32_t> groupRays;
+            constexpr uint8_t kOpen = 0;
+            constexpr uint8_t kLooksHidden = 1;
+            constexpr uint8_t kProvenHidden = 2;
+            constexpr uint8_t kSkipped = 3;
+            while (!level.empty())
             {
-                // Create ray from viewpoint to sample point
-                GfVec3d rayDirection = (point - viewpoint.position).GetNormalized();
-                GfRay ray(viewpoint.position, rayDirection);
+                // Smaller groups keep their candidates for the per-mesh test
+                tested.clear();
+                newEnclosures.clear();
+                for (uint32_t group : level)
+                {
+                    if (pendingCounts[group] >= minMeshes)
+                    {
+                        tested.push_back(group);
+                        const uint32_t enclosure = hierarchy.getGroup(group).enclosingMesh;
+                        if (enclosure != MeshHierarchy::kNoMesh && outsideEnclosure.emplace(enclosure, 0).second)
+                        {
+                            newEnclosures.push_back(enclosure);
+                        }
+                    }
+                }
 
-                bool occluded = false;
+                // Each enclosing mesh is classified once per viewpoint, before the groups that share it read the answer
+                std::vector<uint8_t> outside(newEnclosures.size(), 0);
+                WorkParallelForN(
+                    newEnclosures.size(),
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            outside[i] = MeshHierarchy::isOutsideMesh(scene.geometry, newEnclosures[i], viewpoint.position);
+                        }
+                    },
+                    1);
+                for (size_t i = 0; i < newEnclosures.size(); ++i)
+                {
+                    outsideEnclosure[newEnclosures[i]] = outside[i];
+                }
 
-                // Test if ray is occluded by any other mesh
-                for (const auto &occluder : occludingMeshes)
+                verdicts.assign(tested.size(), kOpen);
+                groupRays.assign(tested.size(), 0);
+                WorkParallelForN(
+                    tested.size(),
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            // Every segment from outside a closed mesh to a point inside it crosses its surface
+                            const MeshHierarchy::Group &group = hierarchy.getGroup(tested[i]);
+                            if (group.enclosingMesh != MeshHierarchy::kNoMesh && outsideEnclosure.at(group.enclosingMesh))
+                            {
+                                verdicts[i] = kProvenHidden;
+                                continue;
+                            }
+
+                            // Meshes an earlier viewpoint deferred are likely hidden and retested anyway, so rays for them are wasted
+                            if (deferredCounts[tested[i]] == pendingCounts[tested[i]])
+                            {
+                                verdicts[i] = kSkipped;
+                                continue;
+                            }
+
+                            // A viewpoint inside the bounds has no sides to look through; descend instead
+                            const GfRange3f &bounds = group.bounds;
+                            if (bounds.IsEmpty() || bounds.Contains(origin))
+                            {
+                                continue;
+                            }
+
+                            // Looks hidden only if no ray gets through; stops at the first that does
+                            const uint32_t budget = computeSampleBudget(bounds, viewpoint.position, tanHalfFov, minSamples, maxSamples);
+                            bool blocked = true;
+                            for (uint32_t sample = 0; sample < budget && blocked; ++sample)
+                            {
+                                const GfVec3d toPoint = GfVec3d(MeshHierarchy::getFacingSample(bounds, viewpoint.position, sample)) - viewpoint.position;
+                                const double distance = toPoint.GetLength();
+                                blocked = scene.rayCaster.isOccluded(origin, GfVec3f(toPoint / std::max(distance, 1e-12)),
+                                                                     static_cast<float>(distance * (1.0 - 1e-4)));
+                                ++groupRays[i];
+                            }
+                            verdicts[i] = blocked ? kLooksHidden : kOpen;
+                        }
+                    },
+                    1);
+
+                nextLevel.clear();
+                for (size_t i = 0; i < tested.size(); ++i)
                 {
-                    if (rayMeshIntersection(ray, occluder))
+                    const MeshHierarchy::Group &group = hierarchy.getGroup(tested[i]);
+                    m_stats.raysTraced += groupRays[i];
+                    m_stats.groupTests += groupRays[i] > 0;
+                    if (verdicts[i] == kProvenHidden || verdicts[i] == kLooksHidden)
                     {
-                        // Check if intersection is closer than our target point
-                        // This is a simplified check - in a full implementation you'd want
-                        // to get the actual intersection distance
-                        occluded = true;
-                        break;
+                        const uint8_t removed = verdicts[i] == kProvenHidden ? kProven : kDeferred;
+                        for (uint32_t m = group.firstMesh; m < group.firstMesh + group.meshCount; ++m)
+                        {
+                            if (state[meshOrder[m]] == kPending)
+                            {
+                                state[meshOrder[m]] = removed;
+                            }
+                        }
+                        if (verdicts[i] == kProvenHidden)
+                        {
+                            m_stats.provenHiddenGroups++;
+                            m_stats.groupProvenMeshes += pendingCounts[tested[i]];
+                        }
+                        else
+                        {
+                            m_stats.hiddenGroups++;
+                            m_stats.groupCulledMeshes += pendingCounts[tested[i]];
+                        }
+                    }
+                    else
+                    {
+                        m_stats.groupTestsSkipped += verdicts[i] == kSkipped;
+                        for (uint32_t child = group.firstChild; child < group.firstChild + group.childCount; ++child)
+                        {
+                            nextLevel.push_back(child);
+                        }
                     }
                 }
+                level.swap(nextLevel);
+            }
 
-                if (!occluded)
+            for (uint32_t meshIndex : candidates)
+            {
+                if (state[meshIndex] == kDeferred)
                 {
-                    visibleSamples++;
+                    deferred.push_back(meshIndex);
                 }
             }
-
-            return static_cast<float>(visibleSamples) / static_cast<float>(samplePoints.size());
-        }
-
-        bool HiddenMeshRemover::isMeshInFrustum(const GfBBox3d &meshBounds, const Viewpoint &viewpoint)
-        {
-            // This is a simplified frustum test
-            // In a full implementation, you'd want to construct a proper view frustum
-
-            GfVec3d meshCenter = meshBounds.GetRange().GetMidpoint();
-            GfVec3d toMesh = (meshCenter - viewpoint.position).GetNormalized();
-
-            // Check if mesh center is roughly in the viewing direction
-            double dotProduct = GfDot(toMesh, viewpoint.direction);
-            double fovRadians = viewpoint.fov * M_PI / 180.0;
-            double cosHalfFov = cos(fovRadians * 0.5);
-
-            return dotProduct > cosHalfFov;
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                            [&](uint32_t meshIndex)
+                                            { return state[meshIndex] != kPending; }),
+                             candidates.end());
         }
 
-        bool HiddenMeshRemover::rayMeshIntersection(const GfRay &ray, const UsdGeomMesh &mesh)
+        size_t HiddenMeshRemover::rasterizeVisibility(const OcclusionScene &scene,
+                                                      const std::vector<Viewpoint> &viewpoints,
+                                                      std::vector<uint8_t> &resolved,
+                                                      std::vector<MeshVisibility> &visibility,
+                                                      std::vector<float> &scores,
+                                                      std::vector<MeshCost> &costs) const
         {
-            // This is a simplified intersection test using bounding box
-            // A full implementation would test against actual mesh triangles
-
-            GfBBox3d meshBounds = getMeshBounds(mesh);
-            GfRange3d range = meshBounds.GetRange();
-
-            // Simple ray-box intersection test
-            GfVec3d rayStart = ray.GetStartPoint();
-            GfVec3d rayDir = ray.GetDirection();
+            const SceneGeometry &geometry = scene.geometry;
+            const size_t meshCount = geometry.getMeshCount();
+            const float nearDistance = static_cast<float>(computeNearDistance(scene.bounds));
+
+            std::vector<uint8_t> seen(meshCount, 0);
+            std::vector<uint32_t> maxPixels(meshCount, 0);
+            std::vector<size_t> bestViews(meshCount, 0);
+            std::vector<double> seconds(meshCount, 0.0);
+            size_t candidateCount = 0;
+            std::mutex seenMutex;
+
+            WorkParallelForN(
+                viewpoints.size(),
+                [&](size_t begin, size_t end)
+                {
+                    SoftwareRasterizer rasterizer(m_options.rasterResolution, m_options.rasterResolution);
+                    FrustumCuller culler;
+                    std::vector<uint32_t> candidates;
+                    std::vector<uint32_t> instanceCandidates;
+                    std::vector<uint32_t> pixelCounts(meshCount);
+                    std::vector<uint8_t> localSeen(meshCount, 0);
+                    std::vector<uint32_t> localMaxPixels(meshCount, 0);
+                    std::vector<size_t> localBestViews(meshCount, 0);
+                    std::vector<double> localSeconds(meshCount, 0.0);
+                    size_t localCandidateCount = 0;
+
+                    for (size_t viewIndex = begin; viewIndex < end; ++viewIndex)
+                    {
+                        const auto viewStart = Clock::now();
+                        const Viewpoint &viewpoint = viewpoints[viewIndex];
+                        const GfMatrix4d cameraToWorld = FrustumCuller::computeCameraToWorld(viewpoint.position, viewpoint.direction);
+
+                        // Only meshes inside the view frustum are rasterized
+                        cullViewpoint(culler, cameraToWorld, viewpoint.fov, geometry, scene.bounds, candidates);
+                        culler.cullBounds(scene.instances, instanceCandidates);
+                        localCandidateCount += candidates.size();
+
+                        rasterizer.setViewProjection(SoftwareRasterizer::computeViewProjection(cameraToWorld, viewpoint.fov), nearDistance);
+                        rasterizer.clear();
+                        rasterizer.renderScene(geometry, candidates, scene.instances, instanceCandidates, viewpoint.position);
+
+                        std::fill(pixelCounts.begin(), pixelCounts.end(), 0);
+                        rasterizer.countVisiblePixels(pixelCounts);
+                        for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                        {
+                            if (pixelCounts[meshIndex] > localMaxPixels[meshIndex])
+                            {
+                                localMaxPixels[meshIndex] = pixelCounts[meshIndex];
+                                localBestViews[meshIndex] = viewIndex;
+                            }
+                            if (pixelCounts[meshIndex] >= static_cast<uint32_t>(std::max(1, m_options.minVisiblePixels)))
+                            {
+                                localSeen[meshIndex] = 1;
+                            }
+                        }
+
+                        // The view's time is shared by the rendered meshes in proportion to their triangles
+                        size_t viewTriangles = 0;
+                        for (uint32_t meshIndex : candidates)
+                        {
+                            viewTriangles += geometry.getTriangleCount(meshIndex);
+                        }
+                        const double viewSeconds = secondsSince(viewStart);
+                        for (uint32_t meshIndex : candidates)
+                        {
+                            if (viewTriangles > 0)
+                            {
+                                localSeconds[meshIndex] += viewSeconds * geometry.getTriangleCount(meshIndex) / static_cast<double>(viewTriangles);
+                            }
+                        }
+                    }
 
-            // Avoid division by zero
-            GfVec3d invDir;
-            invDir[0] = (std::abs(rayDir[0]) > 1e-9) ? 1.0 / rayDir[0] : 1e9;
-            invDir[1] = (std::abs(rayDir[1]) > 1e-9) ? 1.0 / rayDir[1] : 1e9;
-            invDir[2] = (std::abs(rayDir[2]) > 1e-9) ? 1.0 / rayDir[2] : 1e9;
+                    // Merging is an OR and a max, so the result doesn't depend on how views were split;
+                    // equal pixel counts keep the earlier view
+                    std::lock_guard<std::mutex> lock(seenMutex);
+                    for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+                    {
+                        seen[meshIndex] |= localSeen[meshIndex];
+                        if (localMaxPixels[meshIndex] > maxPixels[meshIndex] ||
+                            (localMaxPixels[meshIndex] == maxPixels[meshIndex] && localBestViews[meshIndex] < bestViews[meshIndex]))
+                        {
+                            maxPixels[meshIndex] = localMaxPixels[meshIndex];
+                            bestViews[meshIndex] = localBestViews[meshIndex];
+                        }
+                        seconds[meshIndex] += localSeconds[meshIndex];
+                    }
+                    candidateCount += localCandidateCount;
+                },
+                1);
 
-            GfVec3d t1, t2;
-            for (int i = 0; i < 3; ++i)
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
             {
-                t1[i] = (range.GetMin()[i] - rayStart[i]) * invDir[i];
-                t2[i] = (range.GetMax()[i] - rayStart[i]) * invDir[i];
+                if (!resolved[meshIndex])
+                {
+                    visibility[meshIndex] = seen[meshIndex] ? MeshVisibility::Visible : MeshVisibility::Hidden;
+                    scores[meshIndex] = static_cast<float>(maxPixels[meshIndex]);
+                    costs[meshIndex].recordScore(scores[meshIndex], viewpoints[bestViews[meshIndex]]);
+                    resolved[meshIndex] = seen[meshIndex];
+                }
+                costs[meshIndex].seconds += seconds[meshIndex];
             }
+            return candidateCount;
+        }
 
-            GfVec3d tMin, tMax;
-            for (int i = 0; i < 3; ++i)
+        std::vector<uint8_t> HiddenMeshRemover::findVisibleCandidates(const OcclusionScene &scene,
+                                                                      const Viewpoint &viewpoint,
+                                                                      const GfMatrix4d &cameraToWorld,
+                                                                      const std::vector<uint32_t> &candidates,
+                                                                      std::vector<float> &visibleFractions,
+                                                                      std::vector<uint32_t> &tracedRays)
+        {
+            const SceneGeometry &geometry = scene.geometry;
+            const size_t candidateCount = candidates.size();
+            const int minSamples = std::max(1, m_options.minSurfaceSamples);
+            const int maxSamples = std::max(minSamples, m_options.maxSurfaceSamples);
+
+            const GfVec3d right(cameraToWorld[0][0], cameraToWorld[0][1], cameraToWorld[0][2]);
+            const GfVec3d up(cameraToWorld[1][0], cameraToWorld[1][1], cameraToWorld[1][2]);
+            const GfVec3d forward(-cameraToWorld[2][0], -cameraToWorld[2][1], -cameraToWorld[2][2]);
+            const double tanHalfFov = std::tan(viewpoint.fov * M_PI / 360.0);
+
+            // Sample budget per candidate from its projected size; visible when more
+            // than (1 - occlusionThreshold) of the budget reaches the camera
+            std::vector<SampleProgress> progress(candidateCount);
+            std::vector<uint32_t> pending;
+            for (size_t i = 0; i < candidateCount; ++i)
             {
-                tMin[i] = std::min(t1[i], t2[i]);
-                tMax[i] = std::max(t1[i], t2[i]);
+                SampleProgress &state = progress[i];
+                if (geometry.getTriangleCount(candidates[i]) > 0)
+                {
+                    state.budget = computeSampleBudget(geometry.getBounds(candidates[i]), viewpoint.position,
+                                                       tanHalfFov, minSamples, maxSamples);
+                }
+                state.requiredVisible = (1.0f - m_options.occlusionThreshold) * static_cast<float>(state.budget);
+                if (!state.isSettled())
+                {
+                    pending.push_back(static_cast<uint32_t>(i));
+                }
             }
 
-            double tNear = std::max({tMin[0], tMin[1], tMin[2]});
-            double tFar = std::min({tMax[0], tMax[1], tMax[2]});
+            const size_t packetSize = static_cast<size_t>(std::clamp(m_options.rayPacketSize, 1, RayPacket::kMaxSize));
+            const GfVec3f origin(viewpoint.position);
+            std::vector<SampleRay> rays;
+            std::vector<uint32_t> rayOffsets;
+            std::vector<uint8_t> occluded;
 
-            return tNear <= tFar && tFar > 0.0;
-        }
+            // Trace in rounds of growing size; a candidate leaves as soon as its outcome is fixed
+            for (uint32_t roundSize = kFirstRoundSamples; !pending.empty(); roundSize *= 2)
+            {
+                rayOffsets.assign(1, 0);
+                for (uint32_t i : pending)
+                {
+                    rayOffsets.push_back(rayOffsets.back() + std::min(roundSize, progress[i].budget - progress[i].traced));
+                }
+                rays.resize(rayOffsets.back());
 
-        GfBBox3d HiddenMeshRemover::getMeshBounds(const UsdGeomMesh &mesh)
-        {
-            UsdGeomBoundable boundable(mesh);
-            VtArray<GfVec3f> extent;
+                WorkParallelForN(
+                    pending.size(),
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t p = begin; p < end; ++p)
+                        {
+                            const uint32_t candidate = pending[p];
+                            for (uint32_t r = rayOffsets[p]; r < rayOffsets[p + 1]; ++r)
+                            {
+                                const uint32_t sampleIndex = progress[candidate].traced + (r - rayOffsets[p]);
+                                GfVec3d toPoint = GfVec3d(scene.sampler.getSample(geometry, candidates[candidate], sampleIndex)) - viewpoint.position;
+                                double distance = toPoint.GetLength();
+                                GfVec3d direction = toPoint / std::max(distance, 1e-12);
+
+                                SampleRay &ray = rays[r];
+                                ray.direction = GfVec3f(direction);
+                                // Shorten the segment slightly so surfaces touching the sample point don't count
+                                ray.length = static_cast<float>(distance * (1.0 - 1e-4));
+                                ray.candidate = candidate;
+                                ray.screenKey = computeScreenKey(GfDot(direction, right), GfDot(direction, up),
+                                                                 GfDot(direction, forward), tanHalfFov);
+                            }
+                        }
+                    },
+                    16);
+
+                // Neighbouring rays on screen follow similar paths through the BVHs;
+                // a stable sort keeps the grouping independent of the thread count
+                std::stable_sort(rays.begin(), rays.end(),
+                                 [](const SampleRay &a, const SampleRay &b)
+                                 { return a.screenKey < b.screenKey; });
+
+                const size_t packetCount = (rays.size() + packetSize - 1) / packetSize;
+                occluded.assign(rays.size(), 0);
+                WorkParallelForN(
+                    packetCount,
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t packetIndex = begin; packetIndex < end; ++packetIndex)
+                        {
+                            const size_t first = packetIndex * packetSize;
+                            const size_t last = std::min(first + packetSize, rays.size());
+
+                            if (packetSize == 1)
+                            {
+                                const SampleRay &ray = rays[first];
+                                occluded[first] = scene.rayCaster.isOccluded(origin, ray.direction, ray.length,
+                                                                             candidates[ray.candidate]);
+                                continue;
+                            }
+
+                            RayPacket packet(origin);
+                            for (size_t r = first; r < last; ++r)
+                            {
+                                packet.addRay(rays[r].direction, rays[r].length, candidates[rays[r].candidate]);
+                            }
+                            packet.finalize();
+
+                            const uint32_t occludedMask = scene.rayCaster.findOccluded(packet);
+                            for (size_t r = first; r < last; ++r)
+                            {
+                                occluded[r] = (occludedMask >> (r - first)) & 1u;
+                            }
+                        }
+                    },
+                    4);
+
+                m_stats.raysTraced += rays.size();
+                for (size_t r = 0; r < rays.size(); ++r)
+                {
+                    progress[rays[r].candidate].visible += occluded[r] ? 0 : 1;
+                }
+                for (size_t p = 0; p < pending.size(); ++p)
+                {
+                    progress[pending[p]].traced += rayOffsets[p + 1] - rayOffsets[p];
+                }
 
-            if (boundable.GetExtentAttr().Get(&extent) && extent.size() == 2)
-            {
-                GfVec3d min_point(extent[0]);
-                GfVec3d max_point(extent[1]);
-                GfRange3d range(min_point, max_point);
-                return GfBBox3d(range);
+                pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                             [&](uint32_t candidate)
+                                             { return progress[candidate].isSettled(); }),
+                              pending.end());
             }
 
-            // Fallback: compute bounds from points
-            VtArray<GfVec3f> points;
-            if (mesh.GetPointsAttr().Get(&points))
+            std::vector<uint8_t> visible(candidateCount, 0);
+            visibleFractions.assign(candidateCount, 0.0f);
+            tracedRays.assign(candidateCount, 0);
+            for (size_t i = 0; i < candidateCount; ++i)
             {
-                GfRange3d range;
-                for (const auto &point : points)
+                visible[i] = progress[i].isVisible();
+                tracedRays[i] = progress[i].traced;
+                if (progress[i].traced > 0)
                 {
-                    range.UnionWith(GfVec3d(point));
+                    visibleFractions[i] = static_cast<float>(progress[i].visible) / static_cast<float>(progress[i].traced);
                 }
-                return GfBBox3d(range);
             }
-
-            // Last resort: return unit box
-            return GfBBox3d(GfRange3d(GfVec3d(-1), GfVec3d(1)));
+            return visible;
         }
 
-        GfBBox3d HiddenMeshRemover::calculateSceneBounds(UsdStagePtr stage)
+        std::vector<uint8_t> HiddenMeshRemover::findVisibleTriangles(const OcclusionScene &scene,
+                                                                     const std::vector<Viewpoint> &viewpoints,
+                                                                     const std::vector<uint8_t> &testedMeshes)
         {
-            GfRange3d totalRange;
-
-            auto range = stage->Traverse();
-            for (auto it = range.begin(); it != range.end(); ++it)
+            const SceneGeometry &geometry = scene.geometry;
+            std::vector<uint8_t> visible(geometry.getTotalTriangleCount(), 0);
+            const size_t sampleCount = static_cast<size_t>(std::clamp(m_options.triangleSamples, 1, kMaxTriangleSamples));
+            const size_t packetSize = static_cast<size_t>(std::clamp(m_options.rayPacketSize, 1, RayPacket::kMaxSize));
+
+            FrustumCuller culler;
+            std::vector<uint32_t> candidates;
+            std::vector<uint32_t> pending;
+            std::vector<SampleRay> rays;
+            std::vector<uint8_t> occluded;
+            for (const Viewpoint &viewpoint : viewpoints)
             {
-                if (it->IsA<UsdGeomBoundable>())
+                const GfMatrix4d cameraToWorld = FrustumCuller::computeCameraToWorld(viewpoint.position, viewpoint.direction);
+                cullViewpoint(culler, cameraToWorld, viewpoint.fov, geometry, scene.bounds, candidates);
+
+                // Triangles an earlier viewpoint saw need no further rays
+                pending.clear();
+                for (uint32_t meshIndex : candidates)
                 {
-                    UsdGeomBoundable boundable(*it);
-                    GfBBox3d bounds = getMeshBounds(UsdGeomMesh(boundable));
-                    totalRange.UnionWith(bounds.GetRange());
+                    if (!testedMeshes[meshIndex])
+                    {
+                        continue;
+                    }
+                    for (uint32_t triangle = geometry.triangleOffsets[meshIndex]; triangle < geometry.triangleOffsets[meshIndex + 1]; ++triangle)
+                    {
+                        if (!visible[triangle])
+                        {
+                            pending.push_back(triangle);
+                        }
+                    }
                 }
-            }
 
-            if (totalRange.IsEmpty())
-            {
-                // Default scene bounds if no geometry found
-                totalRange = GfRange3d(GfVec3d(-10), GfVec3d(10));
-            }
+                const GfVec3d right(cameraToWorld[0][0], cameraToWorld[0][1], cameraToWorld[0][2]);
+                const GfVec3d up(cameraToWorld[1][0], cameraToWorld[1][1], cameraToWorld[1][2]);
+                const GfVec3d forward(-cameraToWorld[2][0], -cameraToWorld[2][1], -cameraToWorld[2][2]);
+                const double tanHalfFov = std::tan(viewpoint.fov * M_PI / 360.0);
+                const GfVec3f origin(viewpoint.position);
 
-            return GfBBox3d(totalRange);
+                for (size_t batchBegin = 0; batchBegin < pending.size(); batchBegin += kTriangleBatchSize)
+                {
+                    const size_t batchSize = std::min(kTriangleBatchSize, pending.size() - batchBegin);
+                    rays.resize(batchSize * sampleCount);
+                    WorkParallelForN(
+                        batchSize,
+                        [&](size_t begin, size_t end)
+                        {
+                            for (size_t p = begin; p < end; ++p)
+                            {
+                                const uint32_t triangle = pending[batchBegin + p];
+                                const GfVec3f a = geometry.getPoint(geometry.triangleIndices[3 * triangle]);
+                                const GfVec3f b = geometry.getPoint(geometry.triangleIndices[3 * triangle + 1]);
+                                const GfVec3f c = geometry.getPoint(geometry.triangleIndices[3 * triangle + 2]);
+                                for (size_t s = 0; s < sampleCount; ++s)
+                                {
+                                    const float *weights = kTriangleSampleWeights[s];
+                                    GfVec3d toPoint = GfVec3d(a * weights[0] + b * weights[1] + c * weights[2]) - viewpoint.position;
+                                    double distance = toPoint.GetLength();
+                                    GfVec3d direction = toPoint / std::max(distance, 1e-12);
+                                    const double x = GfDot(direction, right);
+                                    const double y = GfDot(direction, up);
+                                    const double depth = GfDot(direction, forward);
+
+                                    SampleRay &ray = rays[p * sampleCount + s];
+                                    ray.direction = GfVec3f(direction);
+                                    ray.length = static_cast<float>(distance * (1.0 - 1e-4));
+                                    ray.candidate = triangle;
+                                    ray.screenKey = computeScreenKey(x, y, depth, tanHalfFov);
+
+                                    // Samples outside the field of view are not seen from this viewpoint
+                                    const double halfExtent = depth * tanHalfFov;
+                                    if (depth <= 1e-6 || std::abs(x) > halfExtent || std::abs(y) > halfExtent)
+                                    {
+                                        ray.length = 0.0f;
+                                    }
+                                }
+                            }
+                        },
+                        16);
+
+                    rays.erase(std::remove_if(rays.begin(), rays.end(),
+                                              [](const SampleRay &ray)
+                                              { return ray.length <= 0.0f; }),
+                               rays.end());
+                    std::stable_sort(rays.begin(), rays.end(),
+                                     [](const SampleRay &a, const SampleRay &b)
+                                     { return a.screenKey < b.screenKey; });
+
+                    // The triangle's own mesh is not ignored: it may hide its own faces
+                    const size_t packetCount = (rays.size() + packetSize - 1) / packetSize;
+                    occluded.assign(rays.size(), 0);
+                    WorkParallelForN(
+                        packetCount,
+                        [&](size_t begin, size_t end)
+                        {
+                            for (size_t packetIndex = begin; packetIndex < end; ++packetIndex)
+                            {
+                                const size_t first = packetIndex * packetSize;
+                                const size_t last = std::min(first + packetSize, rays.size());
+
+                                if (packetSize == 1)
+                                {
+                                    occluded[first] = scene.rayCaster.isOccluded(origin, rays[first].direction, rays[first].length);
+                                    continue;
+                                }
+
+                                RayPacket packet(origin);
+                                for (size_t r = first; r < last; ++r)
+                                {
+                                    packet.addRay(rays[r].direction, rays[r].length, SceneRayCaster::kNoMesh);
+                                }
+                                packet.finalize();
+
+                                const uint32_t occludedMask = scene.rayCaster.findOccluded(packet);
+                                for (size_t r = first; r < last; ++r)
+                                {
+                                    occluded[r] = (occludedMask >> (r - first)) & 1u;
+                                }
+                            }
+                        },
+                        4);
+
+                    m_stats.raysTraced += rays.size();
+                    for (size_t r = 0; r < rays.size(); ++r)
+                    {
+                        visible[rays[r].candidate] |= occluded[r] ? 0 : 1;
+                    }
+                }
+            }
+            return visible;
         }
 
-        bool HiddenMeshRemover::isMeshInstanced(const UsdGeomMesh &mesh, UsdStagePtr stage)
+        void HiddenMeshRemover::removeHiddenFaces(const OcclusionScene &scene, const std::vector<Viewpoint> &viewpoints,
+                                                  const std::vector<MeshVisibility> &visibility)
         {
-            // This is a simplified check for instancing
-            // In USD, instancing can be complex involving prototypes and instance proxies
+            const SceneGeometry &geometry = scene.geometry;
+            std::vector<uint8_t> testedMeshes(scene.meshes.size(), 0);
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
+            {
+                // Editing an instanced mesh would change every instance of its prototype
+                testedMeshes[meshIndex] = visibility[meshIndex] == MeshVisibility::Visible && !scene.instancedMeshes[meshIndex] &&
+                                          scene.meshes[meshIndex] && geometry.getTriangleCount(meshIndex) > 0;
+            }
 
-            auto prim = mesh.GetPrim();
+            const auto visibilityStart = Clock::now();
+            const std::vector<uint8_t> visibleTriangles = findVisibleTriangles(scene, viewpoints, testedMeshes);
+            m_stats.visibilitySeconds += secondsSince(visibilityStart);
 
-            // Check if this prim is an instance
-            if (prim.IsInstance())
+            const auto authoringStart = Clock::now();
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
             {
-                return true;
-            }
+                if (!testedMeshes[meshIndex])
+                {
+                    continue;
+                }
+                const uint32_t firstTriangle = geometry.triangleOffsets[meshIndex];
+                const size_t triangleCount = geometry.getTriangleCount(meshIndex);
+                const size_t hiddenCount = static_cast<size_t>(std::count(visibleTriangles.begin() + firstTriangle,
+                                                                          visibleTriangles.begin() + firstTriangle + triangleCount, 0));
+                m_stats.hiddenSurfaceTriangles += hiddenCount;
+
+                // The mesh test saw a mesh whose samples all missed; trust it and keep the mesh whole
+                if (hiddenCount == 0 || hiddenCount == triangleCount)
+                {
+                    continue;
+                }
+
+                const UsdGeomMesh &mesh = scene.meshes[meshIndex];
+                const std::string path = mesh.GetPath().GetString();
+                VtIntArray faceVertexCounts;
+                VtIntArray faceVertexIndices;
+                VtVec3fArray points;
+                mesh.GetFaceVertexCountsAttr().Get(&faceVertexCounts);
+                mesh.GetFaceVertexIndicesAttr().Get(&faceVertexIndices);
+                mesh.GetPointsAttr().Get(&points);
+                const std::vector<uint32_t> triangleFaces =
+                    SceneGeometry::mapTrianglesToFaces(faceVertexCounts, faceVertexIndices, points.size());
+                if (triangleFaces.size() != triangleCount)
+                {
+                    logVerbose("Keeping hidden faces of " + path + ": its topology differs from the snapshot");
+                    continue;
+                }
 
-            // Check if there are multiple references to the same mesh data
-            // This would require analyzing the composition graph more thoroughly
-            // For now, we'll use a simple heuristic based on the prim name/path
+                // A face stays if any of its triangles is visible; faces without triangles are left alone
+                std::vector<uint8_t> keepFaces(faceVertexCounts.size(), 1);
+                for (uint32_t face : triangleFaces)
+                {
+                    keepFaces[face] = 0;
+                }
+                for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+                {
+                    keepFaces[triangleFaces[triangle]] |= visibleTriangles[firstTriangle + triangle];
+                }
 
-            return false; // Simplified implementation
+                MeshCompactor::Result result;
+                std::string reason;
+                if (!MeshCompactor::compact(mesh, keepFaces, result, reason))
+                {
+                    logVerbose("Keeping hidden faces of " + path + ": " + reason);
+                }
+                else if (result.removedFaces > 0)
+                {
+                    m_stats.compactedMeshes++;
+                    m_stats.removedFaces += result.removedFaces;
+                    m_stats.removedPoints += result.removedPoints;
+                    logVerbose("Removed " + std::to_string(result.removedFaces) + " hidden faces and " +
+                               std::to_string(result.removedPoints) + " points from " + path);
+                }
+            }
+            m_stats.authoringSeconds += secondsSince(authoringStart);
         }
 
-        std::vector<GfVec3d> HiddenMeshRemover::sampleMeshSurface(const UsdGeomMesh &mesh, size_t numSamples)
+        void HiddenMeshRemover::buildReport(const OcclusionScene &scene, const std::vector<MeshVisibility> &visibility)
         {
-            std::vector<GfVec3d> samples;
-
-            VtArray<GfVec3f> points;
-            if (!mesh.GetPointsAttr().Get(&points) || points.empty())
+            m_report.clear();
+            m_report.addPhase("traversal", m_stats.traversalSeconds);
+            m_report.addPhase("bounds", m_stats.boundsSeconds);
+            m_report.addPhase("bvhBuild", m_stats.bvhBuildSeconds);
+            m_report.addPhase("viewpoints", m_stats.viewpointSeconds);
+            m_report.addPhase("visibility", m_stats.visibilitySeconds);
+            m_report.addPhase("authoring", m_stats.authoringSeconds);
+
+            // No costs are recorded when no visibility test ran
+            m_meshCosts.resize(scene.meshes.size());
+            for (size_t meshIndex = 0; meshIndex < scene.meshes.size(); ++meshIndex)
             {
-                return samples;
+                const MeshCost &cost = m_meshCosts[meshIndex];
+                VisibilityReport::MeshEntry entry;
+                entry.path = scene.meshes[meshIndex].GetPath().GetString();
+                entry.verdict = visibility[meshIndex] == MeshVisibility::Hidden      ? "hidden"
+                                : visibility[meshIndex] == MeshVisibility::Preserved ? "preserved"
+                                                                                     : "visible";
+                entry.score = cost.bestScore;
+                entry.hasBestViewpoint = cost.hasBestViewpoint;
+                entry.bestPosition = cost.bestPosition;
+                entry.bestDirection = cost.bestDirection;
+                entry.raysTraced = cost.raysTraced;
+                entry.triangleCount = scene.geometry.getTriangleCount(meshIndex);
+                entry.seconds = cost.seconds;
+                entry.cached = cost.cached;
+                m_report.addMesh(std::move(entry));
             }
 
-            VtArray<int> faceVertexCounts;
-            VtArray<int> faceVertexIndices;
-
-            if (!mesh.GetFaceVertexCountsAttr().Get(&faceVertexCounts) ||
-                !mesh.GetFaceVertexIndicesAttr().Get(&faceVertexIndices))
+            if (!m_options.reportPath.empty())
             {
-                return samples;
+                if (m_report.save(m_options.reportPath))
+                {
+                    logVerbose("Wrote visibility report to " + m_options.reportPath);
+                }
+                else
+                {
+                    std::cerr << "Warning: Failed to write visibility report: " << m_options.reportPath << std::endl;
+                }
             }
+        }
 
-            // Simple sampling: pick points from vertices
-            // A more sophisticated approach would sample triangle surfaces
-            size_t step = std::max(size_t(1), points.size() / numSamples);
+        GfBBox3d HiddenMeshRemover::calculateSceneBounds(UsdStagePtr stage, WorldSpaceCache &worldCache)
+        {
+            // Populates the shared bounds cache for the whole stage in one parallel pass
+            GfRange3d totalRange = worldCache.computeWorldBounds(stage->GetPseudoRoot());
 
-            for (size_t i = 0; i < points.size(); i += step)
+            if (totalRange.IsEmpty())
             {
-                if (samples.size() >= numSamples)
-                    break;
-                samples.emplace_back(points[i]);
+                // Default scene bounds if no geometry found
+                totalRange = GfRange3d(GfVec3d(-10), GfVec3d(10));
             }
 
-            return samples;
+            return GfBBox3d(totalRange);
+        }
+
+        bool HiddenMeshRemover::isMeshInstanced(const UsdGeomMesh &mesh, UsdStagePtr stage)
+        {
+            // Meshes inside instances never reach this point; they are collected as
+            // instance proxies and only act as occluders. What remains is a mesh prim
+            // that is itself instanceable, whose prototype other instances share.
+            return mesh.GetPrim().IsInstance();
         }
 
         void HiddenMeshRemover::logVerbose(const std::string &message) const
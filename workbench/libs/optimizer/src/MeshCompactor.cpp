@@ -0,0 +1,385 @@
+#include "MeshCompactor.h"
+#include <pxr/base/vt/types.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/usd/sdf/attributeSpec.h>
+#include <pxr/usd/sdf/changeBlock.h>
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/sdf/primSpec.h>
+#include <pxr/usd/usd/editTarget.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/usdGeom/primvarsAPI.h>
+#include <pxr/usd/usdGeom/subset.h>
+#include <pxr/usd/usdGeom/tokens.h>
+#include <algorithm>
+#include <utility>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            /**
+             * @brief Copy the given elements if the value holds an array of this type
+             */
+            template <typename Array>
+            bool selectArray(const VtValue &source, const std::vector<uint32_t> &elements, size_t elementSize, VtValue &selected)
+            {
+                if (!source.IsHolding<Array>())
+                {
+                    return false;
+                }
+                const Array &values = source.UncheckedGet<Array>();
+                Array result;
+                result.reserve(elements.size() * elementSize);
+                for (uint32_t element : elements)
+                {
+                    for (size_t k = 0; k < elementSize; ++k)
+                    {
+                        result.push_back(values[element * elementSize + k]);
+                    }
+                }
+                selected = VtValue(result);
+                return true;
+            }
+
+            template <typename... Arrays>
+            bool selectAnyArray(const VtValue &source, const std::vector<uint32_t> &elements, size_t elementSize, VtValue &selected)
+            {
+                return (selectArray<Arrays>(source, elements, elementSize, selected) || ...);
+            }
+
+            /**
+             * @brief Keep the given elements of an array of elementCount elements, each elementSize values long
+             * @return False if the value is no such array or holds a type primvars rarely use
+             */
+            bool selectElements(const VtValue &source, const std::vector<uint32_t> &elements, size_t elementCount,
+                                size_t elementSize, VtValue &selected)
+            {
+                if (!source.IsArrayValued() || source.GetArraySize() != elementCount * elementSize)
+                {
+                    return false;
+                }
+                return selectAnyArray<VtBoolArray, VtIntArray, VtInt64Array, VtFloatArray, VtDoubleArray, VtHalfArray,
+                                      VtVec2fArray, VtVec3fArray, VtVec4fArray, VtVec2dArray, VtVec3dArray, VtVec4dArray,
+                                      VtVec2hArray, VtVec3hArray, VtVec4hArray, VtVec2iArray, VtVec3iArray, VtVec4iArray,
+                                      VtQuatfArray, VtQuatdArray, VtQuathArray, VtTokenArray, VtStringArray>(source, elements, elementSize,
+                                                                                                            selected);
+            }
+
+            /**
+             * @brief Renumber indices, dropping those that are out of range or map to -1
+             */
+            VtIntArray remapIndices(const VtIntArray &indices, const std::vector<int> &newIndices)
+            {
+                VtIntArray remapped;
+                remapped.reserve(indices.size());
+                for (int index : indices)
+                {
+                    if (index >= 0 && static_cast<size_t>(index) < newIndices.size() && newIndices[index] >= 0)
+                    {
+                        remapped.push_back(newIndices[index]);
+                    }
+                }
+                return remapped;
+            }
+        } // namespace
+
+        bool MeshCompactor::compact(const UsdGeomMesh &mesh, const std::vector<uint8_t> &keepFaces, Result &result,
+                                    std::string &reason)
+        {
+            result = Result();
+            const UsdAttribute countsAttr = mesh.GetFaceVertexCountsAttr();
+            const UsdAttribute indicesAttr = mesh.GetFaceVertexIndicesAttr();
+            const UsdAttribute pointsAttr = mesh.GetPointsAttr();
+            const UsdAttribute holesAttr = mesh.GetHoleIndicesAttr();
+            const UsdAttribute cornersAttr = mesh.GetCornerIndicesAttr();
+            const UsdAttribute creasesAttr = mesh.GetCreaseIndicesAttr();
+            for (const UsdAttribute &attribute : {countsAttr, indicesAttr, pointsAttr, holesAttr, cornersAttr, creasesAttr})
+            {
+                if (attribute.ValueMightBeTimeVarying())
+                {
+                    reason = "time-varying " + attribute.GetName().GetString();
+                    return false;
+                }
+            }
+
+            VtIntArray faceVertexCounts;
+            VtIntArray faceVertexIndices;
+            VtVec3fArray points;
+            countsAttr.Get(&faceVertexCounts);
+            indicesAttr.Get(&faceVertexIndices);
+            pointsAttr.Get(&points);
+            if (keepFaces.size() != faceVertexCounts.size())
+            {
+                reason = "face count differs from the analysed mesh";
+                return false;
+            }
+
+            // Faces, face-vertices and points that remain
+            const size_t faceCount = faceVertexCounts.size();
+            const size_t pointCount = points.size();
+            std::vector<uint32_t> keptFaces;
+            std::vector<uint32_t> keptFaceVertices;
+            std::vector<uint8_t> usedPoints(pointCount, 0);
+            size_t offset = 0;
+            for (size_t face = 0; face < faceCount; ++face)
+            {
+                const int count = faceVertexCounts[face];
+                if (count < 0 || offset + count > faceVertexIndices.size())
+                {
+                    reason = "invalid topology";
+                    return false;
+                }
+                if (keepFaces[face])
+                {
+                    keptFaces.push_back(static_cast<uint32_t>(face));
+                    for (int i = 0; i < count; ++i)
+                    {
+                        const int point = faceVertexIndices[offset + i];
+                        if (point < 0 || static_cast<size_t>(point) >= pointCount)
+                        {
+                            reason = "invalid topology";
+                            return false;
+                        }
+                        keptFaceVertices.push_back(static_cast<uint32_t>(offset + i));
+                        usedPoints[point] = 1;
+                    }
+                }
+                offset += count;
+            }
+            if (keptFaces.size() == faceCount)
+            {
+                return true;
+            }
+            if (keptFaces.empty())
+            {
+                reason = "every face is hidden";
+                return false;
+            }
+
+            // Corners and creases keep their points, so their lengths and sharpnesses stay valid
+            VtIntArray corners;
+            VtIntArray creases;
+            cornersAttr.Get(&corners);
+            creasesAttr.Get(&creases);
+            for (const VtIntArray *sharpPoints : {&corners, &creases})
+            {
+                for (int point : *sharpPoints)
+                {
+                    if (point < 0 || static_cast<size_t>(point) >= pointCount)
+                    {
+                        reason = "invalid corner or crease";
+                        return false;
+                    }
+                    usedPoints[point] = 1;
+                }
+            }
+
+            std::vector<uint32_t> keptPoints;
+            std::vector<int> newPointIndices(pointCount, -1);
+            for (size_t point = 0; point < pointCount; ++point)
+            {
+                if (usedPoints[point])
+                {
+                    newPointIndices[point] = static_cast<int>(keptPoints.size());
+                    keptPoints.push_back(static_cast<uint32_t>(point));
+                }
+            }
+            std::vector<int> newFaceIndices(faceCount, -1);
+            for (size_t i = 0; i < keptFaces.size(); ++i)
+            {
+                newFaceIndices[keptFaces[i]] = static_cast<int>(i);
+            }
+
+            // Topology and points
+            std::vector<std::pair<UsdAttribute, VtValue>> edits;
+            VtIntArray newCounts;
+            newCounts.reserve(keptFaces.size());
+            for (uint32_t face : keptFaces)
+            {
+                newCounts.push_back(faceVertexCounts[face]);
+            }
+            VtIntArray newIndices;
+            newIndices.reserve(keptFaceVertices.size());
+            for (uint32_t faceVertex : keptFaceVertices)
+            {
+                newIndices.push_back(newPointIndices[faceVertexIndices[faceVertex]]);
+            }
+            VtVec3fArray newPoints;
+            newPoints.reserve(keptPoints.size());
+            for (uint32_t point : keptPoints)
+            {
+                newPoints.push_back(points[point]);
+            }
+            edits.emplace_back(countsAttr, VtValue(newCounts));
+            edits.emplace_back(indicesAttr, VtValue(newIndices));
+            edits.emplace_back(pointsAttr, VtValue(newPoints));
+
+            VtIntArray holes;
+            if (holesAttr.Get(&holes) && !holes.empty())
+            {
+                edits.emplace_back(holesAttr, VtValue(remapIndices(holes, newFaceIndices)));
+            }
+            if (!corners.empty())
+            {
+                edits.emplace_back(cornersAttr, VtValue(remapIndices(corners, newPointIndices)));
+            }
+            if (!creases.empty())
+            {
+                edits.emplace_back(creasesAttr, VtValue(remapIndices(creases, newPointIndices)));
+            }
+
+            // Per-element data; constant values do not depend on the topology
+            auto addElementEdit = [&](const UsdAttribute &attribute, const TfToken &interpolation, size_t elementSize)
+            {
+                const std::vector<uint32_t> *elements = nullptr;
+                size_t elementCount = 0;
+                if (interpolation == UsdGeomTokens->uniform)
+                {
+                    elements = &keptFaces;
+                    elementCount = faceCount;
+                }
+                else if (interpolation == UsdGeomTokens->vertex || interpolation == UsdGeomTokens->varying)
+                {
+                    elements = &keptPoints;
+                    elementCount = pointCount;
+                }
+                else if (interpolation == UsdGeomTokens->faceVarying)
+                {
+                    elements = &keptFaceVertices;
+                    elementCount = faceVertexIndices.size();
+                }
+                VtValue value;
+                if (!elements || !attribute || !attribute.Get(&value))
+                {
+                    return true;
+                }
+                if (attribute.ValueMightBeTimeVarying())
+                {
+                    reason = "time-varying " + attribute.GetName().GetString();
+                    return false;
+                }
+                VtValue selected;
+                if (!selectElements(value, *elements, elementCount, elementSize, selected))
+                {
+                    reason = "unsupported type or size of " + attribute.GetName().GetString();
+                    return false;
+                }
+                edits.emplace_back(attribute, selected);
+                return true;
+            };
+
+            if (!addElementEdit(mesh.GetNormalsAttr(), mesh.GetNormalsInterpolation(), 1) ||
+                !addElementEdit(mesh.GetVelocitiesAttr(), UsdGeomTokens->vertex, 1) ||
+                !addElementEdit(mesh.GetAccelerationsAttr(), UsdGeomTokens->vertex, 1))
+            {
+                return false;
+            }
+            for (const UsdGeomPrimvar &primvar : UsdGeomPrimvarsAPI(mesh.GetPrim()).GetPrimvarsWithValues())
+            {
+                // Indexed values are shared through the indices; only the index array has one entry per element
+                const bool added = primvar.IsIndexed()
+                                       ? addElementEdit(primvar.GetIndicesAttr(), primvar.GetInterpolation(), 1)
+                                       : addElementEdit(primvar.GetAttr(), primvar.GetInterpolation(),
+                                                        static_cast<size_t>(std::max(1, primvar.GetElementSize())));
+                if (!added)
+                {
+                    return false;
+                }
+            }
+
+            for (const UsdGeomSubset &subset : UsdGeomSubset::GetAllGeomSubsets(mesh))
+            {
+                TfToken elementType;
+                subset.GetElementTypeAttr().Get(&elementType);
+                if (elementType != UsdGeomTokens->face || subset.GetIndicesAttr().ValueMightBeTimeVarying())
+                {
+                    reason = "subset " + subset.GetPath().GetString() + " cannot be remapped";
+                    return false;
+                }
+                VtIntArray subsetFaces;
+                if (subset.GetIndicesAttr().Get(&subsetFaces))
+                {
+                    edits.emplace_back(subset.GetIndicesAttr(), VtValue(remapIndices(subsetFaces, newFaceIndices)));
+                }
+            }
+
+            const UsdAttribute extentAttr = mesh.GetExtentAttr();
+            VtVec3fArray extent;
+            if (extentAttr.HasAuthoredValue() && !extentAttr.ValueMightBeTimeVarying() &&
+                UsdGeomPointBased::ComputeExtent(newPoints, &extent))
+            {
+                edits.emplace_back(extentAttr, VtValue(extent));
+            }
+
+            // Remember what the edit target held, so a failed Set() can be undone instead of leaving half a mesh
+            const UsdEditTarget editTarget = mesh.GetPrim().GetStage()->GetEditTarget();
+            const SdfLayerHandle layer = editTarget.GetLayer();
+            struct AuthoredValue
+            {
+                SdfPath specPath;
+                bool hadSpec = false;
+                VtValue value; ///< Empty if the spec had no default value
+            };
+            std::vector<AuthoredValue> originals(edits.size());
+            for (size_t i = 0; i < edits.size(); ++i)
+            {
+                originals[i].specPath = editTarget.MapToSpecPath(edits[i].first.GetPath());
+                if (const SdfAttributeSpecHandle spec = layer->GetAttributeAtPath(originals[i].specPath))
+                {
+                    originals[i].hadSpec = true;
+                    if (spec->HasDefaultValue())
+                    {
+                        originals[i].value = spec->GetDefaultValue();
+                    }
+                }
+            }
+
+            SdfChangeBlock changeBlock;
+            for (size_t i = 0; i < edits.size(); ++i)
+            {
+                if (edits[i].first.Set(edits[i].second))
+                {
+                    continue;
+                }
+
+                // Restore the failed edit too, since it may have created its spec before failing
+                for (size_t restored = i + 1; restored-- > 0;)
+                {
+                    const AuthoredValue &original = originals[restored];
+                    const SdfAttributeSpecHandle spec = layer->GetAttributeAtPath(original.specPath);
+                    if (!spec)
+                    {
+                        continue;
+                    }
+                    if (!original.hadSpec)
+                    {
+                        if (const SdfPrimSpecHandle owner = layer->GetPrimAtPath(original.specPath.GetPrimPath()))
+                        {
+                            owner->RemoveProperty(spec);
+                        }
+                    }
+                    else if (original.value.IsEmpty())
+                    {
+                        spec->ClearDefaultValue();
+                    }
+                    else
+                    {
+                        spec->SetDefaultValue(original.value);
+                    }
+                }
+                reason = "could not author " + edits[i].first.GetName().GetString();
+                return false;
+            }
+
+            result.removedFaces = faceCount - keptFaces.size();
+            result.removedPoints = pointCount - keptPoints.size();
+            return true;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
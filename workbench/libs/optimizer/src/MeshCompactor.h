@@ -0,0 +1,57 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Removes faces from a mesh prim together with the points and primvar values only they used
+         *
+         * Everything indexed by face, point or face-vertex is rewritten
+         * consistently: topology, points, normals, velocities and
+         * accelerations, uniform, vertex, varying and face-varying primvars,
+         * hole indices, corners, creases and face subsets. Indexed primvars
+         * keep their values and only lose index entries. Points that corners
+         * or creases refer to are kept even if no remaining face uses them.
+         *
+         * Every edit is prepared before the first one is authored, and the
+         * authored ones are rolled back on the edit target if a later one
+         * fails, so a mesh that cannot be compacted is left exactly as it was.
+         */
+        class MeshCompactor
+        {
+        public:
+            /**
+             * @brief What one compaction removed
+             */
+            struct Result
+            {
+                size_t removedFaces = 0;
+                size_t removedPoints = 0;
+            };
+
+            /**
+             * @brief Remove the faces whose flag is zero and author the compacted mesh at the default time
+             * @param mesh Mesh to edit on the stage's edit target
+             * @param keepFaces One flag per face of the mesh's faceVertexCounts
+             * @param result Receives the number of faces and points removed
+             * @param reason Receives why the mesh was left unchanged when false is returned
+             * @return False if the mesh was not edited, e.g. because its topology or primvars are time-varying,
+             *         a primvar has an unsupported type or size, or every face would be removed
+             */
+            static bool compact(const UsdGeomMesh &mesh, const std::vector<uint8_t> &keepFaces, Result &result,
+                                std::string &reason);
+        };
+
+    } // namespace optimizer
+} // namespace workbench
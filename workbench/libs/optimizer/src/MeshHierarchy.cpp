@@ -0,0 +1,471 @@
+#include "MeshHierarchy.h"
+#include <pxr/base/work/loops.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            /**
+             * @brief Radical inverse of an integer in the given base, in [0, 1)
+             */
+            float radicalInverse(uint32_t index, uint32_t base)
+            {
+                const double inverseBase = 1.0 / base;
+                double factor = inverseBase;
+                double result = 0.0;
+                while (index > 0)
+                {
+                    result += (index % base) * factor;
+                    index /= base;
+                    factor *= inverseBase;
+                }
+                return static_cast<float>(result);
+            }
+
+            /**
+             * @brief Order paths element by element, so every prim's descendants follow it without a gap
+             */
+            bool isBefore(const SdfPathVector &a, const SdfPathVector &b)
+            {
+                const size_t common = std::min(a.size(), b.size());
+                for (size_t i = 0; i < common; ++i)
+                {
+                    if (a[i] != b[i])
+                    {
+                        return a[i].GetName() < b[i].GetName();
+                    }
+                }
+                return a.size() < b.size();
+            }
+
+            /**
+             * @brief Whether every edge of a mesh is shared by exactly two of its triangles
+             *
+             * Triangles that repeat a point have no area and are ignored.
+             */
+            bool isClosedMesh(const SceneGeometry &geometry, uint32_t mesh)
+            {
+                const uint32_t firstTriangle = geometry.triangleOffsets[mesh];
+                const uint32_t endTriangle = geometry.triangleOffsets[mesh + 1];
+                if (endTriangle - firstTriangle < 4)
+                {
+                    return false;
+                }
+
+                std::unordered_map<uint64_t, uint32_t> edgeUses;
+                edgeUses.reserve(3 * (endTriangle - firstTriangle) / 2);
+                for (uint32_t triangle = firstTriangle; triangle < endTriangle; ++triangle)
+                {
+                    const uint32_t *corners = &geometry.triangleIndices[3 * triangle];
+                    if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+                    {
+                        continue;
+                    }
+                    for (int edge = 0; edge < 3; ++edge)
+                    {
+                        const uint32_t a = corners[edge];
+                        const uint32_t b = corners[(edge + 1) % 3];
+                        ++edgeUses[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)];
+                    }
+                }
+                return !edgeUses.empty() && std::all_of(edgeUses.begin(), edgeUses.end(),
+                                                        [](const auto &entry)
+                                                        { return entry.second == 2; });
+            }
+
+            /**
+             * @brief Separating axis test between a triangle and a box; touching counts as overlapping
+             */
+            bool overlapsBox(const GfVec3d &center, const GfVec3d &halfSize, const GfVec3d &a, const GfVec3d &b, const GfVec3d &c)
+            {
+                const GfVec3d v[3] = {a - center, b - center, c - center};
+                const GfVec3d edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+
+                // Projects the triangle and the box onto an axis and checks for a gap
+                auto separates = [&](const GfVec3d &axis)
+                {
+                    const double p0 = GfDot(v[0], axis);
+                    const double p1 = GfDot(v[1], axis);
+                    const double p2 = GfDot(v[2], axis);
+                    const double radius = halfSize[0] * std::abs(axis[0]) + halfSize[1] * std::abs(axis[1]) + halfSize[2] * std::abs(axis[2]);
+                    return std::min({p0, p1, p2}) > radius || std::max({p0, p1, p2}) < -radius;
+                };
+
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    GfVec3d boxAxis(0.0);
+                    boxAxis[axis] = 1.0;
+                    if (separates(boxAxis))
+                    {
+                        return false;
+                    }
+                    for (const GfVec3d &edge : edges)
+                    {
+                        if (separates(GfCross(boxAxis, edge)))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                return !separates(GfCross(edges[0], edges[1]));
+            }
+
+            /**
+             * @brief Count the triangles of a mesh a ray crosses
+             * @return -1 if the ray passes too close to an edge, a vertex or a triangle's plane to be sure
+             */
+            int countCrossings(const SceneGeometry &geometry, uint32_t mesh, const GfVec3d &origin, const GfVec3d &direction)
+            {
+                constexpr double kMargin = 1e-7;
+                int crossings = 0;
+                for (uint32_t triangle = geometry.triangleOffsets[mesh]; triangle < geometry.triangleOffsets[mesh + 1]; ++triangle)
+                {
+                    const GfVec3d a(geometry.getPoint(geometry.triangleIndices[3 * triangle]));
+                    const GfVec3d edge1 = GfVec3d(geometry.getPoint(geometry.triangleIndices[3 * triangle + 1])) - a;
+                    const GfVec3d edge2 = GfVec3d(geometry.getPoint(geometry.triangleIndices[3 * triangle + 2])) - a;
+                    const GfVec3d normal = GfCross(edge1, edge2);
+                    const double area = normal.GetLength();
+                    if (area == 0.0)
+                    {
+                        continue;
+                    }
+
+                    // Möller-Trumbore with the determinant relative to the triangle's size
+                    const GfVec3d toOrigin = origin - a;
+                    const GfVec3d p = GfCross(direction, edge2);
+                    const double determinant = GfDot(edge1, p);
+                    if (std::abs(determinant) <= kMargin * area)
+                    {
+                        // Parallel: only undecided if the ray runs in the triangle's plane
+                        if (std::abs(GfDot(normal, toOrigin)) <= kMargin * area * (1.0 + toOrigin.GetLength()))
+                        {
+                            return -1;
+                        }
+                        continue;
+                    }
+                    const GfVec3d q = GfCross(toOrigin, edge1);
+                    const double u = GfDot(toOrigin, p) / determinant;
+                    const double w = GfDot(direction, q) / determinant;
+                    const double t = GfDot(edge2, q) / determinant;
+                    if (u < -kMargin || w < -kMargin || u + w > 1.0 + kMargin || t < -kMargin * (1.0 + edge1.GetLength()))
+                    {
+                        continue;
+                    }
+                    if (u <= kMargin || w <= kMargin || u + w >= 1.0 - kMargin || t <= kMargin * (1.0 + edge1.GetLength()))
+                    {
+                        return -1;
+                    }
+                    ++crossings;
+                }
+                return crossings;
+            }
+
+            /**
+             * @brief Parity of three rays in unrelated directions; 1 inside, 0 outside, -1 undecided
+             */
+            int classifyPoint(const SceneGeometry &geometry, uint32_t mesh, const GfVec3d &point)
+            {
+                static const GfVec3d kDirections[3] = {GfVec3d(0.2740, 0.5636, 0.7793).GetNormalized(),
+                                                       GfVec3d(-0.7071, 0.3011, -0.6399).GetNormalized(),
+                                                       GfVec3d(0.4472, -0.8660, 0.2236).GetNormalized()};
+                int side = -1;
+                for (const GfVec3d &direction : kDirections)
+                {
+                    const int crossings = countCrossings(geometry, mesh, point, direction);
+                    if (crossings < 0 || (side >= 0 && crossings % 2 != side))
+                    {
+                        return -1;
+                    }
+                    side = crossings % 2;
+                }
+                return side;
+            }
+
+            double getVolume(const GfRange3f &bounds)
+            {
+                const GfVec3f size = bounds.GetSize();
+                return static_cast<double>(size[0]) * size[1] * size[2];
+            }
+        } // namespace
+
+        void MeshHierarchy::clear()
+        {
+            m_groups.clear();
+            m_meshOrder.clear();
+            m_directMeshes.clear();
+            m_closed.clear();
+        }
+
+        void MeshHierarchy::build(const std::vector<UsdGeomMesh> &meshes, const SceneGeometry &geometry)
+        {
+            clear();
+            const size_t meshCount = meshes.size();
+            if (meshCount < 2)
+            {
+                return;
+            }
+
+            // prefixes[m][k] is the ancestor of mesh m with k + 1 path elements, the last one is the mesh
+            std::vector<SdfPathVector> prefixes(meshCount);
+            for (size_t mesh = 0; mesh < meshCount; ++mesh)
+            {
+                prefixes[mesh] = meshes[mesh].GetPath().GetPrefixes();
+            }
+            m_meshOrder.resize(meshCount);
+            std::iota(m_meshOrder.begin(), m_meshOrder.end(), 0u);
+            std::sort(m_meshOrder.begin(), m_meshOrder.end(),
+                      [&](uint32_t a, uint32_t b)
+                      { return isBefore(prefixes[a], prefixes[b]); });
+
+            // Path elements of each group's prim; the root group starts at the pseudo-root
+            std::vector<size_t> depths;
+            Group root;
+            root.meshCount = static_cast<uint32_t>(meshCount);
+            m_groups.push_back(root);
+            depths.push_back(0);
+
+            // Breadth first, so the children of one group are created next to each other
+            for (size_t group = 0; group < m_groups.size(); ++group)
+            {
+                const uint32_t begin = m_groups[group].firstMesh;
+                const uint32_t end = begin + m_groups[group].meshCount;
+                size_t depth = depths[group];
+
+                // Descend while every mesh lies below the same child prim
+                auto sharesChild = [&]()
+                {
+                    const SdfPathVector &first = prefixes[m_meshOrder[begin]];
+                    if (first.size() <= depth)
+                    {
+                        return false;
+                    }
+                    for (uint32_t i = begin + 1; i < end; ++i)
+                    {
+                        const SdfPathVector &other = prefixes[m_meshOrder[i]];
+                        if (other.size() <= depth || other[depth] != first[depth])
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                };
+                while (sharesChild())
+                {
+                    ++depth;
+                }
+
+                m_groups[group].firstChild = static_cast<uint32_t>(m_groups.size());
+                m_groups[group].firstDirect = static_cast<uint32_t>(m_directMeshes.size());
+                for (uint32_t run = begin; run < end;)
+                {
+                    // A mesh at the group's own prim sorts first and has no child prim to share
+                    const SdfPathVector &first = prefixes[m_meshOrder[run]];
+                    uint32_t runEnd = run + 1;
+                    if (first.size() > depth)
+                    {
+                        while (runEnd < end && prefixes[m_meshOrder[runEnd]].size() > depth &&
+                               prefixes[m_meshOrder[runEnd]][depth] == first[depth])
+                        {
+                            ++runEnd;
+                        }
+                    }
+
+                    if (runEnd - run == 1)
+                    {
+                        m_directMeshes.push_back(m_meshOrder[run]);
+                        m_groups[group].directCount++;
+                    }
+                    else
+                    {
+                        Group child;
+                        child.firstMesh = run;
+                        child.meshCount = runEnd - run;
+                        m_groups.push_back(child);
+                        depths.push_back(depth + 1);
+                        m_groups[group].childCount++;
+                    }
+                    run = runEnd;
+                }
+            }
+
+            m_closed.assign(meshCount, 0);
+            WorkParallelForN(
+                meshCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t mesh = begin; mesh < end; ++mesh)
+                    {
+                        m_closed[mesh] = isClosedMesh(geometry, static_cast<uint32_t>(mesh));
+                    }
+                });
+
+            refit(geometry);
+        }
+
+        void MeshHierarchy::refit(const SceneGeometry &geometry, const std::vector<uint32_t> &changedMeshes)
+        {
+            for (uint32_t mesh : changedMeshes)
+            {
+                if (mesh < m_closed.size())
+                {
+                    m_closed[mesh] = isClosedMesh(geometry, mesh);
+                }
+            }
+
+            for (size_t index = m_groups.size(); index-- > 0;)
+            {
+                Group &group = m_groups[index];
+                group.bounds = GfRange3f();
+                for (uint32_t i = group.firstDirect; i < group.firstDirect + group.directCount; ++i)
+                {
+                    group.bounds.UnionWith(geometry.getBounds(m_directMeshes[i]));
+                }
+                for (uint32_t child = group.firstChild; child < group.firstChild + group.childCount; ++child)
+                {
+                    group.bounds.UnionWith(m_groups[child].bounds);
+                }
+            }
+
+            findEnclosures(geometry);
+        }
+
+        void MeshHierarchy::findEnclosures(const SceneGeometry &geometry)
+        {
+            // Smallest first, so the first mesh that encloses a group is the tightest one
+            std::vector<uint32_t> closedMeshes;
+            for (uint32_t mesh = 0; mesh < m_closed.size(); ++mesh)
+            {
+                if (m_closed[mesh])
+                {
+                    closedMeshes.push_back(mesh);
+                }
+            }
+            std::vector<double> volumes(m_closed.size(), 0.0);
+            for (uint32_t mesh : closedMeshes)
+            {
+                volumes[mesh] = getVolume(geometry.getBounds(mesh));
+            }
+            std::stable_sort(closedMeshes.begin(), closedMeshes.end(),
+                             [&](uint32_t a, uint32_t b)
+                             { return volumes[a] < volumes[b]; });
+
+            WorkParallelForN(
+                m_groups.size(),
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t index = begin; index < end; ++index)
+                    {
+                        Group &group = m_groups[index];
+                        group.enclosingMesh = kNoMesh;
+                        if (group.bounds.IsEmpty())
+                        {
+                            continue;
+                        }
+
+                        // Grown a little so that a surface touching the bounds counts as crossing them
+                        const GfVec3d center(group.bounds.GetMidpoint());
+                        const GfVec3d size(group.bounds.GetSize());
+                        const GfVec3d halfSize = size * 0.5 + GfVec3d(1e-5 * (1.0 + size.GetLength()));
+                        const double groupVolume = getVolume(group.bounds);
+                        for (uint32_t mesh : closedMeshes)
+                        {
+                            const GfRange3f meshBounds = geometry.getBounds(mesh);
+                            if (volumes[mesh] <= groupVolume || !meshBounds.Contains(group.bounds))
+                            {
+                                continue;
+                            }
+
+                            // The bounds are connected, so if no triangle crosses them they lie on one side of the surface
+                            bool crossed = false;
+                            for (uint32_t triangle = geometry.triangleOffsets[mesh];
+                                 triangle < geometry.triangleOffsets[mesh + 1] && !crossed; ++triangle)
+                            {
+                                const uint32_t *corners = &geometry.triangleIndices[3 * triangle];
+                                crossed = overlapsBox(center, halfSize, GfVec3d(geometry.getPoint(corners[0])),
+                                                      GfVec3d(geometry.getPoint(corners[1])), GfVec3d(geometry.getPoint(corners[2])));
+                            }
+                            if (!crossed && classifyPoint(geometry, mesh, center) == 1)
+                            {
+                                group.enclosingMesh = mesh;
+                                break;
+                            }
+                        }
+                    }
+                },
+                1);
+        }
+
+        bool MeshHierarchy::isOutsideMesh(const SceneGeometry &geometry, uint32_t mesh, const GfVec3d &point)
+        {
+            return classifyPoint(geometry, mesh, point) == 0;
+        }
+
+        size_t MeshHierarchy::getEnclosedGroupCount() const
+        {
+            return static_cast<size_t>(std::count_if(m_groups.begin(), m_groups.end(),
+                                                     [](const Group &group)
+                                                     { return group.enclosingMesh != kNoMesh; }));
+        }
+
+        GfVec3f MeshHierarchy::getFacingSample(const GfRange3f &bounds, const GfVec3d &eye, uint32_t index)
+        {
+            const GfVec3f &min = bounds.GetMin();
+            const GfVec3f &max = bounds.GetMax();
+            const GfVec3f size = bounds.GetSize();
+
+            // A side faces the eye when the eye lies beyond it on its axis; at most one per axis
+            int axes[3];
+            float coordinates[3];
+            float areas[3];
+            int sideCount = 0;
+            float totalArea = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (eye[axis] >= min[axis] && eye[axis] <= max[axis])
+                {
+                    continue;
+                }
+                axes[sideCount] = axis;
+                coordinates[sideCount] = eye[axis] < min[axis] ? min[axis] : max[axis];
+                areas[sideCount] = size[(axis + 1) % 3] * size[(axis + 2) % 3];
+                totalArea += areas[sideCount];
+                ++sideCount;
+            }
+            if (sideCount == 0)
+            {
+                return bounds.GetMidpoint();
+            }
+
+            float pick = radicalInverse(index, 2) * totalArea;
+            int side = sideCount - 1;
+            for (int i = 0; i < sideCount; ++i)
+            {
+                if (pick < areas[i])
+                {
+                    side = i;
+                    break;
+                }
+                pick -= areas[i];
+            }
+
+            const int axis = axes[side];
+            const int u = (axis + 1) % 3;
+            const int v = (axis + 2) % 3;
+            GfVec3f point;
+            point[axis] = coordinates[side];
+            point[u] = min[u] + radicalInverse(index, 3) * size[u];
+            point[v] = min[v] + radicalInverse(index, 5) * size[v];
+            return point;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
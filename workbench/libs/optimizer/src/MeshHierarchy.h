@@ -0,0 +1,135 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Prim hierarchy above the analysed meshes, with the combined bounds of each group
+         *
+         * A group is a prim with at least two meshes below it; prims on a
+         * chain with a single branch collapse into the deepest one, so every
+         * group splits into at least two children. Meshes are ordered by
+         * path, which makes the meshes below any group one contiguous range
+         * of getMeshOrder().
+         *
+         * Groups are stored breadth first: the root comes first, the
+         * children of a group are adjacent and always follow their parent,
+         * so a reverse pass sees every child before its parent.
+         *
+         * A group may also record a closed mesh whose inside contains the
+         * group's bounds, such as the housing around an assembly. Any
+         * segment from a point outside that mesh into the bounds crosses its
+         * surface, so the whole group is hidden from such a viewpoint.
+         */
+        class MeshHierarchy
+        {
+        public:
+            static constexpr uint32_t kNoMesh = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * @brief One prim with two or more meshes below it
+             */
+            struct Group
+            {
+                GfRange3f bounds;          ///< Union of the bounds of every mesh below the group
+                uint32_t firstMesh = 0;    ///< Start of the group's range in getMeshOrder()
+                uint32_t meshCount = 0;    ///< Meshes anywhere below the group
+                uint32_t firstChild = 0;   ///< Index of the first child group
+                uint32_t childCount = 0;
+                uint32_t firstDirect = 0;  ///< Start of the meshes that belong to no child, in getDirectMeshes()
+                uint32_t directCount = 0;
+                uint32_t enclosingMesh = kNoMesh; ///< Smallest closed mesh whose inside contains the bounds, or kNoMesh
+            };
+
+            /**
+             * @brief Group the meshes by their prim paths and compute the group bounds
+             * @param meshes Meshes of the snapshot, indexed like geometry
+             * @param geometry World-space snapshot providing the mesh bounds
+             */
+            void build(const std::vector<UsdGeomMesh> &meshes, const SceneGeometry &geometry);
+
+            /**
+             * @brief Recompute every group's bounds and enclosing mesh after meshes of the snapshot moved
+             * @param changedMeshes Meshes whose triangles may have been re-read; closedness is only recomputed for them
+             */
+            void refit(const SceneGeometry &geometry, const std::vector<uint32_t> &changedMeshes = {});
+
+            void clear();
+
+            /**
+             * @brief Point on a side of a box that faces the eye
+             *
+             * Sample i is point i of a Halton sequence (bases 2, 3, 5): the
+             * first dimension picks a side through the sides' cumulative
+             * area, the other two a uniform point on it. Every segment from
+             * the eye to a point inside the box crosses one of these sides.
+             *
+             * @param bounds Box to sample; the eye must lie outside it
+             * @param eye Viewer position
+             * @param index Position in the sample sequence
+             */
+            static GfVec3f getFacingSample(const GfRange3f &bounds, const GfVec3d &eye, uint32_t index);
+
+            /**
+             * @brief Whether a point lies outside a closed mesh, decided by ray parity
+             *
+             * Three rays in fixed directions count their crossings of the
+             * mesh's triangles. The answer is only true if all three agree on
+             * an even count and none of them grazes an edge, a vertex or the
+             * plane of a triangle, so false means inside or undecided.
+             */
+            static bool isOutsideMesh(const SceneGeometry &geometry, uint32_t mesh, const GfVec3d &point);
+
+            /**
+             * @brief Groups that have an enclosing closed mesh
+             */
+            size_t getEnclosedGroupCount() const;
+
+            bool empty() const { return m_groups.empty(); }
+            size_t getGroupCount() const { return m_groups.size(); }
+            const Group &getGroup(uint32_t group) const { return m_groups[group]; }
+
+            /**
+             * @brief Mesh indices sorted by path; each group owns the range [firstMesh, firstMesh + meshCount)
+             */
+            const std::vector<uint32_t> &getMeshOrder() const { return m_meshOrder; }
+
+            /**
+             * @brief Mesh indices of each group that lie below none of its children
+             */
+            const std::vector<uint32_t> &getDirectMeshes() const { return m_directMeshes; }
+
+            size_t getMemoryUsage() const
+            {
+                return m_groups.capacity() * sizeof(Group) +
+                       (m_meshOrder.capacity() + m_directMeshes.capacity()) * sizeof(uint32_t) + m_closed.capacity();
+            }
+
+        private:
+            /**
+             * @brief Find the enclosing closed mesh of every group from the current bounds
+             */
+            void findEnclosures(const SceneGeometry &geometry);
+
+            std::vector<Group> m_groups;
+            std::vector<uint32_t> m_meshOrder;
+            std::vector<uint32_t> m_directMeshes;
+            std::vector<uint8_t> m_closed; ///< Per mesh, non-zero if every edge is shared by exactly two triangles
+        };
+
+    } // namespace optimizer
+} // namespace workbench
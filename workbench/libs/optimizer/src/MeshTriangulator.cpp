@@ -1,9 +1,18 @@
 #include "MeshTriangulator.h"
+#include "ScopedConcurrencyLimit.h"
+#include "TopologyCache.h"
+#include "TriangulationKernel.h"
+#include <pxr/usd/sdf/changeBlock.h>
+#include <pxr/usd/usd/resolveInfo.h>
 #include <pxr/usd/usdGeom/primvarsAPI.h>
 #include <pxr/usd/usdGeom/tokens.h>
 #include <pxr/base/tf/token.h>
+#include <pxr/base/work/loops.h>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <utility>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
@@ -12,6 +21,55 @@ namespace workbench
     namespace optimizer
     {
 
+        namespace
+        {
+            /**
+             * @brief Warn about every face with fewer than 3 vertices, in face order
+             */
+            void appendDegenerateWarnings(const VtIntArray &faceVertexCounts, const TriangulationLayout &layout, const char *context,
+                                          std::vector<std::string> &errors)
+            {
+                if (layout.degenerateCount == 0)
+                {
+                    return;
+                }
+                for (int faceVertexCount : faceVertexCounts)
+                {
+                    if (faceVertexCount < 3)
+                    {
+                        errors.push_back("Warning: Skipping degenerate face with " + std::to_string(faceVertexCount) + " vertices" + context);
+                    }
+                }
+            }
+
+            /**
+             * @brief Fan-triangulate an index array laid out like the face vertex indices
+             * @param cache Returns the result for identical arrays seen before; may be null
+             * @param shared Set to whether the result came from the cache
+             */
+            VtIntArray triangulateIndices(const VtIntArray &faceVertexCounts, const VtIntArray &indices, const TriangulationLayout &layout,
+                                          TopologyCache *cache, bool &shared)
+            {
+                // An all-triangle array is its own triangulation, so it is shared rather than copied
+                if (layout.layout == FaceLayout::Triangles && indices.size() == layout.faceVertexCount)
+                {
+                    shared = false;
+                    return indices;
+                }
+                if (cache)
+                {
+                    return cache->findIndices(faceVertexCounts, layout, indices, shared);
+                }
+                shared = false;
+
+                // Filled in place, so the array is allocated once and never zeroed
+                VtIntArray triangulated;
+                triangulated.resize(3 * layout.triangleCount, [&](int *begin, int *)
+                                    { fillTriangulation(layout, faceVertexCounts.cdata(), faceVertexCounts.size(), indices.cdata(), begin); });
+                return triangulated;
+            }
+        } // namespace
+
         MeshTriangulator::MeshTriangulator(const TriangulationOptions &options)
             : m_options(options)
         {
@@ -28,29 +86,130 @@ namespace workbench
             resetStats();
             logVerbose("Starting triangulation of USD stage");
 
-            // Traverse all mesh primitives in the stage
+            // Collect all mesh primitives in the stage
+            std::vector<UsdGeomMesh> meshes;
             UsdPrimRange range = stage->Traverse();
-            bool success = true;
-
             for (UsdPrimRange::iterator it = range.begin(); it != range.end(); ++it)
             {
                 UsdPrim prim = *it;
-
-                // Check if this primitive is a mesh
                 if (prim.IsA<UsdGeomMesh>())
                 {
-                    UsdGeomMesh mesh(prim);
-                    logVerbose("Processing mesh: " + prim.GetPath().GetString());
+                    meshes.emplace_back(prim);
+                }
+            }
+
+            ScopedConcurrencyLimit concurrencyLimit(m_options.numThreads);
+
+            // Times to triangulate each mesh at, flattened so samples of one mesh are adjacent
+            std::vector<std::vector<UsdTimeCode>> meshTimes(meshes.size());
+            WorkParallelForN(
+                meshes.size(),
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        meshTimes[i] = getTopologyTimes(meshes[i]);
+                    }
+                });
+            std::vector<size_t> firstSample(meshes.size() + 1, 0);
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                firstSample[i + 1] = firstSample[i] + meshTimes[i].size();
+            }
+            std::vector<size_t> sampleMeshes(firstSample.back());
+            std::vector<UsdTimeCode> sampleTimes;
+            sampleTimes.reserve(firstSample.back());
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                std::fill(sampleMeshes.begin() + firstSample[i], sampleMeshes.begin() + firstSample[i + 1], i);
+                sampleTimes.insert(sampleTimes.end(), meshTimes[i].begin(), meshTimes[i].end());
+            }
+            meshTimes.clear();
+
+            // Compute every triangulation from the unchanged stage; a sample may read values held from earlier times
+            std::vector<MeshTriangulation> triangulations(sampleTimes.size());
+            {
+                std::unique_ptr<TopologyCache> cache;
+                if (m_options.shareTopology)
+                {
+                    cache = std::make_unique<TopologyCache>();
+                }
+
+                WorkParallelForN(
+                    sampleTimes.size(),
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t sample = begin; sample < end; ++sample)
+                        {
+                            computeTriangulation(meshes[sampleMeshes[sample]], sampleTimes[sample], cache.get(), triangulations[sample]);
+                        }
+                    });
+            }
+
+            // Author in traversal order, so messages and statistics match a serial run
+            bool success = true;
+            std::unordered_set<const int *> authoredIndices; ///< Storage of every triangulated index array authored so far
+            {
+                SdfChangeBlock changeBlock;
+                for (size_t i = 0; i < meshes.size(); ++i)
+                {
+                    const std::string path = meshes[i].GetPath().GetString();
+                    logVerbose("Processing mesh: " + path);
+
+                    const size_t sampleCount = firstSample[i + 1] - firstSample[i];
+                    if (sampleCount > 1)
+                    {
+                        logVerbose("Triangulating " + std::to_string(sampleCount) + " topology samples");
+                    }
+
+                    // Once one time sample is triangulated, every other one is authored too, so none is shadowed by a held value
+                    const bool anyTriangulated = std::any_of(triangulations.begin() + firstSample[i], triangulations.begin() + firstSample[i + 1],
+                                                             [](const MeshTriangulation &result)
+                                                             { return result.valid && result.needsTriangulation; });
+
+                    // Cached results share storage. Counting reuse here, in traversal order, keeps the statistic
+                    // independent of which thread happened to fill the cache first
+                    bool sharesTopology = anyTriangulated;
+                    for (size_t sample = firstSample[i]; sample < firstSample[i + 1]; ++sample)
+                    {
+                        const MeshTriangulation &result = triangulations[sample];
+                        if (result.valid && result.needsTriangulation &&
+                            authoredIndices.count(result.triangulatedIndices.cdata()) == 0)
+                        {
+                            sharesTopology = false;
+                        }
+                    }
+                    for (size_t sample = firstSample[i]; sample < firstSample[i + 1]; ++sample)
+                    {
+                        const MeshTriangulation &result = triangulations[sample];
+                        if (result.valid && result.needsTriangulation)
+                        {
+                            authoredIndices.insert(result.triangulatedIndices.cdata());
+                        }
+                    }
 
-                    if (!triangulateMesh(mesh))
+                    bool meshSucceeded = true;
+                    for (size_t sample = firstSample[i]; sample < firstSample[i + 1]; ++sample)
                     {
-                        std::cerr << "Warning: Failed to triangulate mesh: "
-                                  << prim.GetPath().GetString() << std::endl;
+                        const bool authorUnchanged = anyTriangulated && !sampleTimes[sample].IsDefault();
+                        if (!authorTriangulation(meshes[i], sampleTimes[sample], triangulations[sample], authorUnchanged))
+                        {
+                            meshSucceeded = false;
+                        }
+
+                        // Release the arrays as soon as they are authored
+                        triangulations[sample] = MeshTriangulation();
+                    }
+
+                    if (!meshSucceeded)
+                    {
+                        std::cerr << "Warning: Failed to triangulate mesh: " << path << std::endl;
                         success = false;
                     }
                     else
                     {
                         m_stats.meshesProcessed++;
+                        m_stats.sharedTopologies += sharesTopology ? 1 : 0;
                     }
                 }
             }
@@ -63,157 +222,242 @@ namespace workbench
 
         bool MeshTriangulator::triangulateMesh(UsdGeomMesh &mesh)
         {
-            return triangulateMesh(mesh, UsdTimeCode::Default());
+            if (!m_options.allTimeSamples)
+            {
+                return triangulateMesh(mesh, UsdTimeCode::Default());
+            }
+
+            const std::vector<UsdTimeCode> times = getTopologyTimes(mesh);
+            std::unique_ptr<TopologyCache> cache;
+            if (m_options.shareTopology)
+            {
+                cache = std::make_unique<TopologyCache>();
+            }
+
+            // Compute every sample before authoring any, since held values are read across sample times
+            std::vector<MeshTriangulation> results(times.size());
+            for (size_t i = 0; i < times.size(); ++i)
+            {
+                computeTriangulation(mesh, times[i], cache.get(), results[i]);
+            }
+
+            const bool anyTriangulated = std::any_of(results.begin(), results.end(), [](const MeshTriangulation &result)
+                                                     { return result.valid && result.needsTriangulation; });
+
+            bool success = true;
+            SdfChangeBlock changeBlock;
+            for (size_t i = 0; i < times.size(); ++i)
+            {
+                if (!authorTriangulation(mesh, times[i], results[i], anyTriangulated && !times[i].IsDefault()))
+                {
+                    success = false;
+                }
+            }
+            return success;
         }
 
-        bool MeshTriangulator::triangulateMesh(UsdGeomMesh &mesh, UsdTimeCode timeCode)
+        std::vector<UsdTimeCode> MeshTriangulator::getTopologyTimes(const UsdGeomMesh &mesh) const
+        {
+            if (!m_options.allTimeSamples || !mesh)
+            {
+                return {UsdTimeCode::Default()};
+            }
+
+            const UsdAttribute faceCountsAttr = mesh.GetFaceVertexCountsAttr();
+            const UsdAttribute faceIndicesAttr = mesh.GetFaceVertexIndicesAttr();
+            std::vector<UsdAttribute> attributes = {faceCountsAttr, faceIndicesAttr};
+            if (m_options.preserveOriginalPrimvars)
+            {
+                for (const UsdGeomPrimvar &primvar : UsdGeomPrimvarsAPI(mesh.GetPrim()).GetPrimvars())
+                {
+                    if (primvar.GetInterpolation() == UsdGeomTokens->faceVarying && primvar.IsIndexed())
+                    {
+                        attributes.push_back(primvar.GetIndicesAttr());
+                    }
+                }
+            }
+
+            std::vector<double> samples;
+            for (const UsdAttribute &attribute : attributes)
+            {
+                std::vector<double> attributeSamples;
+                if (attribute.GetTimeSamples(&attributeSamples))
+                {
+                    samples.insert(samples.end(), attributeSamples.begin(), attributeSamples.end());
+                }
+            }
+            std::sort(samples.begin(), samples.end());
+            samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+
+            std::vector<UsdTimeCode> times;
+            times.reserve(samples.size() + 1);
+            if (samples.empty() || (faceCountsAttr.GetResolveInfo(UsdTimeCode::Default()).HasAuthoredValue() &&
+                                    faceIndicesAttr.GetResolveInfo(UsdTimeCode::Default()).HasAuthoredValue()))
+            {
+                times.push_back(UsdTimeCode::Default());
+            }
+            for (double sample : samples)
+            {
+                times.emplace_back(sample);
+            }
+            return times;
+        }
+
+        void MeshTriangulator::computeTriangulation(const UsdGeomMesh &mesh, UsdTimeCode timeCode, TopologyCache *cache, MeshTriangulation &result) const
         {
             if (!mesh)
             {
-                std::cerr << "Error: Invalid mesh provided to triangulateMesh" << std::endl;
-                return false;
+                result.errors.push_back("Error: Invalid mesh provided to triangulateMesh");
+                return;
             }
 
             // Get face vertex counts and indices
             VtIntArray faceVertexCounts;
             VtIntArray faceVertexIndices;
 
-            UsdAttribute faceCountsAttr = mesh.GetFaceVertexCountsAttr();
-            UsdAttribute faceIndicesAttr = mesh.GetFaceVertexIndicesAttr();
-
-            if (!faceCountsAttr.Get(&faceVertexCounts, timeCode))
+            if (!mesh.GetFaceVertexCountsAttr().Get(&faceVertexCounts, timeCode))
             {
-                std::cerr << "Error: Failed to get face vertex counts" << std::endl;
-                return false;
+                result.errors.push_back("Error: Failed to get face vertex counts");
+                return;
             }
 
-            if (!faceIndicesAttr.Get(&faceVertexIndices, timeCode))
+            if (!mesh.GetFaceVertexIndicesAttr().Get(&faceVertexIndices, timeCode))
             {
-                std::cerr << "Error: Failed to get face vertex indices" << std::endl;
-                return false;
+                result.errors.push_back("Error: Failed to get face vertex indices");
+                return;
             }
+            result.valid = true;
 
-            // Check if triangulation is needed
-            bool needsTriangulation = false;
-            for (int count : faceVertexCounts)
+            // Check if triangulation is needed and size the output in the same pass
+            TriangulationLayout layout;
+            if (cache)
             {
-                if (count > 3)
-                {
-                    needsTriangulation = true;
-                    break;
-                }
+                const TopologyCache::Faces faces = cache->findFaces(faceVertexCounts);
+                layout = faces.layout;
+                result.triangulatedCounts = faces.triangulatedCounts;
+            }
+            else
+            {
+                layout = measureTriangulation(faceVertexCounts.cdata(), faceVertexCounts.size());
             }
+            result.facesTriangulated = layout.polygonCount;
+            result.needsTriangulation = layout.polygonCount > 0;
 
-            if (!needsTriangulation)
+            // Time samples that need no triangulation are still built, in case other samples of the mesh do
+            if (!result.needsTriangulation && (!m_options.allTimeSamples || timeCode.IsDefault()))
             {
-                logVerbose("Mesh is already triangulated, skipping");
-                return true;
+                return;
             }
 
-            // Store original statistics
-            m_stats.originalFaceCount += faceVertexCounts.size();
+            result.originalFaceCount = faceVertexCounts.size();
 
             // Triangulate the faces
-            VtIntArray triangulatedCounts;
-            VtIntArray triangulatedIndices;
-
-            if (!triangulateFaces(faceVertexCounts, faceVertexIndices,
-                                  triangulatedCounts, triangulatedIndices))
+            if (!triangulateFaces(faceVertexCounts, faceVertexIndices, layout, cache, result))
             {
-                std::cerr << "Error: Failed to triangulate faces" << std::endl;
-                return false;
+                result.errors.push_back("Error: Failed to triangulate faces");
+                result.valid = false;
+                return;
             }
 
-            // Update statistics
-            m_stats.finalFaceCount += triangulatedCounts.size();
+            // Triangulate primvars if requested
+            if (m_options.preserveOriginalPrimvars && !triangulatePrimvars(mesh, faceVertexCounts, layout, timeCode, cache, result))
+            {
+                result.primvarsFailed = true;
+            }
+        }
 
-            // Count how many faces were actually triangulated
-            for (int count : faceVertexCounts)
+        bool MeshTriangulator::authorTriangulation(UsdGeomMesh &mesh, UsdTimeCode timeCode, const MeshTriangulation &result,
+                                                   bool authorUnchanged)
+        {
+            if (!result.valid || result.needsTriangulation || authorUnchanged)
             {
-                if (count > 3)
+                for (const std::string &error : result.errors)
                 {
-                    m_stats.facesTriangulated++;
+                    std::cerr << error << std::endl;
                 }
             }
+            if (!result.valid)
+            {
+                return false;
+            }
 
-            // Triangulate primvars if requested
-            if (m_options.preserveOriginalPrimvars && !triangulatePrimvars(mesh, faceVertexCounts, timeCode))
+            if (!result.needsTriangulation && !authorUnchanged)
+            {
+                logVerbose("Mesh is already triangulated, skipping");
+                return true;
+            }
+
+            // Update statistics
+            if (result.needsTriangulation)
+            {
+                m_stats.originalFaceCount += result.originalFaceCount;
+                m_stats.finalFaceCount += result.triangulatedCounts.size();
+                m_stats.facesTriangulated += result.facesTriangulated;
+            }
+
+            for (const auto &[primvar, indices] : result.primvarIndices)
+            {
+                primvar.SetIndices(indices, timeCode);
+            }
+            if (result.primvarsFailed)
             {
                 std::cerr << "Warning: Failed to triangulate primvars" << std::endl;
                 // Don't fail the entire operation for primvar issues
             }
 
             // Set the new face data
-            faceCountsAttr.Set(triangulatedCounts, timeCode);
-            faceIndicesAttr.Set(triangulatedIndices, timeCode);
+            mesh.GetFaceVertexCountsAttr().Set(result.triangulatedCounts, timeCode);
+            mesh.GetFaceVertexIndicesAttr().Set(result.triangulatedIndices, timeCode);
 
-            logVerbose("Successfully triangulated mesh with " +
-                       std::to_string(faceVertexCounts.size()) + " original faces to " +
-                       std::to_string(triangulatedCounts.size()) + " triangular faces");
+            if (result.needsTriangulation)
+            {
+                logVerbose("Successfully triangulated mesh with " +
+                           std::to_string(result.originalFaceCount) + " original faces to " +
+                           std::to_string(result.triangulatedCounts.size()) + " triangular faces");
+            }
 
             return true;
         }
 
-        bool MeshTriangulator::triangulateFaces(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices, VtIntArray &triangulatedCounts, VtIntArray &triangulatedIndices)
+        bool MeshTriangulator::triangulateTopology(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices,
+                                                   VtIntArray &triangulatedCounts, VtIntArray &triangulatedIndices)
         {
-
-            triangulatedCounts.clear();
-            triangulatedIndices.clear();
-
-            int indexOffset = 0;
-
-            for (int faceVertexCount : faceVertexCounts)
+            const TriangulationLayout layout = measureTriangulation(faceVertexCounts.cdata(), faceVertexCounts.size());
+            if (!layout.valid || layout.faceVertexCount > faceVertexIndices.size())
             {
-                if (faceVertexCount < 3)
-                {
-                    std::cerr << "Warning: Skipping degenerate face with " << faceVertexCount << " vertices" << std::endl;
-                }
-                else if (faceVertexCount == 3)
-                {
-                    // Already a triangle, copy as-is
-                    triangulatedCounts.push_back(3);
-                    for (int i = 0; i < 3; ++i)
-                    {
-                        triangulatedIndices.push_back(faceVertexIndices[indexOffset + i]);
-                    }
-                }
-                else
-                {
-                    // Triangulate using fan triangulation
-                    triangulateFace(faceVertexCount, indexOffset, faceVertexIndices, triangulatedIndices);
-
-                    // Add triangle counts (each n-gon becomes n-2 triangles)
-                    int numTriangles = faceVertexCount - 2;
-                    for (int i = 0; i < numTriangles; ++i)
-                    {
-                        triangulatedCounts.push_back(3);
-                    }
-                }
-
-                indexOffset += faceVertexCount;
+                return false;
             }
-
+            bool shared = false;
+            triangulatedCounts = VtIntArray(layout.triangleCount, 3);
+            triangulatedIndices = triangulateIndices(faceVertexCounts, faceVertexIndices, layout, nullptr, shared);
             return true;
         }
 
-        void MeshTriangulator::triangulateFace(int faceVertexCount, int startIndex, const VtIntArray &faceVertexIndices, VtIntArray &triangulatedIndices)
+        const char *MeshTriangulator::getKernelName()
         {
+            return getTriangulationKernelName();
+        }
 
-            // Use fan triangulation: connect all vertices to the first vertex
-            // For a face with vertices [v0, v1, v2, v3, v4], create triangles:
-            // [v0, v1, v2], [v0, v2, v3], [v0, v3, v4]
-
-            int firstVertex = faceVertexIndices[startIndex];
+        bool MeshTriangulator::triangulateFaces(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices, const TriangulationLayout &layout,
+                                                TopologyCache *cache, MeshTriangulation &result)
+        {
+            if (!layout.valid || layout.faceVertexCount > faceVertexIndices.size())
+            {
+                return false;
+            }
 
-            for (int i = 1; i < faceVertexCount - 1; ++i)
+            appendDegenerateWarnings(faceVertexCounts, layout, "", result.errors);
+            if (!cache)
             {
-                triangulatedIndices.push_back(firstVertex);
-                triangulatedIndices.push_back(faceVertexIndices[startIndex + i]);
-                triangulatedIndices.push_back(faceVertexIndices[startIndex + i + 1]);
+                result.triangulatedCounts = VtIntArray(layout.triangleCount, 3);
             }
+            bool shared = false;
+            result.triangulatedIndices = triangulateIndices(faceVertexCounts, faceVertexIndices, layout, cache, shared);
+            return true;
         }
 
-        bool MeshTriangulator::triangulatePrimvars(UsdGeomMesh &mesh, const VtIntArray &originalFaceCounts, UsdTimeCode timeCode)
+        bool MeshTriangulator::triangulatePrimvars(const UsdGeomMesh &mesh, const VtIntArray &originalFaceCounts, const TriangulationLayout &layout, UsdTimeCode timeCode,
+                                                   TopologyCache *cache, MeshTriangulation &result)
         {
 
             UsdGeomPrimvarsAPI primvarsAPI(mesh.GetPrim());
@@ -232,8 +476,7 @@ namespace workbench
                 VtValue value;
                 if (!primvar.Get(&value, timeCode))
                 {
-                    std::cerr << "Warning: Failed to get primvar value for "
-                              << primvar.GetPrimvarName() << std::endl;
+                    result.errors.push_back("Warning: Failed to get primvar value for " + primvar.GetPrimvarName().GetString());
                     success = false;
                     continue;
                 }
@@ -248,38 +491,15 @@ namespace workbench
 
                 if (hasIndices)
                 {
-                    VtIntArray newIndices;
-                    int indexOffset = 0;
-
-                    for (int faceVertexCount : originalFaceCounts)
+                    if (indices.size() < layout.faceVertexCount)
                     {
-                        if (faceVertexCount < 3)
-                        {
-                            std::cerr << "Warning: Skipping degenerate face with " << faceVertexCount << " vertices in primvar triangulation" << std::endl;
-                        }
-                        else if (faceVertexCount == 3)
-                        {
-                            // Copy triangle indices as-is
-                            for (int i = 0; i < 3; ++i)
-                            {
-                                newIndices.push_back(indices[indexOffset + i]);
-                            }
-                        }
-                        else
-                        {
-                            // Fan triangulation for indices
-                            int firstIndex = indices[indexOffset];
-                            for (int i = 1; i < faceVertexCount - 1; ++i)
-                            {
-                                newIndices.push_back(firstIndex);
-                                newIndices.push_back(indices[indexOffset + i]);
-                                newIndices.push_back(indices[indexOffset + i + 1]);
-                            }
-                        }
-                        indexOffset += faceVertexCount;
+                        result.errors.push_back("Warning: Indices of primvar " + primvar.GetPrimvarName().GetString() + " do not cover every face vertex");
+                        success = false;
+                        continue;
                     }
-
-                    primvar.SetIndices(newIndices, timeCode);
+                    appendDegenerateWarnings(originalFaceCounts, layout, " in primvar triangulation", result.errors);
+                    bool shared = false;
+                    result.primvarIndices.emplace_back(primvar, triangulateIndices(originalFaceCounts, indices, layout, cache, shared));
                 }
 
                 // TODO: If no indices, the primvar data itself might need expansion
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "HiddenMeshRemover.h"
+#include "MeshHierarchy.h"
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include "SceneRayCaster.h"
+#include "SurfaceSampler.h"
+#include "VoxelGrid.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        struct HiddenMeshRemover::OcclusionScene
+        {
+            std::vector<UsdGeomMesh> meshes;
+            std::vector<uint8_t> instancedMeshes; ///< Non-zero for meshes that are themselves instances, indexed like meshes
+            SceneGeometry geometry;   ///< World-space snapshot, indexed like meshes
+            SceneInstances instances; ///< Instanced occluders, stored once per prototype
+            SceneRayCaster rayCaster; ///< Two-level BVH over meshes and their triangles
+            SurfaceSampler sampler;   ///< Area-weighted sample points on every mesh
+            MeshHierarchy hierarchy;  ///< Prim groups above the meshes, built for hierarchical culling
+            VoxelGrid voxels;         ///< Occupied voxels of meshes and instances, built for the voxel engine
+            GfRange3f bounds;         ///< Union of all mesh and instance bounds
+        };
+
+    } // namespace optimizer
+} // namespace workbench
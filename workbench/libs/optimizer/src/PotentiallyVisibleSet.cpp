@@ -0,0 +1,370 @@
+#include "PotentiallyVisibleSet.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr char kFileMagic[8] = {'W', 'B', 'P', 'V', 'S', '\0', '\0', '\0'};
+            constexpr uint32_t kFileVersion = 1;
+
+            constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+            constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+            uint64_t hashWords(const uint64_t *words, size_t count)
+            {
+                uint64_t hash = kFnvOffset;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    hash = (hash ^ words[i]) * kFnvPrime;
+                }
+                return hash;
+            }
+
+            constexpr bool kLittleEndianHost = std::endian::native == std::endian::little;
+
+            /**
+             * @brief Convert a value between host and file byte order, which is little-endian
+             */
+            template <typename T>
+            T toFileOrder(T value)
+            {
+                if constexpr (!kLittleEndianHost)
+                {
+                    char bytes[sizeof(T)];
+                    std::memcpy(bytes, &value, sizeof(T));
+                    std::reverse(bytes, bytes + sizeof(T));
+                    std::memcpy(&value, bytes, sizeof(T));
+                }
+                return value;
+            }
+
+            template <typename T>
+            void writeValue(std::ofstream &file, const T &value)
+            {
+                const T stored = toFileOrder(value);
+                file.write(reinterpret_cast<const char *>(&stored), sizeof(T));
+            }
+
+            template <typename T>
+            void writeArray(std::ofstream &file, const std::vector<T> &values)
+            {
+                if constexpr (kLittleEndianHost)
+                {
+                    file.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+                }
+                else
+                {
+                    for (const T &value : values)
+                    {
+                        writeValue(file, value);
+                    }
+                }
+            }
+
+            template <typename T>
+            bool readValue(std::ifstream &file, T &value)
+            {
+                if (!file.read(reinterpret_cast<char *>(&value), sizeof(T)))
+                {
+                    return false;
+                }
+                value = toFileOrder(value);
+                return true;
+            }
+
+            /**
+             * @brief Read count values, refusing counts the rest of the file cannot hold
+             */
+            template <typename T>
+            bool readArray(std::ifstream &file, size_t count, uint64_t remainingBytes, std::vector<T> &values)
+            {
+                if (count > remainingBytes / sizeof(T))
+                {
+                    return false;
+                }
+                values.resize(count);
+                if (!file.read(reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(count * sizeof(T))))
+                {
+                    return false;
+                }
+                if constexpr (!kLittleEndianHost)
+                {
+                    for (T &value : values)
+                    {
+                        value = toFileOrder(value);
+                    }
+                }
+                return true;
+            }
+        } // namespace
+
+        void PotentiallyVisibleSet::clear()
+        {
+            *this = PotentiallyVisibleSet();
+        }
+
+        void PotentiallyVisibleSet::reset(const GfRange3d &bounds, const GfVec3i &resolution, const std::vector<std::string> &meshPaths)
+        {
+            clear();
+            m_bounds = bounds;
+            m_resolution = GfVec3i(std::max(resolution[0], 1), std::max(resolution[1], 1), std::max(resolution[2], 1));
+            m_meshPaths = meshPaths;
+            for (size_t mesh = 0; mesh < m_meshPaths.size(); ++mesh)
+            {
+                m_meshIndices.emplace(m_meshPaths[mesh], static_cast<uint32_t>(mesh));
+            }
+
+            const GfVec3d size = bounds.IsEmpty() ? GfVec3d(0.0) : bounds.GetSize();
+            m_cellSize = GfVec3d(size[0] / m_resolution[0], size[1] / m_resolution[1], size[2] / m_resolution[2]);
+            m_wordsPerMask = (m_meshPaths.size() + 63) / 64;
+            m_cellMasks.assign(static_cast<size_t>(m_resolution[0]) * m_resolution[1] * m_resolution[2], kNoMask);
+        }
+
+        void PotentiallyVisibleSet::setVisibleMeshes(uint32_t cell, const std::vector<uint8_t> &visibleMeshes)
+        {
+            std::vector<uint64_t> bits(m_wordsPerMask, 0);
+            for (size_t mesh = 0; mesh < visibleMeshes.size() && mesh < m_meshPaths.size(); ++mesh)
+            {
+                if (visibleMeshes[mesh])
+                {
+                    bits[mesh / 64] |= uint64_t(1) << (mesh % 64);
+                }
+            }
+
+            // Share the bitset with any cell that sees exactly the same meshes
+            const uint64_t hash = hashWords(bits.data(), bits.size());
+            auto range = m_maskLookup.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                const uint64_t *existing = &m_masks[static_cast<size_t>(it->second) * m_wordsPerMask];
+                if (std::equal(bits.begin(), bits.end(), existing))
+                {
+                    m_cellMasks[cell] = it->second;
+                    return;
+                }
+            }
+
+            const uint32_t mask = static_cast<uint32_t>(getUniqueMaskCount());
+            m_masks.insert(m_masks.end(), bits.begin(), bits.end());
+            m_maskLookup.emplace(hash, mask);
+            m_cellMasks[cell] = mask;
+        }
+
+        uint32_t PotentiallyVisibleSet::findCell(const GfVec3d &position) const
+        {
+            if (m_cellMasks.empty())
+            {
+                return kNoCell;
+            }
+
+            int coordinates[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const double offset = position[axis] - m_bounds.GetMin()[axis];
+                // Written so that NaN coordinates are outside too
+                if (!(offset >= 0.0) || !(position[axis] <= m_bounds.GetMax()[axis]))
+                {
+                    return kNoCell;
+                }
+                // Flat axes have a single cell; the upper bound belongs to the last cell
+                const int coordinate = m_cellSize[axis] > 0.0 ? static_cast<int>(offset / m_cellSize[axis]) : 0;
+                coordinates[axis] = std::min(coordinate, m_resolution[axis] - 1);
+            }
+            return getCellIndex(coordinates[0], coordinates[1], coordinates[2]);
+        }
+
+        GfRange3d PotentiallyVisibleSet::getCellBounds(uint32_t cell) const
+        {
+            const size_t sliceCells = static_cast<size_t>(m_resolution[0]) * m_resolution[1];
+            const GfVec3d index(static_cast<double>(cell % m_resolution[0]),
+                                static_cast<double>((cell / m_resolution[0]) % m_resolution[1]),
+                                static_cast<double>(cell / sliceCells));
+            const GfVec3d min = m_bounds.GetMin() + GfCompMult(index, m_cellSize);
+            return GfRange3d(min, min + m_cellSize);
+        }
+
+        std::vector<uint32_t> PotentiallyVisibleSet::getVisibleMeshes(uint32_t cell) const
+        {
+            std::vector<uint32_t> meshes;
+            for (uint32_t mesh = 0; mesh < m_meshPaths.size(); ++mesh)
+            {
+                if (isVisible(cell, mesh))
+                {
+                    meshes.push_back(mesh);
+                }
+            }
+            return meshes;
+        }
+
+        uint32_t PotentiallyVisibleSet::findMesh(const std::string &meshPath) const
+        {
+            auto found = m_meshIndices.find(meshPath);
+            return found == m_meshIndices.end() ? kNoMesh : found->second;
+        }
+
+        size_t PotentiallyVisibleSet::getNavigableCellCount() const
+        {
+            return static_cast<size_t>(std::count_if(m_cellMasks.begin(), m_cellMasks.end(),
+                                                     [](uint32_t mask)
+                                                     { return mask != kNoMask; }));
+        }
+
+        bool PotentiallyVisibleSet::save(const std::string &path) const
+        {
+            // Write next to the target and rename, so an interrupted run never leaves a truncated file
+            const std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file)
+                {
+                    return false;
+                }
+
+                // <magic> <version> <bounds> <resolution> <mesh paths> <bitsets> <cell table>
+                file.write(kFileMagic, sizeof(kFileMagic));
+                writeValue(file, kFileVersion);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    writeValue(file, m_bounds.GetMin()[axis]);
+                }
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    writeValue(file, m_bounds.GetMax()[axis]);
+                }
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    writeValue(file, static_cast<int32_t>(m_resolution[axis]));
+                }
+
+                writeValue(file, static_cast<uint32_t>(m_meshPaths.size()));
+                for (const std::string &meshPath : m_meshPaths)
+                {
+                    writeValue(file, static_cast<uint32_t>(meshPath.size()));
+                    file.write(meshPath.data(), static_cast<std::streamsize>(meshPath.size()));
+                }
+
+                writeValue(file, static_cast<uint32_t>(getUniqueMaskCount()));
+                writeArray(file, m_masks);
+                writeArray(file, m_cellMasks);
+
+                if (!file)
+                {
+                    return false;
+                }
+            }
+
+            // Not every platform lets rename() replace an existing file
+            if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+            {
+                std::remove(path.c_str());
+                return std::rename(tempPath.c_str(), path.c_str()) == 0;
+            }
+            return true;
+        }
+
+        bool PotentiallyVisibleSet::load(const std::string &path)
+        {
+            clear();
+
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file)
+            {
+                return false;
+            }
+            const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+            file.seekg(0);
+            auto remaining = [&]()
+            {
+                return fileSize - static_cast<uint64_t>(file.tellg());
+            };
+
+            char magic[sizeof(kFileMagic)];
+            uint32_t version = 0;
+            if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kFileMagic, sizeof(magic)) != 0 ||
+                !readValue(file, version) || version != kFileVersion)
+            {
+                return false;
+            }
+
+            GfVec3d min, max;
+            int32_t resolution[3] = {0, 0, 0};
+            bool valid = readValue(file, min[0]) && readValue(file, min[1]) && readValue(file, min[2]) &&
+                         readValue(file, max[0]) && readValue(file, max[1]) && readValue(file, max[2]) &&
+                         readValue(file, resolution[0]) && readValue(file, resolution[1]) && readValue(file, resolution[2]);
+            if (!valid || resolution[0] < 1 || resolution[1] < 1 || resolution[2] < 1)
+            {
+                return false;
+            }
+
+            uint32_t meshCount = 0;
+            if (!readValue(file, meshCount) || meshCount > remaining() / sizeof(uint32_t))
+            {
+                return false;
+            }
+            std::vector<std::string> meshPaths(meshCount);
+            for (std::string &meshPath : meshPaths)
+            {
+                uint32_t length = 0;
+                if (!readValue(file, length) || length > remaining())
+                {
+                    return false;
+                }
+                meshPath.resize(length);
+                if (!file.read(meshPath.data(), length))
+                {
+                    return false;
+                }
+            }
+
+            // Cells are indexed by uint32_t and kNoCell is reserved; the cell table must also fit in the rest of the file
+            const uint64_t sliceCells = static_cast<uint64_t>(resolution[0]) * static_cast<uint64_t>(resolution[1]);
+            if (sliceCells >= kNoCell)
+            {
+                return false;
+            }
+            const uint64_t cellCount = sliceCells * static_cast<uint64_t>(resolution[2]);
+            const uint64_t tableBytes = remaining();
+            if (cellCount >= kNoCell || tableBytes < sizeof(uint32_t) ||
+                cellCount > (tableBytes - sizeof(uint32_t)) / sizeof(uint32_t))
+            {
+                return false;
+            }
+
+            reset(GfRange3d(min, max), GfVec3i(resolution[0], resolution[1], resolution[2]), meshPaths);
+
+            uint32_t maskCount = 0;
+            if (!readValue(file, maskCount) ||
+                (m_wordsPerMask > 0 && maskCount > remaining() / (m_wordsPerMask * sizeof(uint64_t))) ||
+                !readArray(file, static_cast<size_t>(maskCount) * m_wordsPerMask, remaining(), m_masks) ||
+                !readArray(file, m_cellMasks.size(), remaining(), m_cellMasks))
+            {
+                clear();
+                return false;
+            }
+
+            // Sets without meshes have no bitsets, only navigable cells
+            const uint32_t maskLimit = m_wordsPerMask > 0 ? maskCount : 1;
+            for (uint32_t mask : m_cellMasks)
+            {
+                if (mask != kNoMask && mask >= maskLimit)
+                {
+                    clear();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,212 @@
+#include "RayPacket.h"
+#include "Bvh.h"
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        RayPacket::RayPacket(const GfVec3f &rayOrigin)
+            : origin(rayOrigin)
+        {
+            // Unused lanes stay zero; they are never part of an active mask
+            for (int lane = 0; lane < kMaxSize; ++lane)
+            {
+                dirX[lane] = dirY[lane] = dirZ[lane] = 0.0f;
+                invX[lane] = invY[lane] = invZ[lane] = 0.0f;
+                tMax[lane] = 0.0f;
+                ignoredMesh[lane] = std::numeric_limits<uint32_t>::max();
+            }
+        }
+
+        void RayPacket::addRay(const GfVec3f &direction, float length, uint32_t ignored)
+        {
+            dirX[size] = direction[0];
+            dirY[size] = direction[1];
+            dirZ[size] = direction[2];
+            tMax[size] = length;
+            ignoredMesh[size] = ignored;
+            ++size;
+        }
+
+        void RayPacket::finalize()
+        {
+            maxTMax = 0.0f;
+            isCoherent = size > 0;
+            for (int lane = 0; lane < size; ++lane)
+            {
+                const GfVec3f inverse = Bvh::computeInverseDirection(GfVec3f(dirX[lane], dirY[lane], dirZ[lane]));
+                invX[lane] = inverse[0];
+                invY[lane] = inverse[1];
+                invZ[lane] = inverse[2];
+                maxTMax = std::max(maxTMax, tMax[lane]);
+
+                if (lane == 0)
+                {
+                    invMin = invMax = inverse;
+                    continue;
+                }
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    invMin[axis] = std::min(invMin[axis], inverse[axis]);
+                    invMax[axis] = std::max(invMax[axis], inverse[axis]);
+                }
+            }
+
+            // The interval bound only holds if no axis mixes positive and negative directions
+            for (int axis = 0; isCoherent && axis < 3; ++axis)
+            {
+                isCoherent = (invMin[axis] > 0.0f) == (invMax[axis] > 0.0f);
+            }
+        }
+
+        namespace
+        {
+            /**
+             * @brief Conservative test of the whole packet frustum against a box
+             * @return False only if no ray of the packet can overlap the box
+             */
+            inline bool intersectPacketFrustum(const GfVec3f &boundsMin, const GfVec3f &boundsMax, const RayPacket &packet)
+            {
+                float lowerEntry = 0.0f;
+                float upperExit = packet.maxTMax;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    // Rays with positive direction enter through the minimum slab
+                    const bool positive = packet.invMin[axis] > 0.0f;
+                    const float entry = (positive ? boundsMin[axis] : boundsMax[axis]) - packet.origin[axis];
+                    const float exit = (positive ? boundsMax[axis] : boundsMin[axis]) - packet.origin[axis];
+
+                    // Distances are linear in the reciprocal, so the interval ends bound every ray
+                    lowerEntry = std::max(lowerEntry, std::min(entry * packet.invMin[axis], entry * packet.invMax[axis]));
+                    upperExit = std::min(upperExit, std::max(exit * packet.invMin[axis], exit * packet.invMax[axis]));
+                }
+                return lowerEntry <= upperExit;
+            }
+        } // namespace
+
+        uint32_t intersectBoxPacket(const GfVec3f &boundsMin, const GfVec3f &boundsMax,
+                                    const RayPacket &packet, uint32_t activeMask, float &tEntry)
+        {
+            tEntry = std::numeric_limits<float>::infinity();
+            if (packet.isCoherent && !intersectPacketFrustum(boundsMin, boundsMax, packet))
+            {
+                return 0;
+            }
+
+            // With a shared origin the box offsets are the same for every ray
+            const float minX = boundsMin[0] - packet.origin[0];
+            const float minY = boundsMin[1] - packet.origin[1];
+            const float minZ = boundsMin[2] - packet.origin[2];
+            const float maxX = boundsMax[0] - packet.origin[0];
+            const float maxY = boundsMax[1] - packet.origin[1];
+            const float maxZ = boundsMax[2] - packet.origin[2];
+
+            uint32_t hitMask = 0;
+
+#if defined(__AVX2__)
+            __m256 nearest = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            for (int base = 0; base < packet.size; base += 8)
+            {
+                if (((activeMask >> base) & 0xFFu) == 0)
+                {
+                    continue;
+                }
+
+                const __m256 ix = _mm256_loadu_ps(packet.invX + base);
+                const __m256 iy = _mm256_loadu_ps(packet.invY + base);
+                const __m256 iz = _mm256_loadu_ps(packet.invZ + base);
+
+                const __m256 t1x = _mm256_mul_ps(_mm256_set1_ps(minX), ix);
+                const __m256 t2x = _mm256_mul_ps(_mm256_set1_ps(maxX), ix);
+                const __m256 t1y = _mm256_mul_ps(_mm256_set1_ps(minY), iy);
+                const __m256 t2y = _mm256_mul_ps(_mm256_set1_ps(maxY), iy);
+                const __m256 t1z = _mm256_mul_ps(_mm256_set1_ps(minZ), iz);
+                const __m256 t2z = _mm256_mul_ps(_mm256_set1_ps(maxZ), iz);
+
+                __m256 tNear = _mm256_max_ps(_mm256_setzero_ps(), _mm256_min_ps(t1x, t2x));
+                tNear = _mm256_max_ps(tNear, _mm256_min_ps(t1y, t2y));
+                tNear = _mm256_max_ps(tNear, _mm256_min_ps(t1z, t2z));
+                __m256 tFar = _mm256_min_ps(_mm256_loadu_ps(packet.tMax + base), _mm256_max_ps(t1x, t2x));
+                tFar = _mm256_min_ps(tFar, _mm256_max_ps(t1y, t2y));
+                tFar = _mm256_min_ps(tFar, _mm256_max_ps(t1z, t2z));
+
+                // Only active rays that hit contribute to the entry distance
+                const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+                const __m256i active = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(activeMask >> base)), laneBits), laneBits);
+                const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ), _mm256_castsi256_ps(active));
+                nearest = _mm256_min_ps(nearest, _mm256_blendv_ps(nearest, tNear, hit));
+                hitMask |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << base;
+            }
+
+            __m128 nearest4 = _mm_min_ps(_mm256_castps256_ps128(nearest), _mm256_extractf128_ps(nearest, 1));
+            nearest4 = _mm_min_ps(nearest4, _mm_movehl_ps(nearest4, nearest4));
+            nearest4 = _mm_min_ss(nearest4, _mm_shuffle_ps(nearest4, nearest4, 1));
+            tEntry = _mm_cvtss_f32(nearest4);
+#elif defined(__SSE2__) || defined(_M_X64)
+            __m128 nearest = _mm_set1_ps(std::numeric_limits<float>::infinity());
+            for (int base = 0; base < packet.size; base += 4)
+            {
+                if (((activeMask >> base) & 0xFu) == 0)
+                {
+                    continue;
+                }
+
+                const __m128 ix = _mm_loadu_ps(packet.invX + base);
+                const __m128 iy = _mm_loadu_ps(packet.invY + base);
+                const __m128 iz = _mm_loadu_ps(packet.invZ + base);
+
+                const __m128 t1x = _mm_mul_ps(_mm_set1_ps(minX), ix);
+                const __m128 t2x = _mm_mul_ps(_mm_set1_ps(maxX), ix);
+                const __m128 t1y = _mm_mul_ps(_mm_set1_ps(minY), iy);
+                const __m128 t2y = _mm_mul_ps(_mm_set1_ps(maxY), iy);
+                const __m128 t1z = _mm_mul_ps(_mm_set1_ps(minZ), iz);
+                const __m128 t2z = _mm_mul_ps(_mm_set1_ps(maxZ), iz);
+
+                __m128 tNear = _mm_max_ps(_mm_setzero_ps(), _mm_min_ps(t1x, t2x));
+                tNear = _mm_max_ps(tNear, _mm_min_ps(t1y, t2y));
+                tNear = _mm_max_ps(tNear, _mm_min_ps(t1z, t2z));
+                __m128 tFar = _mm_min_ps(_mm_loadu_ps(packet.tMax + base), _mm_max_ps(t1x, t2x));
+                tFar = _mm_min_ps(tFar, _mm_max_ps(t1y, t2y));
+                tFar = _mm_min_ps(tFar, _mm_max_ps(t1z, t2z));
+
+                // SSE2 has no blendv: keep the old minimum where a lane is inactive or missed
+                const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+                const __m128i active = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(activeMask >> base)), laneBits), laneBits);
+                const __m128 hit = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_castsi128_ps(active));
+                nearest = _mm_min_ps(nearest, _mm_or_ps(_mm_and_ps(hit, tNear), _mm_andnot_ps(hit, nearest)));
+                hitMask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << base;
+            }
+
+            nearest = _mm_min_ps(nearest, _mm_movehl_ps(nearest, nearest));
+            nearest = _mm_min_ss(nearest, _mm_shuffle_ps(nearest, nearest, 1));
+            tEntry = _mm_cvtss_f32(nearest);
+#else
+            for (int lane = 0; lane < packet.size; ++lane)
+            {
+                if (activeMask & (1u << lane))
+                {
+                    const GfVec3f invDirection(packet.invX[lane], packet.invY[lane], packet.invZ[lane]);
+                    float laneEntry;
+                    if (Bvh::intersectBox(boundsMin, boundsMax, packet.origin, invDirection, packet.tMax[lane], laneEntry))
+                    {
+                        hitMask |= 1u << lane;
+                        tEntry = std::min(tEntry, laneEntry);
+                    }
+                }
+            }
+#endif
+
+            return hitMask;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3f.h>
+#include <cstdint>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Up to sixteen rays from a common origin in structure-of-arrays layout
+         *
+         * All visibility rays of a viewpoint start at the camera, so a packet
+         * only stores one origin. finalize() precomputes the reciprocal
+         * directions and, when every ray points into the same octant, the
+         * interval of reciprocals over the packet. That interval describes a
+         * frustum enclosing all rays and lets a single test reject a box for
+         * the whole packet.
+         */
+        struct alignas(32) RayPacket
+        {
+            static constexpr int kMaxSize = 16;
+
+            GfVec3f origin;
+            int size = 0;
+
+            float dirX[kMaxSize], dirY[kMaxSize], dirZ[kMaxSize];
+            float invX[kMaxSize], invY[kMaxSize], invZ[kMaxSize];
+            float tMax[kMaxSize];              ///< Ray segment length
+            uint32_t ignoredMesh[kMaxSize];    ///< Mesh each ray is aimed at; never counts as an occluder
+
+            bool isCoherent = false; ///< All rays share direction signs, so the bounds below are valid
+            GfVec3f invMin;          ///< Smallest reciprocal direction per axis
+            GfVec3f invMax;          ///< Largest reciprocal direction per axis
+            float maxTMax = 0.0f;    ///< Longest segment in the packet
+
+            explicit RayPacket(const GfVec3f &rayOrigin);
+
+            /**
+             * @brief Append a ray; the packet must not be full
+             * @param direction Normalized ray direction
+             * @param length Only hits closer than this count
+             * @param ignored Mesh to skip for this ray
+             */
+            void addRay(const GfVec3f &direction, float length, uint32_t ignored);
+
+            /**
+             * @brief Compute reciprocal directions and the packet frustum; call before tracing
+             */
+            void finalize();
+
+            /**
+             * @brief Bit mask with one bit set per ray in the packet
+             */
+            uint32_t getRayMask() const { return (size >= 32) ? ~0u : ((1u << size) - 1u); }
+        };
+
+        /**
+         * @brief Slab test of every active ray of a packet against an axis-aligned box
+         *
+         * Coherent packets are first tested as a whole with interval
+         * arithmetic; only if the packet frustum overlaps the box are the
+         * individual rays tested (8 at a time with AVX2, 4 with SSE).
+         *
+         * @param boundsMin Box minimum
+         * @param boundsMax Box maximum
+         * @param packet Finalized ray packet
+         * @param activeMask Rays to test
+         * @param tEntry Receives the smallest entry distance among the rays that hit
+         * @return Mask of the active rays that overlap the box within [0, tMax]
+         */
+        uint32_t intersectBoxPacket(const GfVec3f &boundsMin, const GfVec3f &boundsMax,
+                                    const RayPacket &packet, uint32_t activeMask, float &tEntry);
+
+    } // namespace optimizer
+} // namespace workbench
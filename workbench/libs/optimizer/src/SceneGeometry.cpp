@@ -0,0 +1,248 @@
+#include "SceneGeometry.h"
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/vt/array.h>
+#include <algorithm>
+#include <limits>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            template <typename T>
+            size_t vectorBytes(const std::vector<T> &values)
+            {
+                return values.capacity() * sizeof(T);
+            }
+
+            /**
+             * @brief Fan-triangulate faces, skipping degenerate faces and bad indices
+             * @param firstPoint Added to every index, so triangles address the global point arrays
+             * @param triangleFaces If given, receives the face index of every appended triangle
+             */
+            void appendTriangles(const VtIntArray &faceVertexCounts, const VtIntArray &faceVertexIndices, size_t pointCount,
+                                 uint32_t firstPoint, std::vector<uint32_t> &triangles,
+                                 std::vector<uint32_t> *triangleFaces = nullptr)
+            {
+                uint32_t face = 0;
+                const int count = static_cast<int>(pointCount);
+                size_t indexOffset = 0;
+                for (int faceVertexCount : faceVertexCounts)
+                {
+                    if (faceVertexCount < 0 || indexOffset + faceVertexCount > faceVertexIndices.size())
+                    {
+                        break;
+                    }
+
+                    for (int i = 1; i + 1 < faceVertexCount; ++i)
+                    {
+                        int a = faceVertexIndices[indexOffset];
+                        int b = faceVertexIndices[indexOffset + i];
+                        int c = faceVertexIndices[indexOffset + i + 1];
+                        if (a < 0 || b < 0 || c < 0 || a >= count || b >= count || c >= count)
+                        {
+                            continue;
+                        }
+                        triangles.push_back(firstPoint + a);
+                        triangles.push_back(firstPoint + b);
+                        triangles.push_back(firstPoint + c);
+                        if (triangleFaces)
+                        {
+                            triangleFaces->push_back(face);
+                        }
+                    }
+
+                    indexOffset += faceVertexCount;
+                    ++face;
+                }
+            }
+        } // namespace
+
+        std::vector<uint32_t> SceneGeometry::mapTrianglesToFaces(const VtIntArray &faceVertexCounts,
+                                                                 const VtIntArray &faceVertexIndices, size_t pointCount)
+        {
+            std::vector<uint32_t> triangles;
+            std::vector<uint32_t> triangleFaces;
+            appendTriangles(faceVertexCounts, faceVertexIndices, pointCount, 0, triangles, &triangleFaces);
+            return triangleFaces;
+        }
+
+        void SceneGeometry::clear()
+        {
+            *this = SceneGeometry();
+        }
+
+        void SceneGeometry::extract(const std::vector<UsdGeomMesh> &meshes, const std::vector<GfMatrix4d> &localToWorld,
+                                    UsdTimeCode timeCode)
+        {
+            clear();
+
+            const size_t meshCount = meshes.size();
+            paths.reserve(meshCount);
+            boundsMinX.resize(meshCount);
+            boundsMinY.resize(meshCount);
+            boundsMinZ.resize(meshCount);
+            boundsMaxX.resize(meshCount);
+            boundsMaxY.resize(meshCount);
+            boundsMaxZ.resize(meshCount);
+            pointOffsets.reserve(meshCount + 1);
+            triangleOffsets.reserve(meshCount + 1);
+            pointOffsets.push_back(0);
+            triangleOffsets.push_back(0);
+
+            VtArray<GfVec3f> points;
+            VtIntArray faceVertexCounts;
+            VtIntArray faceVertexIndices;
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                const UsdGeomMesh &mesh = meshes[meshIndex];
+                paths.push_back(mesh.GetPath());
+
+                mesh.GetPointsAttr().Get(&points, timeCode);
+                mesh.GetFaceVertexCountsAttr().Get(&faceVertexCounts, timeCode);
+                mesh.GetFaceVertexIndicesAttr().Get(&faceVertexIndices, timeCode);
+
+                const uint32_t firstPoint = pointOffsets.back();
+                pointsX.resize(firstPoint + points.size());
+                pointsY.resize(firstPoint + points.size());
+                pointsZ.resize(firstPoint + points.size());
+                storeWorldPoints(meshIndex, points, localToWorld[meshIndex]);
+                appendTriangles(faceVertexCounts, faceVertexIndices, points.size(), firstPoint, triangleIndices);
+
+                pointOffsets.push_back(static_cast<uint32_t>(pointsX.size()));
+                triangleOffsets.push_back(static_cast<uint32_t>(triangleIndices.size() / 3));
+            }
+
+            pointsX.shrink_to_fit();
+            pointsY.shrink_to_fit();
+            pointsZ.shrink_to_fit();
+            triangleIndices.shrink_to_fit();
+        }
+
+        bool SceneGeometry::updateMesh(size_t meshIndex, const UsdGeomMesh &mesh, const GfMatrix4d &localToWorld,
+                                       UsdTimeCode timeCode)
+        {
+            VtArray<GfVec3f> points;
+            VtIntArray faceVertexCounts;
+            VtIntArray faceVertexIndices;
+            mesh.GetPointsAttr().Get(&points, timeCode);
+            mesh.GetFaceVertexCountsAttr().Get(&faceVertexCounts, timeCode);
+            mesh.GetFaceVertexIndicesAttr().Get(&faceVertexIndices, timeCode);
+
+            // Offsets of the following meshes must not move
+            if (points.size() != getPointCount(meshIndex))
+            {
+                return false;
+            }
+            std::vector<uint32_t> triangles;
+            appendTriangles(faceVertexCounts, faceVertexIndices, points.size(), pointOffsets[meshIndex], triangles);
+            if (triangles.size() != 3 * getTriangleCount(meshIndex))
+            {
+                return false;
+            }
+
+            std::copy(triangles.begin(), triangles.end(), triangleIndices.begin() + 3 * triangleOffsets[meshIndex]);
+            storeWorldPoints(meshIndex, points, localToWorld);
+            return true;
+        }
+
+        void SceneGeometry::storeWorldPoints(size_t meshIndex, const VtArray<GfVec3f> &points, const GfMatrix4d &transform)
+        {
+            float minPoint[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+            float maxPoint[3] = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+            uint32_t point = pointOffsets[meshIndex];
+            for (const auto &localPoint : points)
+            {
+                GfVec3f worldPoint(transform.Transform(GfVec3d(localPoint)));
+                pointsX[point] = worldPoint[0];
+                pointsY[point] = worldPoint[1];
+                pointsZ[point] = worldPoint[2];
+                ++point;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    minPoint[axis] = std::min(minPoint[axis], worldPoint[axis]);
+                    maxPoint[axis] = std::max(maxPoint[axis], worldPoint[axis]);
+                }
+            }
+
+            boundsMinX[meshIndex] = minPoint[0];
+            boundsMinY[meshIndex] = minPoint[1];
+            boundsMinZ[meshIndex] = minPoint[2];
+            boundsMaxX[meshIndex] = maxPoint[0];
+            boundsMaxY[meshIndex] = maxPoint[1];
+            boundsMaxZ[meshIndex] = maxPoint[2];
+        }
+
+        void SceneGeometry::append(const SceneGeometry &other)
+        {
+            if (pointOffsets.empty())
+            {
+                pointOffsets.push_back(0);
+                triangleOffsets.push_back(0);
+            }
+            const uint32_t firstPoint = static_cast<uint32_t>(pointsX.size());
+            const uint32_t firstTriangle = static_cast<uint32_t>(triangleIndices.size() / 3);
+
+            paths.insert(paths.end(), other.paths.begin(), other.paths.end());
+            boundsMinX.insert(boundsMinX.end(), other.boundsMinX.begin(), other.boundsMinX.end());
+            boundsMinY.insert(boundsMinY.end(), other.boundsMinY.begin(), other.boundsMinY.end());
+            boundsMinZ.insert(boundsMinZ.end(), other.boundsMinZ.begin(), other.boundsMinZ.end());
+            boundsMaxX.insert(boundsMaxX.end(), other.boundsMaxX.begin(), other.boundsMaxX.end());
+            boundsMaxY.insert(boundsMaxY.end(), other.boundsMaxY.begin(), other.boundsMaxY.end());
+            boundsMaxZ.insert(boundsMaxZ.end(), other.boundsMaxZ.begin(), other.boundsMaxZ.end());
+            pointsX.insert(pointsX.end(), other.pointsX.begin(), other.pointsX.end());
+            pointsY.insert(pointsY.end(), other.pointsY.begin(), other.pointsY.end());
+            pointsZ.insert(pointsZ.end(), other.pointsZ.begin(), other.pointsZ.end());
+
+            // Offsets and indices of the other snapshot start at zero
+            for (size_t mesh = 0; mesh < other.getMeshCount(); ++mesh)
+            {
+                pointOffsets.push_back(firstPoint + other.pointOffsets[mesh + 1]);
+                triangleOffsets.push_back(firstTriangle + other.triangleOffsets[mesh + 1]);
+            }
+            triangleIndices.reserve(triangleIndices.size() + other.triangleIndices.size());
+            for (uint32_t index : other.triangleIndices)
+            {
+                triangleIndices.push_back(firstPoint + index);
+            }
+        }
+
+        GfRange3f SceneGeometry::getBounds(size_t mesh) const
+        {
+            if (boundsMinX[mesh] > boundsMaxX[mesh])
+            {
+                return GfRange3f(); // Mesh without points
+            }
+            return GfRange3f(GfVec3f(boundsMinX[mesh], boundsMinY[mesh], boundsMinZ[mesh]),
+                             GfVec3f(boundsMaxX[mesh], boundsMaxY[mesh], boundsMaxZ[mesh]));
+        }
+
+        std::vector<GfRange3f> SceneGeometry::getAllBounds() const
+        {
+            std::vector<GfRange3f> bounds;
+            bounds.reserve(getMeshCount());
+            for (size_t mesh = 0; mesh < getMeshCount(); ++mesh)
+            {
+                bounds.push_back(getBounds(mesh));
+            }
+            return bounds;
+        }
+
+        size_t SceneGeometry::getMemoryUsage() const
+        {
+            size_t bytes = vectorBytes(paths);
+            bytes += vectorBytes(boundsMinX) + vectorBytes(boundsMinY) + vectorBytes(boundsMinZ);
+            bytes += vectorBytes(boundsMaxX) + vectorBytes(boundsMaxY) + vectorBytes(boundsMaxZ);
+            bytes += vectorBytes(pointsX) + vectorBytes(pointsY) + vectorBytes(pointsZ);
+            bytes += vectorBytes(pointOffsets);
+            bytes += vectorBytes(triangleIndices) + vectorBytes(triangleOffsets);
+            return bytes;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/timeCode.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/vt/array.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Flat, world-space snapshot of mesh geometry
+         *
+         * Extracted once from the stage so that visibility queries never go
+         * through USD value resolution. Everything is stored as structure of
+         * arrays: per-mesh bounds, point coordinates and fan-triangulated
+         * vertex indices. Triangle indices address the global point arrays.
+         */
+        struct SceneGeometry
+        {
+            std::vector<SdfPath> paths;
+
+            // World-space bounds, one entry per mesh
+            std::vector<float> boundsMinX, boundsMinY, boundsMinZ;
+            std::vector<float> boundsMaxX, boundsMaxY, boundsMaxZ;
+
+            // World-space points of all meshes; mesh i owns [pointOffsets[i], pointOffsets[i + 1])
+            std::vector<float> pointsX, pointsY, pointsZ;
+            std::vector<uint32_t> pointOffsets;
+
+            // Three indices per triangle; mesh i owns triangles [triangleOffsets[i], triangleOffsets[i + 1])
+            std::vector<uint32_t> triangleIndices;
+            std::vector<uint32_t> triangleOffsets;
+
+            /**
+             * @brief Copy bounds, points and triangles of every mesh into the snapshot
+             * @param meshes The meshes to extract, in the order they will be indexed
+             * @param localToWorld World transform of each mesh, e.g. from WorldSpaceCache
+             * @param timeCode Time at which points and topology are read
+             */
+            void extract(const std::vector<UsdGeomMesh> &meshes, const std::vector<GfMatrix4d> &localToWorld,
+                         UsdTimeCode timeCode = UsdTimeCode::Default());
+
+            /**
+             * @brief Re-read one mesh in place after its points or transform changed
+             *
+             * Offsets of all meshes stay the same, so this only succeeds if
+             * the mesh keeps its point and triangle counts.
+             *
+             * @return False if the counts changed; the snapshot is left untouched and must be extracted again
+             */
+            bool updateMesh(size_t meshIndex, const UsdGeomMesh &mesh, const GfMatrix4d &localToWorld,
+                            UsdTimeCode timeCode = UsdTimeCode::Default());
+
+            /**
+             * @brief Add the meshes of another snapshot after the existing ones
+             *
+             * Lets a snapshot be assembled piece by piece, e.g. one payload
+             * at a time, without keeping the source prims loaded.
+             */
+            void append(const SceneGeometry &other);
+
+            void clear();
+
+            /**
+             * @brief Face of a mesh each of its snapshot triangles came from
+             *
+             * Triangulates like extract(), so entry i belongs to the mesh's
+             * i-th triangle; faces that were skipped have no triangles.
+             */
+            static std::vector<uint32_t> mapTrianglesToFaces(const VtIntArray &faceVertexCounts,
+                                                             const VtIntArray &faceVertexIndices, size_t pointCount);
+
+            size_t getMeshCount() const { return paths.size(); }
+            size_t getPointCount(size_t mesh) const { return pointOffsets[mesh + 1] - pointOffsets[mesh]; }
+            size_t getTriangleCount(size_t mesh) const { return triangleOffsets[mesh + 1] - triangleOffsets[mesh]; }
+            size_t getTotalTriangleCount() const { return triangleIndices.size() / 3; }
+
+            GfRange3f getBounds(size_t mesh) const;
+            GfVec3f getPoint(uint32_t point) const { return GfVec3f(pointsX[point], pointsY[point], pointsZ[point]); }
+
+            /**
+             * @brief Bounds of every mesh as ranges, e.g. for building a BVH
+             */
+            std::vector<GfRange3f> getAllBounds() const;
+
+            /**
+             * @brief Bytes held by the snapshot buffers
+             */
+            size_t getMemoryUsage() const;
+
+        private:
+            /**
+             * @brief Transform points into the mesh's slot of the point arrays and update its bounds
+             */
+            void storeWorldPoints(size_t meshIndex, const VtArray<GfVec3f> &points, const GfMatrix4d &transform);
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,238 @@
+#include "SceneInstances.h"
+#include "WorldSpaceCache.h"
+#include <pxr/usd/usd/primRange.h>
+#include <pxr/base/gf/bbox3d.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/vt/array.h>
+#include <algorithm>
+#include <unordered_map>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            template <typename T>
+            size_t vectorBytes(const std::vector<T> &values)
+            {
+                return values.capacity() * sizeof(T);
+            }
+        } // namespace
+
+        void SceneInstances::clear()
+        {
+            *this = SceneInstances();
+        }
+
+        void SceneInstances::extract(const std::vector<UsdGeomMesh> &instanceProxies,
+                                     const std::vector<UsdGeomPointInstancer> &instancers,
+                                     const WorldSpaceCache &worldCache)
+        {
+            clear();
+
+            // One prototype per distinct source mesh; proxies resolve to the mesh inside their prototype
+            std::vector<UsdGeomMesh> prototypeMeshes;
+            std::unordered_map<SdfPath, uint32_t, SdfPath::Hash> prototypeByPath;
+            auto findPrototype = [&](const UsdPrim &meshPrim)
+            {
+                const UsdPrim source = meshPrim.IsInstanceProxy() ? meshPrim.GetPrimInPrototype() : meshPrim;
+                auto inserted = prototypeByPath.emplace(source.GetPath(), static_cast<uint32_t>(prototypeMeshes.size()));
+                if (inserted.second)
+                {
+                    prototypeMeshes.emplace_back(source);
+                    sources.push_back(source.GetPath());
+                }
+                return inserted.first->second;
+            };
+
+            const std::vector<GfMatrix4d> proxyTransforms = worldCache.computeLocalToWorld(instanceProxies);
+            for (size_t i = 0; i < instanceProxies.size(); ++i)
+            {
+                prototypeIndices.push_back(findPrototype(instanceProxies[i].GetPrim()));
+                localToWorld.push_back(proxyTransforms[i]);
+                sources.push_back(instanceProxies[i].GetPath());
+            }
+
+            const UsdTimeCode time = worldCache.getTime();
+            const std::vector<GfMatrix4d> instancerTransforms = worldCache.computeLocalToWorld(instancers);
+            for (size_t instancerIndex = 0; instancerIndex < instancers.size(); ++instancerIndex)
+            {
+                const UsdGeomPointInstancer &instancer = instancers[instancerIndex];
+                sources.push_back(instancer.GetPath());
+
+                // The root's own transform is part of the instance transforms, so parts are relative to it
+                SdfPathVector targets;
+                instancer.GetPrototypesRel().GetTargets(&targets);
+                std::vector<std::vector<std::pair<uint32_t, GfMatrix4d>>> prototypeParts(targets.size());
+                for (size_t target = 0; target < targets.size(); ++target)
+                {
+                    const UsdPrim root = instancer.GetPrim().GetStage()->GetPrimAtPath(targets[target]);
+                    if (!root)
+                    {
+                        continue;
+                    }
+
+                    std::vector<UsdGeomMesh> parts;
+                    for (const UsdPrim &prim : UsdPrimRange(root, UsdTraverseInstanceProxies()))
+                    {
+                        if (prim.IsA<UsdGeomMesh>())
+                        {
+                            parts.emplace_back(prim);
+                        }
+                    }
+
+                    const GfMatrix4d worldToRoot = worldCache.computeLocalToWorld(std::vector<UsdPrim>{root})[0].GetInverse();
+                    const std::vector<GfMatrix4d> partTransforms = worldCache.computeLocalToWorld(parts);
+                    for (size_t part = 0; part < parts.size(); ++part)
+                    {
+                        prototypeParts[target].emplace_back(findPrototype(parts[part].GetPrim()), partTransforms[part] * worldToRoot);
+                    }
+                }
+
+                VtIntArray protoIndices;
+                VtArray<GfMatrix4d> instanceTransforms;
+                if (!instancer.GetProtoIndicesAttr().Get(&protoIndices, time) ||
+                    !instancer.ComputeInstanceTransformsAtTime(&instanceTransforms, time, time,
+                                                               UsdGeomPointInstancer::IncludeProtoXform,
+                                                               UsdGeomPointInstancer::IgnoreMask))
+                {
+                    continue;
+                }
+
+                const std::vector<bool> mask = instancer.ComputeMaskAtTime(time);
+                for (size_t entry = 0; entry < instanceTransforms.size() && entry < protoIndices.size(); ++entry)
+                {
+                    const int target = protoIndices[entry];
+                    if ((!mask.empty() && !mask[entry]) || target < 0 || static_cast<size_t>(target) >= prototypeParts.size())
+                    {
+                        continue;
+                    }
+
+                    const GfMatrix4d instanceToWorld = instanceTransforms[entry] * instancerTransforms[instancerIndex];
+                    for (const auto &part : prototypeParts[target])
+                    {
+                        prototypeIndices.push_back(part.first);
+                        localToWorld.push_back(part.second * instanceToWorld);
+                    }
+                }
+            }
+
+            prototypes.extract(prototypeMeshes, std::vector<GfMatrix4d>(prototypeMeshes.size(), GfMatrix4d(1.0)), time);
+
+            const size_t instanceCount = prototypeIndices.size();
+            boundsMinX.reserve(instanceCount);
+            boundsMinY.reserve(instanceCount);
+            boundsMinZ.reserve(instanceCount);
+            boundsMaxX.reserve(instanceCount);
+            boundsMaxY.reserve(instanceCount);
+            boundsMaxZ.reserve(instanceCount);
+            for (size_t instance = 0; instance < instanceCount; ++instance)
+            {
+                addInstance(prototypeIndices[instance], localToWorld[instance]);
+            }
+        }
+
+        bool SceneInstances::updatePlacements(const std::vector<UsdGeomMesh> &instanceProxies,
+                                              const std::vector<UsdGeomPointInstancer> &instancers,
+                                              const WorldSpaceCache &worldCache)
+        {
+            SceneInstances current;
+            current.extract(instanceProxies, instancers, worldCache);
+            if (current.prototypeIndices != prototypeIndices ||
+                current.prototypes.pointsX != prototypes.pointsX ||
+                current.prototypes.pointsY != prototypes.pointsY ||
+                current.prototypes.pointsZ != prototypes.pointsZ ||
+                current.prototypes.triangleIndices != prototypes.triangleIndices)
+            {
+                return false;
+            }
+
+            localToWorld.swap(current.localToWorld);
+            boundsMinX.swap(current.boundsMinX);
+            boundsMinY.swap(current.boundsMinY);
+            boundsMinZ.swap(current.boundsMinZ);
+            boundsMaxX.swap(current.boundsMaxX);
+            boundsMaxY.swap(current.boundsMaxY);
+            boundsMaxZ.swap(current.boundsMaxZ);
+            return true;
+        }
+
+        void SceneInstances::append(const SceneInstances &other)
+        {
+            const uint32_t firstPrototype = static_cast<uint32_t>(prototypes.getMeshCount());
+            prototypes.append(other.prototypes);
+            for (uint32_t prototype : other.prototypeIndices)
+            {
+                prototypeIndices.push_back(firstPrototype + prototype);
+            }
+            localToWorld.insert(localToWorld.end(), other.localToWorld.begin(), other.localToWorld.end());
+            sources.insert(sources.end(), other.sources.begin(), other.sources.end());
+            boundsMinX.insert(boundsMinX.end(), other.boundsMinX.begin(), other.boundsMinX.end());
+            boundsMinY.insert(boundsMinY.end(), other.boundsMinY.begin(), other.boundsMinY.end());
+            boundsMinZ.insert(boundsMinZ.end(), other.boundsMinZ.begin(), other.boundsMinZ.end());
+            boundsMaxX.insert(boundsMaxX.end(), other.boundsMaxX.begin(), other.boundsMaxX.end());
+            boundsMaxY.insert(boundsMaxY.end(), other.boundsMaxY.begin(), other.boundsMaxY.end());
+            boundsMaxZ.insert(boundsMaxZ.end(), other.boundsMaxZ.begin(), other.boundsMaxZ.end());
+        }
+
+        void SceneInstances::addInstance(uint32_t prototype, const GfMatrix4d &transform)
+        {
+            GfRange3f bounds;
+            const GfRange3f local = prototypes.getBounds(prototype);
+            if (!local.IsEmpty())
+            {
+                const GfRange3d world = GfBBox3d(GfRange3d(GfVec3d(local.GetMin()), GfVec3d(local.GetMax())), transform).ComputeAlignedRange();
+                bounds = GfRange3f(GfVec3f(world.GetMin()), GfVec3f(world.GetMax()));
+            }
+
+            boundsMinX.push_back(bounds.GetMin()[0]);
+            boundsMinY.push_back(bounds.GetMin()[1]);
+            boundsMinZ.push_back(bounds.GetMin()[2]);
+            boundsMaxX.push_back(bounds.GetMax()[0]);
+            boundsMaxY.push_back(bounds.GetMax()[1]);
+            boundsMaxZ.push_back(bounds.GetMax()[2]);
+        }
+
+        bool SceneInstances::isAffectedBy(const SdfPath &path) const
+        {
+            return std::any_of(sources.begin(), sources.end(),
+                               [&](const SdfPath &source)
+                               { return source.HasPrefix(path) || path.HasPrefix(source); });
+        }
+
+        GfRange3f SceneInstances::getBounds(size_t instance) const
+        {
+            if (boundsMinX[instance] > boundsMaxX[instance])
+            {
+                return GfRange3f(); // Prototype without points
+            }
+            return GfRange3f(GfVec3f(boundsMinX[instance], boundsMinY[instance], boundsMinZ[instance]),
+                             GfVec3f(boundsMaxX[instance], boundsMaxY[instance], boundsMaxZ[instance]));
+        }
+
+        std::vector<GfRange3f> SceneInstances::getAllBounds() const
+        {
+            std::vector<GfRange3f> bounds;
+            bounds.reserve(getInstanceCount());
+            for (size_t instance = 0; instance < getInstanceCount(); ++instance)
+            {
+                bounds.push_back(getBounds(instance));
+            }
+            return bounds;
+        }
+
+        size_t SceneInstances::getMemoryUsage() const
+        {
+            size_t bytes = prototypes.getMemoryUsage();
+            bytes += vectorBytes(prototypeIndices) + vectorBytes(localToWorld) + vectorBytes(sources);
+            bytes += vectorBytes(boundsMinX) + vectorBytes(boundsMinY) + vectorBytes(boundsMinZ);
+            bytes += vectorBytes(boundsMaxX) + vectorBytes(boundsMaxY) + vectorBytes(boundsMaxZ);
+            return bytes;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include <pxr/pxr.h>
+#include <pxr/usd/usdGeom/mesh.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/usd/sdf/path.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        class WorldSpaceCache;
+
+        /**
+         * @brief Instanced geometry that occludes other meshes without being analysed itself
+         *
+         * Meshes inside native instances (instance proxies) and the meshes of
+         * UsdGeomPointInstancer prototypes are stored once each, in their own
+         * local space, in a prototype snapshot. Every placement of a prototype
+         * mesh is an instance: a prototype index, a local-to-world transform
+         * and world-space bounds. A hundred thousand copies of one bolt cost
+         * the bolt's triangles once plus a transform per copy.
+         */
+        struct SceneInstances
+        {
+            SceneGeometry prototypes;               ///< Prototype meshes in their local space
+            std::vector<uint32_t> prototypeIndices; ///< Prototype mesh of each instance
+            std::vector<GfMatrix4d> localToWorld;   ///< Placement of each instance
+            std::vector<SdfPath> sources;           ///< Proxies, instancers and prototype meshes the instances were read from
+
+            // World-space bounds, one entry per instance, laid out like SceneGeometry's
+            std::vector<float> boundsMinX, boundsMinY, boundsMinZ;
+            std::vector<float> boundsMaxX, boundsMaxY, boundsMaxZ;
+
+            /**
+             * @brief Collect prototypes and place every instance of them
+             *
+             * Native instance proxies share the mesh of their prototype and
+             * are placed by their own world transform. Point instancer entries
+             * place every mesh below their prototype root; entries hidden
+             * through invisibleIds are skipped.
+             *
+             * @param instanceProxies Meshes found below native instances
+             * @param instancers Point instancers whose prototypes are not analysed as meshes
+             * @param worldCache Provides world transforms and the time to read at
+             */
+            void extract(const std::vector<UsdGeomMesh> &instanceProxies,
+                         const std::vector<UsdGeomPointInstancer> &instancers,
+                         const WorldSpaceCache &worldCache);
+
+            /**
+             * @brief Re-read instance placements at the cache's time, keeping the prototypes
+             *
+             * @return False, leaving the instances untouched, if the set of
+             *         instances or the prototype geometry changed; call
+             *         extract() and rebuild the BVHs instead
+             */
+            bool updatePlacements(const std::vector<UsdGeomMesh> &instanceProxies,
+                                  const std::vector<UsdGeomPointInstancer> &instancers,
+                                  const WorldSpaceCache &worldCache);
+
+            /**
+             * @brief Add the prototypes and instances of another set after the existing ones
+             *
+             * Prototypes are not shared between the two sets, so a mesh
+             * instanced in both is stored twice.
+             */
+            void append(const SceneInstances &other);
+
+            void clear();
+
+            size_t getInstanceCount() const { return prototypeIndices.size(); }
+
+            /**
+             * @brief Whether an edit at path can move or reshape any instance
+             *
+             * True if the path is a source, an ancestor of one or lies below one.
+             */
+            bool isAffectedBy(const SdfPath &path) const;
+            GfRange3f getBounds(size_t instance) const;
+
+            /**
+             * @brief Bounds of every instance as ranges, e.g. for building a BVH
+             */
+            std::vector<GfRange3f> getAllBounds() const;
+
+            /**
+             * @brief Bytes held by the prototypes and the instance arrays
+             */
+            size_t getMemoryUsage() const;
+
+        private:
+            void addInstance(uint32_t prototype, const GfMatrix4d &transform);
+        };
+
+    } // namespace optimizer
+} // namespace workbench
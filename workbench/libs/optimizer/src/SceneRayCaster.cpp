@@ -0,0 +1,373 @@
+#include "SceneRayCaster.h"
+#include <pxr/base/work/loops.h>
+#include <algorithm>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            // Eight triangles per leaf fill exactly one SIMD packet
+            constexpr uint32_t kTrianglesPerLeaf = TrianglePacket8::kWidth;
+
+            /**
+             * @brief Top-level bounds: meshes first, then instances
+             */
+            std::vector<GfRange3f> collectBounds(const SceneGeometry &geometry, const SceneInstances &instances)
+            {
+                std::vector<GfRange3f> bounds = geometry.getAllBounds();
+                const std::vector<GfRange3f> instanceBounds = instances.getAllBounds();
+                bounds.insert(bounds.end(), instanceBounds.begin(), instanceBounds.end());
+                return bounds;
+            }
+
+            /**
+             * @brief Move a prototype-space normal into world space with the inverse transpose
+             */
+            GfVec3f transformNormal(const GfMatrix4f &worldToLocal, const GfVec3f &normal)
+            {
+                // Row vectors: world normal = normal * transpose(worldToLocal) over the upper 3x3
+                return GfVec3f(worldToLocal[0][0] * normal[0] + worldToLocal[0][1] * normal[1] + worldToLocal[0][2] * normal[2],
+                               worldToLocal[1][0] * normal[0] + worldToLocal[1][1] * normal[1] + worldToLocal[1][2] * normal[2],
+                               worldToLocal[2][0] * normal[0] + worldToLocal[2][1] * normal[1] + worldToLocal[2][2] * normal[2]);
+            }
+        } // namespace
+
+        void SceneRayCaster::build(const SceneGeometry &geometry, const SceneInstances &instances)
+        {
+            m_meshBvhs.clear();
+            m_prototypeBvhs.clear();
+            m_instances.clear();
+            m_packets.clear();
+
+            m_sceneBvh.build(collectBounds(geometry, instances));
+
+            m_meshBvhs.resize(geometry.getMeshCount());
+            for (size_t mesh = 0; mesh < m_meshBvhs.size(); ++mesh)
+            {
+                buildMeshBvh(geometry, mesh, m_meshBvhs[mesh]);
+            }
+
+            // Each prototype is built once, however many instances place it
+            m_prototypeBvhs.resize(instances.prototypes.getMeshCount());
+            for (size_t prototype = 0; prototype < m_prototypeBvhs.size(); ++prototype)
+            {
+                buildMeshBvh(instances.prototypes, prototype, m_prototypeBvhs[prototype]);
+            }
+
+            m_instances.resize(instances.getInstanceCount());
+            for (size_t instance = 0; instance < m_instances.size(); ++instance)
+            {
+                m_instances[instance].worldToLocal = GfMatrix4f(instances.localToWorld[instance].GetInverse());
+                m_instances[instance].prototype = instances.prototypeIndices[instance];
+            }
+
+            m_packets.shrink_to_fit();
+        }
+
+        void SceneRayCaster::buildMeshBvh(const SceneGeometry &geometry, size_t mesh, MeshBvh &meshBvh)
+        {
+            const uint32_t firstTriangle = geometry.triangleOffsets[mesh];
+            std::vector<GfRange3f> triangleBounds;
+            computeTriangleBounds(geometry, mesh, triangleBounds);
+            meshBvh.bvh.build(triangleBounds, kTrianglesPerLeaf);
+
+            // Pack the triangles of every leaf into consecutive SIMD packets
+            const auto &nodes = meshBvh.bvh.getNodes();
+            const auto &slots = meshBvh.bvh.getPrimitiveIndices();
+            meshBvh.nodePackets.assign(nodes.size(), 0);
+            for (size_t node = 0; node < nodes.size(); ++node)
+            {
+                if (!nodes[node].isLeaf())
+                {
+                    continue;
+                }
+
+                meshBvh.nodePackets[node] = static_cast<uint32_t>(m_packets.size());
+                for (uint32_t i = 0; i < nodes[node].primitiveCount; ++i)
+                {
+                    int lane = static_cast<int>(i % TrianglePacket8::kWidth);
+                    if (lane == 0)
+                    {
+                        m_packets.emplace_back();
+                    }
+
+                    uint32_t triangle = firstTriangle + slots[nodes[node].firstOrChild + i];
+                    const uint32_t *indices = &geometry.triangleIndices[3 * triangle];
+                    m_packets.back().setTriangle(lane, geometry.getPoint(indices[0]), geometry.getPoint(indices[1]),
+                                                 geometry.getPoint(indices[2]), triangle);
+                }
+            }
+        }
+
+        void SceneRayCaster::refit(const SceneGeometry &geometry, const SceneInstances &instances,
+                                   const std::vector<uint32_t> &changedMeshes)
+        {
+            // Each mesh owns its BVH and the packets of its leaves, so meshes refit independently
+            WorkParallelForN(
+                changedMeshes.size(),
+                [&](size_t begin, size_t end)
+                {
+                    std::vector<GfRange3f> triangleBounds;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const uint32_t mesh = changedMeshes[i];
+                        computeTriangleBounds(geometry, mesh, triangleBounds);
+                        MeshBvh &meshBvh = m_meshBvhs[mesh];
+                        meshBvh.bvh.refit(triangleBounds);
+
+                        // Leaves keep their triangles, so only the packed coordinates change
+                        const uint32_t firstTriangle = geometry.triangleOffsets[mesh];
+                        const auto &nodes = meshBvh.bvh.getNodes();
+                        const auto &slots = meshBvh.bvh.getPrimitiveIndices();
+                        for (size_t node = 0; node < nodes.size(); ++node)
+                        {
+                            if (!nodes[node].isLeaf())
+                            {
+                                continue;
+                            }
+                            for (uint32_t slot = 0; slot < nodes[node].primitiveCount; ++slot)
+                            {
+                                uint32_t triangle = firstTriangle + slots[nodes[node].firstOrChild + slot];
+                                const uint32_t *indices = &geometry.triangleIndices[3 * triangle];
+                                m_packets[meshBvh.nodePackets[node] + slot / TrianglePacket8::kWidth].setTriangle(
+                                    static_cast<int>(slot % TrianglePacket8::kWidth), geometry.getPoint(indices[0]),
+                                    geometry.getPoint(indices[1]), geometry.getPoint(indices[2]), triangle);
+                            }
+                        }
+                    }
+                });
+
+            for (size_t instance = 0; instance < m_instances.size(); ++instance)
+            {
+                m_instances[instance].worldToLocal = GfMatrix4f(instances.localToWorld[instance].GetInverse());
+            }
+
+            m_sceneBvh.refit(collectBounds(geometry, instances));
+        }
+
+        void SceneRayCaster::computeTriangleBounds(const SceneGeometry &geometry, size_t mesh, std::vector<GfRange3f> &triangleBounds)
+        {
+            const uint32_t firstTriangle = geometry.triangleOffsets[mesh];
+            const size_t triangleCount = geometry.getTriangleCount(mesh);
+
+            triangleBounds.clear();
+            triangleBounds.reserve(triangleCount);
+            for (size_t i = 0; i < triangleCount; ++i)
+            {
+                const uint32_t *indices = &geometry.triangleIndices[3 * (firstTriangle + i)];
+                GfRange3f bounds;
+                bounds.UnionWith(geometry.getPoint(indices[0]));
+                bounds.UnionWith(geometry.getPoint(indices[1]));
+                bounds.UnionWith(geometry.getPoint(indices[2]));
+                triangleBounds.push_back(bounds);
+            }
+        }
+
+        bool SceneRayCaster::intersectPrimitive(uint32_t primitive, const GfVec3f &origin, const GfVec3f &direction,
+                                                float &tMax, bool anyHit, Hit *hit) const
+        {
+            if (primitive < m_meshBvhs.size())
+            {
+                return intersectMesh(m_meshBvhs[primitive], origin, direction, tMax, anyHit, hit);
+            }
+
+            // The direction is not renormalized, so distances stay in world units
+            const Instance &instance = m_instances[primitive - m_meshBvhs.size()];
+            if (!intersectMesh(m_prototypeBvhs[instance.prototype], instance.worldToLocal.Transform(origin),
+                               instance.worldToLocal.TransformDir(direction), tMax, anyHit, hit))
+            {
+                return false;
+            }
+            if (hit)
+            {
+                hit->normal = transformNormal(instance.worldToLocal, hit->normal);
+            }
+            return true;
+        }
+
+        bool SceneRayCaster::intersectMesh(const MeshBvh &meshBvh, const GfVec3f &origin, const GfVec3f &direction,
+                                           float &tMax, bool anyHit, Hit *hit) const
+        {
+            bool found = false;
+            float nearest = tMax;
+
+            meshBvh.bvh.traverseRay(origin, direction, tMax,
+                                    [&](uint32_t nodeIndex, const Bvh::Node &leaf, float &currentTMax)
+                                    {
+                                        uint32_t first = meshBvh.nodePackets[nodeIndex];
+                                        uint32_t packetCount = (leaf.primitiveCount + TrianglePacket8::kWidth - 1) / TrianglePacket8::kWidth;
+                                        for (uint32_t packet = first; packet < first + packetCount; ++packet)
+                                        {
+                                            int lane;
+                                            float distance = intersectTrianglePacket(m_packets[packet], origin, direction, currentTMax, lane);
+                                            if (lane < 0)
+                                            {
+                                                continue;
+                                            }
+
+                                            found = true;
+                                            currentTMax = distance;
+                                            nearest = distance;
+                                            if (hit)
+                                            {
+                                                const TrianglePacket8 &triangles = m_packets[packet];
+                                                hit->triangle = triangles.triangle[lane];
+                                                hit->normal = GfCross(GfVec3f(triangles.e1x[lane], triangles.e1y[lane], triangles.e1z[lane]),
+                                                                      GfVec3f(triangles.e2x[lane], triangles.e2y[lane], triangles.e2z[lane]));
+                                            }
+                                            if (anyHit)
+                                            {
+                                                return true;
+                                            }
+                                        }
+                                        return false;
+                                    });
+
+            tMax = nearest;
+            return found;
+        }
+
+        bool SceneRayCaster::isOccluded(const GfVec3f &origin, const GfVec3f &direction, float maxDistance,
+                                        uint32_t ignoredMesh) const
+        {
+            return m_sceneBvh.intersectRay(origin, direction, maxDistance,
+                                           [&](uint32_t primitive, float &tMax)
+                                           {
+                                               if (primitive == ignoredMesh)
+                                               {
+                                                   return false;
+                                               }
+                                               float primitiveTMax = tMax;
+                                               return intersectPrimitive(primitive, origin, direction, primitiveTMax, true, nullptr);
+                                           });
+        }
+
+        uint32_t SceneRayCaster::findOccluded(const RayPacket &packet) const
+        {
+            const std::vector<uint32_t> &primitiveSlots = m_sceneBvh.getPrimitiveIndices();
+            return m_sceneBvh.traversePacket(packet, packet.getRayMask(),
+                                             [&](uint32_t, const Bvh::Node &leaf, uint32_t rayMask)
+                                             {
+                                                 uint32_t occluded = 0;
+                                                 for (uint32_t i = 0; i < leaf.primitiveCount; ++i)
+                                                 {
+                                                     const uint32_t primitive = primitiveSlots[leaf.firstOrChild + i];
+
+                                                     // A mesh never occludes the rays aimed at it
+                                                     uint32_t primitiveRays = rayMask & ~occluded;
+                                                     for (int lane = 0; lane < packet.size; ++lane)
+                                                     {
+                                                         if (packet.ignoredMesh[lane] == primitive)
+                                                         {
+                                                             primitiveRays &= ~(1u << lane);
+                                                         }
+                                                     }
+
+                                                     if (primitiveRays != 0)
+                                                     {
+                                                         occluded |= findOccludedInPrimitive(primitive, packet, primitiveRays);
+                                                     }
+                                                 }
+                                                 return occluded;
+                                             });
+        }
+
+        uint32_t SceneRayCaster::findOccludedInPrimitive(uint32_t primitive, const RayPacket &packet, uint32_t rayMask) const
+        {
+            if (primitive < m_meshBvhs.size())
+            {
+                return findOccludedInMesh(m_meshBvhs[primitive], packet, rayMask);
+            }
+
+            // Rebuild the packet in prototype space; lanes keep their positions so the mask still applies
+            const Instance &instance = m_instances[primitive - m_meshBvhs.size()];
+            RayPacket localPacket(instance.worldToLocal.Transform(packet.origin));
+            for (int lane = 0; lane < packet.size; ++lane)
+            {
+                localPacket.addRay(instance.worldToLocal.TransformDir(GfVec3f(packet.dirX[lane], packet.dirY[lane], packet.dirZ[lane])),
+                                   packet.tMax[lane], packet.ignoredMesh[lane]);
+            }
+            localPacket.finalize();
+            return findOccludedInMesh(m_prototypeBvhs[instance.prototype], localPacket, rayMask);
+        }
+
+        uint32_t SceneRayCaster::findOccludedInMesh(const MeshBvh &meshBvh, const RayPacket &packet, uint32_t rayMask) const
+        {
+            return meshBvh.bvh.traversePacket(packet, rayMask,
+                                              [&](uint32_t nodeIndex, const Bvh::Node &leaf, uint32_t leafRays)
+                                              {
+                                                  uint32_t first = meshBvh.nodePackets[nodeIndex];
+                                                  uint32_t packetCount = (leaf.primitiveCount + TrianglePacket8::kWidth - 1) / TrianglePacket8::kWidth;
+
+                                                  // The leaf's triangles stay in cache while each ray is tested against them
+                                                  uint32_t hits = 0;
+                                                  for (int lane = 0; lane < packet.size; ++lane)
+                                                  {
+                                                      if (!(leafRays & (1u << lane)))
+                                                      {
+                                                          continue;
+                                                      }
+
+                                                      const GfVec3f direction(packet.dirX[lane], packet.dirY[lane], packet.dirZ[lane]);
+                                                      for (uint32_t trianglePacket = first; trianglePacket < first + packetCount; ++trianglePacket)
+                                                      {
+                                                          int hitLane;
+                                                          intersectTrianglePacket(m_packets[trianglePacket], packet.origin, direction, packet.tMax[lane], hitLane);
+                                                          if (hitLane >= 0)
+                                                          {
+                                                              hits |= 1u << lane;
+                                                              break;
+                                                          }
+                                                      }
+                                                  }
+                                                  return hits;
+                                              });
+        }
+
+        bool SceneRayCaster::intersect(const GfVec3f &origin, const GfVec3f &direction, float maxDistance,
+                                       Hit &hit, uint32_t ignoredMesh) const
+        {
+            hit = Hit();
+            m_sceneBvh.intersectRay(origin, direction, maxDistance,
+                                    [&](uint32_t primitive, float &tMax)
+                                    {
+                                        if (primitive == ignoredMesh)
+                                        {
+                                            return false;
+                                        }
+                                        float primitiveTMax = tMax;
+                                        Hit primitiveHit;
+                                        if (intersectPrimitive(primitive, origin, direction, primitiveTMax, false, &primitiveHit))
+                                        {
+                                            // Shrinking tMax prunes every mesh behind this hit
+                                            tMax = primitiveTMax;
+                                            hit = primitiveHit;
+                                            hit.mesh = primitive;
+                                            hit.distance = primitiveTMax;
+                                        }
+                                        return false;
+                                    });
+            return hit.mesh != kNoMesh;
+        }
+
+        size_t SceneRayCaster::getMemoryUsage() const
+        {
+            size_t bytes = m_sceneBvh.getMemoryUsage() + m_packets.capacity() * sizeof(TrianglePacket8);
+            for (const auto &meshBvh : m_meshBvhs)
+            {
+                bytes += meshBvh.bvh.getMemoryUsage() + meshBvh.nodePackets.capacity() * sizeof(uint32_t);
+            }
+            for (const auto &prototypeBvh : m_prototypeBvhs)
+            {
+                bytes += prototypeBvh.bvh.getMemoryUsage() + prototypeBvh.nodePackets.capacity() * sizeof(uint32_t);
+            }
+            return bytes + m_instances.capacity() * sizeof(Instance);
+        }
+
+    } // namespace optimizer
+} // namespace workbench
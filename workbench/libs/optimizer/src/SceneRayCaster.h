@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Bvh.h"
+#include "RayPacket.h"
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include "TriangleIntersector.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/matrix4f.h>
+#include <pxr/base/gf/vec3f.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Triangle-accurate ray queries against a SceneGeometry snapshot
+         *
+         * Uses two levels of BVH: a top level over the world bounds of every
+         * mesh and instance, and a bottom level per mesh and per instance
+         * prototype over its triangles. Instances share their prototype's
+         * bottom-level BVH; rays are moved into prototype space with the
+         * instance's inverse transform, so copies cost no triangle memory.
+         * Triangles of each leaf are packed into TrianglePacket8 blocks and
+         * tested with the SIMD kernel, so every query reports real hit
+         * distances instead of bounding box overlap.
+         *
+         * Top-level primitives are the meshes of the SceneGeometry, followed
+         * by the instances: instance i has the id getMeshCount() + i. Meshes
+         * ignored by a query are always given by their mesh index.
+         */
+        class SceneRayCaster
+        {
+        public:
+            static constexpr uint32_t kNoMesh = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * @brief Nearest intersection found by intersect()
+             */
+            struct Hit
+            {
+                uint32_t mesh = kNoMesh; ///< Top-level id of the mesh or instance hit
+                uint32_t triangle = 0;   ///< Triangle index in the geometry snapshot, or in the prototypes for instances
+                float distance = std::numeric_limits<float>::infinity();
+                GfVec3f normal = GfVec3f(0.0f); ///< World-space geometric normal of the triangle, not normalized
+            };
+
+            /**
+             * @brief Build both BVH levels and the triangle packets
+             * @param geometry Snapshot to copy triangles from; not referenced afterwards
+             * @param instances Instanced occluders; one bottom-level BVH is built per prototype
+             */
+            void build(const SceneGeometry &geometry, const SceneInstances &instances);
+
+            /**
+             * @brief Follow meshes that moved or deformed without rebuilding
+             *
+             * Refits the triangle BVHs of the given meshes in parallel and
+             * rewrites their triangle packets, takes over the current instance
+             * placements, then refits the top-level BVH. Every mesh must keep
+             * the triangle count it had in build().
+             *
+             * @param geometry The snapshot passed to build(), after SceneGeometry::updateMesh()
+             * @param instances The instances passed to build(), possibly after SceneInstances::updatePlacements()
+             * @param changedMeshes Meshes whose points changed
+             */
+            void refit(const SceneGeometry &geometry, const SceneInstances &instances, const std::vector<uint32_t> &changedMeshes);
+
+            /**
+             * @brief Test whether any triangle lies on a ray segment
+             * @param origin Ray origin
+             * @param direction Normalized ray direction
+             * @param maxDistance Only hits closer than this count
+             * @param ignoredMesh Mesh to skip, typically the one being tested
+             * @return True if a triangle of another mesh is hit before maxDistance
+             */
+            bool isOccluded(const GfVec3f &origin, const GfVec3f &direction, float maxDistance,
+                            uint32_t ignoredMesh = kNoMesh) const;
+
+            /**
+             * @brief Test a packet of rays sharing one origin for occlusion
+             *
+             * Equivalent to calling isOccluded() for every ray of the packet,
+             * but the packet traverses both BVH levels together, so nodes near
+             * the viewpoint are loaded and tested once for all of its rays.
+             *
+             * @param packet Finalized packet; each ray skips its ignoredMesh
+             * @return Mask of the rays that hit a triangle before their tMax
+             */
+            uint32_t findOccluded(const RayPacket &packet) const;
+
+            /**
+             * @brief Find the nearest triangle hit along a ray
+             * @param origin Ray origin
+             * @param direction Normalized ray direction
+             * @param maxDistance Only hits closer than this count
+             * @param hit Receives the nearest hit
+             * @param ignoredMesh Mesh to skip
+             * @return True if anything was hit
+             */
+            bool intersect(const GfVec3f &origin, const GfVec3f &direction, float maxDistance,
+                           Hit &hit, uint32_t ignoredMesh = kNoMesh) const;
+
+            const Bvh &getSceneBvh() const { return m_sceneBvh; }
+
+            /**
+             * @brief Number of meshes; top-level ids from here on are instances
+             */
+            uint32_t getMeshCount() const { return static_cast<uint32_t>(m_meshBvhs.size()); }
+
+            /**
+             * @brief Bytes used by both BVH levels, the triangle packets and the instance transforms
+             */
+            size_t getMemoryUsage() const;
+
+        private:
+            /**
+             * @brief Bounds of each triangle of one mesh, in mesh-local triangle order
+             */
+            static void computeTriangleBounds(const SceneGeometry &geometry, size_t mesh, std::vector<GfRange3f> &triangleBounds);
+
+            struct MeshBvh
+            {
+                Bvh bvh;
+                std::vector<uint32_t> nodePackets; ///< First packet of each leaf node
+            };
+
+            struct Instance
+            {
+                GfMatrix4f worldToLocal; ///< Moves rays into prototype space
+                uint32_t prototype;
+            };
+
+            /**
+             * @brief Build the triangle BVH of one mesh and append its packets
+             */
+            void buildMeshBvh(const SceneGeometry &geometry, size_t mesh, MeshBvh &meshBvh);
+
+            /**
+             * @brief Trace a ray through one top-level primitive, in prototype space for instances
+             * @param tMax In: current search distance; out: distance of the nearest hit
+             * @param anyHit Stop at the first hit instead of the nearest one
+             * @param hit If given, receives the triangle and world-space normal of the hit
+             */
+            bool intersectPrimitive(uint32_t primitive, const GfVec3f &origin, const GfVec3f &direction,
+                                    float &tMax, bool anyHit, Hit *hit) const;
+
+            /**
+             * @brief Trace a ray through one triangle BVH, in the space of its triangles
+             */
+            bool intersectMesh(const MeshBvh &meshBvh, const GfVec3f &origin, const GfVec3f &direction,
+                               float &tMax, bool anyHit, Hit *hit) const;
+
+            /**
+             * @brief Trace the rays in rayMask through one top-level primitive
+             * @return Mask of the rays that hit one of its triangles
+             */
+            uint32_t findOccludedInPrimitive(uint32_t primitive, const RayPacket &packet, uint32_t rayMask) const;
+
+            /**
+             * @brief Trace the rays in rayMask through one triangle BVH
+             * @return Mask of the rays that hit a triangle of the mesh
+             */
+            uint32_t findOccludedInMesh(const MeshBvh &meshBvh, const RayPacket &packet, uint32_t rayMask) const;
+
+            Bvh m_sceneBvh;
+            std::vector<MeshBvh> m_meshBvhs;
+            std::vector<MeshBvh> m_prototypeBvhs;
+            std::vector<Instance> m_instances;
+            std::vector<TrianglePacket8> m_packets;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
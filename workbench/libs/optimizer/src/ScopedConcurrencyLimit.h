@@ -0,0 +1,47 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/base/work/threadLimits.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Apply a worker thread count for the lifetime of the object
+         *
+         * The Work concurrency limit is process-wide, so the previous limit
+         * is restored when the object goes out of scope.
+         */
+        class ScopedConcurrencyLimit
+        {
+        public:
+            /**
+             * @param numThreads Worker threads (0 = keep the current Work limit, negative = all cores but N)
+             */
+            explicit ScopedConcurrencyLimit(int numThreads)
+                : m_previousLimit(WorkGetConcurrencyLimit())
+            {
+                if (numThreads != 0)
+                {
+                    WorkSetConcurrencyLimitArgument(numThreads);
+                }
+            }
+
+            ~ScopedConcurrencyLimit()
+            {
+                WorkSetConcurrencyLimit(m_previousLimit);
+            }
+
+            ScopedConcurrencyLimit(const ScopedConcurrencyLimit &) = delete;
+            ScopedConcurrencyLimit &operator=(const ScopedConcurrencyLimit &) = delete;
+
+        private:
+            unsigned m_previousLimit;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,554 @@
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr int kTilePixels = SoftwareRasterizer::kTileSize * SoftwareRasterizer::kTileSize;
+
+            /**
+             * @brief Edge and depth equations of a triangle, evaluated at a tile's first pixel
+             *
+             * Each value is linear in screen space: moving one pixel right adds
+             * the dx term and moving one row down adds the dy term.
+             */
+            struct TileSetup
+            {
+                float edge[3];
+                float edgeDx[3];
+                float edgeDy[3];
+                float depth;
+                float depthDx;
+                float depthDy;
+            };
+
+#if defined(__AVX2__)
+
+            bool drawTile(const TileSetup &setup, uint32_t id, float *depth, uint32_t *ids)
+            {
+                const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+                const __m256 zero = _mm256_setzero_ps();
+                const __m256 idValue = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(id)));
+
+                __m256 e0 = _mm256_add_ps(_mm256_set1_ps(setup.edge[0]), _mm256_mul_ps(lane, _mm256_set1_ps(setup.edgeDx[0])));
+                __m256 e1 = _mm256_add_ps(_mm256_set1_ps(setup.edge[1]), _mm256_mul_ps(lane, _mm256_set1_ps(setup.edgeDx[1])));
+                __m256 e2 = _mm256_add_ps(_mm256_set1_ps(setup.edge[2]), _mm256_mul_ps(lane, _mm256_set1_ps(setup.edgeDx[2])));
+                __m256 z = _mm256_add_ps(_mm256_set1_ps(setup.depth), _mm256_mul_ps(lane, _mm256_set1_ps(setup.depthDx)));
+
+                const __m256 e0Dy = _mm256_set1_ps(setup.edgeDy[0]);
+                const __m256 e1Dy = _mm256_set1_ps(setup.edgeDy[1]);
+                const __m256 e2Dy = _mm256_set1_ps(setup.edgeDy[2]);
+                const __m256 zDy = _mm256_set1_ps(setup.depthDy);
+
+                int written = 0;
+                for (int row = 0; row < SoftwareRasterizer::kTileSize; ++row)
+                {
+                    float *depthRow = depth + row * SoftwareRasterizer::kTileSize;
+                    float *idRow = reinterpret_cast<float *>(ids + row * SoftwareRasterizer::kTileSize);
+
+                    const __m256 stored = _mm256_loadu_ps(depthRow);
+                    __m256 pass = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ));
+                    pass = _mm256_and_ps(pass, _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+                    pass = _mm256_and_ps(pass, _mm256_cmp_ps(z, stored, _CMP_GT_OQ));
+
+                    const int mask = _mm256_movemask_ps(pass);
+                    if (mask != 0)
+                    {
+                        _mm256_storeu_ps(depthRow, _mm256_blendv_ps(stored, z, pass));
+                        _mm256_storeu_ps(idRow, _mm256_blendv_ps(_mm256_loadu_ps(idRow), idValue, pass));
+                        written |= mask;
+                    }
+
+                    e0 = _mm256_add_ps(e0, e0Dy);
+                    e1 = _mm256_add_ps(e1, e1Dy);
+                    e2 = _mm256_add_ps(e2, e2Dy);
+                    z = _mm256_add_ps(z, zDy);
+                }
+                return written != 0;
+            }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+            inline __m128 select(__m128 mask, __m128 a, __m128 b)
+            {
+                return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+            }
+
+            bool drawTile(const TileSetup &setup, uint32_t id, float *depth, uint32_t *ids)
+            {
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 idValue = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(id)));
+                int written = 0;
+
+                // A tile row is processed as two 4-wide halves
+                for (int half = 0; half < 2; ++half)
+                {
+                    const __m128 lane = _mm_setr_ps(half * 4.0f, half * 4.0f + 1.0f, half * 4.0f + 2.0f, half * 4.0f + 3.0f);
+                    __m128 e0 = _mm_add_ps(_mm_set1_ps(setup.edge[0]), _mm_mul_ps(lane, _mm_set1_ps(setup.edgeDx[0])));
+                    __m128 e1 = _mm_add_ps(_mm_set1_ps(setup.edge[1]), _mm_mul_ps(lane, _mm_set1_ps(setup.edgeDx[1])));
+                    __m128 e2 = _mm_add_ps(_mm_set1_ps(setup.edge[2]), _mm_mul_ps(lane, _mm_set1_ps(setup.edgeDx[2])));
+                    __m128 z = _mm_add_ps(_mm_set1_ps(setup.depth), _mm_mul_ps(lane, _mm_set1_ps(setup.depthDx)));
+
+                    for (int row = 0; row < SoftwareRasterizer::kTileSize; ++row)
+                    {
+                        float *depthRow = depth + row * SoftwareRasterizer::kTileSize + half * 4;
+                        float *idRow = reinterpret_cast<float *>(ids + row * SoftwareRasterizer::kTileSize + half * 4);
+
+                        const __m128 stored = _mm_loadu_ps(depthRow);
+                        __m128 pass = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero));
+                        pass = _mm_and_ps(pass, _mm_cmpge_ps(e2, zero));
+                        pass = _mm_and_ps(pass, _mm_cmpgt_ps(z, stored));
+
+                        const int mask = _mm_movemask_ps(pass);
+                        if (mask != 0)
+                        {
+                            _mm_storeu_ps(depthRow, select(pass, z, stored));
+                            _mm_storeu_ps(idRow, select(pass, idValue, _mm_loadu_ps(idRow)));
+                            written |= mask;
+                        }
+
+                        e0 = _mm_add_ps(e0, _mm_set1_ps(setup.edgeDy[0]));
+                        e1 = _mm_add_ps(e1, _mm_set1_ps(setup.edgeDy[1]));
+                        e2 = _mm_add_ps(e2, _mm_set1_ps(setup.edgeDy[2]));
+                        z = _mm_add_ps(z, _mm_set1_ps(setup.depthDy));
+                    }
+                }
+                return written != 0;
+            }
+
+#else
+
+            bool drawTile(const TileSetup &setup, uint32_t id, float *depth, uint32_t *ids)
+            {
+                bool written = false;
+                for (int row = 0; row < SoftwareRasterizer::kTileSize; ++row)
+                {
+                    for (int column = 0; column < SoftwareRasterizer::kTileSize; ++column)
+                    {
+                        const float x = static_cast<float>(column);
+                        const float y = static_cast<float>(row);
+                        const float e0 = setup.edge[0] + x * setup.edgeDx[0] + y * setup.edgeDy[0];
+                        const float e1 = setup.edge[1] + x * setup.edgeDx[1] + y * setup.edgeDy[1];
+                        const float e2 = setup.edge[2] + x * setup.edgeDx[2] + y * setup.edgeDy[2];
+                        const float z = setup.depth + x * setup.depthDx + y * setup.depthDy;
+
+                        const int pixel = row * SoftwareRasterizer::kTileSize + column;
+                        if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f && z > depth[pixel])
+                        {
+                            depth[pixel] = z;
+                            ids[pixel] = id;
+                            written = true;
+                        }
+                    }
+                }
+                return written;
+            }
+
+#endif
+        } // namespace
+
+        SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+        {
+            m_tilesX = std::max(1, (width + kTileSize - 1) / kTileSize);
+            m_tilesY = std::max(1, (height + kTileSize - 1) / kTileSize);
+            m_width = m_tilesX * kTileSize;
+            m_height = m_tilesY * kTileSize;
+
+            const size_t tileCount = static_cast<size_t>(m_tilesX) * m_tilesY;
+            m_depth.resize(tileCount * kTilePixels);
+            m_ids.resize(tileCount * kTilePixels);
+            m_tileMinDepth.resize(tileCount);
+            clear();
+        }
+
+        GfMatrix4d SoftwareRasterizer::computeViewProjection(const GfMatrix4d &cameraToWorld, double fovDegrees)
+        {
+            const GfVec3d right(cameraToWorld[0][0], cameraToWorld[0][1], cameraToWorld[0][2]);
+            const GfVec3d up(cameraToWorld[1][0], cameraToWorld[1][1], cameraToWorld[1][2]);
+            const GfVec3d forward(-cameraToWorld[2][0], -cameraToWorld[2][1], -cameraToWorld[2][2]);
+            const GfVec3d eye(cameraToWorld[3][0], cameraToWorld[3][1], cameraToWorld[3][2]);
+
+            const double focal = 1.0 / std::tan(std::clamp(fovDegrees, 1.0, 179.0) * M_PI / 360.0);
+
+            GfMatrix4d matrix(0.0);
+            for (int i = 0; i < 3; ++i)
+            {
+                matrix[i][0] = focal * right[i];
+                matrix[i][1] = focal * up[i];
+                matrix[i][2] = forward[i];
+                matrix[i][3] = forward[i];
+            }
+            matrix[3][0] = -focal * GfDot(eye, right);
+            matrix[3][1] = -focal * GfDot(eye, up);
+            matrix[3][2] = -GfDot(eye, forward);
+            matrix[3][3] = -GfDot(eye, forward);
+            return matrix;
+        }
+
+        void SoftwareRasterizer::setViewProjection(const GfMatrix4d &viewProjection, float nearDistance)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int column = 0; column < 4; ++column)
+                {
+                    m_matrix[row][column] = static_cast<float>(viewProjection[row][column]);
+                }
+            }
+            m_viewProjection = viewProjection;
+            m_nearDistance = std::max(nearDistance, 1e-7f);
+        }
+
+        void SoftwareRasterizer::clear()
+        {
+            std::fill(m_depth.begin(), m_depth.end(), 0.0f);
+            std::fill(m_ids.begin(), m_ids.end(), kNoMesh);
+            std::fill(m_tileMinDepth.begin(), m_tileMinDepth.end(), 0.0f);
+        }
+
+        SoftwareRasterizer::ClipVertex SoftwareRasterizer::transform(float x, float y, float z) const
+        {
+            return transform(m_matrix, x, y, z);
+        }
+
+        SoftwareRasterizer::ClipVertex SoftwareRasterizer::transform(const float (&matrix)[4][4], float x, float y, float z)
+        {
+            return ClipVertex{
+                x * matrix[0][0] + y * matrix[1][0] + z * matrix[2][0] + matrix[3][0],
+                x * matrix[0][1] + y * matrix[1][1] + z * matrix[2][1] + matrix[3][1],
+                x * matrix[0][3] + y * matrix[1][3] + z * matrix[2][3] + matrix[3][3]};
+        }
+
+        SoftwareRasterizer::ScreenVertex SoftwareRasterizer::toScreen(const ClipVertex &vertex) const
+        {
+            const float invW = 1.0f / vertex.w;
+            return ScreenVertex{
+                (vertex.x * invW * 0.5f + 0.5f) * static_cast<float>(m_width),
+                (0.5f - vertex.y * invW * 0.5f) * static_cast<float>(m_height),
+                invW};
+        }
+
+        void SoftwareRasterizer::renderScene(const SceneGeometry &geometry, const std::vector<uint32_t> &meshes,
+                                             const SceneInstances &instances, const std::vector<uint32_t> &visibleInstances,
+                                             const GfVec3d &eye)
+        {
+            const uint32_t meshCount = static_cast<uint32_t>(geometry.getMeshCount());
+            m_drawOrder.clear();
+            m_drawDistances.resize(meshCount + instances.getInstanceCount());
+
+            auto addDraw = [&](uint32_t id, const GfRange3f &bounds)
+            {
+                if (!bounds.IsEmpty())
+                {
+                    m_drawDistances[id] = static_cast<float>((GfVec3d(bounds.GetMidpoint()) - eye).GetLengthSq());
+                    m_drawOrder.push_back(id);
+                }
+            };
+            for (uint32_t mesh : meshes)
+            {
+                addDraw(mesh, geometry.getBounds(mesh));
+            }
+            for (uint32_t instance : visibleInstances)
+            {
+                addDraw(meshCount + instance, instances.getBounds(instance));
+            }
+
+            // Front to back, so near occluders fill the hierarchical Z first
+            std::sort(m_drawOrder.begin(), m_drawOrder.end(),
+                      [this](uint32_t a, uint32_t b)
+                      {
+                          return m_drawDistances[a] < m_drawDistances[b] ||
+                                 (m_drawDistances[a] == m_drawDistances[b] && a < b);
+                      });
+
+            for (uint32_t id : m_drawOrder)
+            {
+                if (id < meshCount)
+                {
+                    renderMesh(geometry, id);
+                }
+                else
+                {
+                    renderInstance(instances, id - meshCount, id);
+                }
+            }
+        }
+
+        bool SoftwareRasterizer::renderMesh(const SceneGeometry &geometry, uint32_t mesh)
+        {
+            if (isBoundsCulled(geometry.getBounds(mesh)))
+            {
+                return false;
+            }
+
+            drawMesh(geometry, mesh, m_matrix, mesh);
+            return true;
+        }
+
+        bool SoftwareRasterizer::renderInstance(const SceneInstances &instances, uint32_t instance, uint32_t id)
+        {
+            if (isBoundsCulled(instances.getBounds(instance)))
+            {
+                return false;
+            }
+
+            // Prototype points go straight to clip space; the instance is never expanded in memory
+            const GfMatrix4d localToClip = instances.localToWorld[instance] * m_viewProjection;
+            float matrix[4][4];
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int column = 0; column < 4; ++column)
+                {
+                    matrix[row][column] = static_cast<float>(localToClip[row][column]);
+                }
+            }
+
+            drawMesh(instances.prototypes, instances.prototypeIndices[instance], matrix, id);
+            return true;
+        }
+
+        void SoftwareRasterizer::drawMesh(const SceneGeometry &geometry, uint32_t mesh, const float (&matrix)[4][4], uint32_t id)
+        {
+            const uint32_t firstPoint = geometry.pointOffsets[mesh];
+            const uint32_t lastPoint = geometry.pointOffsets[mesh + 1];
+            m_clipPoints.resize(lastPoint - firstPoint);
+            for (uint32_t point = firstPoint; point < lastPoint; ++point)
+            {
+                m_clipPoints[point - firstPoint] = transform(matrix, geometry.pointsX[point], geometry.pointsY[point], geometry.pointsZ[point]);
+            }
+
+            const uint32_t *indices = geometry.triangleIndices.data();
+            for (uint32_t triangle = geometry.triangleOffsets[mesh]; triangle < geometry.triangleOffsets[mesh + 1]; ++triangle)
+            {
+                drawTriangle(m_clipPoints[indices[3 * triangle] - firstPoint],
+                             m_clipPoints[indices[3 * triangle + 1] - firstPoint],
+                             m_clipPoints[indices[3 * triangle + 2] - firstPoint],
+                             id);
+            }
+        }
+
+        bool SoftwareRasterizer::isBoundsCulled(const GfRange3f &bounds) const
+        {
+            if (bounds.IsEmpty())
+            {
+                return true;
+            }
+
+            float minX = std::numeric_limits<float>::max();
+            float minY = std::numeric_limits<float>::max();
+            float maxX = std::numeric_limits<float>::lowest();
+            float maxY = std::numeric_limits<float>::lowest();
+            float maxDepth = 0.0f;
+            int behindCount = 0;
+
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const ClipVertex vertex = transform((corner & 1) ? bounds.GetMax()[0] : bounds.GetMin()[0],
+                                                    (corner & 2) ? bounds.GetMax()[1] : bounds.GetMin()[1],
+                                                    (corner & 4) ? bounds.GetMax()[2] : bounds.GetMin()[2]);
+                if (vertex.w < m_nearDistance)
+                {
+                    ++behindCount;
+                    continue;
+                }
+
+                const ScreenVertex screen = toScreen(vertex);
+                minX = std::min(minX, screen.x);
+                minY = std::min(minY, screen.y);
+                maxX = std::max(maxX, screen.x);
+                maxY = std::max(maxY, screen.y);
+                maxDepth = std::max(maxDepth, screen.invW);
+            }
+
+            if (behindCount == 8)
+            {
+                return true;
+            }
+            if (behindCount > 0)
+            {
+                // Straddles the near plane; the projected corners don't bound it
+                return false;
+            }
+
+            if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(m_width) || minY >= static_cast<float>(m_height))
+            {
+                return true;
+            }
+
+            // Occluded if every covered tile already holds something nearer than the box
+            const int tileX0 = std::max(0, static_cast<int>(minX)) / kTileSize;
+            const int tileY0 = std::max(0, static_cast<int>(minY)) / kTileSize;
+            const int tileX1 = std::min(m_width - 1, static_cast<int>(maxX)) / kTileSize;
+            const int tileY1 = std::min(m_height - 1, static_cast<int>(maxY)) / kTileSize;
+            for (int tileY = tileY0; tileY <= tileY1; ++tileY)
+            {
+                for (int tileX = tileX0; tileX <= tileX1; ++tileX)
+                {
+                    if (m_tileMinDepth[static_cast<size_t>(tileY) * m_tilesX + tileX] < maxDepth)
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void SoftwareRasterizer::drawTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, uint32_t id)
+        {
+            const ClipVertex input[3] = {a, b, c};
+            const bool inFront[3] = {a.w >= m_nearDistance, b.w >= m_nearDistance, c.w >= m_nearDistance};
+
+            if (inFront[0] && inFront[1] && inFront[2])
+            {
+                rasterizeTriangle(toScreen(a), toScreen(b), toScreen(c), id);
+                return;
+            }
+            if (!inFront[0] && !inFront[1] && !inFront[2])
+            {
+                return;
+            }
+
+            // Clip against the near plane; a triangle becomes a triangle or a quad
+            ClipVertex clipped[4];
+            int clippedCount = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                const ClipVertex &current = input[i];
+                const ClipVertex &next = input[(i + 1) % 3];
+                if (inFront[i])
+                {
+                    clipped[clippedCount++] = current;
+                }
+                if (inFront[i] != inFront[(i + 1) % 3])
+                {
+                    const float t = (m_nearDistance - current.w) / (next.w - current.w);
+                    clipped[clippedCount++] = ClipVertex{current.x + t * (next.x - current.x),
+                                                         current.y + t * (next.y - current.y),
+                                                         m_nearDistance};
+                }
+            }
+
+            rasterizeTriangle(toScreen(clipped[0]), toScreen(clipped[1]), toScreen(clipped[2]), id);
+            if (clippedCount == 4)
+            {
+                rasterizeTriangle(toScreen(clipped[0]), toScreen(clipped[2]), toScreen(clipped[3]), id);
+            }
+        }
+
+        void SoftwareRasterizer::rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, uint32_t id)
+        {
+            // Setup runs in double: clipped vertices can land far outside the screen
+            double area = (double(v2.x) - v0.x) * (double(v1.y) - v0.y) - (double(v2.y) - v0.y) * (double(v1.x) - v0.x);
+            if (std::abs(area) < 1e-12)
+            {
+                return;
+            }
+            if (area < 0.0)
+            {
+                // Double-sided: flip the winding so the interior is positive
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            const float minX = std::min({v0.x, v1.x, v2.x});
+            const float maxX = std::max({v0.x, v1.x, v2.x});
+            const float minY = std::min({v0.y, v1.y, v2.y});
+            const float maxY = std::max({v0.y, v1.y, v2.y});
+            if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(m_width) || minY >= static_cast<float>(m_height))
+            {
+                return;
+            }
+
+            const int tileX0 = std::max(0, static_cast<int>(minX)) / kTileSize;
+            const int tileY0 = std::max(0, static_cast<int>(minY)) / kTileSize;
+            const int tileX1 = std::min(m_width - 1, static_cast<int>(maxX)) / kTileSize;
+            const int tileY1 = std::min(m_height - 1, static_cast<int>(maxY)) / kTileSize;
+            const float maxDepth = std::max({v0.invW, v1.invW, v2.invW});
+
+            // Edge i is opposite vertex i, so its value is that vertex's barycentric weight times area
+            const ScreenVertex *from[3] = {&v1, &v2, &v0};
+            const ScreenVertex *to[3] = {&v2, &v0, &v1};
+            double edgeDx[3], edgeDy[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                edgeDx[i] = double(to[i]->y) - from[i]->y;
+                edgeDy[i] = -(double(to[i]->x) - from[i]->x);
+            }
+
+            const double depthDx = (edgeDx[0] * v0.invW + edgeDx[1] * v1.invW + edgeDx[2] * v2.invW) / area;
+            const double depthDy = (edgeDy[0] * v0.invW + edgeDy[1] * v1.invW + edgeDy[2] * v2.invW) / area;
+
+            TileSetup setup;
+            for (int i = 0; i < 3; ++i)
+            {
+                setup.edgeDx[i] = static_cast<float>(edgeDx[i]);
+                setup.edgeDy[i] = static_cast<float>(edgeDy[i]);
+            }
+            setup.depthDx = static_cast<float>(depthDx);
+            setup.depthDy = static_cast<float>(depthDy);
+
+            for (int tileY = tileY0; tileY <= tileY1; ++tileY)
+            {
+                for (int tileX = tileX0; tileX <= tileX1; ++tileX)
+                {
+                    const size_t tile = static_cast<size_t>(tileY) * m_tilesX + tileX;
+
+                    // Hierarchical Z: nothing in this triangle is nearer than the farthest stored pixel
+                    if (maxDepth <= m_tileMinDepth[tile])
+                    {
+                        continue;
+                    }
+
+                    // Evaluate the equations at the center of the tile's first pixel
+                    const double x = tileX * kTileSize + 0.5;
+                    const double y = tileY * kTileSize + 0.5;
+                    double edge[3];
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        edge[i] = edgeDx[i] * (x - from[i]->x) + edgeDy[i] * (y - from[i]->y);
+                        setup.edge[i] = static_cast<float>(edge[i]);
+                    }
+                    setup.depth = static_cast<float>((edge[0] * v0.invW + edge[1] * v1.invW + edge[2] * v2.invW) / area);
+
+                    if (drawTile(setup, id, &m_depth[tile * kTilePixels], &m_ids[tile * kTilePixels]))
+                    {
+                        updateTileDepth(tile);
+                    }
+                }
+            }
+        }
+
+        void SoftwareRasterizer::updateTileDepth(size_t tile)
+        {
+            const float *depth = &m_depth[tile * kTilePixels];
+            float minDepth = depth[0];
+            for (int pixel = 1; pixel < kTilePixels; ++pixel)
+            {
+                minDepth = std::min(minDepth, depth[pixel]);
+            }
+            m_tileMinDepth[tile] = minDepth;
+        }
+
+        void SoftwareRasterizer::countVisiblePixels(std::vector<uint32_t> &pixelCounts) const
+        {
+            for (uint32_t id : m_ids)
+            {
+                if (id < pixelCounts.size())
+                {
+                    ++pixelCounts[id];
+                }
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/range3f.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief CPU rasterizer that renders mesh IDs into a tiled depth buffer
+         *
+         * The framebuffer is split into 8x8 pixel tiles stored contiguously, so
+         * one tile row maps onto one 8-wide SIMD register. Depth is stored as
+         * 1/w (larger is closer), which needs no far plane and keeps precision
+         * for distant geometry. Each tile tracks its farthest depth as a
+         * hierarchical Z value, which rejects triangles and whole meshes that
+         * lie behind everything already drawn in that tile.
+         */
+        class SoftwareRasterizer
+        {
+        public:
+            static constexpr int kTileSize = 8;
+            static constexpr uint32_t kNoMesh = std::numeric_limits<uint32_t>::max();
+
+            /**
+             * @brief Allocate the framebuffer
+             * @param width Width in pixels, rounded up to a multiple of kTileSize
+             * @param height Height in pixels, rounded up to a multiple of kTileSize
+             */
+            SoftwareRasterizer(int width, int height);
+
+            /**
+             * @brief Build a world-to-clip matrix for a square perspective view
+             *
+             * Uses the row-vector convention of GfMatrix4d. Clip-space w is the
+             * distance along the view direction; z is unused by the rasterizer.
+             *
+             * @param cameraToWorld Camera placement looking down -Z, e.g. from FrustumCuller::computeCameraToWorld()
+             * @param fovDegrees Full field of view in degrees
+             */
+            static GfMatrix4d computeViewProjection(const GfMatrix4d &cameraToWorld, double fovDegrees);
+
+            /**
+             * @brief Set the camera used by subsequent render calls
+             * @param viewProjection World-to-clip matrix, e.g. from computeViewProjection()
+             * @param nearDistance Geometry closer than this to the camera is clipped
+             */
+            void setViewProjection(const GfMatrix4d &viewProjection, float nearDistance);
+
+            /**
+             * @brief Reset depth to infinitely far and every pixel to kNoMesh
+             */
+            void clear();
+
+            /**
+             * @brief Render a set of meshes and instances, nearest first
+             * @param geometry World-space scene snapshot
+             * @param meshes Indices of the meshes to draw, e.g. frustum culling candidates
+             * @param instances Instanced occluders
+             * @param visibleInstances Indices of the instances to draw
+             * @param eye Camera position, used to sort meshes front to back
+             */
+            void renderScene(const SceneGeometry &geometry, const std::vector<uint32_t> &meshes,
+                             const SceneInstances &instances, const std::vector<uint32_t> &visibleInstances,
+                             const GfVec3d &eye);
+
+            /**
+             * @brief Render the triangles of one mesh with its index as ID
+             * @return False if the mesh was culled or fully occluded
+             */
+            bool renderMesh(const SceneGeometry &geometry, uint32_t mesh);
+
+            /**
+             * @brief Render one instance's prototype through the instance transform
+             * @param id Pixel ID; renderScene() uses the mesh count plus the instance index,
+             *           which countVisiblePixels() ignores
+             * @return False if the instance was culled or fully occluded
+             */
+            bool renderInstance(const SceneInstances &instances, uint32_t instance, uint32_t id);
+
+            /**
+             * @brief Add the number of pixels showing each mesh to pixelCounts
+             * @param pixelCounts One counter per mesh, indexed by mesh ID
+             */
+            void countVisiblePixels(std::vector<uint32_t> &pixelCounts) const;
+
+            int getWidth() const { return m_width; }
+            int getHeight() const { return m_height; }
+
+        private:
+            /**
+             * @brief A vertex after the view-projection transform
+             */
+            struct ClipVertex
+            {
+                float x, y, w;
+            };
+
+            /**
+             * @brief A vertex after the perspective divide, in pixel coordinates
+             */
+            struct ScreenVertex
+            {
+                float x, y, invW;
+            };
+
+            ClipVertex transform(float x, float y, float z) const;
+            static ClipVertex transform(const float (&matrix)[4][4], float x, float y, float z);
+            ScreenVertex toScreen(const ClipVertex &vertex) const;
+
+            /**
+             * @brief Test whether a world-space box is off screen or behind all drawn depth
+             */
+            bool isBoundsCulled(const GfRange3f &bounds) const;
+
+            /**
+             * @brief Transform and draw every triangle of one mesh of a snapshot
+             * @param matrix Snapshot-space to clip-space transform
+             */
+            void drawMesh(const SceneGeometry &geometry, uint32_t mesh, const float (&matrix)[4][4], uint32_t id);
+
+            /**
+             * @brief Clip a triangle against the near plane and rasterize the pieces
+             */
+            void drawTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, uint32_t id);
+
+            /**
+             * @brief Rasterize a triangle that lies entirely in front of the near plane
+             */
+            void rasterizeTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, uint32_t id);
+
+            /**
+             * @brief Recompute the farthest depth stored in a tile
+             */
+            void updateTileDepth(size_t tile);
+
+            int m_width;
+            int m_height;
+            int m_tilesX;
+            int m_tilesY;
+            float m_nearDistance = 1e-3f;
+            float m_matrix[4][4] = {};
+            GfMatrix4d m_viewProjection = GfMatrix4d(1.0); ///< m_matrix in double precision, for composing instance transforms
+
+            std::vector<float> m_depth;        ///< 1/w per pixel, tile-major; 0 = empty
+            std::vector<uint32_t> m_ids;       ///< Mesh index per pixel, tile-major
+            std::vector<float> m_tileMinDepth; ///< Farthest (smallest) 1/w in each tile
+
+            // Scratch buffers reused between meshes
+            std::vector<ClipVertex> m_clipPoints;
+            std::vector<uint32_t> m_drawOrder;
+            std::vector<float> m_drawDistances;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
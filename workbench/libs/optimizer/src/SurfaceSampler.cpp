@@ -0,0 +1,100 @@
+#include "SurfaceSampler.h"
+#include <algorithm>
+#include <cmath>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            /**
+             * @brief Radical inverse of an integer in the given base, in [0, 1)
+             */
+            float radicalInverse(uint32_t index, uint32_t base)
+            {
+                const double inverseBase = 1.0 / base;
+                double factor = inverseBase;
+                double result = 0.0;
+                while (index > 0)
+                {
+                    result += (index % base) * factor;
+                    index /= base;
+                    factor *= inverseBase;
+                }
+                return static_cast<float>(result);
+            }
+        } // namespace
+
+        void SurfaceSampler::build(const SceneGeometry &geometry)
+        {
+            m_cumulativeAreas.assign(geometry.getTotalTriangleCount(), 0.0f);
+
+            for (size_t mesh = 0; mesh < geometry.getMeshCount(); ++mesh)
+            {
+                updateMesh(geometry, static_cast<uint32_t>(mesh));
+            }
+        }
+
+        void SurfaceSampler::updateMesh(const SceneGeometry &geometry, uint32_t mesh)
+        {
+            // Accumulate in double so large meshes keep small triangles distinguishable
+            double total = 0.0;
+            for (uint32_t triangle = geometry.triangleOffsets[mesh]; triangle < geometry.triangleOffsets[mesh + 1]; ++triangle)
+            {
+                const uint32_t *indices = &geometry.triangleIndices[3 * triangle];
+                const GfVec3f a = geometry.getPoint(indices[0]);
+                const GfVec3f b = geometry.getPoint(indices[1]);
+                const GfVec3f c = geometry.getPoint(indices[2]);
+                total += 0.5 * GfCross(b - a, c - a).GetLength();
+                m_cumulativeAreas[triangle] = static_cast<float>(total);
+            }
+        }
+
+        float SurfaceSampler::getSurfaceArea(const SceneGeometry &geometry, uint32_t mesh) const
+        {
+            const uint32_t end = geometry.triangleOffsets[mesh + 1];
+            return (end > geometry.triangleOffsets[mesh]) ? m_cumulativeAreas[end - 1] : 0.0f;
+        }
+
+        GfVec3f SurfaceSampler::getSample(const SceneGeometry &geometry, uint32_t mesh, uint32_t index) const
+        {
+            const uint32_t first = geometry.triangleOffsets[mesh];
+            const uint32_t count = geometry.triangleOffsets[mesh + 1] - first;
+
+            // Halton point 0 is the origin; start at 1 so the first sample is not a corner
+            const float u = radicalInverse(index + 1, 2);
+            const float v = radicalInverse(index + 1, 3);
+            const float w = radicalInverse(index + 1, 5);
+
+            uint32_t triangle;
+            const float area = getSurfaceArea(geometry, mesh);
+            if (area > 0.0f)
+            {
+                const auto begin = m_cumulativeAreas.begin() + first;
+                const auto found = std::upper_bound(begin, begin + count, u * area);
+                triangle = first + static_cast<uint32_t>(std::min<ptrdiff_t>(found - begin, count - 1));
+            }
+            else
+            {
+                // Only degenerate triangles: any of them is as good as another
+                triangle = first + std::min(static_cast<uint32_t>(u * count), count - 1);
+            }
+
+            // Uniform barycentric coordinates from two unit interval values
+            const float root = std::sqrt(v);
+            const float b0 = 1.0f - root;
+            const float b1 = w * root;
+
+            const uint32_t *indices = &geometry.triangleIndices[3 * triangle];
+            const GfVec3f a = geometry.getPoint(indices[0]);
+            const GfVec3f b = geometry.getPoint(indices[1]);
+            const GfVec3f c = geometry.getPoint(indices[2]);
+            return a * b0 + b * b1 + c * (1.0f - b0 - b1);
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3f.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Area-weighted, low-discrepancy points on the triangles of each mesh
+         *
+         * Sample i of a mesh is point i of a Halton sequence (bases 2, 3, 5):
+         * the first dimension picks a triangle through the mesh's cumulative
+         * area, the other two a uniform point inside it. Every prefix of the
+         * sequence is spread evenly over the surface, so callers can stop
+         * drawing samples at any point and large faces are never skipped.
+         */
+        class SurfaceSampler
+        {
+        public:
+            /**
+             * @brief Compute the cumulative triangle areas of every mesh
+             * @param geometry Snapshot to sample; not referenced afterwards
+             */
+            void build(const SceneGeometry &geometry);
+
+            /**
+             * @brief Recompute the areas of one mesh after SceneGeometry::updateMesh()
+             */
+            void updateMesh(const SceneGeometry &geometry, uint32_t mesh);
+
+            /**
+             * @brief World-space position of one sample
+             * @param geometry The snapshot passed to build()
+             * @param mesh Mesh to sample; must have at least one triangle
+             * @param index Position in the mesh's sample sequence
+             */
+            GfVec3f getSample(const SceneGeometry &geometry, uint32_t mesh, uint32_t index) const;
+
+            /**
+             * @brief Total triangle area of a mesh
+             */
+            float getSurfaceArea(const SceneGeometry &geometry, uint32_t mesh) const;
+
+            /**
+             * @brief Bytes used by the cumulative area table
+             */
+            size_t getMemoryUsage() const { return m_cumulativeAreas.capacity() * sizeof(float); }
+
+        private:
+            /// Running area of each mesh's triangles, restarting at every mesh; indexed like triangles
+            std::vector<float> m_cumulativeAreas;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,133 @@
+#include "TopologyCache.h"
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr uint64_t kHashSeed = 0x9e3779b97f4a7c15ull;
+            constexpr uint64_t kHashPrime = 0x100000001b3ull;
+
+            /**
+             * @brief Spread the bits of a hash so that combined hashes stay well distributed
+             */
+            uint64_t mixHash(uint64_t hash)
+            {
+                hash ^= hash >> 30;
+                hash *= 0xbf58476d1ce4e5b9ull;
+                hash ^= hash >> 27;
+                hash *= 0x94d049bb133111ebull;
+                return hash ^ (hash >> 31);
+            }
+
+            /**
+             * @brief Hash an index array one 32-bit word at a time in four independent lanes
+             */
+            uint64_t hashArray(const VtIntArray &array)
+            {
+                uint64_t lanes[4] = {kHashSeed, kHashSeed + 1, kHashSeed + 2, kHashSeed + 3};
+                const int *data = array.cdata();
+                const size_t size = array.size();
+                size_t i = 0;
+                for (; i + 4 <= size; i += 4)
+                {
+                    for (int lane = 0; lane < 4; ++lane)
+                    {
+                        lanes[lane] = (lanes[lane] ^ static_cast<uint32_t>(data[i + lane])) * kHashPrime;
+                    }
+                }
+                for (; i < size; ++i)
+                {
+                    lanes[0] = (lanes[0] ^ static_cast<uint32_t>(data[i])) * kHashPrime;
+                }
+                return mixHash(mixHash(lanes[0] ^ size) ^ mixHash(lanes[1]) * 3 ^ mixHash(lanes[2]) * 5 ^ mixHash(lanes[3]) * 7);
+            }
+
+            bool sameArray(const VtIntArray &a, const VtIntArray &b)
+            {
+                return a.IsIdentical(b) || a == b;
+            }
+
+            template <typename Map, typename Match>
+            auto findEntry(Map &entries, uint64_t hash, Match &&match) -> decltype(&entries.begin()->second)
+            {
+                auto [begin, end] = entries.equal_range(hash);
+                for (auto it = begin; it != end; ++it)
+                {
+                    if (match(it->second))
+                    {
+                        return &it->second;
+                    }
+                }
+                return nullptr;
+            }
+        } // namespace
+
+        TopologyCache::Faces TopologyCache::findFaces(const VtIntArray &faceVertexCounts)
+        {
+            const uint64_t hash = hashArray(faceVertexCounts);
+            Shard &shard = m_shards[hash % kShardCount];
+            auto match = [&](const FacesEntry &entry)
+            { return sameArray(entry.faceVertexCounts, faceVertexCounts); };
+
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (const FacesEntry *entry = findEntry(shard.faces, hash, match))
+                {
+                    return entry->faces;
+                }
+            }
+
+            // Measure outside the lock; the first result inserted wins
+            FacesEntry computed;
+            computed.faceVertexCounts = faceVertexCounts;
+            computed.faces.layout = measureTriangulation(faceVertexCounts.cdata(), faceVertexCounts.size());
+            computed.faces.triangulatedCounts = VtIntArray(computed.faces.layout.triangleCount, 3);
+
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (const FacesEntry *entry = findEntry(shard.faces, hash, match))
+            {
+                return entry->faces;
+            }
+            return shard.faces.emplace(hash, std::move(computed))->second.faces;
+        }
+
+        VtIntArray TopologyCache::findIndices(const VtIntArray &faceVertexCounts, const TriangulationLayout &layout,
+                                              const VtIntArray &indices, bool &shared)
+        {
+            const uint64_t hash = mixHash(hashArray(faceVertexCounts) ^ hashArray(indices) * kHashPrime);
+            Shard &shard = m_shards[hash % kShardCount];
+            auto match = [&](const IndicesEntry &entry)
+            { return sameArray(entry.indices, indices) && sameArray(entry.faceVertexCounts, faceVertexCounts); };
+
+            shared = true;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (const IndicesEntry *entry = findEntry(shard.indices, hash, match))
+                {
+                    return entry->triangulatedIndices;
+                }
+            }
+
+            // Triangulate outside the lock, filling the array in place
+            IndicesEntry computed;
+            computed.faceVertexCounts = faceVertexCounts;
+            computed.indices = indices;
+            computed.triangulatedIndices.resize(3 * layout.triangleCount, [&](int *begin, int *)
+                                                { fillTriangulation(layout, faceVertexCounts.cdata(), faceVertexCounts.size(), indices.cdata(), begin); });
+
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (const IndicesEntry *entry = findEntry(shard.indices, hash, match))
+            {
+                return entry->triangulatedIndices;
+            }
+            shared = false;
+            return shard.indices.emplace(hash, std::move(computed))->second.triangulatedIndices;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "TriangulationKernel.h"
+#include <pxr/pxr.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Triangulation results shared by every mesh with the same topology
+         *
+         * Face vertex count arrays and index arrays are keyed by a hash of
+         * their contents and compared in full on a hash match. A topology is
+         * triangulated by the first mesh that asks for it; later meshes get a
+         * copy of the same VtArray, so they share its storage until one of
+         * them is edited. Face-varying primvar indices laid out by the same
+         * counts are cached the same way.
+         *
+         * Lookups may run concurrently. Two threads missing the same key may
+         * both triangulate it, but only the first result is kept and returned
+         * to both, so sharing does not depend on timing.
+         */
+        class TopologyCache
+        {
+        public:
+            /**
+             * @brief Sizes and triangulated face vertex counts of one counts array
+             */
+            struct Faces
+            {
+                TriangulationLayout layout;
+                VtIntArray triangulatedCounts;
+            };
+
+            /**
+             * @brief Measure a counts array, or return the result for an identical array seen before
+             */
+            Faces findFaces(const VtIntArray &faceVertexCounts);
+
+            /**
+             * @brief Fan-triangulate indices laid out by the counts, or return the result for an identical pair
+             * @param layout Result of findFaces for faceVertexCounts; must be valid and cover the indices
+             * @param shared Set to whether the result came from an earlier lookup
+             */
+            VtIntArray findIndices(const VtIntArray &faceVertexCounts, const TriangulationLayout &layout,
+                                   const VtIntArray &indices, bool &shared);
+
+        private:
+            static constexpr size_t kShardCount = 64;
+
+            struct FacesEntry
+            {
+                VtIntArray faceVertexCounts;
+                Faces faces;
+            };
+
+            struct IndicesEntry
+            {
+                VtIntArray faceVertexCounts;
+                VtIntArray indices;
+                VtIntArray triangulatedIndices;
+            };
+
+            /**
+             * @brief Entries whose hashes fall into one shard, behind one lock
+             */
+            struct Shard
+            {
+                mutable std::mutex mutex;
+                std::unordered_multimap<uint64_t, FacesEntry> faces;
+                std::unordered_multimap<uint64_t, IndicesEntry> indices;
+            };
+
+            std::array<Shard, kShardCount> m_shards;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
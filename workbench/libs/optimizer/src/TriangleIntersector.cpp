@@ -0,0 +1,280 @@
+#include "TriangleIntersector.h"
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            // Hits closer than this are treated as the ray origin touching a surface
+            constexpr float kMinHitDistance = 1e-6f;
+        } // namespace
+
+        TrianglePacket8::TrianglePacket8()
+        {
+            for (int lane = 0; lane < kWidth; ++lane)
+            {
+                v0x[lane] = v0y[lane] = v0z[lane] = 0.0f;
+                e1x[lane] = e1y[lane] = e1z[lane] = 0.0f;
+                e2x[lane] = e2y[lane] = e2z[lane] = 0.0f;
+                triangle[lane] = 0;
+            }
+        }
+
+        void TrianglePacket8::setTriangle(int lane, const GfVec3f &a, const GfVec3f &b, const GfVec3f &c, uint32_t triangleIndex)
+        {
+            GfVec3f e1 = b - a;
+            GfVec3f e2 = c - a;
+            v0x[lane] = a[0];
+            v0y[lane] = a[1];
+            v0z[lane] = a[2];
+            e1x[lane] = e1[0];
+            e1y[lane] = e1[1];
+            e1z[lane] = e1[2];
+            e2x[lane] = e2[0];
+            e2y[lane] = e2[1];
+            e2z[lane] = e2[2];
+            triangle[lane] = triangleIndex;
+        }
+
+#if defined(__AVX2__)
+
+        namespace
+        {
+            inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c)
+            {
+#if defined(__FMA__)
+                return _mm256_fmadd_ps(a, b, c);
+#else
+                return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+            }
+
+            inline __m256 multiplySub(__m256 a, __m256 b, __m256 c)
+            {
+#if defined(__FMA__)
+                return _mm256_fmsub_ps(a, b, c);
+#else
+                return _mm256_sub_ps(_mm256_mul_ps(a, b), c);
+#endif
+            }
+        } // namespace
+
+        const char *getTriangleKernelName()
+        {
+            return "AVX2";
+        }
+
+        float intersectTrianglePacket(const TrianglePacket8 &packet, const GfVec3f &origin,
+                                      const GfVec3f &direction, float tMax, int &hitLane)
+        {
+            const __m256 dx = _mm256_set1_ps(direction[0]);
+            const __m256 dy = _mm256_set1_ps(direction[1]);
+            const __m256 dz = _mm256_set1_ps(direction[2]);
+
+            const __m256 e1x = _mm256_load_ps(packet.e1x);
+            const __m256 e1y = _mm256_load_ps(packet.e1y);
+            const __m256 e1z = _mm256_load_ps(packet.e1z);
+            const __m256 e2x = _mm256_load_ps(packet.e2x);
+            const __m256 e2y = _mm256_load_ps(packet.e2y);
+            const __m256 e2z = _mm256_load_ps(packet.e2z);
+
+            // p = d x e2
+            const __m256 px = multiplySub(dy, e2z, _mm256_mul_ps(dz, e2y));
+            const __m256 py = multiplySub(dz, e2x, _mm256_mul_ps(dx, e2z));
+            const __m256 pz = multiplySub(dx, e2y, _mm256_mul_ps(dy, e2x));
+
+            const __m256 det = multiplyAdd(e1x, px, multiplyAdd(e1y, py, _mm256_mul_ps(e1z, pz)));
+            const __m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+            // s = o - v0
+            const __m256 sx = _mm256_sub_ps(_mm256_set1_ps(origin[0]), _mm256_load_ps(packet.v0x));
+            const __m256 sy = _mm256_sub_ps(_mm256_set1_ps(origin[1]), _mm256_load_ps(packet.v0y));
+            const __m256 sz = _mm256_sub_ps(_mm256_set1_ps(origin[2]), _mm256_load_ps(packet.v0z));
+
+            const __m256 u = _mm256_mul_ps(multiplyAdd(sx, px, multiplyAdd(sy, py, _mm256_mul_ps(sz, pz))), invDet);
+
+            // q = s x e1
+            const __m256 qx = multiplySub(sy, e1z, _mm256_mul_ps(sz, e1y));
+            const __m256 qy = multiplySub(sz, e1x, _mm256_mul_ps(sx, e1z));
+            const __m256 qz = multiplySub(sx, e1y, _mm256_mul_ps(sy, e1x));
+
+            const __m256 v = _mm256_mul_ps(multiplyAdd(dx, qx, multiplyAdd(dy, qy, _mm256_mul_ps(dz, qz))), invDet);
+            const __m256 t = _mm256_mul_ps(multiplyAdd(e2x, qx, multiplyAdd(e2y, qy, _mm256_mul_ps(e2z, qz))), invDet);
+
+            // Ordered comparisons are false for NaN, so degenerate lanes drop out
+            const __m256 zero = _mm256_setzero_ps();
+            __m256 mask = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(kMinHitDistance), _CMP_GT_OQ));
+            mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(tMax), _CMP_LT_OQ));
+
+            int hitBits = _mm256_movemask_ps(mask);
+            hitLane = -1;
+            if (hitBits == 0)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+
+            alignas(32) float distances[TrianglePacket8::kWidth];
+            _mm256_store_ps(distances, _mm256_blendv_ps(_mm256_set1_ps(std::numeric_limits<float>::infinity()), t, mask));
+
+            float nearest = std::numeric_limits<float>::infinity();
+            for (int lane = 0; lane < TrianglePacket8::kWidth; ++lane)
+            {
+                if (distances[lane] < nearest)
+                {
+                    nearest = distances[lane];
+                    hitLane = lane;
+                }
+            }
+            return nearest;
+        }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+        namespace
+        {
+            // Test one half of the packet; returns the hit mask and writes distances
+            inline int intersectHalf(const TrianglePacket8 &packet, int offset, const GfVec3f &origin,
+                                     const GfVec3f &direction, float tMax, float *distances)
+            {
+                const __m128 dx = _mm_set1_ps(direction[0]);
+                const __m128 dy = _mm_set1_ps(direction[1]);
+                const __m128 dz = _mm_set1_ps(direction[2]);
+
+                const __m128 e1x = _mm_load_ps(packet.e1x + offset);
+                const __m128 e1y = _mm_load_ps(packet.e1y + offset);
+                const __m128 e1z = _mm_load_ps(packet.e1z + offset);
+                const __m128 e2x = _mm_load_ps(packet.e2x + offset);
+                const __m128 e2y = _mm_load_ps(packet.e2y + offset);
+                const __m128 e2z = _mm_load_ps(packet.e2z + offset);
+
+                const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+                const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+                const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+                const __m128 det = _mm_add_ps(_mm_mul_ps(e1x, px), _mm_add_ps(_mm_mul_ps(e1y, py), _mm_mul_ps(e1z, pz)));
+                const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+                const __m128 sx = _mm_sub_ps(_mm_set1_ps(origin[0]), _mm_load_ps(packet.v0x + offset));
+                const __m128 sy = _mm_sub_ps(_mm_set1_ps(origin[1]), _mm_load_ps(packet.v0y + offset));
+                const __m128 sz = _mm_sub_ps(_mm_set1_ps(origin[2]), _mm_load_ps(packet.v0z + offset));
+
+                const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_add_ps(_mm_mul_ps(sy, py), _mm_mul_ps(sz, pz))), invDet);
+
+                const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+                const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_add_ps(_mm_mul_ps(dy, qy), _mm_mul_ps(dz, qz))), invDet);
+                const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_add_ps(_mm_mul_ps(e2y, qy), _mm_mul_ps(e2z, qz))), invDet);
+
+                const __m128 zero = _mm_setzero_ps();
+                __m128 mask = _mm_cmpneq_ps(det, zero);
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+                mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+                mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(kMinHitDistance)));
+                mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(tMax)));
+
+                // SSE2 has no blendv: select t where the mask is set, +inf elsewhere
+                const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+                _mm_storeu_ps(distances, _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, infinity)));
+                return _mm_movemask_ps(mask);
+            }
+        } // namespace
+
+        const char *getTriangleKernelName()
+        {
+            return "SSE";
+        }
+
+        float intersectTrianglePacket(const TrianglePacket8 &packet, const GfVec3f &origin,
+                                      const GfVec3f &direction, float tMax, int &hitLane)
+        {
+            float distances[TrianglePacket8::kWidth];
+            int hitBits = intersectHalf(packet, 0, origin, direction, tMax, distances);
+            hitBits |= intersectHalf(packet, 4, origin, direction, tMax, distances + 4) << 4;
+
+            hitLane = -1;
+            float nearest = std::numeric_limits<float>::infinity();
+            if (hitBits == 0)
+            {
+                return nearest;
+            }
+
+            for (int lane = 0; lane < TrianglePacket8::kWidth; ++lane)
+            {
+                if (distances[lane] < nearest)
+                {
+                    nearest = distances[lane];
+                    hitLane = lane;
+                }
+            }
+            return nearest;
+        }
+
+#else
+
+        const char *getTriangleKernelName()
+        {
+            return "scalar";
+        }
+
+        float intersectTrianglePacket(const TrianglePacket8 &packet, const GfVec3f &origin,
+                                      const GfVec3f &direction, float tMax, int &hitLane)
+        {
+            hitLane = -1;
+            float nearest = std::numeric_limits<float>::infinity();
+
+            for (int lane = 0; lane < TrianglePacket8::kWidth; ++lane)
+            {
+                GfVec3f e1(packet.e1x[lane], packet.e1y[lane], packet.e1z[lane]);
+                GfVec3f e2(packet.e2x[lane], packet.e2y[lane], packet.e2z[lane]);
+                GfVec3f p = GfCross(direction, e2);
+                float det = GfDot(e1, p);
+                if (det == 0.0f)
+                {
+                    continue;
+                }
+
+                float invDet = 1.0f / det;
+                GfVec3f s = origin - GfVec3f(packet.v0x[lane], packet.v0y[lane], packet.v0z[lane]);
+                float u = GfDot(s, p) * invDet;
+                if (!(u >= 0.0f && u <= 1.0f))
+                {
+                    continue;
+                }
+
+                GfVec3f q = GfCross(s, e1);
+                float v = GfDot(direction, q) * invDet;
+                if (!(v >= 0.0f && u + v <= 1.0f))
+                {
+                    continue;
+                }
+
+                float t = GfDot(e2, q) * invDet;
+                if (t > kMinHitDistance && t < tMax && t < nearest)
+                {
+                    nearest = t;
+                    hitLane = lane;
+                }
+            }
+            return nearest;
+        }
+
+#endif
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/base/gf/vec3f.h>
+#include <cstdint>
+#include <limits>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Eight triangles in structure-of-arrays layout for SIMD intersection
+         *
+         * Each triangle is stored as its first vertex and two edge vectors, the
+         * form the Möller–Trumbore test consumes directly. Unused lanes have
+         * zero edges, which makes them degenerate and never hit.
+         */
+        struct alignas(32) TrianglePacket8
+        {
+            static constexpr int kWidth = 8;
+
+            float v0x[kWidth], v0y[kWidth], v0z[kWidth];
+            float e1x[kWidth], e1y[kWidth], e1z[kWidth];
+            float e2x[kWidth], e2y[kWidth], e2z[kWidth];
+            uint32_t triangle[kWidth]; ///< Triangle index of each lane
+
+            TrianglePacket8();
+
+            /**
+             * @brief Store a triangle in one lane of the packet
+             */
+            void setTriangle(int lane, const GfVec3f &a, const GfVec3f &b, const GfVec3f &c, uint32_t triangleIndex);
+        };
+
+        /**
+         * @brief Name of the instruction set the triangle kernel was compiled for
+         * @return "AVX2", "SSE" or "scalar"
+         */
+        const char *getTriangleKernelName();
+
+        /**
+         * @brief Intersect a ray with all eight triangles of a packet (double-sided)
+         *
+         * Uses 8-wide AVX2 when compiled with AVX2 support, two 4-wide SSE halves
+         * on other x86 builds and a scalar loop elsewhere.
+         *
+         * @param packet The triangles to test
+         * @param origin Ray origin
+         * @param direction Ray direction
+         * @param tMax Only hits with distance in (0, tMax) are reported
+         * @param hitLane Receives the lane of the nearest hit, or -1
+         * @return Distance of the nearest hit, or +infinity if none
+         */
+        float intersectTrianglePacket(const TrianglePacket8 &packet, const GfVec3f &origin,
+                                      const GfVec3f &direction, float tMax, int &hitLane);
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,198 @@
+#include "TriangulationKernel.h"
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        TriangulationLayout measureTriangulation(const int *faceVertexCounts, size_t faceCount)
+        {
+            TriangulationLayout result;
+            size_t triangleFaces = 0;
+            size_t quadFaces = 0;
+            for (size_t face = 0; face < faceCount; ++face)
+            {
+                const int count = faceVertexCounts[face];
+                result.valid = result.valid && count >= 0;
+                result.faceVertexCount += static_cast<size_t>(std::max(count, 0));
+                if (count < 3)
+                {
+                    result.degenerateCount++;
+                    continue;
+                }
+                result.triangleCount += static_cast<size_t>(count - 2);
+                triangleFaces += count == 3;
+                quadFaces += count == 4;
+            }
+            result.polygonCount = faceCount - triangleFaces - result.degenerateCount;
+
+            if (triangleFaces == faceCount)
+            {
+                result.layout = FaceLayout::Triangles;
+            }
+            else if (quadFaces == faceCount)
+            {
+                result.layout = FaceLayout::Quads;
+            }
+            else
+            {
+                result.layout = FaceLayout::Mixed;
+            }
+            return result;
+        }
+
+        namespace
+        {
+            inline void fillQuad(const int *quad, int *out)
+            {
+                out[0] = quad[0];
+                out[1] = quad[1];
+                out[2] = quad[2];
+                out[3] = quad[0];
+                out[4] = quad[2];
+                out[5] = quad[3];
+            }
+
+#if defined(__AVX2__)
+
+            /**
+             * @brief Split two quads per step: one 8-index load, one 8-index and one 4-index store
+             * @return Quads written; the caller finishes the rest
+             */
+            size_t fillQuadsSimd(const int *faceVertexIndices, size_t quadCount, int *triangulatedIndices)
+            {
+                const __m256i firstHalf = _mm256_setr_epi32(0, 1, 2, 0, 2, 3, 4, 5);
+                const __m256i secondHalf = _mm256_setr_epi32(6, 4, 6, 7, 0, 0, 0, 0);
+                size_t quad = 0;
+                for (; quad + 2 <= quadCount; quad += 2)
+                {
+                    const __m256i quads = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(faceVertexIndices + 4 * quad));
+                    int *out = triangulatedIndices + 6 * quad;
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permutevar8x32_epi32(quads, firstHalf));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8),
+                                     _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(quads, secondHalf)));
+                }
+                return quad;
+            }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+            /**
+             * @brief Split one quad per step: one 4-index load, one 4-index and one 2-index store
+             * @return Quads written; the caller finishes the rest
+             */
+            size_t fillQuadsSimd(const int *faceVertexIndices, size_t quadCount, int *triangulatedIndices)
+            {
+                for (size_t quad = 0; quad < quadCount; ++quad)
+                {
+                    const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i *>(faceVertexIndices + 4 * quad));
+                    int *out = triangulatedIndices + 6 * quad;
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi32(indices, _MM_SHUFFLE(0, 2, 1, 0)));
+                    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 4), _mm_shuffle_epi32(indices, _MM_SHUFFLE(3, 3, 3, 2)));
+                }
+                return quadCount;
+            }
+
+#else
+
+            size_t fillQuadsSimd(const int *, size_t, int *)
+            {
+                return 0;
+            }
+
+#endif
+
+            template <FaceLayout Layout>
+            void fillFaces(const int *faceVertexCounts, size_t faceCount, const int *faceVertexIndices, int *triangulatedIndices);
+
+            template <>
+            void fillFaces<FaceLayout::Triangles>(const int *, size_t faceCount, const int *faceVertexIndices,
+                                                  int *triangulatedIndices)
+            {
+                std::copy(faceVertexIndices, faceVertexIndices + 3 * faceCount, triangulatedIndices);
+            }
+
+            template <>
+            void fillFaces<FaceLayout::Quads>(const int *, size_t faceCount, const int *faceVertexIndices,
+                                              int *triangulatedIndices)
+            {
+                for (size_t quad = fillQuadsSimd(faceVertexIndices, faceCount, triangulatedIndices); quad < faceCount; ++quad)
+                {
+                    fillQuad(faceVertexIndices + 4 * quad, triangulatedIndices + 6 * quad);
+                }
+            }
+
+            template <>
+            void fillFaces<FaceLayout::Mixed>(const int *faceVertexCounts, size_t faceCount, const int *faceVertexIndices,
+                                              int *triangulatedIndices)
+            {
+                const int *face = faceVertexIndices;
+                int *out = triangulatedIndices;
+                for (size_t i = 0; i < faceCount; ++i)
+                {
+                    const int count = faceVertexCounts[i];
+                    if (count == 3)
+                    {
+                        out[0] = face[0];
+                        out[1] = face[1];
+                        out[2] = face[2];
+                        out += 3;
+                    }
+                    else if (count == 4)
+                    {
+                        fillQuad(face, out);
+                        out += 6;
+                    }
+                    else if (count > 4)
+                    {
+                        // Connect every edge not touching the first vertex to it
+                        for (int k = 1; k < count - 1; ++k)
+                        {
+                            out[0] = face[0];
+                            out[1] = face[k];
+                            out[2] = face[k + 1];
+                            out += 3;
+                        }
+                    }
+                    face += count;
+                }
+            }
+        } // namespace
+
+        const char *getTriangulationKernelName()
+        {
+#if defined(__AVX2__)
+            return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+            return "SSE";
+#else
+            return "scalar";
+#endif
+        }
+
+        void fillTriangulation(const TriangulationLayout &layout, const int *faceVertexCounts, size_t faceCount,
+                               const int *faceVertexIndices, int *triangulatedIndices)
+        {
+            switch (layout.layout)
+            {
+            case FaceLayout::Triangles:
+                fillFaces<FaceLayout::Triangles>(faceVertexCounts, faceCount, faceVertexIndices, triangulatedIndices);
+                break;
+            case FaceLayout::Quads:
+                fillFaces<FaceLayout::Quads>(faceVertexCounts, faceCount, faceVertexIndices, triangulatedIndices);
+                break;
+            case FaceLayout::Mixed:
+                fillFaces<FaceLayout::Mixed>(faceVertexCounts, faceCount, faceVertexIndices, triangulatedIndices);
+                break;
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
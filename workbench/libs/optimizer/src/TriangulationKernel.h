@@ -0,0 +1,63 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <cstddef>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Face shapes of a topology, which select the fill kernel
+         */
+        enum class FaceLayout
+        {
+            Triangles, ///< Every face has 3 vertices
+            Quads,     ///< Every face has 4 vertices
+            Mixed      ///< Anything else, including degenerate faces
+        };
+
+        /**
+         * @brief Output sizes of a fan triangulation, from one pass over the face vertex counts
+         */
+        struct TriangulationLayout
+        {
+            FaceLayout layout = FaceLayout::Triangles;
+            bool valid = true;          ///< False if a face vertex count is negative; such faces count as degenerate
+            size_t faceVertexCount = 0; ///< Sum of the counts, the indices the topology reads
+            size_t triangleCount = 0;   ///< Faces after triangulation
+            size_t polygonCount = 0;    ///< Faces with more than 3 vertices
+            size_t degenerateCount = 0; ///< Faces with fewer than 3 vertices, which are dropped
+        };
+
+        /**
+         * @brief Classify the faces and size the triangulated arrays exactly
+         */
+        TriangulationLayout measureTriangulation(const int *faceVertexCounts, size_t faceCount);
+
+        /**
+         * @brief Name of the instruction set the quad kernel was compiled for
+         * @return "AVX2", "SSE" or "scalar"
+         */
+        const char *getTriangulationKernelName();
+
+        /**
+         * @brief Write the fan triangulation of a topology into preallocated storage
+         *
+         * Faces with vertices [v0, v1, ..., vn] become the triangles
+         * [v0, v1, v2], [v0, v2, v3], ... in face order. All-triangle
+         * topologies are copied, all-quad topologies use a SIMD shuffle kernel
+         * and mixed ones a scalar loop with quad and triangle fast paths.
+         *
+         * @param layout Result of measureTriangulation for the same counts; must be valid
+         * @param faceVertexIndices At least layout.faceVertexCount indices
+         * @param triangulatedIndices Room for exactly 3 * layout.triangleCount indices
+         */
+        void fillTriangulation(const TriangulationLayout &layout, const int *faceVertexCounts, size_t faceCount,
+                               const int *faceVertexIndices, int *triangulatedIndices);
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,416 @@
+#include "ViewpointGenerator.h"
+#include "FrustumCuller.h"
+#include <pxr/base/work/loops.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr int kSignatureResolution = 16;     ///< Primary rays per axis of a view signature
+            constexpr float kRefinementDisagreement = 0.25f; ///< Jaccard distance at which neighbours are split
+            constexpr size_t kRefinementNeighbours = 6;  ///< Nearest sphere views compared with each view
+
+            /**
+             * @brief Fraction of meshes seen by only one of two views (0 = identical sets)
+             */
+            float computeJaccardDistance(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+            {
+                if (a.empty() && b.empty())
+                {
+                    return 0.0f;
+                }
+
+                size_t shared = 0;
+                auto itA = a.begin();
+                auto itB = b.begin();
+                while (itA != a.end() && itB != b.end())
+                {
+                    if (*itA == *itB)
+                    {
+                        ++shared;
+                        ++itA;
+                        ++itB;
+                    }
+                    else if (*itA < *itB)
+                    {
+                        ++itA;
+                    }
+                    else
+                    {
+                        ++itB;
+                    }
+                }
+                return 1.0f - static_cast<float>(shared) / static_cast<float>(a.size() + b.size() - shared);
+            }
+        } // namespace
+
+        ViewpointGenerator::ViewpointGenerator(const GfRange3d &sceneBounds)
+            : m_bounds(sceneBounds), m_center(sceneBounds.GetMidpoint())
+        {
+            GfVec3d size = sceneBounds.GetSize();
+            double maxDim = std::max({size[0], size[1], size[2]});
+            m_radius = maxDim * 1.5; // Distance from center to place viewpoints
+        }
+
+        ViewpointGenerator::Viewpoint ViewpointGenerator::makeSphereView(const GfVec3d &unitDirection, float fov) const
+        {
+            // Direction points towards scene center
+            return Viewpoint(m_center + unitDirection * m_radius, -unitDirection, fov);
+        }
+
+        std::vector<ViewpointGenerator::Viewpoint> ViewpointGenerator::generateLatLongGrid(int density) const
+        {
+            std::vector<Viewpoint> viewpoints;
+
+            for (int i = 0; i < density; ++i)
+            {
+                for (int j = 0; j < density; ++j)
+                {
+                    double theta = (2.0 * M_PI * i) / density;            // Azimuth
+                    double phi = (M_PI * j) / std::max(1, density - 1); // Elevation
+
+                    // Convert spherical to cartesian coordinates
+                    GfVec3d unitDirection(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+                    viewpoints.push_back(makeSphereView(unitDirection, 60.0f));
+                }
+            }
+
+            return viewpoints;
+        }
+
+        std::vector<ViewpointGenerator::Viewpoint> ViewpointGenerator::generateFibonacciSphere(size_t count) const
+        {
+            std::vector<Viewpoint> viewpoints;
+            viewpoints.reserve(count);
+
+            // Successive points advance by the golden angle and cover equal areas in z
+            const double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+            for (size_t i = 0; i < count; ++i)
+            {
+                double z = 1.0 - (2.0 * i + 1.0) / static_cast<double>(count);
+                double ring = std::sqrt(std::max(0.0, 1.0 - z * z));
+                double theta = goldenAngle * static_cast<double>(i);
+                viewpoints.push_back(makeSphereView(GfVec3d(ring * cos(theta), ring * sin(theta), z), 60.0f));
+            }
+
+            return viewpoints;
+        }
+
+        std::vector<ViewpointGenerator::Viewpoint> ViewpointGenerator::generateAxisViews() const
+        {
+            std::vector<Viewpoint> viewpoints;
+
+            double axisDistance = m_radius * 0.8;
+            std::vector<GfVec3d> axisPositions = {
+                m_center + GfVec3d(axisDistance, 0, 0),  // +X
+                m_center + GfVec3d(-axisDistance, 0, 0), // -X
+                m_center + GfVec3d(0, axisDistance, 0),  // +Y
+                m_center + GfVec3d(0, -axisDistance, 0), // -Y
+                m_center + GfVec3d(0, 0, axisDistance),  // +Z
+                m_center + GfVec3d(0, 0, -axisDistance)  // -Z
+            };
+
+            for (const auto &pos : axisPositions)
+            {
+                GfVec3d direction = (m_center - pos).GetNormalized();
+                viewpoints.emplace_back(pos, direction, 90.0f); // Wider FOV for axis views
+            }
+
+            return viewpoints;
+        }
+
+        std::vector<ViewpointGenerator::Viewpoint> ViewpointGenerator::generateInteriorProbes(int resolution, const SceneRayCaster &rayCaster) const
+        {
+            std::vector<Viewpoint> viewpoints;
+            if (resolution <= 0 || m_bounds.IsEmpty() || rayCaster.getMeshCount() == 0)
+            {
+                return viewpoints;
+            }
+
+            const GfVec3d cellSize = m_bounds.GetSize() / static_cast<double>(resolution);
+            double smallestCell = std::numeric_limits<double>::max();
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (cellSize[axis] > 0.0)
+                {
+                    smallestCell = std::min(smallestCell, cellSize[axis]);
+                }
+            }
+            const float clearance = static_cast<float>(0.25 * smallestCell);
+            const float maxDistance = static_cast<float>(m_bounds.GetSize().GetLength());
+
+            const GfVec3d axes[6] = {GfVec3d(1, 0, 0), GfVec3d(-1, 0, 0), GfVec3d(0, 1, 0),
+                                     GfVec3d(0, -1, 0), GfVec3d(0, 0, 1), GfVec3d(0, 0, -1)};
+
+            const size_t cellCount = static_cast<size_t>(resolution) * resolution * resolution;
+            std::vector<uint8_t> isFree(cellCount, 0);
+
+            auto cellCenter = [&](size_t cell)
+            {
+                GfVec3d index(static_cast<double>(cell % resolution), static_cast<double>((cell / resolution) % resolution),
+                              static_cast<double>(cell / (static_cast<size_t>(resolution) * resolution)));
+                return m_bounds.GetMin() + GfCompMult(index + GfVec3d(0.5), cellSize);
+            };
+
+            WorkParallelForN(
+                cellCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t cell = begin; cell < end; ++cell)
+                    {
+                        isFree[cell] = isFreeSpace(GfVec3f(cellCenter(cell)), clearance, maxDistance, rayCaster);
+                    }
+                },
+                8);
+
+            for (size_t cell = 0; cell < cellCount; ++cell)
+            {
+                if (!isFree[cell])
+                {
+                    continue;
+                }
+
+                // Six 90 degree views cover every direction around the probe
+                const GfVec3d position = cellCenter(cell);
+                for (const GfVec3d &axis : axes)
+                {
+                    viewpoints.emplace_back(position, axis, 90.0f);
+                }
+            }
+
+            return viewpoints;
+        }
+
+        bool ViewpointGenerator::isFreeSpace(const GfVec3f &position, float clearance, float maxDistance,
+                                             const SceneRayCaster &rayCaster)
+        {
+            const GfVec3f axes[6] = {GfVec3f(1, 0, 0), GfVec3f(-1, 0, 0), GfVec3f(0, 1, 0),
+                                     GfVec3f(0, -1, 0), GfVec3f(0, 0, 1), GfVec3f(0, 0, -1)};
+            for (const GfVec3f &direction : axes)
+            {
+                SceneRayCaster::Hit hit;
+                if (!rayCaster.intersect(position, direction, maxDistance, hit))
+                {
+                    continue;
+                }
+
+                // Too close to a surface, or looking at the inside of a closed mesh
+                if (hit.distance < clearance || GfDot(hit.normal, direction) > 0.0f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<uint32_t> ViewpointGenerator::computeSignature(const Viewpoint &viewpoint, const SceneRayCaster &rayCaster) const
+        {
+            const GfMatrix4d cameraToWorld = FrustumCuller::computeCameraToWorld(viewpoint.position, viewpoint.direction);
+            const GfVec3d right(cameraToWorld[0][0], cameraToWorld[0][1], cameraToWorld[0][2]);
+            const GfVec3d up(cameraToWorld[1][0], cameraToWorld[1][1], cameraToWorld[1][2]);
+            const GfVec3d forward = viewpoint.direction.GetNormalized();
+            const double tanHalfFov = std::tan(viewpoint.fov * M_PI / 360.0);
+
+            const GfVec3f origin(viewpoint.position);
+            const float maxDistance = static_cast<float>((viewpoint.position - m_center).GetLength() + m_bounds.GetSize().GetLength());
+
+            std::vector<uint32_t> signature;
+            for (int y = 0; y < kSignatureResolution; ++y)
+            {
+                for (int x = 0; x < kSignatureResolution; ++x)
+                {
+                    // Pixel centers across the square view
+                    double u = ((x + 0.5) / kSignatureResolution * 2.0 - 1.0) * tanHalfFov;
+                    double v = ((y + 0.5) / kSignatureResolution * 2.0 - 1.0) * tanHalfFov;
+                    GfVec3f direction((forward + right * u + up * v).GetNormalized());
+
+                    SceneRayCaster::Hit hit;
+                    if (rayCaster.intersect(origin, direction, maxDistance, hit))
+                    {
+                        signature.push_back(hit.mesh);
+                    }
+                }
+            }
+
+            std::sort(signature.begin(), signature.end());
+            signature.erase(std::unique(signature.begin(), signature.end()), signature.end());
+            return signature;
+        }
+
+        std::vector<ViewpointGenerator::Viewpoint> ViewpointGenerator::refineSphere(const std::vector<Viewpoint> &sphereViews, int passes,
+                                                                                    const SceneRayCaster &rayCaster) const
+        {
+            std::vector<Viewpoint> added;
+            if (sphereViews.size() < 2 || passes <= 0)
+            {
+                return added;
+            }
+
+            std::vector<Viewpoint> views = sphereViews;
+            std::vector<std::vector<uint32_t>> signatures(views.size());
+            auto computeSignatures = [&](size_t first)
+            {
+                signatures.resize(views.size());
+                WorkParallelForN(
+                    views.size() - first,
+                    [&](size_t begin, size_t end)
+                    {
+                        for (size_t i = first + begin; i < first + end; ++i)
+                        {
+                            signatures[i] = computeSignature(views[i], rayCaster);
+                        }
+                    },
+                    1);
+            };
+            computeSignatures(0);
+
+            // Do not split views closer than a quarter of the initial spacing
+            const double minAngle = 0.25 * std::sqrt(4.0 * M_PI / static_cast<double>(sphereViews.size()));
+            const double tolerance = 1e-6 * m_radius;
+
+            std::vector<GfVec3d> units;
+            for (int pass = 0; pass < passes; ++pass)
+            {
+                units.clear();
+                for (const Viewpoint &view : views)
+                {
+                    units.push_back((view.position - m_center).GetNormalized());
+                }
+
+                // Pairs of nearest neighbours on the sphere, each listed once
+                std::vector<std::pair<size_t, size_t>> pairs;
+                std::vector<std::pair<double, size_t>> nearest;
+                for (size_t i = 0; i < views.size(); ++i)
+                {
+                    nearest.clear();
+                    for (size_t j = 0; j < views.size(); ++j)
+                    {
+                        if (j != i)
+                        {
+                            nearest.emplace_back(-GfDot(units[i], units[j]), j);
+                        }
+                    }
+                    const size_t neighbourCount = std::min(kRefinementNeighbours, nearest.size());
+                    std::partial_sort(nearest.begin(), nearest.begin() + neighbourCount, nearest.end());
+                    for (size_t k = 0; k < neighbourCount; ++k)
+                    {
+                        pairs.emplace_back(std::min(i, nearest[k].second), std::max(i, nearest[k].second));
+                    }
+                }
+                std::sort(pairs.begin(), pairs.end());
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+                std::vector<Viewpoint> refined;
+                for (const auto &[a, b] : pairs)
+                {
+                    const double angle = std::acos(std::clamp(GfDot(units[a], units[b]), -1.0, 1.0));
+                    const GfVec3d middle = units[a] + units[b];
+                    if (angle < minAngle || middle.GetLength() < 1e-6)
+                    {
+                        continue;
+                    }
+                    if (computeJaccardDistance(signatures[a], signatures[b]) > kRefinementDisagreement)
+                    {
+                        refined.push_back(makeSphereView(middle.GetNormalized(), views[a].fov));
+                    }
+                }
+
+                removeDuplicates(refined, tolerance);
+                if (refined.empty())
+                {
+                    break;
+                }
+
+                const size_t first = views.size();
+                views.insert(views.end(), refined.begin(), refined.end());
+                added.insert(added.end(), refined.begin(), refined.end());
+                computeSignatures(first);
+            }
+
+            return added;
+        }
+
+        size_t ViewpointGenerator::removeDuplicates(std::vector<Viewpoint> &viewpoints, double tolerance)
+        {
+            if (viewpoints.empty())
+            {
+                return 0;
+            }
+            tolerance = std::max(tolerance, 1e-12);
+
+            // Hash positions into cells of the tolerance size; duplicates can only share or neighbour a cell
+            auto cellOf = [&](const GfVec3d &position)
+            {
+                return GfVec3d(std::floor(position[0] / tolerance), std::floor(position[1] / tolerance),
+                               std::floor(position[2] / tolerance));
+            };
+            auto hashCell = [](const GfVec3d &cell)
+            {
+                uint64_t hash = 1469598103934665603ull;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    hash = (hash ^ static_cast<uint64_t>(static_cast<int64_t>(cell[axis]))) * 1099511628211ull;
+                }
+                return hash;
+            };
+
+            std::unordered_map<uint64_t, std::vector<size_t>> cells;
+            std::vector<Viewpoint> unique;
+            const double cosTolerance = std::cos(M_PI / 180.0); // Directions within one degree
+
+            for (const Viewpoint &viewpoint : viewpoints)
+            {
+                const GfVec3d cell = cellOf(viewpoint.position);
+                const GfVec3d direction = viewpoint.direction.GetNormalized();
+
+                bool duplicate = false;
+                for (int dx = -1; dx <= 1 && !duplicate; ++dx)
+                {
+                    for (int dy = -1; dy <= 1 && !duplicate; ++dy)
+                    {
+                        for (int dz = -1; dz <= 1 && !duplicate; ++dz)
+                        {
+                            auto found = cells.find(hashCell(cell + GfVec3d(dx, dy, dz)));
+                            if (found == cells.end())
+                            {
+                                continue;
+                            }
+                            for (size_t index : found->second)
+                            {
+                                const Viewpoint &other = unique[index];
+                                if ((other.position - viewpoint.position).GetLength() <= tolerance &&
+                                    GfDot(other.direction.GetNormalized(), direction) >= cosTolerance &&
+                                    std::abs(other.fov - viewpoint.fov) < 1e-3f)
+                                {
+                                    duplicate = true;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if (!duplicate)
+                {
+                    cells[hashCell(cell)].push_back(unique.size());
+                    unique.push_back(viewpoint);
+                }
+            }
+
+            const size_t removed = viewpoints.size() - unique.size();
+            viewpoints = std::move(unique);
+            return removed;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "HiddenMeshRemover.h"
+#include "SceneRayCaster.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/gf/vec3d.h>
+#include <cstdint>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Places generated viewpoints around and inside a scene
+         *
+         * Sphere viewpoints sit on a sphere around the scene bounds and look
+         * at its center. Interior probes are cube maps of six 90 degree views
+         * placed in free space inside the bounds. Adaptive refinement adds
+         * sphere viewpoints between neighbours that see different meshes.
+         */
+        class ViewpointGenerator
+        {
+        public:
+            using Viewpoint = HiddenMeshRemover::Viewpoint;
+
+            /**
+             * @param sceneBounds World-space bounds of all geometry
+             */
+            explicit ViewpointGenerator(const GfRange3d &sceneBounds);
+
+            /**
+             * @brief density x density latitude/longitude grid on the sphere
+             *
+             * Kept for reproducing older results. Points cluster at the poles
+             * and the first and last rows collapse to a single point each.
+             */
+            std::vector<Viewpoint> generateLatLongGrid(int density) const;
+
+            /**
+             * @brief Evenly spaced viewpoints on the sphere from a Fibonacci lattice
+             * @param count Number of viewpoints
+             */
+            std::vector<Viewpoint> generateFibonacciSphere(size_t count) const;
+
+            /**
+             * @brief Six wide-angle views along the main axes, closer than the sphere
+             */
+            std::vector<Viewpoint> generateAxisViews() const;
+
+            /**
+             * @brief Cube-map probes at the free cells of a grid inside the scene bounds
+             *
+             * A cell center is free if axis-aligned rays from it only hit front
+             * faces and keep a clearance of a quarter cell to any surface, so
+             * probes are not placed inside closed meshes or against walls.
+             *
+             * @param resolution Grid cells per axis
+             * @param rayCaster Ray caster over the scene geometry and instances
+             * @return Six viewpoints per free cell
+             */
+            std::vector<Viewpoint> generateInteriorProbes(int resolution, const SceneRayCaster &rayCaster) const;
+
+            /**
+             * @brief Whether a point lies in free space
+             *
+             * Rays along the six axes must only hit front faces, each at
+             * least clearance away; rays that hit nothing within maxDistance
+             * count as free.
+             */
+            static bool isFreeSpace(const GfVec3f &position, float clearance, float maxDistance, const SceneRayCaster &rayCaster);
+
+            /**
+             * @brief Add sphere viewpoints where neighbouring views disagree about visibility
+             *
+             * Each view's signature is the set of meshes seen by a coarse grid
+             * of primary rays. Neighbouring sphere views whose signatures
+             * differ by more than a quarter (Jaccard distance) get a new view
+             * at their midpoint; each pass works on the views of the last.
+             *
+             * @param sphereViews Views from generateFibonacciSphere() or generateLatLongGrid()
+             * @param passes Number of refinement passes
+             * @param rayCaster Ray caster over the scene geometry
+             * @return The added views only
+             */
+            std::vector<Viewpoint> refineSphere(const std::vector<Viewpoint> &sphereViews, int passes,
+                                                const SceneRayCaster &rayCaster) const;
+
+            /**
+             * @brief Remove viewpoints that repeat an earlier one
+             *
+             * Two viewpoints are duplicates if their positions are within
+             * tolerance and their directions and fields of view match.
+             *
+             * @return Number of viewpoints removed
+             */
+            static size_t removeDuplicates(std::vector<Viewpoint> &viewpoints, double tolerance);
+
+        private:
+            Viewpoint makeSphereView(const GfVec3d &unitDirection, float fov) const;
+
+            /**
+             * @brief Sorted ids of the meshes hit by a coarse grid of primary rays
+             */
+            std::vector<uint32_t> computeSignature(const Viewpoint &viewpoint, const SceneRayCaster &rayCaster) const;
+
+            GfRange3d m_bounds;
+            GfVec3d m_center;
+            double m_radius; ///< Distance of sphere viewpoints from the center
+        };
+
+    } // namespace optimizer
+} // namespace workbench
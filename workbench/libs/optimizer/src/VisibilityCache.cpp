@@ -0,0 +1,268 @@
+#include "VisibilityCache.h"
+#include "Bvh.h"
+#include <pxr/base/work/loops.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            constexpr const char *kFileHeader = "workbench-visibility-cache";
+            constexpr int kFileVersion = 1;
+
+            constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+            constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+            /**
+             * @brief 64-bit FNV-1a, continued from a previous hash value
+             */
+            uint64_t hashBytes(const void *data, size_t size, uint64_t hash)
+            {
+                const unsigned char *bytes = static_cast<const unsigned char *>(data);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    hash = (hash ^ bytes[i]) * kFnvPrime;
+                }
+                return hash;
+            }
+
+            template <typename T>
+            uint64_t hashValue(const T &value, uint64_t hash)
+            {
+                return hashBytes(&value, sizeof(T), hash);
+            }
+
+            /**
+             * @brief Spread the bits of a hash so that sums of hashes stay well distributed
+             */
+            uint64_t mixHash(uint64_t hash)
+            {
+                hash ^= hash >> 30;
+                hash *= 0xbf58476d1ce4e5b9ull;
+                hash ^= hash >> 27;
+                hash *= 0x94d049bb133111ebull;
+                return hash ^ (hash >> 31);
+            }
+        } // namespace
+
+        uint64_t VisibilityCache::computeAnalysisHash(const std::vector<Viewpoint> &viewpoints, const RemovalOptions &options,
+                                                      const SceneInstances &instances)
+        {
+            uint64_t hash = hashValue(kFileVersion, kFnvOffset);
+            for (const Viewpoint &viewpoint : viewpoints)
+            {
+                hash = hashBytes(viewpoint.position.data(), 3 * sizeof(double), hash);
+                hash = hashBytes(viewpoint.direction.data(), 3 * sizeof(double), hash);
+                hash = hashValue(viewpoint.fov, hash);
+            }
+
+            // Options that change verdicts; thread count and packet size only change speed
+            hash = hashValue(static_cast<int>(options.engine), hash);
+            hash = hashValue(options.occlusionThreshold, hash);
+            hash = hashValue(options.minSurfaceSamples, hash);
+            hash = hashValue(options.maxSurfaceSamples, hash);
+            hash = hashValue(options.rasterResolution, hash);
+            hash = hashValue(options.minVisiblePixels, hash);
+            hash = hashValue(options.refinementPasses, hash);
+            hash = hashValue(options.interiorProbeResolution, hash);
+            if (options.hierarchicalCulling)
+            {
+                // Keeps the key of existing cache files when the option is off
+                hash = hashValue(options.minGroupMeshes, hash);
+            }
+            if (options.engine == HiddenMeshRemover::VisibilityEngine::Voxel)
+            {
+                hash = hashValue(options.voxelResolution, hash);
+            }
+
+            const SceneGeometry &prototypes = instances.prototypes;
+            hash = hashBytes(prototypes.pointsX.data(), prototypes.pointsX.size() * sizeof(float), hash);
+            hash = hashBytes(prototypes.pointsY.data(), prototypes.pointsY.size() * sizeof(float), hash);
+            hash = hashBytes(prototypes.pointsZ.data(), prototypes.pointsZ.size() * sizeof(float), hash);
+            hash = hashBytes(prototypes.triangleIndices.data(), prototypes.triangleIndices.size() * sizeof(uint32_t), hash);
+            hash = hashBytes(instances.prototypeIndices.data(), instances.prototypeIndices.size() * sizeof(uint32_t), hash);
+            hash = hashBytes(instances.localToWorld.data(), instances.localToWorld.size() * sizeof(GfMatrix4d), hash);
+            return hash;
+        }
+
+        void VisibilityCache::computeKeys(const SceneGeometry &geometry, uint64_t analysisHash)
+        {
+            const size_t meshCount = geometry.getMeshCount();
+            m_analysisHash = analysisHash;
+            m_paths.resize(meshCount);
+            m_entries.assign(meshCount, Entry());
+
+            // World-space points already include the transform; indices are hashed relative to the mesh
+            WorkParallelForN(
+                meshCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t mesh = begin; mesh < end; ++mesh)
+                    {
+                        m_paths[mesh] = geometry.paths[mesh].GetString();
+
+                        const uint32_t firstPoint = geometry.pointOffsets[mesh];
+                        const size_t pointCount = geometry.getPointCount(mesh);
+                        uint64_t hash = hashValue(static_cast<uint64_t>(pointCount), kFnvOffset);
+                        hash = hashBytes(geometry.pointsX.data() + firstPoint, pointCount * sizeof(float), hash);
+                        hash = hashBytes(geometry.pointsY.data() + firstPoint, pointCount * sizeof(float), hash);
+                        hash = hashBytes(geometry.pointsZ.data() + firstPoint, pointCount * sizeof(float), hash);
+                        for (uint32_t i = 3 * geometry.triangleOffsets[mesh]; i < 3 * geometry.triangleOffsets[mesh + 1]; ++i)
+                        {
+                            hash = hashValue(geometry.triangleIndices[i] - firstPoint, hash);
+                        }
+                        m_entries[mesh].geometryHash = hash;
+                    }
+                },
+                64);
+
+            Bvh bvh;
+            const std::vector<GfRange3f> bounds = geometry.getAllBounds();
+            bvh.build(bounds);
+
+            // Neighbours are combined by a sum, so the key does not depend on mesh order
+            WorkParallelForN(
+                meshCount,
+                [&](size_t begin, size_t end)
+                {
+                    for (size_t mesh = begin; mesh < end; ++mesh)
+                    {
+                        if (bounds[mesh].IsEmpty())
+                        {
+                            continue;
+                        }
+
+                        const GfVec3f margin(bounds[mesh].GetSize().GetLength());
+                        const GfRange3f neighbourhood(bounds[mesh].GetMin() - margin, bounds[mesh].GetMax() + margin);
+                        uint64_t sum = 0;
+                        uint64_t count = 0;
+                        bvh.queryBox(neighbourhood.GetMin(), neighbourhood.GetMax(),
+                                     [&](uint32_t other)
+                                     {
+                                         if (other != mesh && !bounds[other].IsEmpty() &&
+                                             !GfRange3f::GetIntersection(bounds[other], neighbourhood).IsEmpty())
+                                         {
+                                             sum += mixHash(m_entries[other].geometryHash);
+                                             ++count;
+                                         }
+                                     });
+                        m_entries[mesh].neighbourhoodHash = mixHash(sum ^ mixHash(count));
+                    }
+                },
+                16);
+        }
+
+        size_t VisibilityCache::load(const std::string &path)
+        {
+            m_loaded.clear();
+
+            std::ifstream file(path);
+            if (!file)
+            {
+                return 0;
+            }
+
+            std::string header;
+            int version = 0;
+            std::string analysisHash;
+            file >> header >> version >> analysisHash;
+            if (header != kFileHeader || version != kFileVersion ||
+                std::strtoull(analysisHash.c_str(), nullptr, 16) != m_analysisHash)
+            {
+                return 0;
+            }
+
+            std::string line;
+            std::getline(file, line);
+            while (std::getline(file, line))
+            {
+                // <geometry hash> <neighbourhood hash> <hidden|visible> <score> <path>
+                std::istringstream fields(line);
+                std::string geometryHash, neighbourhoodHash, verdict, meshPath;
+                Entry entry;
+                if (!(fields >> geometryHash >> neighbourhoodHash >> verdict >> entry.score) ||
+                    !std::getline(fields >> std::ws, meshPath))
+                {
+                    continue;
+                }
+                entry.geometryHash = std::strtoull(geometryHash.c_str(), nullptr, 16);
+                entry.neighbourhoodHash = std::strtoull(neighbourhoodHash.c_str(), nullptr, 16);
+                entry.hidden = verdict == "hidden";
+                m_loaded[meshPath] = entry;
+            }
+            return m_loaded.size();
+        }
+
+        bool VisibilityCache::find(uint32_t mesh, bool &hidden, float &score) const
+        {
+            auto found = m_loaded.find(m_paths[mesh]);
+            if (found == m_loaded.end() ||
+                found->second.geometryHash != m_entries[mesh].geometryHash ||
+                found->second.neighbourhoodHash != m_entries[mesh].neighbourhoodHash)
+            {
+                return false;
+            }
+
+            hidden = found->second.hidden;
+            score = found->second.score;
+            return true;
+        }
+
+        void VisibilityCache::store(uint32_t mesh, bool hidden, float score)
+        {
+            Entry &entry = m_entries[mesh];
+            entry.hidden = hidden;
+            entry.score = score;
+            entry.stored = true;
+        }
+
+        bool VisibilityCache::save(const std::string &path) const
+        {
+            // Write next to the target and rename, so an interrupted run never leaves a truncated cache
+            const std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::trunc);
+                if (!file)
+                {
+                    return false;
+                }
+
+                file << kFileHeader << " " << kFileVersion << " " << std::hex << m_analysisHash << "\n";
+                for (size_t mesh = 0; mesh < m_entries.size(); ++mesh)
+                {
+                    const Entry &entry = m_entries[mesh];
+                    if (!entry.stored)
+                    {
+                        continue;
+                    }
+                    file << std::hex << entry.geometryHash << " " << entry.neighbourhoodHash << " "
+                         << (entry.hidden ? "hidden" : "visible") << " " << std::defaultfloat << std::setprecision(9)
+                         << entry.score << " " << m_paths[mesh] << "\n";
+                }
+
+                if (!file)
+                {
+                    return false;
+                }
+            }
+
+            // Not every platform lets rename() replace an existing file
+            if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+            {
+                std::remove(path.c_str());
+                return std::rename(tempPath.c_str(), path.c_str()) == 0;
+            }
+            return true;
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "HiddenMeshRemover.h"
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include <pxr/pxr.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Sidecar file of per-mesh visibility verdicts from earlier runs
+         *
+         * Each mesh is keyed by two content hashes: one of its own world-space
+         * points and triangles, and one of the meshes whose bounds come within
+         * one mesh diagonal of it, its likely occluders. A file also records a
+         * hash of the viewpoints and analysis options and is ignored entirely
+         * if that changes; refined and interior probe views follow the
+         * geometry and are covered by the options that create them. A cached
+         * verdict is reused only if both mesh keys still match, so only
+         * changed meshes and their neighbours are analysed again.
+         *
+         * Occluders outside the neighbourhood are assumed not to change a
+         * mesh's verdict; moving a distant occluder can leave a stale entry.
+         */
+        class VisibilityCache
+        {
+        public:
+            using Viewpoint = HiddenMeshRemover::Viewpoint;
+            using RemovalOptions = HiddenMeshRemover::RemovalOptions;
+
+            /**
+             * @brief Hash of the viewpoints and the options that affect verdicts
+             *
+             * Pass only viewpoints that do not depend on the mesh geometry;
+             * the options that derive further views are part of the hash.
+             * Instanced occluders have no verdicts of their own, so they are
+             * hashed here and any change to them invalidates the whole file.
+             */
+            static uint64_t computeAnalysisHash(const std::vector<Viewpoint> &viewpoints, const RemovalOptions &options,
+                                                const SceneInstances &instances);
+
+            /**
+             * @brief Compute the geometry and neighbourhood keys of every mesh
+             * @param geometry Snapshot the verdicts are computed from; paths are copied
+             * @param analysisHash Result of computeAnalysisHash() for this run
+             */
+            void computeKeys(const SceneGeometry &geometry, uint64_t analysisHash);
+
+            /**
+             * @brief Read the entries of an earlier run
+             *
+             * A missing file is not an error; it leaves the cache empty.
+             *
+             * @return Number of entries read whose analysis hash matches this run
+             */
+            size_t load(const std::string &path);
+
+            /**
+             * @brief Look up the verdict of a mesh from the loaded entries
+             * @param mesh Mesh index in the snapshot passed to computeKeys()
+             * @return True if an entry exists and both keys still match
+             */
+            bool find(uint32_t mesh, bool &hidden, float &score) const;
+
+            /**
+             * @brief Record the verdict of a mesh for save()
+             */
+            void store(uint32_t mesh, bool hidden, float score);
+
+            /**
+             * @brief Write the stored verdicts, replacing the file atomically
+             * @return False if the file could not be written
+             */
+            bool save(const std::string &path) const;
+
+        private:
+            struct Entry
+            {
+                uint64_t geometryHash = 0;
+                uint64_t neighbourhoodHash = 0;
+                bool hidden = false;
+                float score = 0.0f;
+                bool stored = false; ///< Set by store(); only stored entries are saved
+            };
+
+            uint64_t m_analysisHash = 0;
+            std::vector<std::string> m_paths;
+            std::vector<Entry> m_entries; ///< Current keys and stored verdicts, indexed like meshes
+            std::unordered_map<std::string, Entry> m_loaded;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,175 @@
+#include "VisibilityReport.h"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            std::string escapeJson(const std::string &text)
+            {
+                std::string escaped;
+                escaped.reserve(text.size());
+                for (char c : text)
+                {
+                    if (c == '"' || c == '\\')
+                    {
+                        escaped += '\\';
+                        escaped += c;
+                    }
+                    else if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char code[8];
+                        std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                        escaped += code;
+                    }
+                    else
+                    {
+                        escaped += c;
+                    }
+                }
+                return escaped;
+            }
+
+            std::string escapeCsv(const std::string &text)
+            {
+                if (text.find_first_of(",\"\n\r") == std::string::npos)
+                {
+                    return text;
+                }
+                std::string escaped = "\"";
+                for (char c : text)
+                {
+                    escaped += c;
+                    if (c == '"')
+                    {
+                        escaped += '"';
+                    }
+                }
+                return escaped + "\"";
+            }
+
+            void writeJsonVector(std::ostream &stream, const GfVec3d &value)
+            {
+                stream << "[" << value[0] << ", " << value[1] << ", " << value[2] << "]";
+            }
+
+            bool endsWith(const std::string &text, const std::string &suffix)
+            {
+                return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+            }
+        } // namespace
+
+        void VisibilityReport::clear()
+        {
+            m_meshes.clear();
+            m_phases.clear();
+        }
+
+        bool VisibilityReport::save(const std::string &path) const
+        {
+            auto writeFile = [](const std::string &filePath, auto &&write)
+            {
+                std::ofstream file(filePath, std::ios::trunc);
+                if (!file)
+                {
+                    return false;
+                }
+
+                // Enough digits to tell neighbouring viewpoints and short phases apart
+                file << std::setprecision(std::numeric_limits<float>::max_digits10);
+                write(file);
+                return static_cast<bool>(file);
+            };
+
+            if (endsWith(path, ".csv") || endsWith(path, ".CSV"))
+            {
+                // One table per file, so the mesh rows stay plain CSV
+                const std::string phasesPath = path.substr(0, path.size() - 4) + ".phases" + path.substr(path.size() - 4);
+                const bool meshesWritten = writeFile(path, [this](std::ostream &stream)
+                                                     { writeCsv(stream); });
+                return meshesWritten && writeFile(phasesPath, [this](std::ostream &stream)
+                                                  { writePhasesCsv(stream); });
+            }
+            return writeFile(path, [this](std::ostream &stream)
+                             { writeJson(stream); });
+        }
+
+        void VisibilityReport::writeJson(std::ostream &stream) const
+        {
+            stream << "{\n  \"phases\": {";
+            for (size_t i = 0; i < m_phases.size(); ++i)
+            {
+                stream << (i > 0 ? "," : "") << "\n    \"" << escapeJson(m_phases[i].name) << "\": " << m_phases[i].seconds;
+            }
+            stream << (m_phases.empty() ? "},\n" : "\n  },\n");
+
+            stream << "  \"meshes\": [";
+            for (size_t i = 0; i < m_meshes.size(); ++i)
+            {
+                const MeshEntry &mesh = m_meshes[i];
+                stream << (i > 0 ? "," : "") << "\n    {\"path\": \"" << escapeJson(mesh.path) << "\""
+                       << ", \"verdict\": \"" << mesh.verdict << "\""
+                       << ", \"score\": " << mesh.score
+                       << ", \"bestViewpoint\": ";
+                if (mesh.hasBestViewpoint)
+                {
+                    stream << "{\"position\": ";
+                    writeJsonVector(stream, mesh.bestPosition);
+                    stream << ", \"direction\": ";
+                    writeJsonVector(stream, mesh.bestDirection);
+                    stream << "}";
+                }
+                else
+                {
+                    stream << "null";
+                }
+                stream << ", \"raysTraced\": " << mesh.raysTraced
+                       << ", \"triangleCount\": " << mesh.triangleCount
+                       << ", \"seconds\": " << mesh.seconds
+                       << ", \"cached\": " << (mesh.cached ? "true" : "false") << "}";
+            }
+            stream << (m_meshes.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        }
+
+        void VisibilityReport::writeCsv(std::ostream &stream) const
+        {
+            stream << "path,verdict,score,bestX,bestY,bestZ,bestDirX,bestDirY,bestDirZ,raysTraced,triangleCount,seconds,cached\n";
+            for (const MeshEntry &mesh : m_meshes)
+            {
+                stream << escapeCsv(mesh.path) << "," << mesh.verdict << "," << mesh.score;
+                for (const GfVec3d *vector : {&mesh.bestPosition, &mesh.bestDirection})
+                {
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        // Left empty when no viewpoint saw the mesh
+                        stream << ",";
+                        if (mesh.hasBestViewpoint)
+                        {
+                            stream << (*vector)[axis];
+                        }
+                    }
+                }
+                stream << "," << mesh.raysTraced << "," << mesh.triangleCount << "," << mesh.seconds << ","
+                       << (mesh.cached ? 1 : 0) << "\n";
+            }
+        }
+
+        void VisibilityReport::writePhasesCsv(std::ostream &stream) const
+        {
+            stream << "phase,seconds\n";
+            for (const Phase &phase : m_phases)
+            {
+                stream << escapeCsv(phase.name) << "," << phase.seconds << "\n";
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
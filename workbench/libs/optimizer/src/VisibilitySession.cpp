@@ -0,0 +1,331 @@
+#include "VisibilitySession.h"
+#include "OcclusionScene.h"
+#include "ScopedConcurrencyLimit.h"
+#include "WorldSpaceCache.h"
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/usdGeom/tokens.h>
+#include <algorithm>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            /**
+             * @brief Whether a changed property moves the points of the mesh it belongs to
+             */
+            bool isGeometryProperty(const TfToken &name)
+            {
+                return name == UsdGeomTokens->points ||
+                       name == UsdGeomTokens->faceVertexCounts ||
+                       name == UsdGeomTokens->faceVertexIndices;
+            }
+
+            /**
+             * @brief Whether a changed property moves, adds or hides point-instancer entries
+             */
+            bool isInstancerProperty(const TfToken &name)
+            {
+                return name == UsdGeomTokens->positions ||
+                       name == UsdGeomTokens->orientations ||
+                       name == UsdGeomTokens->scales ||
+                       name == UsdGeomTokens->protoIndices ||
+                       name == UsdGeomTokens->invisibleIds;
+            }
+
+            /**
+             * @brief Whether a changed property moves every mesh below its prim
+             */
+            bool isTransformProperty(const TfToken &name)
+            {
+                // Matches the xformOpOrder attribute and every op, e.g. xformOp:translate
+                return TfStringStartsWith(name.GetString(), "xformOp");
+            }
+        } // namespace
+
+        VisibilitySession::VisibilitySession(UsdStagePtr stage, const HiddenMeshRemover::RemovalOptions &options)
+            : m_stage(stage), m_remover(options)
+        {
+            if (m_stage)
+            {
+                m_noticeKey = TfNotice::Register(TfCreateWeakPtr(this), &VisibilitySession::onObjectsChanged, m_stage);
+            }
+        }
+
+        VisibilitySession::~VisibilitySession()
+        {
+            TfNotice::Revoke(m_noticeKey);
+        }
+
+        bool VisibilitySession::analyze()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_pendingMutex);
+                m_pendingMeshes.clear();
+                m_pendingXforms.clear();
+                m_pendingRebuild = false;
+            }
+
+            m_scene.reset();
+            m_viewpoints.clear();
+            m_visibility.clear();
+            m_meshIndices.clear();
+            if (!m_stage)
+            {
+                return false;
+            }
+
+            m_remover.resetStats();
+            ScopedConcurrencyLimit concurrencyLimit(m_remover.getOptions().numThreads);
+            m_scene = std::make_unique<OcclusionScene>();
+            m_visibility = m_remover.analyzeStage(m_stage, *m_scene, m_viewpoints);
+            if (m_remover.getOptions().streamPayloads)
+            {
+                // Loading and unloading payloads resyncs them; those notices are not edits
+                std::lock_guard<std::mutex> lock(m_pendingMutex);
+                m_pendingMeshes.clear();
+                m_pendingXforms.clear();
+                m_pendingRebuild = false;
+            }
+            for (size_t meshIndex = 0; meshIndex < m_scene->meshes.size(); ++meshIndex)
+            {
+                m_meshIndices[m_scene->meshes[meshIndex].GetPath()] = static_cast<uint32_t>(meshIndex);
+            }
+            countVerdicts();
+            return !m_visibility.empty();
+        }
+
+        bool VisibilitySession::hasPendingChanges() const
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMutex);
+            return m_pendingRebuild || !m_pendingMeshes.empty() || !m_pendingXforms.empty();
+        }
+
+        size_t VisibilitySession::update()
+        {
+            std::unordered_set<SdfPath, SdfPath::Hash> meshPaths;
+            std::unordered_set<SdfPath, SdfPath::Hash> xformPaths;
+            bool rebuild = false;
+            {
+                std::lock_guard<std::mutex> lock(m_pendingMutex);
+                meshPaths.swap(m_pendingMeshes);
+                xformPaths.swap(m_pendingXforms);
+                rebuild = m_pendingRebuild;
+                m_pendingRebuild = false;
+            }
+
+            // Instances are stored per prototype and not refitted; any edit to them re-analyses
+            if (!rebuild && m_scene && m_scene->instances.getInstanceCount() > 0)
+            {
+                auto touchesInstances = [&](const std::unordered_set<SdfPath, SdfPath::Hash> &paths)
+                {
+                    return std::any_of(paths.begin(), paths.end(),
+                                       [&](const SdfPath &path)
+                                       { return m_scene->instances.isAffectedBy(path); });
+                };
+                rebuild = touchesInstances(meshPaths) || touchesInstances(xformPaths);
+            }
+
+            if (rebuild || m_visibility.empty())
+            {
+                if (!rebuild && meshPaths.empty() && xformPaths.empty())
+                {
+                    return 0;
+                }
+                analyze();
+                return m_visibility.size();
+            }
+
+            const std::vector<uint32_t> changed = resolveChangedMeshes(meshPaths, xformPaths);
+            if (changed.empty())
+            {
+                return 0;
+            }
+
+            ScopedConcurrencyLimit concurrencyLimit(m_remover.getOptions().numThreads);
+            OcclusionScene &scene = *m_scene;
+            SceneGeometry &geometry = scene.geometry;
+
+            std::vector<GfRange3f> regions;
+            regions.reserve(changed.size());
+            for (uint32_t meshIndex : changed)
+            {
+                regions.push_back(geometry.getBounds(meshIndex));
+            }
+
+            // Re-read the changed meshes into the snapshot in place; new counts need new offsets
+            if (!m_remover.refitOcclusionScene(scene, changed, WorldSpaceCache()))
+            {
+                m_remover.logVerbose("Point or triangle count of a changed mesh differs; analyzing the whole stage");
+                analyze();
+                return m_visibility.size();
+            }
+
+            // Old and new extent of each changed mesh, grown by its diagonal
+            for (size_t i = 0; i < changed.size(); ++i)
+            {
+                regions[i].UnionWith(geometry.getBounds(changed[i]));
+                if (!regions[i].IsEmpty())
+                {
+                    const GfVec3f margin(regions[i].GetSize().GetLength());
+                    regions[i] = GfRange3f(regions[i].GetMin() - margin, regions[i].GetMax() + margin);
+                }
+            }
+
+            // Re-test changed meshes and every mesh near them; all others keep their verdict
+            const size_t meshCount = m_visibility.size();
+            std::vector<uint8_t> resolved(meshCount, 1);
+            for (uint32_t meshIndex : changed)
+            {
+                resolved[meshIndex] = 0;
+            }
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                const GfRange3f bounds = geometry.getBounds(meshIndex);
+                if (!resolved[meshIndex] || bounds.IsEmpty())
+                {
+                    continue;
+                }
+                for (const GfRange3f &region : regions)
+                {
+                    if (!region.IsEmpty() && !GfRange3f::GetIntersection(bounds, region).IsEmpty())
+                    {
+                        resolved[meshIndex] = 0;
+                        break;
+                    }
+                }
+            }
+
+            size_t retested = 0;
+            for (size_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+            {
+                if (m_visibility[meshIndex] == MeshVisibility::Preserved)
+                {
+                    resolved[meshIndex] = 1;
+                }
+                else if (!resolved[meshIndex])
+                {
+                    m_visibility[meshIndex] = MeshVisibility::Visible;
+                    ++retested;
+                }
+            }
+
+            std::vector<float> scores(meshCount, 0.0f);
+            m_remover.testVisibility(scene, m_viewpoints, resolved, m_visibility, scores);
+            countVerdicts();
+
+            m_remover.logVerbose("Re-tested " + std::to_string(retested) + " meshes around " +
+                                 std::to_string(changed.size()) + " changed meshes");
+            return retested;
+        }
+
+        bool VisibilitySession::isHidden(const SdfPath &meshPath) const
+        {
+            auto found = m_meshIndices.find(meshPath);
+            return found != m_meshIndices.end() && found->second < m_visibility.size() &&
+                   m_visibility[found->second] == MeshVisibility::Hidden;
+        }
+
+        std::vector<SdfPath> VisibilitySession::getHiddenMeshes() const
+        {
+            std::vector<SdfPath> hiddenMeshes;
+            for (size_t meshIndex = 0; meshIndex < m_visibility.size(); ++meshIndex)
+            {
+                if (m_visibility[meshIndex] == MeshVisibility::Hidden)
+                {
+                    hiddenMeshes.push_back(m_scene->meshes[meshIndex].GetPath());
+                }
+            }
+            return hiddenMeshes;
+        }
+
+        void VisibilitySession::onObjectsChanged(const UsdNotice::ObjectsChanged &notice, const UsdStageWeakPtr &sender)
+        {
+            std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+            // Creating or removing a property also resyncs it; only prim resyncs change the mesh set
+            for (const SdfPath &path : notice.GetResyncedPaths())
+            {
+                if (path.IsPrimPath() || path.IsAbsoluteRootPath())
+                {
+                    m_pendingRebuild = true;
+                }
+                else if (path.IsPropertyPath() && (isGeometryProperty(path.GetNameToken()) || isInstancerProperty(path.GetNameToken())))
+                {
+                    m_pendingMeshes.insert(path.GetPrimPath());
+                }
+                else if (path.IsPropertyPath() && isTransformProperty(path.GetNameToken()))
+                {
+                    m_pendingXforms.insert(path.GetPrimPath());
+                }
+            }
+
+            for (const SdfPath &path : notice.GetChangedInfoOnlyPaths())
+            {
+                if (!path.IsPropertyPath())
+                {
+                    continue;
+                }
+                if (isGeometryProperty(path.GetNameToken()) || isInstancerProperty(path.GetNameToken()))
+                {
+                    m_pendingMeshes.insert(path.GetPrimPath());
+                }
+                else if (isTransformProperty(path.GetNameToken()))
+                {
+                    m_pendingXforms.insert(path.GetPrimPath());
+                }
+            }
+        }
+
+        std::vector<uint32_t> VisibilitySession::resolveChangedMeshes(const std::unordered_set<SdfPath, SdfPath::Hash> &meshPaths,
+                                                                      const std::unordered_set<SdfPath, SdfPath::Hash> &xformPaths) const
+        {
+            std::vector<uint32_t> changed;
+            for (const SdfPath &path : meshPaths)
+            {
+                auto found = m_meshIndices.find(path);
+                if (found != m_meshIndices.end())
+                {
+                    changed.push_back(found->second);
+                }
+            }
+
+            // A transform moves the prim's own mesh and every mesh below it
+            if (!xformPaths.empty())
+            {
+                for (const auto &[meshPath, meshIndex] : m_meshIndices)
+                {
+                    for (SdfPath prefix = meshPath; !prefix.IsEmpty() && !prefix.IsAbsoluteRootPath(); prefix = prefix.GetParentPath())
+                    {
+                        if (xformPaths.count(prefix))
+                        {
+                            changed.push_back(meshIndex);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+            return changed;
+        }
+
+        void VisibilitySession::countVerdicts()
+        {
+            HiddenMeshRemover::RemovalStats &stats = m_remover.m_stats;
+            stats.hiddenMeshes = 0;
+            stats.preservedMeshes = 0;
+            for (MeshVisibility verdict : m_visibility)
+            {
+                stats.hiddenMeshes += verdict == MeshVisibility::Hidden;
+                stats.preservedMeshes += verdict == MeshVisibility::Preserved;
+            }
+        }
+
+    } // namespace optimizer
+} // namespace workbench
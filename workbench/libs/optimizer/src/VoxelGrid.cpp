@@ -0,0 +1,367 @@
+#include "VoxelGrid.h"
+#include <pxr/base/gf/matrix4d.h>
+#include <algorithm>
+#include <cmath>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        namespace
+        {
+            /// Voxels are tested slightly enlarged, so triangles on a voxel face occupy both sides
+            constexpr float kOverlapSlack = 1e-3f;
+
+            /**
+             * @brief Separating axis test of a triangle against a cube
+             * @param a Triangle corner relative to the cube center
+             * @param halfSize Half the edge length of the cube
+             */
+            bool overlapsCube(const GfVec3f &a, const GfVec3f &b, const GfVec3f &c, float halfSize)
+            {
+                auto separates = [&](const GfVec3f &axis)
+                {
+                    const float pa = GfDot(a, axis);
+                    const float pb = GfDot(b, axis);
+                    const float pc = GfDot(c, axis);
+                    const float radius = halfSize * (std::abs(axis[0]) + std::abs(axis[1]) + std::abs(axis[2]));
+                    return std::min({pa, pb, pc}) > radius || std::max({pa, pb, pc}) < -radius;
+                };
+
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    if (std::min({a[axis], b[axis], c[axis]}) > halfSize || std::max({a[axis], b[axis], c[axis]}) < -halfSize)
+                    {
+                        return false;
+                    }
+                }
+                const GfVec3f edges[3] = {b - a, c - b, a - c};
+                if (separates(GfCross(edges[0], edges[1])))
+                {
+                    return false;
+                }
+                for (const GfVec3f &edge : edges)
+                {
+                    if (separates(GfVec3f(0.0f, -edge[2], edge[1])) || separates(GfVec3f(edge[2], 0.0f, -edge[0])) ||
+                        separates(GfVec3f(-edge[1], edge[0], 0.0f)))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        } // namespace
+
+        template <typename Visitor>
+        bool VoxelGrid::forEachOverlappedVoxel(const GfVec3f &a, const GfVec3f &b, const GfVec3f &c, Visitor &&visit) const
+        {
+            // The border voxels stay free, so the fill can always run around the scene
+            Coordinates low;
+            Coordinates high;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float minimum = (std::min({a[axis], b[axis], c[axis]}) - m_origin[axis]) / m_voxelSize;
+                const float maximum = (std::max({a[axis], b[axis], c[axis]}) - m_origin[axis]) / m_voxelSize;
+                low[axis] = std::max(1, static_cast<int>(std::floor(minimum - kOverlapSlack)));
+                high[axis] = std::min(m_dims[axis] - 2, static_cast<int>(std::floor(maximum + kOverlapSlack)));
+                if (low[axis] > high[axis])
+                {
+                    return true;
+                }
+            }
+
+            // Walk columns along the normal's dominant axis, testing only where the plane crosses each column
+            const GfVec3f normal = GfCross(b - a, c - a);
+            int d = 0;
+            for (int axis = 1; axis < 3; ++axis)
+            {
+                if (std::abs(normal[axis]) > std::abs(normal[d]))
+                {
+                    d = axis;
+                }
+            }
+            const int u = (d + 1) % 3;
+            const int v = (d + 2) % 3;
+            const float planeOffset = GfDot(normal, a);
+            const float halfSize = 0.5f * m_voxelSize * (1.0f + kOverlapSlack);
+
+            Coordinates voxel;
+            for (voxel[u] = low[u]; voxel[u] <= high[u]; ++voxel[u])
+            {
+                for (voxel[v] = low[v]; voxel[v] <= high[v]; ++voxel[v])
+                {
+                    int first = low[d];
+                    int last = high[d];
+                    if (normal[d] != 0.0f)
+                    {
+                        float columnMin = std::numeric_limits<float>::max();
+                        float columnMax = std::numeric_limits<float>::lowest();
+                        for (int corner = 0; corner < 4; ++corner)
+                        {
+                            const float pu = m_origin[u] + static_cast<float>(voxel[u] + (corner & 1)) * m_voxelSize;
+                            const float pv = m_origin[v] + static_cast<float>(voxel[v] + (corner >> 1)) * m_voxelSize;
+                            const float pd = (planeOffset - normal[u] * pu - normal[v] * pv) / normal[d];
+                            columnMin = std::min(columnMin, pd);
+                            columnMax = std::max(columnMax, pd);
+                        }
+                        first = std::max(first, static_cast<int>(std::floor((columnMin - m_origin[d]) / m_voxelSize - kOverlapSlack)));
+                        last = std::min(last, static_cast<int>(std::floor((columnMax - m_origin[d]) / m_voxelSize + kOverlapSlack)));
+                    }
+                    for (voxel[d] = first; voxel[d] <= last; ++voxel[d])
+                    {
+                        const GfVec3f center = m_origin + GfVec3f(static_cast<float>(voxel[0]) + 0.5f, static_cast<float>(voxel[1]) + 0.5f,
+                                                                  static_cast<float>(voxel[2]) + 0.5f) * m_voxelSize;
+                        if (overlapsCube(a - center, b - center, c - center, halfSize) && !visit(voxel[0], voxel[1], voxel[2]))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        void VoxelGrid::clear()
+        {
+            *this = VoxelGrid();
+        }
+
+        void VoxelGrid::build(const SceneGeometry &geometry, const SceneInstances &instances, const GfRange3f &bounds, int resolution)
+        {
+            clear();
+            if (bounds.IsEmpty())
+            {
+                return;
+            }
+
+            const GfVec3f size = bounds.GetSize();
+            const float longest = std::max({size[0], size[1], size[2]});
+            m_voxelSize = longest > 0.0f ? longest / static_cast<float>(std::max(1, resolution)) : 1.0f;
+            m_origin = bounds.GetMin() - GfVec3f(m_voxelSize);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                // One free voxel below the bounds and at least one above them
+                const int voxels = static_cast<int>(std::floor(size[axis] / m_voxelSize)) + 3;
+                m_brickDims[axis] = (voxels + kBrickSize - 1) / kBrickSize;
+                m_dims[axis] = m_brickDims[axis] * kBrickSize;
+            }
+            m_brickSlots.assign(static_cast<size_t>(m_brickDims[0]) * m_brickDims[1] * m_brickDims[2], kEmptyBrick);
+
+            auto occupyVoxel = [this](int x, int y, int z)
+            {
+                occupy(x, y, z);
+                return true;
+            };
+            for (size_t triangle = 0; triangle < geometry.getTotalTriangleCount(); ++triangle)
+            {
+                forEachOverlappedVoxel(geometry.getPoint(geometry.triangleIndices[3 * triangle]),
+                                       geometry.getPoint(geometry.triangleIndices[3 * triangle + 1]),
+                                       geometry.getPoint(geometry.triangleIndices[3 * triangle + 2]), occupyVoxel);
+            }
+
+            const SceneGeometry &prototypes = instances.prototypes;
+            for (size_t instance = 0; instance < instances.getInstanceCount(); ++instance)
+            {
+                const uint32_t prototype = instances.prototypeIndices[instance];
+                const GfMatrix4d &transform = instances.localToWorld[instance];
+                auto toWorld = [&](uint32_t point)
+                {
+                    return GfVec3f(transform.Transform(GfVec3d(prototypes.getPoint(point))));
+                };
+                for (uint32_t triangle = prototypes.triangleOffsets[prototype]; triangle < prototypes.triangleOffsets[prototype + 1]; ++triangle)
+                {
+                    forEachOverlappedVoxel(toWorld(prototypes.triangleIndices[3 * triangle]),
+                                           toWorld(prototypes.triangleIndices[3 * triangle + 1]),
+                                           toWorld(prototypes.triangleIndices[3 * triangle + 2]), occupyVoxel);
+                }
+            }
+        }
+
+        void VoxelGrid::occupy(int x, int y, int z)
+        {
+            uint32_t &slot = m_brickSlots[getBrickIndex({x / kBrickSize, y / kBrickSize, z / kBrickSize})];
+            if (slot == kEmptyBrick)
+            {
+                slot = static_cast<uint32_t>(m_occupied.size());
+                m_occupied.push_back(Brick{});
+            }
+            m_occupied[slot][z % kBrickSize] |= uint64_t(1) << (x % kBrickSize + kBrickSize * (y % kBrickSize));
+        }
+
+        void VoxelGrid::reach(const Coordinates &voxel, Fill &fill, std::vector<Coordinates> &brickQueue,
+                              std::vector<Coordinates> &voxelQueue) const
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (voxel[axis] < 0 || voxel[axis] >= m_dims[axis])
+                {
+                    return;
+                }
+            }
+
+            const Coordinates brick = {voxel[0] / kBrickSize, voxel[1] / kBrickSize, voxel[2] / kBrickSize};
+            const size_t brickIndex = getBrickIndex(brick);
+            const uint32_t slot = m_brickSlots[brickIndex];
+            if (slot == kEmptyBrick)
+            {
+                if (!fill.emptyReached[brickIndex])
+                {
+                    fill.emptyReached[brickIndex] = 1;
+                    brickQueue.push_back(brick);
+                }
+                return;
+            }
+
+            uint64_t &reached = fill.reached[slot][voxel[2] % kBrickSize];
+            const uint64_t bit = uint64_t(1) << (voxel[0] % kBrickSize + kBrickSize * (voxel[1] % kBrickSize));
+            if (reached & bit)
+            {
+                return;
+            }
+            reached |= bit;
+
+            // Occupied voxels are reached but stop the fill
+            if (!(m_occupied[slot][voxel[2] % kBrickSize] & bit))
+            {
+                voxelQueue.push_back(voxel);
+            }
+        }
+
+        VoxelGrid::Fill VoxelGrid::floodFill(const std::vector<GfVec3d> &seeds) const
+        {
+            Fill fill;
+            fill.reached.assign(m_occupied.size(), Brick{});
+            fill.emptyReached.assign(m_brickSlots.size(), 0);
+            if (m_brickSlots.empty())
+            {
+                return fill;
+            }
+
+            std::vector<Coordinates> brickQueue;
+            std::vector<Coordinates> voxelQueue;
+            bool fromOutside = false;
+            for (const GfVec3d &seed : seeds)
+            {
+                Coordinates voxel;
+                bool inside = true;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const double coordinate = std::floor((seed[axis] - m_origin[axis]) / m_voxelSize);
+                    inside = inside && coordinate >= 0.0 && coordinate < m_dims[axis];
+                    voxel[axis] = inside ? static_cast<int>(coordinate) : 0;
+                }
+                if (!inside)
+                {
+                    fromOutside = true;
+                    continue;
+                }
+
+                reach(voxel, fill, brickQueue, voxelQueue);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    for (int step : {-1, 1})
+                    {
+                        Coordinates neighbour = voxel;
+                        neighbour[axis] += step;
+                        reach(neighbour, fill, brickQueue, voxelQueue);
+                    }
+                }
+            }
+            if (fromOutside)
+            {
+                // The border is free and connected all around the scene
+                reach({0, 0, 0}, fill, brickQueue, voxelQueue);
+            }
+
+            while (!brickQueue.empty() || !voxelQueue.empty())
+            {
+                if (!voxelQueue.empty())
+                {
+                    const Coordinates voxel = voxelQueue.back();
+                    voxelQueue.pop_back();
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        for (int step : {-1, 1})
+                        {
+                            Coordinates neighbour = voxel;
+                            neighbour[axis] += step;
+                            reach(neighbour, fill, brickQueue, voxelQueue);
+                        }
+                    }
+                    continue;
+                }
+
+                // An empty brick passes the fill on to its neighbours at once
+                const Coordinates brick = brickQueue.back();
+                brickQueue.pop_back();
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    for (int step : {-1, 1})
+                    {
+                        Coordinates neighbour = brick;
+                        neighbour[axis] += step;
+                        if (neighbour[axis] < 0 || neighbour[axis] >= m_brickDims[axis])
+                        {
+                            continue;
+                        }
+
+                        // Voxels of the neighbour's face that touches this brick
+                        Coordinates voxel;
+                        voxel[axis] = neighbour[axis] * kBrickSize + (step > 0 ? 0 : kBrickSize - 1);
+                        if (m_brickSlots[getBrickIndex(neighbour)] == kEmptyBrick)
+                        {
+                            voxel[(axis + 1) % 3] = neighbour[(axis + 1) % 3] * kBrickSize;
+                            voxel[(axis + 2) % 3] = neighbour[(axis + 2) % 3] * kBrickSize;
+                            reach(voxel, fill, brickQueue, voxelQueue);
+                            continue;
+                        }
+                        for (int i = 0; i < kBrickSize; ++i)
+                        {
+                            for (int j = 0; j < kBrickSize; ++j)
+                            {
+                                voxel[(axis + 1) % 3] = neighbour[(axis + 1) % 3] * kBrickSize + i;
+                                voxel[(axis + 2) % 3] = neighbour[(axis + 2) % 3] * kBrickSize + j;
+                                reach(voxel, fill, brickQueue, voxelQueue);
+                            }
+                        }
+                    }
+                }
+            }
+            return fill;
+        }
+
+        bool VoxelGrid::isMeshReached(const Fill &fill, const SceneGeometry &geometry, uint32_t mesh) const
+        {
+            if (fill.reached.size() != m_occupied.size())
+            {
+                return false;
+            }
+
+            auto isUnreached = [&](int x, int y, int z)
+            {
+                const uint32_t slot = m_brickSlots[getBrickIndex({x / kBrickSize, y / kBrickSize, z / kBrickSize})];
+                const uint64_t bit = uint64_t(1) << (x % kBrickSize + kBrickSize * (y % kBrickSize));
+                return slot == kEmptyBrick || !(fill.reached[slot][z % kBrickSize] & bit);
+            };
+            for (uint32_t triangle = geometry.triangleOffsets[mesh]; triangle < geometry.triangleOffsets[mesh + 1]; ++triangle)
+            {
+                if (!forEachOverlappedVoxel(geometry.getPoint(geometry.triangleIndices[3 * triangle]),
+                                            geometry.getPoint(geometry.triangleIndices[3 * triangle + 1]),
+                                            geometry.getPoint(geometry.triangleIndices[3 * triangle + 2]), isUnreached))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        size_t VoxelGrid::getMemoryUsage() const
+        {
+            return m_brickSlots.capacity() * sizeof(uint32_t) + m_occupied.capacity() * sizeof(Brick);
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "SceneGeometry.h"
+#include "SceneInstances.h"
+#include <pxr/pxr.h>
+#include <pxr/base/gf/range3f.h>
+#include <pxr/base/gf/vec3d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief Sparse voxelization of the scene's triangles with a flood fill through the free space
+         *
+         * The grid covers the scene bounds plus a free border at least one
+         * voxel wide, split into bricks of 8x8x8 voxels. Only bricks that
+         * triangles touch store voxel bits; an empty brick costs one entry in
+         * a dense brick table, and the fill crosses it as a whole instead of
+         * voxel by voxel.
+         *
+         * Voxelization is conservative: every voxel a triangle overlaps is
+         * occupied, so closed surfaces never leak. Openings narrower than a
+         * voxel are closed as well.
+         */
+        class VoxelGrid
+        {
+        public:
+            static constexpr int kBrickSize = 8;
+
+            /// One bit per voxel of a brick; word z holds row y at bits 8 * y to 8 * y + 7
+            using Brick = std::array<uint64_t, kBrickSize>;
+
+            /**
+             * @brief Voxels one flood fill reached, kept apart from the grid so one grid serves many fills
+             */
+            struct Fill
+            {
+                std::vector<Brick> reached;        ///< Filled free voxels and reached occupied ones, per occupied brick
+                std::vector<uint8_t> emptyReached; ///< Non-zero for empty bricks the fill crossed, per brick
+            };
+
+            /**
+             * @brief Size the grid to the bounds and occupy the voxels of every mesh and instance
+             * @param geometry World-space snapshot of the analysed meshes
+             * @param instances Instanced occluders
+             * @param bounds Union of all mesh and instance bounds
+             * @param resolution Voxels along the longest axis of the bounds
+             */
+            void build(const SceneGeometry &geometry, const SceneInstances &instances, const GfRange3f &bounds, int resolution);
+
+            void clear();
+
+            /**
+             * @brief Flood the free space connected to the seed points
+             *
+             * A seed outside the grid stands for everything outside the
+             * scene bounds, so the fill starts from the whole border. Seeds
+             * inside occupied voxels spread into the free voxels next to them.
+             * Occupied voxels next to filled ones count as reached.
+             */
+            Fill floodFill(const std::vector<GfVec3d> &seeds) const;
+
+            /**
+             * @brief Whether a fill reached any voxel a mesh overlaps
+             * @param geometry The snapshot the grid was built from
+             */
+            bool isMeshReached(const Fill &fill, const SceneGeometry &geometry, uint32_t mesh) const;
+
+            bool empty() const { return m_brickSlots.empty(); }
+            size_t getOccupiedBrickCount() const { return m_occupied.size(); }
+
+            /**
+             * @brief Bytes held by the brick table and the occupied voxel bits
+             */
+            size_t getMemoryUsage() const;
+
+        private:
+            using Coordinates = std::array<int, 3>;
+
+            static constexpr uint32_t kEmptyBrick = std::numeric_limits<uint32_t>::max();
+
+            size_t getBrickIndex(const Coordinates &brick) const
+            {
+                return (static_cast<size_t>(brick[2]) * m_brickDims[1] + brick[1]) * m_brickDims[0] + brick[0];
+            }
+
+            /**
+             * @brief Call visit(x, y, z) for every voxel the triangle overlaps until it returns false
+             * @return False if visit stopped the walk
+             */
+            template <typename Visitor>
+            bool forEachOverlappedVoxel(const GfVec3f &a, const GfVec3f &b, const GfVec3f &c, Visitor &&visit) const;
+
+            void occupy(int x, int y, int z);
+
+            /**
+             * @brief Fill one voxel, or the whole brick if it is empty, unless it was reached before
+             */
+            void reach(const Coordinates &voxel, Fill &fill, std::vector<Coordinates> &brickQueue,
+                       std::vector<Coordinates> &voxelQueue) const;
+
+            GfVec3f m_origin = GfVec3f(0.0f); ///< Minimum corner of voxel (0, 0, 0)
+            float m_voxelSize = 1.0f;
+            Coordinates m_dims = {0, 0, 0};      ///< Voxels per axis, multiples of kBrickSize
+            Coordinates m_brickDims = {0, 0, 0};
+            std::vector<uint32_t> m_brickSlots;  ///< Slot in m_occupied of each brick, or kEmptyBrick
+            std::vector<Brick> m_occupied;
+        };
+
+    } // namespace optimizer
+} // namespace workbench
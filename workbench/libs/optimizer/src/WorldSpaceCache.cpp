@@ -0,0 +1,24 @@
+#include "WorldSpaceCache.h"
+#include <pxr/usd/usdGeom/tokens.h>
+#include <pxr/base/gf/bbox3d.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        WorldSpaceCache::WorldSpaceCache(UsdTimeCode timeCode)
+            : m_timeCode(timeCode),
+              m_bboxCache(timeCode, {UsdGeomTokens->default_, UsdGeomTokens->render}, /*useExtentsHint=*/true)
+        {
+        }
+
+        GfRange3d WorldSpaceCache::computeWorldBounds(const UsdPrim &prim)
+        {
+            return m_bboxCache.ComputeWorldBound(prim).ComputeAlignedRange();
+        }
+
+    } // namespace optimizer
+} // namespace workbench
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usd/timeCode.h>
+#include <pxr/usd/usdGeom/bboxCache.h>
+#include <pxr/usd/usdGeom/xformCache.h>
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/range3d.h>
+#include <pxr/base/work/loops.h>
+#include <vector>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace workbench
+{
+    namespace optimizer
+    {
+
+        /**
+         * @brief World-space transforms and bounds shared by one analysis run
+         *
+         * Transforms are computed once for all prims of interest, in parallel,
+         * and then only looked up. Bounds come from a single UsdGeomBBoxCache,
+         * so the first query for the stage root populates the bounds of every
+         * prim below it with OpenUSD's own multithreaded traversal.
+         */
+        class WorldSpaceCache
+        {
+        public:
+            explicit WorldSpaceCache(UsdTimeCode timeCode = UsdTimeCode::Default());
+
+            /**
+             * @brief Compute the local-to-world transform of each prim in parallel
+             *
+             * UsdGeomXformCache is not thread-safe, so each worker fills its own
+             * cache over a contiguous range. Prims given in traversal order share
+             * most ancestors within a range, which keeps the redundant work small.
+             *
+             * @param prims Prims or schema objects (anything with GetPrim())
+             * @return One matrix per input, in the same order
+             */
+            template <typename PrimLike>
+            std::vector<GfMatrix4d> computeLocalToWorld(const std::vector<PrimLike> &prims) const;
+
+            /**
+             * @brief World-space axis-aligned bounds of a prim and its descendants
+             *
+             * Not thread-safe; call from the thread that owns the cache.
+             */
+            GfRange3d computeWorldBounds(const UsdPrim &prim);
+
+            UsdTimeCode getTime() const { return m_timeCode; }
+
+        private:
+            UsdTimeCode m_timeCode;
+            UsdGeomBBoxCache m_bboxCache;
+        };
+
+        template <typename PrimLike>
+        std::vector<GfMatrix4d> WorldSpaceCache::computeLocalToWorld(const std::vector<PrimLike> &prims) const
+        {
+            std::vector<GfMatrix4d> transforms(prims.size());
+
+            // Ranges of a few hundred prims amortize each worker's cache warm-up
+            WorkParallelForN(
+                prims.size(),
+                [&](size_t begin, size_t end)
+                {
+                    UsdGeomXformCache xformCache(m_timeCode);
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        transforms[i] = xformCache.GetLocalToWorldTransform(prims[i].GetPrim());
+                    }
+                },
+                256);
+
+            return transforms;
+        }
+
+    } // namespace optimizer
+} // namespace workbench